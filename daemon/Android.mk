@@ -3,13 +3,23 @@ include $(CLEAR_VARS)
 
 XML_H := $(shell cd $(LOCAL_PATH) && make events_xml.h defaults_xml.h)
 
-LOCAL_CFLAGS += -Wall -O3 -mthumb-interwork -fno-exceptions -pthread -DETCDIR=\"/etc\" -Ilibsensors
+LOCAL_CFLAGS += -Wall -O3 -mthumb-interwork -fno-exceptions -pthread -DETCDIR=\"/etc\" -Ilibsensors -I$(LOCAL_PATH)/../decode
 
 LOCAL_SRC_FILES := \
+	../decode/GatorDecode.cpp \
+	../decode/Varint.cpp \
+	BlockIo.cpp \
 	Buffer.cpp \
+	BufferBudget.cpp \
+	CaptureFile.cpp \
+	CaptureIndex.cpp \
+	CaptureState.cpp \
+	CaptureSummary.cpp \
+	CaptureWriter.cpp \
 	CapturedXML.cpp \
 	Child.cpp \
 	ConfigurationXML.cpp \
+	CpuPower.cpp \
 	Driver.cpp \
 	DriverSource.cpp \
 	DynBuf.cpp \
@@ -17,25 +27,38 @@ LOCAL_SRC_FILES := \
 	ExternalSource.cpp \
 	FSDriver.cpp \
 	Fifo.cpp \
+	Hub.cpp \
 	Hwmon.cpp \
 	KMod.cpp \
+	LazyMaps.cpp \
+	LiveFilter.cpp \
 	LocalCapture.cpp \
 	Logging.cpp \
 	main.cpp \
 	MaliVideoDriver.cpp \
+	MirroredMemory.cpp \
 	Monitor.cpp \
 	OlySocket.cpp \
 	OlyUtility.cpp \
+	PerfAnalytics.cpp \
 	PerfBuffer.cpp \
 	PerfDriver.cpp \
 	PerfGroup.cpp \
+	PerfPmu.cpp \
 	PerfSource.cpp \
+	PerfUncore.cpp \
 	Proc.cpp \
+	ProcStats.cpp \
+	Reactor.cpp \
+	SchedLatency.cpp \
 	Sender.cpp \
 	SessionData.cpp \
 	SessionXML.cpp \
+	SpillQueue.cpp \
 	Source.cpp \
 	StreamlineSetup.cpp \
+	StringTable.cpp \
+	ThreadPlacement.cpp \
 	UEvent.cpp \
 	UserSpaceSource.cpp \
 	libsensors/access.c \
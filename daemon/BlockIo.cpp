@@ -0,0 +1,259 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "BlockIo.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "Buffer.h"
+#include "DriverSource.h"
+#include "Logging.h"
+#include "SessionData.h"
+
+#define SYS_BLOCK "/sys/block"
+#define NS_PER_US 1000ULL
+#define SECTOR_SIZE 512
+
+// Buckets are powers of 10 starting at 100us, the last bucket is everything slower
+const char *const BlockIo::LATENCY_COUNTERS[] = {
+	"Linux_block_latency_100us",
+	"Linux_block_latency_1ms",
+	"Linux_block_latency_10ms",
+	"Linux_block_latency_100ms",
+	"Linux_block_latency_slow",
+};
+
+static const char *const TOTAL_COUNTERS[] = {
+	"Linux_block_rq_rd",
+	"Linux_block_rq_wr",
+};
+
+BlockIo::BlockIo() : mRequests(), mTime(0), mDiskCount(0), mIssue(-1) {
+	memset(mTotalBytes, 0, sizeof(mTotalBytes));
+	memset(mLatency, 0, sizeof(mLatency));
+}
+
+int BlockIo::readDisks(Disk *const disks, const int max) {
+	DIR *dir = opendir(SYS_BLOCK);
+	if (dir == NULL) {
+		logg->logMessage("%s(%s:%i): opendir failed", __FUNCTION__, __FILE__, __LINE__);
+		return 0;
+	}
+
+	int count = 0;
+	char buf[256];
+	struct dirent *dirent;
+	while (count < max && (dirent = readdir(dir)) != NULL) {
+		if (dirent->d_name[0] == '.' || strlen(dirent->d_name) >= sizeof(disks[count].name)) {
+			continue;
+		}
+
+		// Skip disks without media, like unused loop and ram devices
+		int64_t sectors;
+		snprintf(buf, sizeof(buf), SYS_BLOCK "/%s/size", dirent->d_name);
+		if (DriverSource::readInt64Driver(buf, &sectors) != 0 || sectors <= 0) {
+			continue;
+		}
+
+		snprintf(buf, sizeof(buf), SYS_BLOCK "/%s/dev", dirent->d_name);
+		FILE *const file = fopen(buf, "r");
+		if (file == NULL) {
+			continue;
+		}
+		unsigned int major;
+		unsigned int minor;
+		const bool parsed = fscanf(file, "%u:%u", &major, &minor) == 2;
+		fclose(file);
+		if (!parsed) {
+			continue;
+		}
+
+		strcpy(disks[count].name, dirent->d_name);
+		// MKDEV in the kernel, which differs from the userspace dev_t
+		disks[count].dev = (major << 20) | minor;
+		++count;
+	}
+	closedir(dir);
+
+	return count;
+}
+
+void BlockIo::getDiskCounter(char *const buf, const int size, const Disk &disk, const bool write) {
+	// readDisks only accepts names that fit, the precision tells the compiler so
+	snprintf(buf, size, "Linux_block_disk_%.*s_%s", (int)sizeof(disk.name) - 1, disk.name, write ? "wr" : "rd");
+}
+
+void BlockIo::writeEvents(mxml_node_t *root) {
+	Disk disks[MAX_DISKS];
+	const int count = readDisks(disks, ARRAY_LENGTH(disks));
+	if (count <= 0) {
+		return;
+	}
+
+	root = mxmlNewElement(root, "category");
+	mxmlElementSetAttr(root, "name", "Linux Disks");
+
+	char buf[128];
+	for (int i = 0; i < count; ++i) {
+		for (int write = 0; write < 2; ++write) {
+			mxml_node_t *node = mxmlNewElement(root, "event");
+			getDiskCounter(buf, sizeof(buf), disks[i], write);
+			mxmlElementSetAttr(node, "counter", buf);
+			mxmlElementSetAttrf(node, "title", "Disk IO %s", disks[i].name);
+			mxmlElementSetAttr(node, "name", write ? "Write" : "Read");
+			mxmlElementSetAttr(node, "units", "B");
+			mxmlElementSetAttrf(node, "description", "Bytes %s %s, computed by gatord in perf mode", write ? "written to" : "read from", disks[i].name);
+		}
+	}
+}
+
+bool BlockIo::init(PerfAnalytics *const analytics) {
+	bool enabled = false;
+	for (int i = 0; i < BUCKET_COUNT; ++i) {
+		mLatencyKeys[i] = gSessionData->perf.getEnabledKey(LATENCY_COUNTERS[i]);
+		enabled = enabled || mLatencyKeys[i] >= 0;
+	}
+	for (int write = 0; write < 2; ++write) {
+		mTotalKeys[write] = gSessionData->perf.getEnabledKey(TOTAL_COUNTERS[write]);
+		enabled = enabled || mTotalKeys[write] >= 0;
+	}
+
+	Disk disks[MAX_DISKS];
+	const int count = readDisks(disks, ARRAY_LENGTH(disks));
+	char buf[128];
+	mDiskCount = 0;
+	for (int i = 0; i < count; ++i) {
+		DiskCounters *const disk = &mDisks[mDiskCount];
+		bool diskEnabled = false;
+		for (int write = 0; write < 2; ++write) {
+			getDiskCounter(buf, sizeof(buf), disks[i], write);
+			disk->keys[write] = gSessionData->perf.getEnabledKey(buf);
+			disk->bytes[write] = 0;
+			diskEnabled = diskEnabled || disk->keys[write] >= 0;
+		}
+		if (diskEnabled) {
+			disk->dev = disks[i].dev;
+			++mDiskCount;
+		}
+	}
+	if (!enabled && mDiskCount == 0) {
+		return false;
+	}
+
+	DynBuf format;
+	if ((mIssue = analytics->addTracepoint(BLOCK_RQ_ISSUE, this, &format)) < 0
+			|| !PerfAnalytics::getField(format.getBuf(), "dev", &mIssueDev.offset, &mIssueDev.size)
+			|| !PerfAnalytics::getField(format.getBuf(), "sector", &mIssueSector.offset, &mIssueSector.size)
+			|| !PerfAnalytics::getField(format.getBuf(), "nr_sector", &mIssueNrSector.offset, &mIssueNrSector.size)
+			|| !PerfAnalytics::getField(format.getBuf(), "rwbs", &mIssueRwbs.offset, &mIssueRwbs.size)
+			|| analytics->addTracepoint(BLOCK_RQ_COMPLETE, this, &format) < 0
+			|| !PerfAnalytics::getField(format.getBuf(), "dev", &mCompleteDev.offset, &mCompleteDev.size)
+			|| !PerfAnalytics::getField(format.getBuf(), "sector", &mCompleteSector.offset, &mCompleteSector.size)) {
+		logg->logMessage("%s(%s:%i): Unable to add the block tracepoints", __FUNCTION__, __FILE__, __LINE__);
+		return false;
+	}
+
+	return true;
+}
+
+int BlockIo::getBucket(const uint64_t delta) {
+	uint64_t limit = 100*NS_PER_US;
+	int bucket = 0;
+	while (bucket < BUCKET_COUNT - 1 && delta >= limit) {
+		limit *= 10;
+		++bucket;
+	}
+	return bucket;
+}
+
+uint64_t BlockIo::getRequestKey(const uint32_t dev, const uint64_t sector) {
+	// Sectors fit in 40 bits for disks up to 512TB
+	return ((uint64_t)dev << 40) ^ sector;
+}
+
+void BlockIo::sample(const int, const uint64_t time, const int tracepoint, const char *const raw, const int size) {
+	if (time > mTime) {
+		mTime = time;
+	}
+
+	if (tracepoint == mIssue) {
+		const uint32_t dev = PerfAnalytics::readField(raw, size, mIssueDev.offset, mIssueDev.size);
+		const uint64_t sector = PerfAnalytics::readField(raw, size, mIssueSector.offset, mIssueSector.size);
+		if (mIssueRwbs.offset < 0 || mIssueRwbs.offset + mIssueRwbs.size > size) {
+			return;
+		}
+		// rwbs is a string like 'WS' or 'FWFS', requests that neither read nor write, like flushes and discards, are not counted
+		const char *const rwbs = raw + mIssueRwbs.offset;
+		const bool write = memchr(rwbs, 'W', mIssueRwbs.size) != NULL;
+		if (!write && memchr(rwbs, 'R', mIssueRwbs.size) == NULL) {
+			return;
+		}
+
+		Request *const request = mRequests.get(getRequestKey(dev, sector));
+		request->issueTime = time;
+		request->bytes = PerfAnalytics::readField(raw, size, mIssueNrSector.offset, mIssueNrSector.size) * SECTOR_SIZE;
+		request->write = write;
+		request->disk = -1;
+		for (int i = 0; i < mDiskCount; ++i) {
+			if (mDisks[i].dev == dev) {
+				request->disk = i;
+				break;
+			}
+		}
+		return;
+	}
+
+	// block_rq_complete, may be called more than once for a partially completed request but only the first has the sector it was issued with
+	const uint64_t key = getRequestKey(PerfAnalytics::readField(raw, size, mCompleteDev.offset, mCompleteDev.size), PerfAnalytics::readField(raw, size, mCompleteSector.offset, mCompleteSector.size));
+	const Request *const request = mRequests.find(key);
+	if (request == NULL) {
+		return;
+	}
+
+	if (time >= request->issueTime) {
+		++mLatency[getBucket(time - request->issueTime)];
+	}
+	mTotalBytes[request->write] += request->bytes;
+	if (request->disk >= 0) {
+		mDisks[request->disk].bytes[request->write] += request->bytes;
+	}
+	mRequests.remove(key);
+}
+
+void BlockIo::flush(Buffer *const buffer) {
+	for (int write = 0; write < 2; ++write) {
+		if (mTotalKeys[write] >= 0 && mTotalBytes[write] != 0) {
+			buffer->event64(mTotalKeys[write], mTotalBytes[write]);
+		}
+		mTotalBytes[write] = 0;
+
+		for (int i = 0; i < mDiskCount; ++i) {
+			if (mDisks[i].keys[write] >= 0 && mDisks[i].bytes[write] != 0) {
+				buffer->event64(mDisks[i].keys[write], mDisks[i].bytes[write]);
+			}
+			mDisks[i].bytes[write] = 0;
+		}
+	}
+
+	for (int bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+		if (mLatencyKeys[bucket] >= 0 && mLatency[bucket] != 0) {
+			buffer->event64(mLatencyKeys[bucket], mLatency[bucket]);
+		}
+		mLatency[bucket] = 0;
+	}
+
+	// Removing may shift another entry into this slot so look at it again
+	for (int i = 0; i < mRequests.getCapacity(); ++i) {
+		if (mRequests.isUsed(i) && mTime > mRequests.getValue(i)->issueTime + REQUEST_TIMEOUT_S * NS_PER_S) {
+			mRequests.remove(mRequests.getKey(i));
+			--i;
+		}
+	}
+}
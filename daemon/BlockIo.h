@@ -0,0 +1,95 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef BLOCKIO_H
+#define BLOCKIO_H
+
+#include <stdint.h>
+
+#include "HashMap.h"
+#include "PerfAnalytics.h"
+#include "mxml/mxml.h"
+
+#define BLOCK_RQ_ISSUE "block/block_rq_issue"
+#define BLOCK_RQ_COMPLETE "block/block_rq_complete"
+
+// Matches block_rq_issue with block_rq_complete to count the bytes read and written, in total and per disk, and a histogram of the request latencies
+class BlockIo : public PerfAnalyzer {
+public:
+	BlockIo();
+
+	// Returns false if none of the counters are enabled or the tracepoints are not available
+	bool init(PerfAnalytics *const analytics);
+
+	void sample(const int cpu, const uint64_t time, const int tracepoint, const char *const raw, const int size);
+	void flush(Buffer *const buffer);
+
+	static const char *const LATENCY_COUNTERS[];
+	static const int BUCKET_COUNT = 5;
+	static const int MAX_DISKS = 32;
+	// Requests that have not completed after this long are forgotten, they were merged, cancelled or are still in flight when the capture stops
+	static const int REQUEST_TIMEOUT_S = 10;
+
+	struct Disk {
+		char name[32];
+		// Kernel dev_t
+		uint32_t dev;
+	};
+
+	// Lists the disks in /sys/block that have media, returns the number of disks
+	static int readDisks(Disk *const disks, const int max);
+	// Writes the name of the per disk counter, write is false for reads
+	static void getDiskCounter(char *const buf, const int size, const Disk &disk, const bool write);
+	// Adds the per disk events
+	static void writeEvents(mxml_node_t *root);
+
+private:
+	struct Field {
+		int offset;
+		int size;
+	};
+
+	struct Request {
+		uint64_t issueTime;
+		int64_t bytes;
+		int disk;
+		bool write;
+	};
+
+	struct DiskCounters {
+		uint32_t dev;
+		int keys[2];
+		int64_t bytes[2];
+	};
+
+	static int getBucket(const uint64_t delta);
+	static uint64_t getRequestKey(const uint32_t dev, const uint64_t sector);
+
+	HashMap<Request> mRequests;
+	// Time of the latest sample
+	uint64_t mTime;
+	DiskCounters mDisks[MAX_DISKS];
+	int mDiskCount;
+	int mTotalKeys[2];
+	int64_t mTotalBytes[2];
+	int mLatencyKeys[BUCKET_COUNT];
+	int64_t mLatency[BUCKET_COUNT];
+	int mIssue;
+	Field mIssueDev;
+	Field mIssueSector;
+	Field mIssueNrSector;
+	Field mIssueRwbs;
+	Field mCompleteDev;
+	Field mCompleteSector;
+
+	// Intentionally unimplemented
+	BlockIo(const BlockIo &);
+	BlockIo &operator=(const BlockIo &);
+};
+
+#endif // BLOCKIO_H
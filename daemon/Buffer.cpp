@@ -8,9 +8,15 @@
 
 #include "Buffer.h"
 
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+
 #include "Logging.h"
+#include "MirroredMemory.h"
 #include "Sender.h"
 #include "SessionData.h"
+#include "StringTable.h"
 
 #define mask (mSize - 1)
 
@@ -21,6 +27,17 @@ enum {
 	CODE_MAPS     = 4,
 	CODE_COMM     = 5,
 	CODE_KEYS_OLD = 6,
+	CODE_STRING   = 7,
+	CODE_COMM_ID  = 8,
+	CODE_MAPS_ID  = 9,
+};
+
+// Permission flags of a CODE_MAPS_ID mapping
+enum {
+	MAPS_READ   = 1 << 0,
+	MAPS_WRITE  = 1 << 1,
+	MAPS_EXEC   = 1 << 2,
+	MAPS_SHARED = 1 << 3,
 };
 
 // Summary Frame Messages
@@ -29,6 +46,11 @@ enum {
 	MESSAGE_CORE_NAME = 3,
 };
 
+// Compact Block Counter Frame keys, see compactEvent
+enum {
+	COMPACT_KEY_RUN = -1,
+};
+
 // From gator_marshaling.c
 #define NEWLINE_CANARY \
 	/* Unix */ \
@@ -42,7 +64,27 @@ enum {
 	/* Add another character so the length isn't 0x0a bytes */ \
 	"5"
 
-Buffer::Buffer(const int32_t core, const int32_t buftype, const int size, sem_t *const readerSem) : mCore(core), mBufType(buftype), mSize(size), mReadPos(0), mWritePos(0), mCommitPos(0), mAvailable(true), mIsDone(false), mBuf(new char[mSize]), mCommitTime(gSessionData->mLiveRate), mReaderSem(readerSem) {
+// Interned strings of the whole capture, shared by the buffers of every thread
+static StringTable gStrings;
+static pthread_mutex_t gStringsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// The ring must be at least a page so that it can be mirrored
+static int ringSize(const int size) {
+	const int pageSize = sysconf(_SC_PAGESIZE);
+	return size < pageSize ? pageSize : size;
+}
+
+static char *ringMap(const int size) {
+	size_t mappedSize = size;
+	char *const buf = mirroredMap(&mappedSize);
+	if (buf == NULL || mappedSize != (size_t)size) {
+		logg->logError(__FILE__, __LINE__, "Unable to map a %d byte ring buffer", size);
+		handleException();
+	}
+	return buf;
+}
+
+Buffer::Buffer(const int32_t core, const int32_t buftype, const int size, sem_t *const readerSem) : mCore(core), mBufType(buftype), mSize(ringSize(size)), mReadPos(0), mWritePos(0), mCommitPos(0), mAvailable(true), mIsDone(false), mBuf(ringMap(mSize)), mCommitTime(gSessionData->mLiveRate), mReaderSem(readerSem), mSentStrings(), mCompact(buftype == FRAME_BLOCK_COUNTER && gSessionData->mCompactCounters) {
 	if ((mSize & mask) != 0) {
 		logg->logError(__FILE__, __LINE__, "Buffer size is not a power of 2");
 		handleException();
@@ -51,7 +93,7 @@ Buffer::Buffer(const int32_t core, const int32_t buftype, const int size, sem_t
 }
 
 Buffer::~Buffer() {
-	delete [] mBuf;
+	mirroredUnmap(mBuf, mSize);
 }
 
 void Buffer::write(Sender *const sender) {
@@ -59,27 +101,12 @@ void Buffer::write(Sender *const sender) {
 		return;
 	}
 
-	// determine the size of two halves
-	int length1 = mCommitPos - mReadPos;
-	char *buffer1 = mBuf + mReadPos;
-	int length2 = 0;
-	char *buffer2 = mBuf;
-	if (length1 < 0) {
-		length1 = mSize - mReadPos;
-		length2 = mCommitPos;
-	}
+	// mBuf is mirrored so the committed data is contiguous even if it wraps
+	const int length = (mCommitPos - mReadPos) & mask;
 
-	logg->logMessage("Sending data length1: %i length2: %i", length1, length2);
+	logg->logMessage("Sending data length: %i", length);
 
-	// start, middle or end
-	if (length1 > 0) {
-		sender->writeData(buffer1, length1, RESPONSE_APC_DATA);
-	}
-
-	// possible wrap around
-	if (length2 > 0) {
-		sender->writeData(buffer2, length2, RESPONSE_APC_DATA);
-	}
+	sender->writeData(mBuf + mReadPos, length, RESPONSE_APC_DATA);
 
 	mReadPos = mCommitPos;
 }
@@ -120,16 +147,15 @@ bool Buffer::checkSpace(const int bytes) {
 }
 
 int Buffer::contiguousSpaceAvailable() const {
-	int remaining = bytesAvailable();
-	int contiguous = mSize - mWritePos;
-	if (remaining < contiguous) {
-		return remaining;
-	} else {
-		return contiguous;
-	}
+	// mBuf is mirrored so all the available space is contiguous
+	return bytesAvailable();
 }
 
 void Buffer::commit(const uint64_t time) {
+	if (mCompact) {
+		compactFlushRun();
+	}
+
 	// post-populate the length, which does not include the response type length nor the length itself, i.e. only the length of the payload
 	const int typeLength = gSessionData->mLocalCapture ? 0 : 1;
 	int length = mWritePos - mCommitPos;
@@ -137,9 +163,7 @@ void Buffer::commit(const uint64_t time) {
 		length += mSize;
 	}
 	length = length - typeLength - sizeof(int32_t);
-	for (size_t byte = 0; byte < sizeof(int32_t); byte++) {
-		mBuf[(mCommitPos + typeLength + byte) & mask] = (length >> byte * 8) & 0xFF;
-	}
+	writeLEInt((unsigned char *)mBuf + mCommitPos + typeLength, length);
 
 	logg->logMessage("Committing data mReadPos: %i mWritePos: %i mCommitPos: %i", mReadPos, mWritePos, mCommitPos);
 	mCommitPos = mWritePos;
@@ -189,11 +213,34 @@ void Buffer::packInt(char *const buf, const int size, int &writePos, int32_t x)
 	writePos = (writePos + packedBytes) & /*mask*/(size - 1);
 }
 
+// The mBuf members below pack without masking each byte as mBuf is mirrored
 void Buffer::packInt(int32_t x) {
-	packInt(mBuf, mSize, mWritePos, x);
+	char *const buf = mBuf + mWritePos;
+	int packedBytes = 0;
+	int more = true;
+	while (more) {
+		// low order 7 bits of x
+		char b = x & 0x7f;
+		x >>= 7;
+
+		if ((x == 0 && (b & 0x40) == 0) || (x == -1 && (b & 0x40) != 0)) {
+			more = false;
+		} else {
+			b |= 0x80;
+		}
+
+		buf[packedBytes] = b;
+		packedBytes++;
+	}
+
+	mWritePos = (mWritePos + packedBytes) & mask;
 }
 
 void Buffer::packInt64(int64_t x) {
+	mWritePos = (mWritePos + packInt64(mBuf + mWritePos, x)) & mask;
+}
+
+int Buffer::packInt64(char *const buf, int64_t x) {
 	int packedBytes = 0;
 	int more = true;
 	while (more) {
@@ -207,20 +254,16 @@ void Buffer::packInt64(int64_t x) {
 			b |= 0x80;
 		}
 
-		mBuf[(mWritePos + packedBytes) & mask] = b;
+		buf[packedBytes] = b;
 		packedBytes++;
 	}
 
-	mWritePos = (mWritePos + packedBytes) & mask;
+	return packedBytes;
 }
 
 void Buffer::writeBytes(const void *const data, size_t count) {
-	size_t i;
-	for (i = 0; i < count; ++i) {
-		mBuf[(mWritePos + i) & mask] = static_cast<const char *>(data)[i];
-	}
-
-	mWritePos = (mWritePos + i) & mask;
+	memcpy(mBuf + mWritePos, data, count);
+	mWritePos = (mWritePos + count) & mask;
 }
 
 void Buffer::writeString(const char *const str) {
@@ -234,9 +277,65 @@ void Buffer::frame() {
 		packInt(RESPONSE_APC_DATA);
 	}
 	// Reserve space for the length
-	mWritePos += sizeof(int32_t);
-	packInt(mBufType);
+	mWritePos = (mWritePos + sizeof(int32_t)) & mask;
+	packInt(mCompact ? FRAME_BLOCK_COUNTER_COMPACT : mBufType);
 	packInt(mCore);
+
+	if (mCompact) {
+		compactReset();
+	}
+}
+
+// A compact block counter frame contains the same (key, value) records as a block counter frame with the following changes
+// - The timestamp (key 0) is the delta from the previous timestamp in the frame, or from zero for the first timestamp
+// - The records following a timestamp are compared to the records following the previous timestamp at the same position.
+//   If the keys match, the value is the delta from the previous value, otherwise it is the absolute value
+// - A run of records identical to the previous records at the same position are replaced with (COMPACT_KEY_RUN, length)
+void Buffer::compactReset() {
+	mCompactTime = 0;
+	mCompactRun = 0;
+	mCompactPrevCount = 0;
+	mCompactCurrCount = 0;
+}
+
+void Buffer::compactFlushRun() {
+	if (mCompactRun > 0) {
+		packInt(COMPACT_KEY_RUN);
+		packInt(mCompactRun);
+		mCompactRun = 0;
+	}
+}
+
+void Buffer::compactTimestamp(const uint64_t time) {
+	compactFlushRun();
+	packInt(0);
+	packInt64(time - mCompactTime);
+	mCompactTime = time;
+
+	const int count = mCompactCurrCount < MAX_COMPACT_RECORDS ? mCompactCurrCount : MAX_COMPACT_RECORDS;
+	memcpy(mCompactPrevKeys, mCompactCurrKeys, count * sizeof(mCompactPrevKeys[0]));
+	memcpy(mCompactPrevValues, mCompactCurrValues, count * sizeof(mCompactPrevValues[0]));
+	mCompactPrevCount = count;
+	mCompactCurrCount = 0;
+}
+
+void Buffer::compactEvent(const int32_t key, const int64_t value) {
+	const int pos = mCompactCurrCount++;
+	const bool keyMatches = pos < mCompactPrevCount && mCompactPrevKeys[pos] == key;
+
+	if (pos < MAX_COMPACT_RECORDS) {
+		mCompactCurrKeys[pos] = key;
+		mCompactCurrValues[pos] = value;
+	}
+
+	if (keyMatches && mCompactPrevValues[pos] == value) {
+		++mCompactRun;
+		return;
+	}
+
+	compactFlushRun();
+	packInt(key);
+	packInt64(keyMatches ? value - mCompactPrevValues[pos] : value);
 }
 
 void Buffer::summary(const int64_t timestamp, const int64_t uptime, const int64_t monotonicDelta, const char *const uname) {
@@ -263,7 +362,12 @@ void Buffer::coreName(const int core, const int cpuid, const char *const name) {
 
 bool Buffer::eventHeader(const uint64_t curr_time) {
 	bool retval = false;
-	if (checkSpace(MAXSIZE_PACK32 + MAXSIZE_PACK64)) {
+	if (mCompact) {
+		if (checkSpace(3 * MAXSIZE_PACK32 + MAXSIZE_PACK64)) {
+			compactTimestamp(curr_time);
+			retval = true;
+		}
+	} else if (checkSpace(MAXSIZE_PACK32 + MAXSIZE_PACK64)) {
 		packInt(0);	// key of zero indicates a timestamp
 		packInt64(curr_time);
 		retval = true;
@@ -274,7 +378,12 @@ bool Buffer::eventHeader(const uint64_t curr_time) {
 
 bool Buffer::eventTid(const int tid) {
 	bool retval = false;
-	if (checkSpace(2 * MAXSIZE_PACK32)) {
+	if (mCompact) {
+		if (checkSpace(3 * MAXSIZE_PACK32 + MAXSIZE_PACK64)) {
+			compactEvent(1, tid);
+			retval = true;
+		}
+	} else if (checkSpace(2 * MAXSIZE_PACK32)) {
 		packInt(1);	// key of 1 indicates a tid
 		packInt(tid);
 		retval = true;
@@ -284,14 +393,27 @@ bool Buffer::eventTid(const int tid) {
 }
 
 void Buffer::event(const int32_t key, const int32_t value) {
-	if (checkSpace(2 * MAXSIZE_PACK32)) {
+	if (mCompact) {
+		if (checkSpace(3 * MAXSIZE_PACK32 + MAXSIZE_PACK64)) {
+			compactEvent(key, value);
+		}
+	} else if (checkSpace(2 * MAXSIZE_PACK32)) {
 		packInt(key);
 		packInt(value);
 	}
 }
 
 void Buffer::event64(const int64_t key, const int64_t value) {
-	if (checkSpace(2 * MAXSIZE_PACK64)) {
+	if (mCompact) {
+		// Compact records are compared and decoded with 32 bit keys, and COMPACT_KEY_RUN marks a run
+		if (key != (int32_t)key || key == COMPACT_KEY_RUN) {
+			logg->logMessage("%s(%s:%i): key %lld can not be written to a compact block counter frame", __FUNCTION__, __FILE__, __LINE__, (long long)key);
+			return;
+		}
+		if (checkSpace(3 * MAXSIZE_PACK32 + MAXSIZE_PACK64)) {
+			compactEvent(key, value);
+		}
+	} else if (checkSpace(2 * MAXSIZE_PACK64)) {
 		packInt64(key);
 		packInt64(value);
 	}
@@ -351,7 +473,110 @@ void Buffer::format(const int length, const char *const format) {
 	check(1);
 }
 
+// Returns the id of str, sending it first if this buffer has not sent it before. The ids are shared by every buffer so that an id is the same string throughout the capture,
+// but as the frames of different buffers are not ordered each buffer defines an id before it first uses it
+int Buffer::internString(const char *const str) {
+	bool isNew;
+	pthread_mutex_lock(&gStringsMutex);
+	const int id = gStrings.intern(str, &isNew);
+	pthread_mutex_unlock(&gStringsMutex);
+
+	bool *const sent = id == 0 ? NULL : mSentStrings.get(id);
+	if (sent != NULL && !*sent) {
+		*sent = true;
+		const int strLen = strlen(str) + 1;
+		if (checkSpace(2 * MAXSIZE_PACK32 + strLen)) {
+			packInt(CODE_STRING);
+			packInt(id);
+			writeBytes(str, strLen);
+		} else {
+			logg->logError(__FILE__, __LINE__, "Ran out of buffer space for perf attrs");
+			handleException();
+		}
+	}
+
+	return id;
+}
+
+// Sends /proc/[pid]/maps as (start, end, offset, flags, path id) for each mapping instead of as text
+void Buffer::mapsInterned(const int pid, const int tid, const char *const maps) {
+	struct Mapping {
+		unsigned long long start;
+		unsigned long long end;
+		unsigned long long offset;
+		int flags;
+		int pathId;
+	};
+
+	int lines = 1;
+	for (const char *c = maps; *c != '\0'; ++c) {
+		if (*c == '\n') {
+			++lines;
+		}
+	}
+
+	Mapping *const mappings = (Mapping *)malloc(lines * sizeof(Mapping));
+	if (mappings == NULL) {
+		logg->logError(__FILE__, __LINE__, "malloc failed");
+		handleException();
+	}
+
+	// Intern the paths first as the strings must precede the message that references them
+	int count = 0;
+	for (const char *line = maps; *line != '\0'; ) {
+		const char *eol = strchr(line, '\n');
+		if (eol == NULL) {
+			eol = line + strlen(line);
+		}
+		char perms[5];
+		int pathPos;
+		Mapping *const mapping = &mappings[count];
+		if (sscanf(line, "%llx-%llx %4s %llx %*s %*s %n", &mapping->start, &mapping->end, perms, &mapping->offset, &pathPos) >= 4) {
+			char path[PATH_MAX];
+			int pathLen = 0;
+			if (line + pathPos < eol) {
+				pathLen = eol - (line + pathPos);
+				if (pathLen > (int)sizeof(path) - 1) {
+					pathLen = sizeof(path) - 1;
+				}
+				memcpy(path, line + pathPos, pathLen);
+			}
+			path[pathLen] = '\0';
+
+			mapping->flags = (perms[0] == 'r' ? MAPS_READ : 0) | (perms[1] == 'w' ? MAPS_WRITE : 0) | (perms[2] == 'x' ? MAPS_EXEC : 0) | (perms[3] == 's' ? MAPS_SHARED : 0);
+			mapping->pathId = internString(path);
+			++count;
+		}
+		line = *eol == '\0' ? eol : eol + 1;
+	}
+
+	if (checkSpace(4 * MAXSIZE_PACK32 + count * (3 * MAXSIZE_PACK64 + 2 * MAXSIZE_PACK32))) {
+		packInt(CODE_MAPS_ID);
+		packInt(pid);
+		packInt(tid);
+		packInt(count);
+		for (int i = 0; i < count; ++i) {
+			packInt64(mappings[i].start);
+			packInt64(mappings[i].end);
+			packInt64(mappings[i].offset);
+			packInt(mappings[i].flags);
+			packInt(mappings[i].pathId);
+		}
+	} else {
+		logg->logError(__FILE__, __LINE__, "Ran out of buffer space for perf attrs");
+		handleException();
+	}
+
+	free(mappings);
+	check(1);
+}
+
 void Buffer::maps(const int pid, const int tid, const char *const maps) {
+	if (gSessionData->mInternStrings) {
+		mapsInterned(pid, tid, maps);
+		return;
+	}
+
 	const int mapsLen = strlen(maps) + 1;
 	if (checkSpace(3 * MAXSIZE_PACK32 + mapsLen)) {
 		packInt(CODE_MAPS);
@@ -366,6 +591,23 @@ void Buffer::maps(const int pid, const int tid, const char *const maps) {
 }
 
 void Buffer::comm(const int pid, const int tid, const char *const image, const char *const comm) {
+	if (gSessionData->mInternStrings) {
+		const int imageId = internString(image);
+		const int commId = internString(comm);
+		if (checkSpace(5 * MAXSIZE_PACK32)) {
+			packInt(CODE_COMM_ID);
+			packInt(pid);
+			packInt(tid);
+			packInt(imageId);
+			packInt(commId);
+		} else {
+			logg->logError(__FILE__, __LINE__, "Ran out of buffer space for perf attrs");
+			handleException();
+		}
+		check(1);
+		return;
+	}
+
 	const int imageLen = strlen(image) + 1;
 	const int commLen = strlen(comm) + 1;
 	if (checkSpace(3 * MAXSIZE_PACK32 + imageLen + commLen)) {
@@ -12,6 +12,7 @@
 #include <stdint.h>
 #include <semaphore.h>
 
+#include "HashMap.h"
 #include "k/perf_event.h"
 
 class Sender;
@@ -22,6 +23,7 @@ enum {
 	FRAME_EXTERNAL      = 10,
 	FRAME_PERF_ATTRS    = 11,
 	FRAME_PERF          = 12,
+	FRAME_BLOCK_COUNTER_COMPACT = 14,
 };
 
 class Buffer {
@@ -49,6 +51,7 @@ public:
 	bool eventHeader(uint64_t curr_time);
 	bool eventTid(int tid);
 	void event(int32_t key, int32_t value);
+	// Compact frames only have 32 bit keys, a record with a wider key is dropped
 	void event64(int64_t key, int64_t value);
 
 	// Perf Attrs messages
@@ -68,6 +71,8 @@ public:
 	static void packInt(char *const buf, const int size, int &writePos, int32_t x);
 	void packInt(int32_t x);
 	void packInt64(int64_t x);
+	// Packs x into buf, which must have room for MAXSIZE_PACK64 bytes, and returns the number of bytes used. Decode with varintDecode from Varint.h
+	static int packInt64(char *const buf, int64_t x);
 	void writeBytes(const void *const data, size_t count);
 	void writeString(const char *const str);
 
@@ -79,8 +84,18 @@ public:
 	}
 
 private:
+	// Maximum number of records per timestamp that can be suppressed or delta encoded in a compact block counter frame
+	// Must match COMPACT_MAX_RECORDS in the driver as decoders can not tell which side wrote a frame
+	static const int MAX_COMPACT_RECORDS = 128;
+
 	bool commitReady() const;
 	bool checkSpace(int bytes);
+	void compactReset();
+	void compactTimestamp(uint64_t time);
+	void compactEvent(int32_t key, int64_t value);
+	void compactFlushRun();
+	int internString(const char *const str);
+	void mapsInterned(const int pid, const int tid, const char *const maps);
 
 	const int32_t mCore;
 	const int32_t mBufType;
@@ -93,6 +108,19 @@ private:
 	char *const mBuf;
 	uint64_t mCommitTime;
 	sem_t *const mReaderSem;
+	// Ids of the interned strings this buffer has sent, used when gSessionData->mInternStrings is set
+	HashMap<bool> mSentStrings;
+
+	// Compact block counter state, reset at the start of every frame so that frames can be decoded independently
+	const bool mCompact;
+	uint64_t mCompactTime;
+	int mCompactRun;
+	int mCompactPrevCount;
+	int mCompactCurrCount;
+	int32_t mCompactPrevKeys[MAX_COMPACT_RECORDS];
+	int64_t mCompactPrevValues[MAX_COMPACT_RECORDS];
+	int32_t mCompactCurrKeys[MAX_COMPACT_RECORDS];
+	int64_t mCompactCurrValues[MAX_COMPACT_RECORDS];
 
 	// Intentionally unimplemented
 	Buffer(const Buffer &);
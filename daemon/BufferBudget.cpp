@@ -0,0 +1,169 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "BufferBudget.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "Buffer.h"
+#include "Logging.h"
+#include "SessionData.h"
+
+// Rough number of bytes per perf record, sched_switch records are the largest
+#define PERF_RECORD_BYTES 64
+// Rough number of context switches per second per CPU
+#define SCHED_SWITCH_RATE 1000
+// UserSpaceSource samples ten times a second
+#define USER_SPACE_RATE 10
+#define MIN_USER_SPACE_SIZE (64 * 1024)
+// The bytes sent by each CPU are scaled so that they total at most this, keeping the weights small enough to multiply without overflow
+#define MAX_WEIGHT (1 << 20)
+
+// Returns the largest power of 2 no greater than x, at least 1 and at most 1 << 30 so that it fits in an int
+static uint64_t floorPow2(const uint64_t x) {
+	uint64_t pow2 = 1;
+	while (pow2 <= (x >> 1) && pow2 < (1 << 30)) {
+		pow2 <<= 1;
+	}
+	return pow2;
+}
+
+BufferBudget::BufferBudget() : mUserSpaceSize(0) {
+	mHistory = (History *)mmap(NULL, sizeof(*mHistory), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (mHistory == MAP_FAILED) {
+		logg->logError(__FILE__, __LINE__, "Unable to mmap shared memory for the buffer history");
+		handleException();
+	}
+	memset(mHistory, 0, sizeof(*mHistory));
+	memset(mPerfRingSize, 0, sizeof(mPerfRingSize));
+}
+
+BufferBudget::~BufferBudget() {
+	munmap(mHistory, sizeof(*mHistory));
+}
+
+// Returns the number of bytes of perf rings that can be mapped, or -1 if there is no limit
+int BufferBudget::perfMlockLimit() const {
+	// Without CAP_IPC_LOCK the perf rings of a user are limited to perf_event_mlock_kb per online CPU, approximate CAP_IPC_LOCK with root
+	if (geteuid() == 0) {
+		return -1;
+	}
+
+	FILE *const fh = fopen("/proc/sys/kernel/perf_event_mlock_kb", "r");
+	if (fh == NULL) {
+		return -1;
+	}
+	int kb;
+	const bool read = fscanf(fh, "%i", &kb) == 1;
+	fclose(fh);
+	if (!read || kb <= 0) {
+		return -1;
+	}
+
+	return kb * 1024;
+}
+
+void BufferBudget::calculate() {
+	const int pageSize = sysconf(_SC_PAGESIZE);
+	const int cores = gSessionData->mCores < NR_CPUS ? gSessionData->mCores : NR_CPUS;
+	const uint64_t budget = (uint64_t)gSessionData->mTotalBufferSize * 1024 * 1024;
+
+	// Expected data rates in bytes per second
+	int userCounters = 0;
+	for (int i = 0; i < MAX_PERFORMANCE_COUNTERS; ++i) {
+		const Counter &counter = gSessionData->mCounters[i];
+		if (counter.isEnabled() && (counter.getDriver() == &gSessionData->hwmon || counter.getDriver() == &gSessionData->fsDriver)) {
+			++userCounters;
+		}
+	}
+	// Add one for the timestamp
+	const uint64_t userRate = (uint64_t)(userCounters + 1) * (Buffer::MAXSIZE_PACK32 + Buffer::MAXSIZE_PACK64) * USER_SPACE_RATE;
+	const uint64_t perfRate = (uint64_t)cores * (gSessionData->mSampleRate + SCHED_SWITCH_RATE) * PERF_RECORD_BYTES;
+
+	uint64_t userSize = budget * userRate / (userRate + perfRate);
+	if (userSize < budget / 64) {
+		userSize = budget / 64;
+	} else if (userSize > budget / 2) {
+		userSize = budget / 2;
+	}
+	// Buffer requires a power of 2
+	uint64_t userSpaceSize = floorPow2(userSize);
+	if (userSpaceSize < userSize && userSpaceSize < (1 << 30)) {
+		userSpaceSize <<= 1;
+	}
+	mUserSpaceSize = (int)userSpaceSize;
+	if (mUserSpaceSize < MIN_USER_SPACE_SIZE) {
+		mUserSpaceSize = MIN_USER_SPACE_SIZE;
+	}
+
+	uint64_t perfBudget = budget > (uint64_t)mUserSpaceSize ? budget - mUserSpaceSize : budget / 2;
+	const int mlockLimit = perfMlockLimit();
+	if (mlockLimit >= 0) {
+		// Each ring also maps a header page
+		const uint64_t limit = mlockLimit > pageSize ? (uint64_t)(mlockLimit - pageSize) * cores : 0;
+		if (perfBudget > limit) {
+			logg->logMessage("%s(%s:%i): Limiting perf rings to %lli bytes by perf_event_mlock_kb", __FUNCTION__, __FILE__, __LINE__, (long long)limit);
+			perfBudget = limit;
+		}
+	}
+
+	// Weight the CPUs by the data they sent last session, giving every CPU at least a quarter of an even share and doubling the weight of those that overflowed.
+	// History of many GB is scaled down and the budget is divided before multiplying so that nothing overflows
+	uint64_t total = 0;
+	for (int cpu = 0; cpu < cores; ++cpu) {
+		total += mHistory->mBytes[cpu];
+	}
+	const uint64_t unit = total / MAX_WEIGHT + 1;
+	uint64_t weights[NR_CPUS];
+	uint64_t weightSum = 0;
+	for (int cpu = 0; cpu < cores; ++cpu) {
+		weights[cpu] = 1;
+		if (total > 0) {
+			const uint64_t bytes = mHistory->mBytes[cpu] / unit;
+			const uint64_t minWeight = total / unit / (4 * cores);
+			weights[cpu] = bytes > minWeight ? bytes : minWeight;
+			if (mHistory->mOverflows[cpu] > 0) {
+				weights[cpu] *= 2;
+			}
+			if (weights[cpu] == 0) {
+				weights[cpu] = 1;
+			}
+		}
+		weightSum += weights[cpu];
+	}
+
+	for (int cpu = 0; cpu < NR_CPUS; ++cpu) {
+		// perf requires a power of 2 number of pages
+		int size = pageSize;
+		if (cpu < cores) {
+			size = (int)floorPow2(perfBudget / weightSum * weights[cpu] + perfBudget % weightSum * weights[cpu] / weightSum);
+			if (size < pageSize) {
+				size = pageSize;
+			}
+		}
+		mPerfRingSize[cpu] = size;
+		if (cpu < cores) {
+			logg->logMessage("%s(%s:%i): cpu %i perf ring %i bytes (last session sent %lli bytes with %i overflows)", __FUNCTION__, __FILE__, __LINE__, cpu, size, (long long)mHistory->mBytes[cpu], mHistory->mOverflows[cpu]);
+		}
+	}
+	logg->logMessage("%s(%s:%i): user space buffer %i bytes", __FUNCTION__, __FILE__, __LINE__, mUserSpaceSize);
+
+	// Start collecting the history for the next session
+	memset(mHistory, 0, sizeof(*mHistory));
+}
+
+void BufferBudget::perfRingSent(const int cpu, const int bytes) {
+	mHistory->mBytes[cpu] += bytes;
+	// Treat a ring that was within a page of full as having overflowed
+	if (bytes >= mPerfRingSize[cpu] - gSessionData->mPageSize) {
+		++mHistory->mOverflows[cpu];
+	}
+}
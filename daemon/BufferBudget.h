@@ -0,0 +1,50 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef BUFFERBUDGET_H
+#define BUFFERBUDGET_H
+
+#include <stdint.h>
+
+#include "Config.h"
+
+// Divides gSessionData->mTotalBufferSize between the per CPU perf rings and the user space counter buffer by their expected data rates.
+// The perf rings are resized between sessions using the amount of data each CPU sent and whether its ring overflowed during the previous session
+class BufferBudget {
+public:
+	BufferBudget();
+	~BufferBudget();
+
+	// Must be called after the session xml is parsed and the counters are set up
+	void calculate();
+
+	int getPerfRingSize(const int cpu) const { return mPerfRingSize[cpu]; }
+	int getUserSpaceSize() const { return mUserSpaceSize; }
+
+	// Called by PerfBuffer after sending all the data in a ring, so bytes is also how full the ring was
+	void perfRingSent(const int cpu, const int bytes);
+
+private:
+	// Shared across all instances of gatord so that the next session can use it
+	struct History {
+		uint64_t mBytes[NR_CPUS];
+		int mOverflows[NR_CPUS];
+	};
+
+	int perfMlockLimit() const;
+
+	History *mHistory;
+	int mPerfRingSize[NR_CPUS];
+	int mUserSpaceSize;
+
+	// Intentionally unimplemented
+	BufferBudget(const BufferBudget &);
+	BufferBudget &operator=(const BufferBudget &);
+};
+
+#endif // BUFFERBUDGET_H
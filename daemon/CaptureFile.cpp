@@ -0,0 +1,207 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "CaptureFile.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <unistd.h>
+
+#include "Buffer.h"
+#include "CaptureIndex.h"
+#include "CaptureWriter.h"
+#include "Logging.h"
+#include "SessionData.h"
+
+// Frames that hold state needed to decode later frames, from gator_main.c
+enum {
+	STATE_FRAME_SUMMARY = FRAME_SUMMARY,
+	STATE_FRAME_NAME = 3,
+	STATE_FRAME_PERF_ATTRS = FRAME_PERF_ATTRS,
+};
+
+CaptureFile::CaptureFile(const char *const apcDir) : mApcDir(strdup(apcDir)), mSegmented(gSessionData->mSegmentSize > 0 || gSessionData->mSegmentDuration > 0), mWriter(NULL), mIndex(NULL), mSegment(0), mSegmentBytes(0), mSegmentStart(0), mHeaderLength(0), mFrameRemaining(0), mFrameIsState(false), mFrame(), mFrameOffset(0), mReplaying(false), mState(), mSegments(NULL), mSegmentCount(0), mSegmentCapacity(0), mFirstSegment(0), mRetiring(NULL), mRetiringIndex(NULL), mRetireThreadRunning(false) {
+	pthread_mutex_init(&mSegmentsMutex, NULL);
+	openSegment();
+}
+
+CaptureFile::~CaptureFile() {
+	if (mRetireThreadRunning) {
+		pthread_join(mRetireThreadID, NULL);
+	}
+	// Flushes and syncs the data file
+	delete mWriter;
+	delete mIndex;
+	free(mSegments);
+	free(mApcDir);
+	pthread_mutex_destroy(&mSegmentsMutex);
+}
+
+void CaptureFile::openSegment() {
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s/%010d", mApcDir, mSegment);
+	mWriter = new CaptureWriter();
+	if (!mWriter->open(path)) {
+		logg->logError(__FILE__, __LINE__, "Failed to open binary file: %s", path);
+		handleException();
+	}
+	mSegmentBytes = 0;
+	mSegmentStart = getTime();
+
+	snprintf(path, sizeof(path), "%s/%010d.idx", mApcDir, mSegment);
+	mIndex = new CaptureIndex(path);
+}
+
+void CaptureFile::emit(const char *const data, const int length) {
+	mWriter->write(data, length);
+	mSegmentBytes += length;
+	if (!mFrame.append(data, length)) {
+		logg->logError(__FILE__, __LINE__, "Unable to buffer a frame of the capture");
+		handleException();
+	}
+}
+
+void CaptureFile::write(const char *data, int length) {
+	while (length > 0) {
+		if (mFrameRemaining == 0) {
+			// Collect the length, frame type and core before deciding whether to start a new segment
+			while (mHeaderLength < FRAME_HEADER_SIZE && length > 0) {
+				mHeader[mHeaderLength++] = *data++;
+				--length;
+			}
+			if (mHeaderLength < FRAME_HEADER_SIZE) {
+				return;
+			}
+			mHeaderLength = 0;
+
+			if (mSegmented && !mReplaying && ((gSessionData->mSegmentSize > 0 && mSegmentBytes >= gSessionData->mSegmentSize) ||
+			    (gSessionData->mSegmentDuration > 0 && getTime() - mSegmentStart >= (uint64_t)gSessionData->mSegmentDuration))) {
+				rotate();
+			}
+
+			const int frameLength = (mHeader[0] & 0xFF) | (mHeader[1] & 0xFF) << 8 | (mHeader[2] & 0xFF) << 16 | (mHeader[3] & 0xFF) << 24;
+			// Frame types are packed ints less than 64 so they are always one byte
+			const int frameType = mHeader[4];
+			mFrameIsState = mSegmented && (frameType == STATE_FRAME_SUMMARY || frameType == STATE_FRAME_NAME || frameType == STATE_FRAME_PERF_ATTRS);
+			mFrame.clear();
+			mFrameOffset = mSegmentBytes;
+			mFrameRemaining = sizeof(int32_t) + frameLength - FRAME_HEADER_SIZE;
+			emit(mHeader, FRAME_HEADER_SIZE);
+		}
+
+		const int bytes = length < mFrameRemaining ? length : mFrameRemaining;
+		emit(data, bytes);
+		data += bytes;
+		length -= bytes;
+		mFrameRemaining -= bytes;
+
+		if (mFrameRemaining == 0) {
+			mIndex->add(mFrameOffset, mFrame.getBuf(), mFrame.getLength());
+			if (mFrameIsState && !mReplaying) {
+				// The state is kept without the frame length
+				mState.add(mFrame.getBuf() + sizeof(int32_t), mFrame.getLength() - sizeof(int32_t));
+			}
+		}
+	}
+}
+
+void CaptureFile::rotate() {
+	// Only one segment is closed at a time, this only waits if storage is slower than a segment
+	if (mRetireThreadRunning) {
+		pthread_join(mRetireThreadID, NULL);
+		mRetireThreadRunning = false;
+	}
+
+	pthread_mutex_lock(&mSegmentsMutex);
+	if (mSegmentCount >= mSegmentCapacity) {
+		mSegmentCapacity = mSegmentCapacity == 0 ? 64 : 2 * mSegmentCapacity;
+		mSegments = (Segment *)realloc(mSegments, mSegmentCapacity * sizeof(*mSegments));
+		if (mSegments == NULL) {
+			logg->logError(__FILE__, __LINE__, "realloc failed");
+			handleException();
+		}
+	}
+	mSegments[mSegmentCount].mBytes = mSegmentBytes;
+	mSegments[mSegmentCount].mEndTime = getTime();
+	++mSegmentCount;
+	pthread_mutex_unlock(&mSegmentsMutex);
+
+	mRetiring = mWriter;
+	mRetiringIndex = mIndex;
+	if (pthread_create(&mRetireThreadID, NULL, retireThreadStatic, this) != 0) {
+		logg->logError(__FILE__, __LINE__, "Unable to start the gatord-retire thread");
+		handleException();
+	}
+	mRetireThreadRunning = true;
+
+	++mSegment;
+	logg->logMessage("Starting capture segment %i", mSegment);
+	openSegment();
+
+	// Replay the state so that the segment can be decoded on its own, the header of the pending frame is already in mHeader
+	char header[FRAME_HEADER_SIZE];
+	memcpy(header, mHeader, sizeof(header));
+	DynBuf state;
+	mState.write(&state);
+	mReplaying = true;
+	write(state.getBuf(), state.getLength());
+	mReplaying = false;
+	memcpy(mHeader, header, sizeof(header));
+}
+
+void *CaptureFile::retireThreadStatic(void *arg) {
+	prctl(PR_SET_NAME, (unsigned long)&"gatord-retire", 0, 0, 0);
+	static_cast<CaptureFile *>(arg)->retire();
+	return NULL;
+}
+
+void CaptureFile::retire() {
+	// Flushes and syncs the segment
+	delete mRetiring;
+	mRetiring = NULL;
+	delete mRetiringIndex;
+	mRetiringIndex = NULL;
+
+	if (gSessionData->mRetainSize <= 0 && gSessionData->mRetainDuration <= 0) {
+		return;
+	}
+
+	pthread_mutex_lock(&mSegmentsMutex);
+
+	// Include the next segment so that disk use stays below the limit
+	int64_t total = gSessionData->mSegmentSize;
+	for (int i = 0; i < mSegmentCount; ++i) {
+		total += mSegments[i].mBytes;
+	}
+
+	const uint64_t now = getTime();
+	int removed = 0;
+	while (removed < mSegmentCount &&
+	       ((gSessionData->mRetainSize > 0 && total > gSessionData->mRetainSize) ||
+		(gSessionData->mRetainDuration > 0 && now - mSegments[removed].mEndTime > (uint64_t)gSessionData->mRetainDuration))) {
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "%s/%010d", mApcDir, mFirstSegment + removed);
+		if (unlink(path) != 0) {
+			logg->logMessage("%s(%s:%i): unable to remove %s", __FUNCTION__, __FILE__, __LINE__, path);
+		} else {
+			logg->logMessage("Removed capture segment %s", path);
+		}
+		snprintf(path, sizeof(path), "%s/%010d.idx", mApcDir, mFirstSegment + removed);
+		unlink(path);
+		total -= mSegments[removed].mBytes;
+		++removed;
+	}
+
+	mSegmentCount -= removed;
+	mFirstSegment += removed;
+	memmove(mSegments, mSegments + removed, mSegmentCount * sizeof(*mSegments));
+
+	pthread_mutex_unlock(&mSegmentsMutex);
+}
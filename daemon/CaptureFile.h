@@ -0,0 +1,84 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef CAPTUREFILE_H
+#define CAPTUREFILE_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "CaptureState.h"
+#include "DynBuf.h"
+
+class CaptureIndex;
+class CaptureWriter;
+
+// The local capture data, optionally split into numbered segment files 0000000000, 0000000001, etc.
+// Segments start on a frame boundary and begin with the state, the latest of the summary, name and perf attrs messages sent so far, so that each can be decoded on its own.
+// Old segments are closed and removed by the retention policy on a background thread.
+// Each segment, or the single 0000000000 file of an unsegmented capture, has an index, eg 0000000000.idx, see CaptureIndex
+class CaptureFile {
+public:
+	CaptureFile(const char *const apcDir);
+	~CaptureFile();
+
+	void write(const char *data, int length);
+
+private:
+	// The frame length, frame type and core, both of which are one byte packed ints
+	static const int FRAME_HEADER_SIZE = 6;
+
+	struct Segment {
+		int64_t mBytes;
+		uint64_t mEndTime;
+	};
+
+	void openSegment();
+	void emit(const char *const data, const int length);
+	void rotate();
+	static void *retireThreadStatic(void *arg);
+	void retire();
+
+	char *mApcDir;
+	const bool mSegmented;
+	CaptureWriter *mWriter;
+	CaptureIndex *mIndex;
+	int mSegment;
+	int64_t mSegmentBytes;
+	uint64_t mSegmentStart;
+
+	// Frame currently being written
+	char mHeader[FRAME_HEADER_SIZE];
+	int mHeaderLength;
+	int mFrameRemaining;
+	bool mFrameIsState;
+	// The frame being written and its offset in the segment
+	DynBuf mFrame;
+	int64_t mFrameOffset;
+	// Set while copying mState into a new segment
+	bool mReplaying;
+	CaptureState mState;
+
+	// Closed segments, mSegments[i] is segment mFirstSegment + i
+	pthread_mutex_t mSegmentsMutex;
+	Segment *mSegments;
+	int mSegmentCount;
+	int mSegmentCapacity;
+	int mFirstSegment;
+
+	CaptureWriter *mRetiring;
+	CaptureIndex *mRetiringIndex;
+	pthread_t mRetireThreadID;
+	bool mRetireThreadRunning;
+
+	// Intentionally unimplemented
+	CaptureFile(const CaptureFile &);
+	CaptureFile &operator=(const CaptureFile &);
+};
+
+#endif // CAPTUREFILE_H
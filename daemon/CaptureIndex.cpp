@@ -0,0 +1,313 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "CaptureIndex.h"
+
+#include <string.h>
+
+#include "Buffer.h"
+#include "Logging.h"
+#include "SessionData.h"
+#include "Varint.h"
+#include "k/perf_event.h"
+
+#define GATOR_INDEX_MAGIC 0x58444947 // "GIDX"
+// Version 1 used the times the frames were written
+#define GATOR_INDEX_VERSION 2
+
+// Sched trace frame messages, from gator_main.c
+enum {
+	MESSAGE_SCHED_SWITCH = 1,
+	MESSAGE_SCHED_EXIT = 2,
+};
+
+
+static void writeLEInt64(char *const buf, const uint64_t v) {
+	Buffer::writeLEInt((unsigned char *)buf, v);
+	Buffer::writeLEInt((unsigned char *)buf + 4, v >> 32);
+}
+
+CaptureIndex::CaptureIndex(const char *const path) : mFile(NULL), mType(0), mCore(0), mStartTime(0), mEndTime(0), mHaveTime(false), mSampleTypes(), mIdKeys() {
+	mFile = fopen(path, "wb");
+	if (mFile == NULL) {
+		logg->logError(__FILE__, __LINE__, "Failed to open index file: %s", path);
+		handleException();
+	}
+	char header[8];
+	Buffer::writeLEInt((unsigned char *)header, GATOR_INDEX_MAGIC);
+	Buffer::writeLEInt((unsigned char *)header + 4, GATOR_INDEX_VERSION);
+	fwrite(header, sizeof(header), 1, mFile);
+}
+
+CaptureIndex::~CaptureIndex() {
+	if (fclose(mFile) != 0) {
+		logg->logMessage("%s(%s:%i): Unable to write the capture index", __FUNCTION__, __FILE__, __LINE__);
+	}
+}
+
+void CaptureIndex::add(const int64_t offset, const char *const data, const int length) {
+	mType = -1;
+	mCore = -1;
+	mStartTime = 0;
+	mEndTime = 0;
+	mHaveTime = false;
+
+	// The frames written most often are scanned for their times directly, the rest are decoded
+	const uint8_t *pos = (const uint8_t *)data + sizeof(int32_t);
+	const uint8_t *const end = (const uint8_t *)data + length;
+	int64_t type;
+	const int typeLength = varintDecode(pos, end, &type);
+	if (typeLength > 0) {
+		pos += typeLength;
+		mType = type;
+		switch (type) {
+		case GATOR_FRAME_BLOCK_COUNTER:
+		case GATOR_FRAME_BLOCK_COUNTER_COMPACT:
+			if (scanCore(&pos, end)) {
+				scanBlockCounter(pos, end, type == GATOR_FRAME_BLOCK_COUNTER_COMPACT);
+			}
+			break;
+		case GATOR_FRAME_SCHED_TRACE:
+			if (scanCore(&pos, end)) {
+				scanSchedTrace(pos, end);
+			}
+			break;
+		case GATOR_FRAME_PERF:
+			// PerfBuffer writes the cpu as a raw byte
+			if (pos < end) {
+				mCore = *pos++;
+				scanPerf(pos, end);
+			}
+			break;
+		default:
+			GatorDecoder::decodeFrame(this, (const uint8_t *)data + sizeof(int32_t), length - sizeof(int32_t), offset);
+			break;
+		}
+	}
+
+	char entry[ENTRY_SIZE];
+	writeLEInt64(entry, mStartTime);
+	writeLEInt64(entry + 8, mEndTime);
+	writeLEInt64(entry + 16, offset);
+	Buffer::writeLEInt((unsigned char *)entry + 24, length);
+	Buffer::writeLEInt((unsigned char *)entry + 28, mType);
+	Buffer::writeLEInt((unsigned char *)entry + 32, mCore);
+	Buffer::writeLEInt((unsigned char *)entry + 36, 0);
+	if (fwrite(entry, sizeof(entry), 1, mFile) != 1) {
+		logg->logError(__FILE__, __LINE__, "Unable to write the capture index");
+		handleException();
+	}
+}
+
+bool CaptureIndex::scanCore(const uint8_t **const pos, const uint8_t *const end) {
+	int64_t core;
+	const int len = varintDecode(*pos, end, &core);
+	if (len == 0) {
+		return false;
+	}
+	*pos += len;
+	mCore = core;
+	return true;
+}
+
+// Only the timestamp records, key 0, are of interest. In a compact frame they are deltas from the previous timestamp.
+// Most bytes are skipped sixteen at a time by counting the values that end in them, a timestamp key is a zero byte that starts a value at a key position
+void CaptureIndex::scanBlockCounter(const uint8_t *pos, const uint8_t *const end, const bool compact) {
+	int64_t time = 0;
+	// Whether the value at pos is a key
+	bool atKey = true;
+	while (end - pos >= 16) {
+		const unsigned int stops = ~varintContinuationMask(pos) & 0xffff;
+		if (stops == 0) {
+			// Sixteen bytes without a terminator is not a valid value
+			return;
+		}
+		// Only the values that end in these bytes are looked at, the next block starts after the last of them
+		const int used = 32 - __builtin_clz(stops);
+		const unsigned int starts = ((stops << 1) | 1) & ((1U << used) - 1);
+		unsigned int zeros = varintZeroMask(pos) & starts;
+		bool found = false;
+		while (zeros != 0) {
+			const int i = __builtin_ctz(zeros);
+			// Values alternate between keys and values
+			if (((__builtin_popcount(stops & ((1U << i) - 1)) & 1) == 0) == atKey) {
+				int64_t value;
+				const int len = varintDecode(pos + i + 1, end, &value);
+				if (len == 0) {
+					return;
+				}
+				time = compact ? time + value : value;
+				this->time(time);
+				pos += i + 1 + len;
+				atKey = true;
+				found = true;
+				break;
+			}
+			zeros &= zeros - 1;
+		}
+		if (!found) {
+			atKey = (__builtin_popcount(stops) & 1) == 0 ? atKey : !atKey;
+			pos += used;
+		}
+	}
+
+	// The last few bytes one value at a time, a timestamp key found above has already been handled so this starts with isTime clear
+	bool isTime = false;
+	while (pos < end) {
+		int64_t value;
+		const int len = varintDecode(pos, end, &value);
+		if (len == 0) {
+			return;
+		}
+		pos += len;
+		if (atKey) {
+			isTime = value == 0;
+		} else if (isTime) {
+			time = compact ? time + value : value;
+			this->time(time);
+		}
+		atKey = !atKey;
+	}
+}
+
+void CaptureIndex::scanSchedTrace(const uint8_t *pos, const uint8_t *const end) {
+	while (pos < end) {
+		int64_t code;
+		int64_t time;
+		int len = varintDecode(pos, end, &code);
+		if (len == 0 || (code != MESSAGE_SCHED_SWITCH && code != MESSAGE_SCHED_EXIT)) {
+			return;
+		}
+		pos += len;
+		len = varintDecode(pos, end, &time);
+		if (len == 0) {
+			return;
+		}
+		pos += len;
+		this->time(time);
+		// Skip the pid and, for a switch, the state
+		for (int i = code == MESSAGE_SCHED_SWITCH ? 2 : 1; i > 0; --i) {
+			len = varintSkip(pos, end);
+			if (len == 0) {
+				return;
+			}
+			pos += len;
+		}
+	}
+}
+
+// The records of a perf ring are in time order, so only the first and last samples are looked up
+void CaptureIndex::scanPerf(const uint8_t *const data, const uint8_t *const end) {
+	const uint8_t *first = NULL;
+	const uint8_t *last = NULL;
+	const uint8_t *pos = data;
+	while (end - pos >= (int)sizeof(struct perf_event_header)) {
+		struct perf_event_header header;
+		memcpy(&header, pos, sizeof(header));
+		if (header.size < sizeof(header) || end - pos < header.size) {
+			break;
+		}
+		if (header.type == PERF_RECORD_SAMPLE) {
+			if (first == NULL) {
+				first = pos;
+			}
+			last = pos;
+		}
+		pos += header.size;
+	}
+
+	if (first != NULL) {
+		sampleTime(first);
+		sampleTime(last);
+	}
+}
+
+void CaptureIndex::sampleTime(const uint8_t *const sample) {
+	struct perf_event_header header;
+	memcpy(&header, sample, sizeof(header));
+	// The event id is first unless the kernel predates PERF_SAMPLE_IDENTIFIER, see DEFAULT_PEA_ARGS in PerfGroup.cpp
+	const int idOffset = sizeof(struct perf_event_header) + (gSessionData->perf.getLegacySupport() ? 3 * sizeof(uint64_t) : 0);
+	if (idOffset + (int)sizeof(uint64_t) > header.size) {
+		return;
+	}
+	uint64_t id;
+	memcpy(&id, sample + idOffset, sizeof(id));
+	const int *const key = mIdKeys.find(id);
+	const uint64_t *const sampleType = key != NULL ? mSampleTypes.find((uint32_t)*key) : NULL;
+	if (sampleType == NULL || (*sampleType & PERF_SAMPLE_TIME) == 0) {
+		return;
+	}
+	// Only the identifier, ip and tid come before the time
+	const int timeOffset = sizeof(header) + sizeof(uint64_t) * (((*sampleType & PERF_SAMPLE_IDENTIFIER) ? 1 : 0) + ((*sampleType & PERF_SAMPLE_IP) ? 1 : 0) + ((*sampleType & PERF_SAMPLE_TID) ? 1 : 0));
+	if (timeOffset + (int)sizeof(uint64_t) <= header.size) {
+		uint64_t time;
+		memcpy(&time, sample + timeOffset, sizeof(time));
+		this->time(time);
+	}
+}
+
+void CaptureIndex::time(const int64_t time) {
+	if (!mHaveTime || time < mStartTime) {
+		mStartTime = time;
+	}
+	if (!mHaveTime || time > mEndTime) {
+		mEndTime = time;
+	}
+	mHaveTime = true;
+}
+
+void CaptureIndex::frame(const int type, const int core, const uint8_t *, int) {
+	mType = type;
+	mCore = core;
+}
+
+void CaptureIndex::backtrace(int, const int64_t time, int, int, int) {
+	this->time(time);
+}
+
+void CaptureIndex::threadName(int, const int64_t time, int, const char *, int) {
+	this->time(time);
+}
+
+void CaptureIndex::link(int, const int64_t time, int, int, int) {
+	this->time(time);
+}
+
+void CaptureIndex::annotate(int, int, const int64_t time, const uint8_t *, int) {
+	this->time(time);
+}
+
+void CaptureIndex::idle(int, const int64_t time, int) {
+	this->time(time);
+}
+
+void CaptureIndex::activitySwitch(int, const int64_t time, int, int, int, int) {
+	this->time(time);
+}
+
+void CaptureIndex::pea(int, const uint8_t *const attr, const int size, const int key) {
+	struct perf_event_attr eventAttr;
+	memset(&eventAttr, 0, sizeof(eventAttr));
+	memcpy(&eventAttr, attr, size < (int)sizeof(eventAttr) ? size : sizeof(eventAttr));
+	*mSampleTypes.get((uint32_t)key) = eventAttr.sample_type;
+}
+
+void CaptureIndex::key(int, const uint64_t id, const int key) {
+	*mIdKeys.get(id) = key;
+}
+
+// data is the result of reading the group, { u64 nr; { u64 value; u64 id; } values[nr]; }
+void CaptureIndex::keysOld(int, const int *const keys, const int keyCount, const uint8_t *const data, const int length) {
+	uint64_t nr;
+	memcpy(&nr, data, sizeof(nr));
+	for (uint64_t i = 0; i < nr && i < (uint64_t)keyCount && (2 * i + 3) * sizeof(uint64_t) <= (uint64_t)length; ++i) {
+		uint64_t id;
+		memcpy(&id, data + (2 * i + 2) * sizeof(uint64_t), sizeof(id));
+		*mIdKeys.get(id) = keys[i];
+	}
+}
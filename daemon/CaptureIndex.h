@@ -0,0 +1,71 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef CAPTUREINDEX_H
+#define CAPTUREINDEX_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "GatorDecode.h"
+#include "HashMap.h"
+
+// The index of a segment of a local capture, eg 0000000000.idx, so that tools can seek to a time range or to the data of one core without reading the whole segment. All values are little endian
+// - Header: magic GATOR_INDEX_MAGIC, version
+// - An entry per frame: start time, end time, segment offset (uint64_t), length, frame type, core (int32_t), padding
+// The start and end times are those of the earliest and latest event in the frame, in the time base of its events, or zero if the frame has no timestamped events.
+// Indexing runs on the sender thread, so the block counter, sched trace and perf frames that make up most of a capture are scanned for their times rather than decoded.
+// Perf frames use the times of their first and last samples
+class CaptureIndex : private GatorDecodeHandler {
+public:
+	CaptureIndex(const char *const path);
+	// Closes the index
+	~CaptureIndex();
+
+	// Indexes the complete frame at offset in the segment, data starts with the frame length
+	void add(const int64_t offset, const char *const data, const int length);
+
+private:
+	static const int ENTRY_SIZE = 40;
+
+	void time(const int64_t time);
+	bool scanCore(const uint8_t **const pos, const uint8_t *const end);
+	void scanBlockCounter(const uint8_t *pos, const uint8_t *const end, const bool compact);
+	void scanSchedTrace(const uint8_t *pos, const uint8_t *const end);
+	void scanPerf(const uint8_t *const data, const uint8_t *const end);
+	void sampleTime(const uint8_t *const sample);
+
+	// GatorDecodeHandler, for the frames that are not scanned
+	void frame(int type, int core, const uint8_t *payload, int length);
+	void backtrace(int core, int64_t time, int execCookie, int tgid, int pid);
+	void threadName(int core, int64_t time, int pid, const char *name, int length);
+	void link(int core, int64_t time, int cookie, int tgid, int pid);
+	void annotate(int core, int pid, int64_t time, const uint8_t *data, int length);
+	void idle(int core, int64_t time, int state);
+	void activitySwitch(int core, int64_t time, int key, int activity, int pid, int state);
+	void pea(int core, const uint8_t *attr, int size, int key);
+	void key(int core, uint64_t id, int key);
+	void keysOld(int core, const int *keys, int keyCount, const uint8_t *data, int length);
+
+	FILE *mFile;
+	// The frame being indexed
+	int mType;
+	int mCore;
+	int64_t mStartTime;
+	int64_t mEndTime;
+	bool mHaveTime;
+	// The perf sample type of each key and the key of each perf event id, from the perf attrs frames which are replayed at the start of each segment
+	HashMap<uint64_t> mSampleTypes;
+	HashMap<int> mIdKeys;
+
+	// Intentionally unimplemented
+	CaptureIndex(const CaptureIndex &);
+	CaptureIndex &operator=(const CaptureIndex &);
+};
+
+#endif // CAPTUREINDEX_H
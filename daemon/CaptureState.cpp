@@ -0,0 +1,163 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "CaptureState.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "Buffer.h"
+#include "Logging.h"
+
+CaptureState::CaptureState() : mMessages(), mSeq(0), mSize(0), mKind(KIND_UNIQUE), mId(0) {
+}
+
+CaptureState::~CaptureState() {
+	for (int i = 0; i < mMessages.getCapacity(); ++i) {
+		if (mMessages.isUsed(i)) {
+			free(mMessages.getValue(i)->data);
+		}
+	}
+}
+
+void CaptureState::add(const char *const payload, const int length) {
+	// Don't use the key of a message that failed to decode in an earlier frame
+	mKind = KIND_UNIQUE;
+	GatorDecoder::decodeFrame(this, (const uint8_t *)payload, length, 0);
+}
+
+void CaptureState::setKey(const int kind, const int id) {
+	mKind = kind;
+	mId = id;
+}
+
+// Called after the callback for the contents of the message, which set its key
+void CaptureState::message(const int type, const int core, const uint8_t *const data, const int length) {
+	++mSeq;
+	// Messages without a key are never replaced, the seq is unique and less than 1 << 56. String ids are the same in every frame source, see Buffer::internString
+	const uint64_t key = mKind == KIND_UNIQUE ? mSeq : ((uint64_t)mKind << 56) | ((uint64_t)(uint16_t)(mKind == KIND_STRING ? 0 : core) << 32) | (uint32_t)mId;
+	const bool isString = mKind == KIND_STRING;
+	mKind = KIND_UNIQUE;
+
+	// A string never changes so keep its first definition, which is before every use of it
+	if (isString && mMessages.find(key) != NULL) {
+		return;
+	}
+	Message *const message = mMessages.get(key);
+	mSize += length - message->length;
+	if (mSize > MAX_STATE_SIZE) {
+		logg->logError(__FILE__, __LINE__, "The capture state is larger than %i MB, reduce the number of processes or don't segment the capture", (int)(MAX_STATE_SIZE >> 20));
+		handleException();
+	}
+	char *const copy = (char *)realloc(message->data, length);
+	if (copy == NULL) {
+		logg->logError(__FILE__, __LINE__, "Unable to save the capture state");
+		handleException();
+	}
+	memcpy(copy, data, length);
+	message->seq = mSeq;
+	message->data = copy;
+	message->length = length;
+	message->frameType = type;
+	message->core = core;
+}
+
+void CaptureState::summary(int64_t, int64_t, int64_t) {
+	setKey(KIND_SUMMARY, 0);
+}
+
+void CaptureState::coreName(const int core, int, const char *, int) {
+	setKey(KIND_CORE_NAME, core);
+}
+
+void CaptureState::cookie(int, const int cookie, const char *, int) {
+	setKey(KIND_COOKIE, cookie);
+}
+
+void CaptureState::threadName(int, int64_t, const int pid, const char *, int) {
+	setKey(KIND_THREAD_NAME, pid);
+}
+
+void CaptureState::link(int, int64_t, int, int, const int pid) {
+	setKey(KIND_LINK, pid);
+}
+
+void CaptureState::pea(int, const uint8_t *, int, const int key) {
+	setKey(KIND_PEA, key);
+}
+
+// The maps are the whole of /proc/[pid]/maps so each replaces the last, in either form
+void CaptureState::maps(int, const int pid, int, const char *, int) {
+	setKey(KIND_MAPS, pid);
+}
+
+void CaptureState::mapping(int, const int pid, int, uint64_t, uint64_t, uint64_t, int, int) {
+	setKey(KIND_MAPS, pid);
+}
+
+void CaptureState::comm(int, int, const int tid, const char *, int, const char *, int) {
+	setKey(KIND_COMM, tid);
+}
+
+void CaptureState::commId(int, int, const int tid, int, int) {
+	setKey(KIND_COMM, tid);
+}
+
+void CaptureState::internedString(int, const int id, const char *, int) {
+	setKey(KIND_STRING, id);
+}
+
+int CaptureState::compareMessages(const void *a, const void *b) {
+	const uint64_t seqA = (*(const Message *const *)a)->seq;
+	const uint64_t seqB = (*(const Message *const *)b)->seq;
+	return seqA < seqB ? -1 : seqA > seqB ? 1 : 0;
+}
+
+void CaptureState::write(DynBuf *const frames) const {
+	const Message **const messages = (const Message **)malloc((mMessages.getCount() + 1) * sizeof(Message *));
+	if (messages == NULL) {
+		logg->logError(__FILE__, __LINE__, "malloc failed");
+		handleException();
+	}
+	int count = 0;
+	for (int i = 0; i < mMessages.getCapacity(); ++i) {
+		if (mMessages.isUsed(i)) {
+			messages[count++] = mMessages.getValue(i);
+		}
+	}
+	qsort(messages, count, sizeof(Message *), compareMessages);
+
+	// Consecutive messages of the same frame type and core share a frame
+	int frameStart = -1;
+	for (int i = 0; i < count; ++i) {
+		const Message *const message = messages[i];
+		if (frameStart < 0 || message->frameType != messages[i - 1]->frameType || message->core != messages[i - 1]->core || (int)frames->getLength() - frameStart >= MAX_FRAME_SIZE) {
+			if (frameStart >= 0) {
+				Buffer::writeLEInt((unsigned char *)frames->getBuf() + frameStart, frames->getLength() - frameStart - sizeof(int32_t));
+			}
+			frameStart = frames->getLength();
+			char header[sizeof(int32_t) + 2 * Buffer::MAXSIZE_PACK64] = { 0 };
+			int headerLength = sizeof(int32_t);
+			headerLength += Buffer::packInt64(header + headerLength, message->frameType);
+			headerLength += Buffer::packInt64(header + headerLength, message->core);
+			if (!frames->append(header, headerLength)) {
+				logg->logError(__FILE__, __LINE__, "Unable to replay the capture state");
+				handleException();
+			}
+		}
+		if (!frames->append(message->data, message->length)) {
+			logg->logError(__FILE__, __LINE__, "Unable to replay the capture state");
+			handleException();
+		}
+	}
+	if (frameStart >= 0) {
+		Buffer::writeLEInt((unsigned char *)frames->getBuf() + frameStart, frames->getLength() - frameStart - sizeof(int32_t));
+	}
+
+	free(messages);
+}
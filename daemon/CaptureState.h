@@ -0,0 +1,88 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef CAPTURESTATE_H
+#define CAPTURESTATE_H
+
+#include <stdint.h>
+
+#include "DynBuf.h"
+#include "GatorDecode.h"
+#include "HashMap.h"
+
+// The summary, name and perf attrs messages needed to decode the frames that follow them, replayed at the start of each segment of a local capture, see CaptureFile.
+// Only the latest message for each core name, cookie, thread, process, string, etc. is kept so the state is bounded by the number of live ids rather than by the length of the capture
+class CaptureState : private GatorDecodeHandler {
+public:
+	CaptureState();
+	~CaptureState();
+
+	// Adds the messages of a state frame, payload starts with the frame type
+	void add(const char *const payload, const int length);
+	// Appends the state to frames as frames in the local capture format
+	void write(DynBuf *const frames) const;
+
+private:
+	// If this is exceeded the ids are not bounding the state, fail rather than use all the memory
+	static const int64_t MAX_STATE_SIZE = 64 << 20;
+	// The replayed messages are regrouped into frames of about this size
+	static const int MAX_FRAME_SIZE = 64 << 10;
+
+	// What a message describes, messages of the same kind, frame core and id replace each other except strings whose ids are unique for the whole capture
+	enum Kind {
+		KIND_UNIQUE,
+		KIND_SUMMARY,
+		KIND_CORE_NAME,
+		KIND_COOKIE,
+		KIND_THREAD_NAME,
+		KIND_LINK,
+		KIND_PEA,
+		KIND_MAPS,
+		KIND_COMM,
+		KIND_STRING,
+	};
+
+	struct Message {
+		// Messages are replayed in the order they were last received so that ids are always defined before they are used
+		uint64_t seq;
+		char *data;
+		int length;
+		int frameType;
+		int core;
+	};
+
+	static int compareMessages(const void *a, const void *b);
+	void setKey(const int kind, const int id);
+
+	// GatorDecodeHandler
+	void message(int type, int core, const uint8_t *data, int length);
+	void summary(int64_t timestamp, int64_t uptime, int64_t monotonicDelta);
+	void coreName(int core, int cpuid, const char *name, int length);
+	void cookie(int core, int cookie, const char *name, int length);
+	void threadName(int core, int64_t time, int pid, const char *name, int length);
+	void link(int core, int64_t time, int cookie, int tgid, int pid);
+	void pea(int core, const uint8_t *attr, int size, int key);
+	void maps(int core, int pid, int tid, const char *maps, int length);
+	void comm(int core, int pid, int tid, const char *image, int imageLength, const char *comm, int commLength);
+	void internedString(int core, int id, const char *str, int length);
+	void commId(int core, int pid, int tid, int imageId, int commId);
+	void mapping(int core, int pid, int tid, uint64_t start, uint64_t end, uint64_t offset, int flags, int pathId);
+
+	HashMap<Message> mMessages;
+	uint64_t mSeq;
+	int64_t mSize;
+	// Kind and id of the message being decoded
+	int mKind;
+	int mId;
+
+	// Intentionally unimplemented
+	CaptureState(const CaptureState &);
+	CaptureState &operator=(const CaptureState &);
+};
+
+#endif // CAPTURESTATE_H
@@ -0,0 +1,829 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "CaptureSummary.h"
+
+#include <elf.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Buffer.h"
+#include "EventsXML.h"
+#include "k/perf_event.h"
+#include "SessionData.h"
+
+// The driver uses cookie 0 for kernel addresses and ~0 for addresses it could not resolve
+static const int NO_COOKIE = 0;
+
+static const uint64_t ADDRESS_MASK = (1ULL << 48) - 1;
+
+// Reads a NUL terminated string from a perf record
+static bool readString(const char **const pos, const char *const end, const char **const str) {
+	const char *const nul = (const char *)memchr(*pos, '\0', end - *pos);
+	if (nul == NULL) {
+		return false;
+	}
+	*str = *pos;
+	*pos = nul + 1;
+	return true;
+}
+
+template <typename T>
+static bool readRaw(const char **const pos, const char *const end, T *const value) {
+	if (end - *pos < (int)sizeof(T)) {
+		return false;
+	}
+	memcpy(value, *pos, sizeof(T));
+	*pos += sizeof(T);
+	return true;
+}
+
+static uint64_t sampleKey(const int imageId, const uint64_t address) {
+	return ((uint64_t)imageId << 48) | (address & ADDRESS_MASK);
+}
+
+CaptureSummary::CaptureSummary() : mStartTime(getTime()), mSamples(0), mLengthBytes(0), mFrameRemaining(0), mFrame(), mNames(), mNameList(NULL), mNameCapacity(0), mKernelImageId(0), mBacktraceTgid(0), mBacktracePid(0), mBacktraceFirst(false), mPrevPidOffset(-1), mNextPidOffset(-1) {
+	memset(mCores, 0, sizeof(mCores));
+	mKernelImageId = nameId("[kernel]");
+}
+
+CaptureSummary::~CaptureSummary() {
+	for (int i = 0; i < mMaps.getCapacity(); ++i) {
+		if (mMaps.isUsed(i)) {
+			free(mMaps.getValue(i)->mappings);
+		}
+	}
+	for (int i = 0; i < mNameCapacity; ++i) {
+		free(mNameList[i]);
+	}
+	free(mNameList);
+}
+
+int CaptureSummary::nameId(const char *const name) {
+	bool isNew;
+	const int id = mNames.intern(name, &isNew);
+	if (isNew) {
+		if (id >= mNameCapacity) {
+			const int capacity = mNameCapacity == 0 ? 256 : 2*mNameCapacity;
+			char **const nameList = (char **)realloc(mNameList, capacity * sizeof(char *));
+			if (nameList == NULL) {
+				logg->logError(__FILE__, __LINE__, "realloc failed");
+				handleException();
+			}
+			memset(nameList + mNameCapacity, 0, (capacity - mNameCapacity) * sizeof(char *));
+			mNameList = nameList;
+			mNameCapacity = capacity;
+		}
+		mNameList[id] = strdup(name);
+		if (mNameList[id] == NULL) {
+			logg->logError(__FILE__, __LINE__, "strdup failed");
+			handleException();
+		}
+	}
+	return id;
+}
+
+int CaptureSummary::nameId(const char *const name, const int length) {
+	char buf[PATH_MAX];
+	const int size = length < (int)sizeof(buf) - 1 ? length : (int)sizeof(buf) - 1;
+	memcpy(buf, name, size);
+	buf[size] = '\0';
+	return nameId(buf);
+}
+
+void CaptureSummary::write(const char *data, int length) {
+	while (length > 0) {
+		if (mLengthBytes < (int)sizeof(mLengthBuf)) {
+			mLengthBuf[mLengthBytes++] = *data++;
+			--length;
+			if (mLengthBytes == (int)sizeof(mLengthBuf)) {
+				mFrameRemaining = (mLengthBuf[0] & 0xFF) | (mLengthBuf[1] & 0xFF) << 8 | (mLengthBuf[2] & 0xFF) << 16 | (mLengthBuf[3] & 0xFF) << 24;
+				mFrame.reset();
+			}
+			continue;
+		}
+
+		// Decode whole frames in place and only copy frames split across calls
+		if (mFrame.getLength() == 0 && length >= mFrameRemaining) {
+			GatorDecoder::decodeFrame(this, (const uint8_t *)data, mFrameRemaining, 0);
+		} else {
+			const int bytes = length < mFrameRemaining ? length : mFrameRemaining;
+			if (!mFrame.append(data, bytes)) {
+				logg->logError(__FILE__, __LINE__, "Unable to buffer a frame for the summary");
+				handleException();
+			}
+			if (bytes < mFrameRemaining) {
+				mFrameRemaining -= bytes;
+				return;
+			}
+			GatorDecoder::decodeFrame(this, (const uint8_t *)mFrame.getBuf(), mFrame.getLength(), 0);
+			mFrame.reset();
+		}
+		data += mFrameRemaining;
+		length -= mFrameRemaining;
+		mFrameRemaining = 0;
+		mLengthBytes = 0;
+	}
+}
+
+// Counter, block counter and compact block counter frames
+void CaptureSummary::counter(const int core, int64_t, const int key, const int64_t value) {
+	addCounter(core, key, value, false);
+}
+
+void CaptureSummary::addCounter(const int core, const int key, const int64_t value, const bool cumulative) {
+	// Key 1 is the thread marker for thread specific counters
+	if (key <= 1) {
+		return;
+	}
+	CounterTotal *const total = mCounters.get(((uint64_t)core << 32) | (uint32_t)key);
+	if (total->count == 0 || value < total->min) {
+		total->min = value;
+	}
+	if (total->count == 0 || value > total->max) {
+		total->max = value;
+	}
+	total->last = value;
+	// Perf reports running totals, the driver and user space sources report the change since the last value or the absolute value
+	total->total = cumulative ? value : total->total + value;
+	++total->count;
+}
+
+CaptureSummary::Thread *CaptureSummary::getThread(const int tid, const int tgid) {
+	Thread *const thread = mThreads.get((uint32_t)tid);
+	if (tgid > 0) {
+		thread->tgid = tgid;
+	}
+	return thread;
+}
+
+void CaptureSummary::sample(const int tid, const int tgid, const int imageId, const uint64_t address) {
+	++mSamples;
+	++getThread(tid, tgid)->samples;
+	++*mSampleCounts.get(sampleKey(imageId < MAX_IMAGES ? imageId : 0, address));
+}
+
+void CaptureSummary::contextSwitch(const int core, const uint64_t time, const int prevTid, const int nextTid) {
+	if (core < 0 || core >= NR_CPUS) {
+		return;
+	}
+	Core &c = mCores[core];
+	++c.contextSwitches;
+	const int tid = prevTid >= 0 ? prevTid : c.running;
+	if (c.switched && time > c.lastSwitch) {
+		getThread(tid, 0)->cpuTime += time - c.lastSwitch;
+	}
+	c.lastSwitch = time;
+	c.running = nextTid;
+	c.switched = true;
+}
+
+// Backtrace frame, the first address is where the sample was taken and the rest are the callers
+void CaptureSummary::backtrace(int, int64_t, int, const int tgid, const int pid) {
+	mBacktraceTgid = tgid;
+	mBacktracePid = pid;
+	mBacktraceFirst = true;
+}
+
+void CaptureSummary::backtraceAddress(int, const int cookie, const int64_t address) {
+	if (!mBacktraceFirst) {
+		return;
+	}
+	const int *const imageId = mCookies.find((uint32_t)cookie);
+	sample(mBacktracePid, mBacktraceTgid, cookie == NO_COOKIE ? mKernelImageId : imageId != NULL ? *imageId : 0, address);
+	mBacktraceFirst = false;
+}
+
+// Name frame
+void CaptureSummary::cookie(int, const int cookie, const char *const name, const int length) {
+	*mCookies.get((uint32_t)cookie) = nameId(name, length);
+}
+
+void CaptureSummary::threadName(int, int64_t, const int pid, const char *const name, const int length) {
+	getThread(pid, 0)->nameId = nameId(name, length);
+}
+
+void CaptureSummary::link(int, int64_t, int, const int tgid, const int pid) {
+	getThread(pid, tgid);
+}
+
+// Sched trace frame
+void CaptureSummary::schedSwitch(const int core, const int64_t time, const int pid, int) {
+	// The driver only reports the thread being switched to
+	contextSwitch(core, time, -1, pid);
+}
+
+void CaptureSummary::addMapping(const int pid, const uint64_t start, const uint64_t end, const uint64_t offset, const int imageId) {
+	Mappings *const maps = mMaps.get((uint32_t)pid);
+	if (maps->count >= maps->capacity) {
+		maps->capacity = maps->capacity == 0 ? 32 : 2*maps->capacity;
+		maps->mappings = (Mapping *)realloc(maps->mappings, maps->capacity * sizeof(Mapping));
+		if (maps->mappings == NULL) {
+			logg->logError(__FILE__, __LINE__, "realloc failed");
+			handleException();
+		}
+	}
+	Mapping &mapping = maps->mappings[maps->count++];
+	mapping.start = start;
+	mapping.end = end;
+	mapping.offset = offset;
+	mapping.imageId = imageId;
+}
+
+void CaptureSummary::addMaps(const int pid, const char *const maps) {
+	for (const char *line = maps; *line != '\0'; ) {
+		const char *eol = strchr(line, '\n');
+		if (eol == NULL) {
+			eol = line + strlen(line);
+		}
+		unsigned long long start, end, offset;
+		int pathPos;
+		if (sscanf(line, "%llx-%llx %*s %llx %*s %*s %n", &start, &end, &offset, &pathPos) >= 3 && line + pathPos < eol) {
+			addMapping(pid, start, end, offset, nameId(line + pathPos, eol - (line + pathPos)));
+		}
+		line = *eol == '\0' ? eol : eol + 1;
+	}
+}
+
+// Perf attrs frame
+void CaptureSummary::pea(int, const uint8_t *const attr, const int size, const int key) {
+	struct perf_event_attr eventAttr;
+	memset(&eventAttr, 0, sizeof(eventAttr));
+	memcpy(&eventAttr, attr, size < (int)sizeof(eventAttr) ? size : sizeof(eventAttr));
+	KeyAttr *const keyAttr = mKeyAttrs.get((uint32_t)key);
+	keyAttr->sampleType = eventAttr.sample_type;
+	keyAttr->readFormat = eventAttr.read_format;
+	keyAttr->isTracepoint = eventAttr.type == PERF_TYPE_TRACEPOINT;
+}
+
+void CaptureSummary::key(int, const uint64_t id, const int key) {
+	*mIdKeys.get(id) = key;
+}
+
+// data is the result of reading the group, { u64 nr; { u64 value; u64 id; } values[nr]; }
+void CaptureSummary::keysOld(int, const int *const keys, const int keyCount, const uint8_t *const data, const int length) {
+	const char *pos = (const char *)data;
+	const char *const end = pos + length;
+	uint64_t nr;
+	if (!readRaw(&pos, end, &nr)) {
+		return;
+	}
+	for (uint64_t i = 0; i < nr && i < (uint64_t)keyCount; ++i) {
+		uint64_t value, id;
+		if (!readRaw(&pos, end, &value) || !readRaw(&pos, end, &id)) {
+			return;
+		}
+		*mIdKeys.get(id) = keys[i];
+	}
+}
+
+// The NUL terminated tracepoint format
+void CaptureSummary::format(int, const char *const format, int) {
+	if (strstr(format, "sched_switch") != NULL) {
+		const char *field = strstr(format, " prev_pid;");
+		if (field != NULL && (field = strstr(field, "offset:")) != NULL) {
+			mPrevPidOffset = strtol(field + strlen("offset:"), NULL, 10);
+		}
+		field = strstr(format, " next_pid;");
+		if (field != NULL && (field = strstr(field, "offset:")) != NULL) {
+			mNextPidOffset = strtol(field + strlen("offset:"), NULL, 10);
+		}
+	}
+}
+
+void CaptureSummary::maps(int, const int pid, int, const char *const maps, int) {
+	addMaps(pid, maps);
+}
+
+void CaptureSummary::comm(int, const int pid, const int tid, const char *, int, const char *const comm, const int commLength) {
+	getThread(tid, pid)->nameId = nameId(comm, commLength);
+}
+
+void CaptureSummary::internedString(int, const int id, const char *const str, const int length) {
+	*mStrings.get((uint32_t)id) = nameId(str, length);
+}
+
+void CaptureSummary::commId(int, const int pid, const int tid, int, const int commId) {
+	const int *const comm = mStrings.find((uint32_t)commId);
+	getThread(tid, pid)->nameId = comm != NULL ? *comm : 0;
+}
+
+void CaptureSummary::mapping(int, const int pid, int, const uint64_t start, const uint64_t end, const uint64_t offset, int, const int pathId) {
+	const int *const path = mStrings.find((uint32_t)pathId);
+	if (path != NULL && *path != 0) {
+		addMapping(pid, start, end, offset, *path);
+	}
+}
+
+// Perf frame, the raw perf ring buffer records
+void CaptureSummary::perf(const int cpu, const uint8_t *const data, const int length) {
+	const char *pos = (const char *)data;
+	const char *const end = pos + length;
+	while (end - pos >= (int)sizeof(struct perf_event_header)) {
+		struct perf_event_header header;
+		memcpy(&header, pos, sizeof(header));
+		if (header.size < sizeof(header) || end - pos < header.size) {
+			return;
+		}
+		const char *const body = pos + sizeof(header);
+		const char *const next = pos + header.size;
+
+		if (header.type == PERF_RECORD_SAMPLE) {
+			perfSample(cpu, header.misc, body, next);
+		} else if (header.type == PERF_RECORD_MMAP) {
+			struct {
+				__u32 pid, tid;
+				__u64 addr, len, pgoff;
+			} mmap;
+			const char *p = body;
+			const char *filename;
+			if (readRaw(&p, next, &mmap) && readString(&p, next, &filename) && filename[0] != '\0') {
+				addMapping(mmap.pid, mmap.addr, mmap.addr + mmap.len, mmap.pgoff, nameId(filename));
+			}
+		} else if (header.type == PERF_RECORD_COMM) {
+			__u32 ids[2];
+			const char *p = body;
+			const char *comm;
+			if (readRaw(&p, next, &ids) && readString(&p, next, &comm)) {
+				getThread(ids[1], ids[0])->nameId = nameId(comm);
+			}
+		}
+
+		pos = next;
+	}
+}
+
+void CaptureSummary::perfSample(const int cpu, const int misc, const char *pos, const char *const end) {
+	// Find the sample type from the event id, which is first unless the kernel predates PERF_SAMPLE_IDENTIFIER. See DEFAULT_PEA_ARGS in PerfGroup.cpp
+	uint64_t id;
+	const char *idPos = pos + (gSessionData->perf.getLegacySupport() ? 3 * sizeof(uint64_t) : 0);
+	if (!readRaw(&idPos, end, &id)) {
+		return;
+	}
+	const int *const key = mIdKeys.find(id);
+	const KeyAttr *const attr = key != NULL ? mKeyAttrs.find((uint32_t)*key) : NULL;
+	if (attr == NULL) {
+		return;
+	}
+
+	uint64_t ip = 0, time = 0, skip;
+	__u32 tid[2] = { 0, 0 };
+	const uint64_t sampleType = attr->sampleType;
+	if (((sampleType & PERF_SAMPLE_IDENTIFIER) && !readRaw(&pos, end, &skip)) ||
+			((sampleType & PERF_SAMPLE_IP) && !readRaw(&pos, end, &ip)) ||
+			((sampleType & PERF_SAMPLE_TID) && !readRaw(&pos, end, &tid)) ||
+			((sampleType & PERF_SAMPLE_TIME) && !readRaw(&pos, end, &time)) ||
+			((sampleType & PERF_SAMPLE_ADDR) && !readRaw(&pos, end, &skip)) ||
+			((sampleType & PERF_SAMPLE_ID) && !readRaw(&pos, end, &skip)) ||
+			((sampleType & PERF_SAMPLE_STREAM_ID) && !readRaw(&pos, end, &skip)) ||
+			((sampleType & PERF_SAMPLE_CPU) && !readRaw(&pos, end, &skip)) ||
+			((sampleType & PERF_SAMPLE_PERIOD) && !readRaw(&pos, end, &skip))) {
+		return;
+	}
+
+	if (sampleType & PERF_SAMPLE_READ) {
+		// Only group reads are used, see DEFAULT_PEA_ARGS
+		uint64_t nr;
+		if (!(attr->readFormat & PERF_FORMAT_GROUP) || !readRaw(&pos, end, &nr) ||
+				((attr->readFormat & PERF_FORMAT_TOTAL_TIME_ENABLED) && !readRaw(&pos, end, &skip)) ||
+				((attr->readFormat & PERF_FORMAT_TOTAL_TIME_RUNNING) && !readRaw(&pos, end, &skip))) {
+			return;
+		}
+		for (uint64_t i = 0; i < nr; ++i) {
+			uint64_t value, valueId = 0;
+			if (!readRaw(&pos, end, &value) || ((attr->readFormat & PERF_FORMAT_ID) && !readRaw(&pos, end, &valueId))) {
+				return;
+			}
+			const int *const valueKey = mIdKeys.find(valueId);
+			if (valueKey != NULL) {
+				addCounter(cpu, *valueKey, value, true);
+			}
+		}
+	}
+
+	if (sampleType & PERF_SAMPLE_CALLCHAIN) {
+		uint64_t nr;
+		if (!readRaw(&pos, end, &nr) || nr > (uint64_t)(end - pos) / sizeof(uint64_t)) {
+			return;
+		}
+		pos += nr * sizeof(uint64_t);
+	}
+
+	if ((sampleType & PERF_SAMPLE_RAW) && attr->isTracepoint && mPrevPidOffset >= 0 && mNextPidOffset >= 0) {
+		// The only tracepoint sampled is sched_switch, see PerfSource::prepare
+		__u32 size;
+		int32_t prevPid, nextPid;
+		const char *prevPos, *nextPos;
+		if (!readRaw(&pos, end, &size) || size > (__u32)(end - pos)) {
+			return;
+		}
+		prevPos = pos + mPrevPidOffset;
+		nextPos = pos + mNextPidOffset;
+		if (readRaw(&prevPos, pos + size, &prevPid) && readRaw(&nextPos, pos + size, &nextPid)) {
+			contextSwitch(cpu, time, prevPid, nextPid);
+		}
+	}
+
+	if (sampleType & PERF_SAMPLE_IP) {
+		int imageId = 0;
+		uint64_t address = ip;
+		if ((misc & PERF_RECORD_MISC_CPUMODE_MASK) == PERF_RECORD_MISC_KERNEL) {
+			imageId = mKernelImageId;
+		} else {
+			const Mappings *const maps = mMaps.find(tid[0]);
+			// Search backwards so that the most recent mapping of an address is used
+			for (int i = maps != NULL ? maps->count - 1 : -1; i >= 0; --i) {
+				const Mapping &mapping = maps->mappings[i];
+				if (ip >= mapping.start && ip < mapping.end) {
+					imageId = mapping.imageId;
+					address = ip - mapping.start + mapping.offset;
+					break;
+				}
+			}
+		}
+		sample(tid[1], tid[0], imageId, address);
+	}
+}
+
+template <typename Ehdr, typename Phdr, typename Shdr, typename Sym>
+CaptureSummary::Symbol *CaptureSummary::readElfSymbols(const char *const data, const size_t size, int *const count) {
+	*count = 0;
+	const Ehdr *const ehdr = (const Ehdr *)data;
+	if (ehdr->e_phoff + (uint64_t)ehdr->e_phnum * sizeof(Phdr) > size || ehdr->e_shoff + (uint64_t)ehdr->e_shnum * sizeof(Shdr) > size) {
+		return NULL;
+	}
+	const Phdr *const phdrs = (const Phdr *)(data + ehdr->e_phoff);
+	const Shdr *const shdrs = (const Shdr *)(data + ehdr->e_shoff);
+
+	// Prefer the full symbol table but fall back to the dynamic symbols of stripped images
+	const Shdr *symtab = NULL;
+	for (int i = 0; i < ehdr->e_shnum; ++i) {
+		if (shdrs[i].sh_type == SHT_SYMTAB || (symtab == NULL && shdrs[i].sh_type == SHT_DYNSYM)) {
+			symtab = &shdrs[i];
+		}
+	}
+	if (symtab == NULL || symtab->sh_link >= ehdr->e_shnum || symtab->sh_offset + symtab->sh_size > size) {
+		return NULL;
+	}
+	const Shdr *const strtab = &shdrs[symtab->sh_link];
+	if (strtab->sh_offset + strtab->sh_size > size) {
+		return NULL;
+	}
+
+	const Sym *const syms = (const Sym *)(data + symtab->sh_offset);
+	const int symCount = symtab->sh_size / sizeof(Sym);
+	Symbol *const symbols = (Symbol *)malloc(symCount * sizeof(Symbol));
+	if (symbols == NULL) {
+		return NULL;
+	}
+
+	for (int i = 0; i < symCount; ++i) {
+		const Sym &sym = syms[i];
+		if ((sym.st_info & 0xf) != STT_FUNC || sym.st_shndx == SHN_UNDEF || sym.st_name >= strtab->sh_size) {
+			continue;
+		}
+		// Convert the virtual address to a file offset as that is what the samples use, clearing the Thumb bit
+		const uint64_t value = sym.st_value & ~1ULL;
+		for (int j = 0; j < ehdr->e_phnum; ++j) {
+			const Phdr &phdr = phdrs[j];
+			if (phdr.p_type == PT_LOAD && value >= phdr.p_vaddr && value < phdr.p_vaddr + phdr.p_filesz) {
+				Symbol &symbol = symbols[(*count)++];
+				symbol.start = value - phdr.p_vaddr + phdr.p_offset;
+				symbol.size = sym.st_size;
+				// Temporarily the offset of the name in the string table
+				symbol.nameId = strtab->sh_offset + sym.st_name;
+				break;
+			}
+		}
+	}
+
+	return symbols;
+}
+
+int CaptureSummary::compareSymbols(const void *a, const void *b) {
+	const uint64_t startA = ((const Symbol *)a)->start;
+	const uint64_t startB = ((const Symbol *)b)->start;
+	return startA < startB ? -1 : startA > startB ? 1 : 0;
+}
+
+void CaptureSummary::loadSymbols(const int imageId, Symbols *const symbols) {
+	symbols->loaded = true;
+
+	if (imageId == mKernelImageId) {
+		FILE *const f = fopen("/proc/kallsyms", "r");
+		if (f == NULL) {
+			return;
+		}
+		int capacity = 0;
+		char line[512];
+		while (fgets(line, sizeof(line), f) != NULL) {
+			unsigned long long address;
+			char type;
+			char name[256];
+			if (sscanf(line, "%llx %c %255s", &address, &type, name) != 3 || (type != 't' && type != 'T') || address == 0) {
+				continue;
+			}
+			if (symbols->count >= capacity) {
+				capacity = capacity == 0 ? 1024 : 2*capacity;
+				Symbol *const s = (Symbol *)realloc(symbols->symbols, capacity * sizeof(Symbol));
+				if (s == NULL) {
+					break;
+				}
+				symbols->symbols = s;
+			}
+			Symbol &symbol = symbols->symbols[symbols->count++];
+			symbol.start = address;
+			// kallsyms has no sizes, a symbol extends to the next one
+			symbol.size = 0;
+			symbol.nameId = nameId(name);
+		}
+		fclose(f);
+		qsort(symbols->symbols, symbols->count, sizeof(Symbol), compareSymbols);
+		return;
+	}
+
+	const int fd = open(mNameList[imageId], O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < EI_NIDENT) {
+		close(fd);
+		return;
+	}
+	const char *const data = (const char *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return;
+	}
+
+	if (memcmp(data, ELFMAG, SELFMAG) == 0) {
+		if (data[EI_CLASS] == ELFCLASS32 && st.st_size >= (off_t)sizeof(Elf32_Ehdr)) {
+			symbols->symbols = readElfSymbols<Elf32_Ehdr, Elf32_Phdr, Elf32_Shdr, Elf32_Sym>(data, st.st_size, &symbols->count);
+		} else if (data[EI_CLASS] == ELFCLASS64 && st.st_size >= (off_t)sizeof(Elf64_Ehdr)) {
+			symbols->symbols = readElfSymbols<Elf64_Ehdr, Elf64_Phdr, Elf64_Shdr, Elf64_Sym>(data, st.st_size, &symbols->count);
+		}
+	}
+	for (int i = 0; i < symbols->count; ++i) {
+		const char *const name = data + symbols->symbols[i].nameId;
+		symbols->symbols[i].nameId = memchr(name, '\0', data + st.st_size - name) != NULL ? nameId(name) : 0;
+	}
+
+	munmap((void *)data, st.st_size);
+	qsort(symbols->symbols, symbols->count, sizeof(Symbol), compareSymbols);
+}
+
+// Returns the name id of the function containing address or 0 if it is unknown
+int CaptureSummary::findFunction(const int imageId, const uint64_t address, HashMap<Symbols> *const symbolCache) {
+	if (imageId == 0) {
+		return 0;
+	}
+	Symbols *const symbols = symbolCache->get(imageId);
+	if (!symbols->loaded) {
+		loadSymbols(imageId, symbols);
+	}
+
+	// Find the last symbol starting at or before address
+	int low = 0;
+	int high = symbols->count;
+	while (low < high) {
+		const int mid = low + (high - low) / 2;
+		if (symbols->symbols[mid].start <= address) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	if (low == 0) {
+		return 0;
+	}
+	const Symbol &symbol = symbols->symbols[low - 1];
+	if (symbol.size != 0 && address >= symbol.start + symbol.size) {
+		return 0;
+	}
+	return symbol.nameId;
+}
+
+static void writeJSONString(FILE *const f, const char *str) {
+	fputc('"', f);
+	for (; *str != '\0'; ++str) {
+		const unsigned char c = *str;
+		if (c == '"' || c == '\\') {
+			fprintf(f, "\\%c", c);
+		} else if (c < 0x20) {
+			fprintf(f, "\\u%04x", c);
+		} else {
+			fputc(c, f);
+		}
+	}
+	fputc('"', f);
+}
+
+template <typename T>
+static int compareDescending(const T a, const T b) {
+	return a > b ? -1 : a < b ? 1 : 0;
+}
+
+static int compareFunctions(const void *a, const void *b) {
+	return compareDescending(*(const int64_t *)a, *(const int64_t *)b);
+}
+
+struct ProcessTotal {
+	int64_t cpuTime;
+	int64_t samples;
+	int pid;
+	int nameId;
+};
+
+static int compareProcesses(const void *a, const void *b) {
+	const ProcessTotal *const pa = (const ProcessTotal *)a;
+	const ProcessTotal *const pb = (const ProcessTotal *)b;
+	const int result = compareDescending(pa->cpuTime, pb->cpuTime);
+	return result != 0 ? result : compareDescending(pa->samples, pb->samples);
+}
+
+static int compareKeys(const void *a, const void *b) {
+	return -compareDescending(*(const uint64_t *)a, *(const uint64_t *)b);
+}
+
+bool CaptureSummary::writeJSON(const char *const path) {
+	const uint64_t duration = getTime() - mStartTime;
+	const double seconds = duration / (double)NS_PER_S;
+
+	// Attribute the samples to functions
+	HashMap<Symbols> symbolCache;
+	HashMap<Function> functions;
+	for (int i = 0; i < mSampleCounts.getCapacity(); ++i) {
+		if (!mSampleCounts.isUsed(i)) {
+			continue;
+		}
+		const uint64_t key = mSampleCounts.getKey(i);
+		const int imageId = key >> 48;
+		uint64_t address = key & ADDRESS_MASK;
+		if (imageId == mKernelImageId && (address & (1ULL << 47))) {
+			// Restore the upper bits of 64-bit kernel addresses
+			address |= ~ADDRESS_MASK;
+		}
+		const int functionId = findFunction(imageId, address, &symbolCache);
+		Function *const function = functions.get(((uint64_t)imageId << 32) | (uint32_t)functionId);
+		function->samples += *mSampleCounts.getValue(i);
+		function->imageId = imageId;
+		function->nameId = functionId;
+	}
+	for (int i = 0; i < symbolCache.getCapacity(); ++i) {
+		if (symbolCache.isUsed(i)) {
+			free(symbolCache.getValue(i)->symbols);
+		}
+	}
+
+	int functionCount = 0;
+	Function *const sortedFunctions = (Function *)malloc((functions.getCapacity() + 1) * sizeof(Function));
+	// Group the threads by process
+	HashMap<ProcessTotal> processes;
+	for (int i = 0; i < mThreads.getCapacity(); ++i) {
+		if (!mThreads.isUsed(i)) {
+			continue;
+		}
+		const int tid = mThreads.getKey(i);
+		const Thread *const thread = mThreads.getValue(i);
+		const int pid = thread->tgid > 0 ? thread->tgid : tid;
+		ProcessTotal *const process = processes.get((uint32_t)pid);
+		process->pid = pid;
+		process->cpuTime += thread->cpuTime;
+		process->samples += thread->samples;
+		if (tid == pid || process->nameId == 0) {
+			process->nameId = thread->nameId != 0 ? thread->nameId : process->nameId;
+		}
+	}
+	int processCount = 0;
+	ProcessTotal *const sortedProcesses = (ProcessTotal *)malloc((processes.getCapacity() + 1) * sizeof(ProcessTotal));
+	int counterCount = 0;
+	uint64_t *const counterKeys = (uint64_t *)malloc((mCounters.getCapacity() + 1) * sizeof(uint64_t));
+	if (sortedFunctions == NULL || sortedProcesses == NULL || counterKeys == NULL) {
+		logg->logError(__FILE__, __LINE__, "malloc failed");
+		handleException();
+	}
+
+	for (int i = 0; i < functions.getCapacity(); ++i) {
+		if (functions.isUsed(i)) {
+			sortedFunctions[functionCount++] = *functions.getValue(i);
+		}
+	}
+	// samples is the first member
+	qsort(sortedFunctions, functionCount, sizeof(Function), compareFunctions);
+	for (int i = 0; i < processes.getCapacity(); ++i) {
+		// pid 0 is the idle task
+		if (processes.isUsed(i) && processes.getKey(i) != 0) {
+			sortedProcesses[processCount++] = *processes.getValue(i);
+		}
+	}
+	qsort(sortedProcesses, processCount, sizeof(ProcessTotal), compareProcesses);
+	for (int i = 0; i < mCounters.getCapacity(); ++i) {
+		if (mCounters.isUsed(i)) {
+			counterKeys[counterCount++] = mCounters.getKey(i);
+		}
+	}
+	qsort(counterKeys, counterCount, sizeof(uint64_t), compareKeys);
+
+	FILE *const f = fopen(path, "w");
+	if (f == NULL) {
+		logg->logMessage("%s(%s:%i): Unable to open %s", __FUNCTION__, __FILE__, __LINE__, path);
+		free(sortedFunctions);
+		free(sortedProcesses);
+		free(counterKeys);
+		return false;
+	}
+
+	fprintf(f, "{\n  \"duration_ns\": %llu,\n  \"samples\": %lld,\n  \"top_functions\": [", (unsigned long long)duration, (long long)mSamples);
+	for (int i = 0; i < functionCount && i < MAX_TOP_FUNCTIONS; ++i) {
+		const Function &function = sortedFunctions[i];
+		fprintf(f, "%s\n    { \"function\": ", i == 0 ? "" : ",");
+		if (function.nameId != 0) {
+			writeJSONString(f, mNameList[function.nameId]);
+		} else {
+			fprintf(f, "null");
+		}
+		fprintf(f, ", \"image\": ");
+		if (function.imageId != 0) {
+			writeJSONString(f, mNameList[function.imageId]);
+		} else {
+			fprintf(f, "null");
+		}
+		fprintf(f, ", \"samples\": %lld }", (long long)function.samples);
+	}
+
+	bool deltas[MAX_PERFORMANCE_COUNTERS];
+	EventsXML eventsXML;
+	eventsXML.getDeltaCounters(deltas);
+
+	fprintf(f, "\n  ],\n  \"cores\": [");
+	int counterIndex = 0;
+	for (int core = 0; core < gSessionData->mCores && core < NR_CPUS; ++core) {
+		fprintf(f, "%s\n    { \"core\": %i, \"context_switches\": %lld, \"counters\": [", core == 0 ? "" : ",", core, (long long)mCores[core].contextSwitches);
+		for (bool first = true; counterIndex < counterCount && (int)(counterKeys[counterIndex] >> 32) <= core; ++counterIndex) {
+			if ((int)(counterKeys[counterIndex] >> 32) < core) {
+				continue;
+			}
+			const int key = (uint32_t)counterKeys[counterIndex];
+			const char *name = NULL;
+			bool delta = true;
+			for (int i = 0; i < MAX_PERFORMANCE_COUNTERS; ++i) {
+				if (gSessionData->mCounters[i].isEnabled() && gSessionData->mCounters[i].getKey() == key) {
+					name = gSessionData->mCounters[i].getType();
+					delta = deltas[i];
+					break;
+				}
+			}
+			// Skip the internal keys
+			if (name == NULL) {
+				continue;
+			}
+			const CounterTotal *const total = mCounters.find(counterKeys[counterIndex]);
+			fprintf(f, "%s\n      { \"name\": ", first ? "" : ",");
+			writeJSONString(f, name);
+			if (delta) {
+				fprintf(f, ", \"key\": %i, \"total\": %lld, \"values\": %lld, \"rate\": %.3f }", key, (long long)total->total, (long long)total->count, seconds > 0 ? total->total / seconds : 0.0);
+			} else {
+				// Summing absolute values is meaningless so report how they varied
+				fprintf(f, ", \"key\": %i, \"last\": %lld, \"min\": %lld, \"max\": %lld, \"mean\": %.3f, \"values\": %lld }", key, (long long)total->last, (long long)total->min, (long long)total->max,
+						total->count > 0 ? total->total / (double)total->count : 0.0, (long long)total->count);
+			}
+			first = false;
+		}
+		fprintf(f, "\n    ] }");
+	}
+
+	fprintf(f, "\n  ],\n  \"processes\": [");
+	for (int i = 0; i < processCount; ++i) {
+		const ProcessTotal &process = sortedProcesses[i];
+		fprintf(f, "%s\n    { \"pid\": %i, \"name\": ", i == 0 ? "" : ",", process.pid);
+		if (process.nameId != 0) {
+			writeJSONString(f, mNameList[process.nameId]);
+		} else {
+			fprintf(f, "null");
+		}
+		fprintf(f, ", \"cpu_time_ns\": %lld, \"samples\": %lld }", (long long)process.cpuTime, (long long)process.samples);
+	}
+	fprintf(f, "\n  ]\n}\n");
+
+	free(sortedFunctions);
+	free(sortedProcesses);
+	free(counterKeys);
+
+	const bool result = !ferror(f);
+	if (fclose(f) != 0 || !result) {
+		logg->logMessage("%s(%s:%i): Unable to write %s", __FUNCTION__, __FILE__, __LINE__, path);
+		return false;
+	}
+	return true;
+}
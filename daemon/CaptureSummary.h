@@ -0,0 +1,175 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef CAPTURESUMMARY_H
+#define CAPTURESUMMARY_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "Config.h"
+#include "DynBuf.h"
+#include "GatorDecode.h"
+#include "HashMap.h"
+#include "Logging.h"
+#include "StringTable.h"
+
+// Reduces the local capture data, as it is written, to a json summary for use without Streamline, eg to fail CI builds on performance regressions:
+// the most sampled functions, per core counter statistics, per core context switches and per process cpu time. The frames are decoded by GatorDecoder
+class CaptureSummary : private GatorDecodeHandler {
+public:
+	CaptureSummary();
+	~CaptureSummary();
+
+	// Receives the same data as the 0000000000 file of a local capture, frames may be split across calls
+	void write(const char *data, int length);
+	bool writeJSON(const char *const path);
+
+private:
+	static const int MAX_TOP_FUNCTIONS = 20;
+	// Image ids are stored in the top bits of the sample keys
+	static const int MAX_IMAGES = 0xffff;
+
+	struct Thread {
+		int64_t cpuTime;
+		int64_t samples;
+		int tgid;
+		int nameId;
+	};
+
+	struct Core {
+		int64_t contextSwitches;
+		uint64_t lastSwitch;
+		int running;
+		bool switched;
+	};
+
+	// Delta counters report the total and rate, absolute counters such as meminfo or cpu_freq report the last, min, max and mean
+	struct CounterTotal {
+		int64_t total;
+		int64_t last;
+		int64_t min;
+		int64_t max;
+		int64_t count;
+	};
+
+	struct Mapping {
+		uint64_t start;
+		uint64_t end;
+		uint64_t offset;
+		int imageId;
+	};
+
+	struct Mappings {
+		Mapping *mappings;
+		int count;
+		int capacity;
+	};
+
+	struct KeyAttr {
+		uint64_t sampleType;
+		uint64_t readFormat;
+		bool isTracepoint;
+	};
+
+	struct Symbol {
+		uint64_t start;
+		uint64_t size;
+		int nameId;
+	};
+
+	struct Symbols {
+		Symbol *symbols;
+		int count;
+		bool loaded;
+	};
+
+	struct Function {
+		int64_t samples;
+		int imageId;
+		int nameId;
+	};
+
+	// GatorDecodeHandler
+	void counter(int core, int64_t time, int key, int64_t value);
+	void backtrace(int core, int64_t time, int execCookie, int tgid, int pid);
+	void backtraceAddress(int core, int cookie, int64_t address);
+	void cookie(int core, int cookie, const char *name, int length);
+	void threadName(int core, int64_t time, int pid, const char *name, int length);
+	void link(int core, int64_t time, int cookie, int tgid, int pid);
+	void schedSwitch(int core, int64_t time, int pid, int state);
+	void pea(int core, const uint8_t *attr, int size, int key);
+	void key(int core, uint64_t id, int key);
+	void keysOld(int core, const int *keys, int keyCount, const uint8_t *data, int length);
+	void format(int core, const char *format, int length);
+	void maps(int core, int pid, int tid, const char *maps, int length);
+	void comm(int core, int pid, int tid, const char *image, int imageLength, const char *comm, int commLength);
+	void internedString(int core, int id, const char *str, int length);
+	void commId(int core, int pid, int tid, int imageId, int commId);
+	void mapping(int core, int pid, int tid, uint64_t start, uint64_t end, uint64_t offset, int flags, int pathId);
+	void perf(int cpu, const uint8_t *data, int length);
+
+	void perfSample(const int cpu, const int misc, const char *pos, const char *const end);
+
+	int nameId(const char *const name);
+	int nameId(const char *const name, const int length);
+	Thread *getThread(const int tid, const int tgid);
+	void addCounter(const int core, const int key, const int64_t value, const bool cumulative);
+	void contextSwitch(const int core, const uint64_t time, const int prevTid, const int nextTid);
+	void addMapping(const int pid, const uint64_t start, const uint64_t end, const uint64_t offset, const int imageId);
+	void addMaps(const int pid, const char *const maps);
+	void sample(const int tid, const int tgid, const int imageId, const uint64_t address);
+
+	template <typename Ehdr, typename Phdr, typename Shdr, typename Sym>
+	static Symbol *readElfSymbols(const char *const data, const size_t size, int *const count);
+	static int compareSymbols(const void *a, const void *b);
+	void loadSymbols(const int imageId, Symbols *const symbols);
+	int findFunction(const int imageId, const uint64_t address, HashMap<Symbols> *const symbolCache);
+
+	uint64_t mStartTime;
+	int64_t mSamples;
+
+	// Frame reassembly
+	char mLengthBuf[4];
+	int mLengthBytes;
+	int mFrameRemaining;
+	DynBuf mFrame;
+
+	// Interned image, thread and function names, mNameList[id] is the name with that id
+	StringTable mNames;
+	char **mNameList;
+	int mNameCapacity;
+	int mKernelImageId;
+
+	HashMap<Thread> mThreads;
+	Core mCores[NR_CPUS];
+	HashMap<CounterTotal> mCounters;
+	// Samples by image id and address, see sampleKey
+	HashMap<int64_t> mSampleCounts;
+
+	// Driver state, cookie to image id
+	HashMap<int> mCookies;
+	// The backtrace being decoded, only the first address is sampled
+	int mBacktraceTgid;
+	int mBacktracePid;
+	bool mBacktraceFirst;
+
+	// Perf state
+	HashMap<Mappings> mMaps;
+	HashMap<int> mIdKeys;
+	HashMap<KeyAttr> mKeyAttrs;
+	HashMap<int> mStrings;
+	int mPrevPidOffset;
+	int mNextPidOffset;
+
+	// Intentionally unimplemented
+	CaptureSummary(const CaptureSummary &);
+	CaptureSummary &operator=(const CaptureSummary &);
+};
+
+#endif // CAPTURESUMMARY_H
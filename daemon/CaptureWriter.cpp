@@ -0,0 +1,159 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "CaptureWriter.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <unistd.h>
+
+#include "Logging.h"
+
+CaptureWriter::CaptureWriter() : mFill(0), mPath(NULL), mFd(-1), mDirect(false), mOffset(0), mAllocated(0) {
+	for (int i = 0; i < CHUNK_COUNT; ++i) {
+		if (posix_memalign((void **)&mChunks[i], ALIGNMENT, CHUNK_SIZE) != 0) {
+			logg->logError(__FILE__, __LINE__, "failed to allocate %d bytes", CHUNK_SIZE);
+			handleException();
+		}
+		mChunkLengths[i] = 0;
+	}
+
+	// Chunk 0 is being filled, the rest are free
+	if (sem_init(&mFullSem, 0, 0) || sem_init(&mFreeSem, 0, CHUNK_COUNT - 1)) {
+		logg->logError(__FILE__, __LINE__, "sem_init() failed");
+		handleException();
+	}
+}
+
+CaptureWriter::~CaptureWriter() {
+	close();
+	for (int i = 0; i < CHUNK_COUNT; ++i) {
+		free(mChunks[i]);
+	}
+	sem_destroy(&mFullSem);
+	sem_destroy(&mFreeSem);
+}
+
+bool CaptureWriter::open(const char *const path) {
+	mPath = path;
+	mDirect = true;
+	mFd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0666);
+	if (mFd < 0 && errno == EINVAL) {
+		// The filesystem does not support O_DIRECT, eg tmpfs
+		mDirect = false;
+		mFd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	}
+	if (mFd < 0) {
+		return false;
+	}
+
+	if (pthread_create(&mWriterThreadID, NULL, writerThreadStatic, this) != 0) {
+		::close(mFd);
+		mFd = -1;
+		return false;
+	}
+
+	return true;
+}
+
+void CaptureWriter::queueChunk() {
+	sem_post(&mFullSem);
+	sem_wait(&mFreeSem);
+	mFill = (mFill + 1) % CHUNK_COUNT;
+	mChunkLengths[mFill] = 0;
+}
+
+void CaptureWriter::write(const char *data, int length) {
+	while (length > 0) {
+		const int space = CHUNK_SIZE - mChunkLengths[mFill];
+		const int bytes = length < space ? length : space;
+		memcpy(mChunks[mFill] + mChunkLengths[mFill], data, bytes);
+		mChunkLengths[mFill] += bytes;
+		data += bytes;
+		length -= bytes;
+
+		if (mChunkLengths[mFill] == CHUNK_SIZE) {
+			queueChunk();
+		}
+	}
+}
+
+void CaptureWriter::close() {
+	if (mFd < 0) {
+		return;
+	}
+
+	// A chunk that is not full tells the writer thread to exit after writing it
+	sem_post(&mFullSem);
+	pthread_join(mWriterThreadID, NULL);
+
+	// Remove the padding of the last O_DIRECT write and the unused preallocated space
+	if (ftruncate(mFd, mOffset) != 0) {
+		logg->logMessage("%s(%s:%i): ftruncate failed", __FUNCTION__, __FILE__, __LINE__);
+	}
+	if (fsync(mFd) != 0) {
+		logg->logMessage("%s(%s:%i): fsync failed", __FUNCTION__, __FILE__, __LINE__);
+	}
+	::close(mFd);
+	mFd = -1;
+}
+
+void *CaptureWriter::writerThreadStatic(void *arg) {
+	static_cast<CaptureWriter *>(arg)->writerThread();
+	return NULL;
+}
+
+void CaptureWriter::writeChunk(const char *const chunk, const int length) {
+	// O_DIRECT requires aligned lengths, the padding is removed in close
+	const int alignedLength = mDirect ? (length + ALIGNMENT - 1) & ~(ALIGNMENT - 1) : length;
+
+	if (mOffset + alignedLength > mAllocated) {
+		// Allocate in large extents to reduce fragmentation and metadata updates
+		if (fallocate(mFd, 0, mAllocated, EXTENT_SIZE) == 0) {
+			mAllocated += EXTENT_SIZE;
+		} else {
+			// Not supported by this filesystem, don't try again
+			logg->logMessage("%s(%s:%i): fallocate failed", __FUNCTION__, __FILE__, __LINE__);
+			mAllocated = (off_t)1 << (sizeof(off_t) * 8 - 2);
+		}
+	}
+
+	int pos = 0;
+	while (pos < alignedLength) {
+		const ssize_t bytes = pwrite(mFd, chunk + pos, alignedLength - pos, mOffset + pos);
+		if (bytes < 0 && errno == EINTR) {
+			continue;
+		}
+		if (bytes <= 0) {
+			logg->logError(__FILE__, __LINE__, "Failed writing binary file %s", mPath);
+			handleException();
+		}
+		pos += bytes;
+	}
+
+	mOffset += length;
+}
+
+void CaptureWriter::writerThread() {
+	prctl(PR_SET_NAME, (unsigned long)&"gatord-writer", 0, 0, 0);
+
+	for (int chunk = 0; ; chunk = (chunk + 1) % CHUNK_COUNT) {
+		sem_wait(&mFullSem);
+		const int length = mChunkLengths[chunk];
+		if (length > 0) {
+			writeChunk(mChunks[chunk], length);
+		}
+		if (length < CHUNK_SIZE) {
+			break;
+		}
+		sem_post(&mFreeSem);
+	}
+}
@@ -0,0 +1,60 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef CAPTUREWRITER_H
+#define CAPTUREWRITER_H
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/types.h>
+
+// Writes the local capture data file on its own thread so that a slow storage device does not stall the sender thread.
+// Data is copied into aligned chunks that are written with O_DIRECT if the filesystem supports it, the file is preallocated in large extents and is only synced on close
+class CaptureWriter {
+public:
+	CaptureWriter();
+	~CaptureWriter();
+
+	bool open(const char *const path);
+	// Blocks only when all the chunks are waiting to be written
+	void write(const char *data, int length);
+	// Writes any remaining data, trims the preallocated space and syncs the file
+	void close();
+
+private:
+	static const int CHUNK_SIZE = 1 << 20;
+	// Bounds the amount of data waiting to be written
+	static const int CHUNK_COUNT = 8;
+	static const int EXTENT_SIZE = 64 << 20;
+	// Satisfies the O_DIRECT alignment requirements of all common block devices
+	static const int ALIGNMENT = 4096;
+
+	static void *writerThreadStatic(void *arg);
+	void writerThread();
+	void writeChunk(const char *const chunk, const int length);
+	void queueChunk();
+
+	char *mChunks[CHUNK_COUNT];
+	int mChunkLengths[CHUNK_COUNT];
+	// Chunk currently being filled by write
+	int mFill;
+	sem_t mFullSem;
+	sem_t mFreeSem;
+	pthread_t mWriterThreadID;
+	const char *mPath;
+	int mFd;
+	bool mDirect;
+	off_t mOffset;
+	off_t mAllocated;
+
+	// Intentionally unimplemented
+	CaptureWriter(const CaptureWriter &);
+	CaptureWriter &operator=(const CaptureWriter &);
+};
+
+#endif // CAPTUREWRITER_H
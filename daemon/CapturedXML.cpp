@@ -22,7 +22,7 @@ CapturedXML::CapturedXML() {
 CapturedXML::~CapturedXML() {
 }
 
-mxml_node_t* CapturedXML::getTree(bool includeTime) {
+mxml_node_t* CapturedXML::getTree(bool includeTime, bool localCapture) {
 	mxml_node_t *xml;
 	mxml_node_t *captured;
 	mxml_node_t *target;
@@ -52,10 +52,12 @@ mxml_node_t* CapturedXML::getTree(bool includeTime) {
 		mxmlElementSetAttr(target, "supports_live", "yes");
 	}
 
-	if (gSessionData->mLocalCapture) {
+	if (localCapture) {
 		mxmlElementSetAttr(target, "local_capture", "yes");
 	}
 
+	gSessionData->threadPlacement.writeCaptured(captured);
+
 	mxml_node_t *counters = NULL;
 	for (x = 0; x < MAX_PERFORMANCE_COUNTERS; x++) {
 		const Counter & counter = gSessionData->mCounters[x];
@@ -83,7 +85,7 @@ mxml_node_t* CapturedXML::getTree(bool includeTime) {
 
 char* CapturedXML::getXML(bool includeTime) {
 	char* xml_string;
-	mxml_node_t *xml = getTree(includeTime);
+	mxml_node_t *xml = getTree(includeTime, gSessionData->mLocalCapture);
 	xml_string = mxmlSaveAllocString(xml, mxmlWhitespaceCB);
 	mxmlDelete(xml);
 	return xml_string;
@@ -95,7 +97,10 @@ void CapturedXML::write(char* path) {
 	// Set full path
 	snprintf(file, PATH_MAX, "%s/captured.xml", path);
 
-	char* xml = getXML(true);
+	// The data file is always in the local capture format, even when it is an archive of a live capture
+	mxml_node_t *tree = getTree(true, true);
+	char* xml = mxmlSaveAllocString(tree, mxmlWhitespaceCB);
+	mxmlDelete(tree);
 	if (util->writeToDisk(file, xml) < 0) {
 		logg->logError(__FILE__, __LINE__, "Error writing %s\nPlease verify the path.", file);
 		handleException();
@@ -112,7 +117,7 @@ const char * mxmlWhitespaceCB(mxml_node_t *node, int loc) {
 
 	if (loc == MXML_WS_BEFORE_OPEN) {
 		// Single indentation
-		if (!strcmp(name, "target") || !strcmp(name, "counters"))
+		if (!strcmp(name, "target") || !strcmp(name, "daemon") || !strcmp(name, "counters"))
 			return("\n  ");
 
 		// Double indentation
@@ -18,7 +18,7 @@ public:
 	char* getXML(bool includeTime); // the string should be freed by the caller
 	void write(char* path);
 private:
-	mxml_node_t* getTree(bool includeTime);
+	mxml_node_t* getTree(bool includeTime, bool localCapture);
 };
 
 const char * mxmlWhitespaceCB(mxml_node_t *node, int where);
@@ -16,6 +16,7 @@
 
 #include "Logging.h"
 #include "CapturedXML.h"
+#include "CaptureSummary.h"
 #include "SessionData.h"
 #include "LocalCapture.h"
 #include "Sender.h"
@@ -28,12 +29,14 @@
 #include "DriverSource.h"
 #include "ExternalSource.h"
 #include "UserSpaceSource.h"
+#include "Reactor.h"
 
 static sem_t haltPipeline, senderThreadStarted, startProfile, senderSem; // Shared by Child and spawned threads
 static Source *primarySource = NULL;
 static Source *externalSource = NULL;
 static Source *userSpaceSource = NULL;
 static Sender* sender = NULL;        // Shared by Child.cpp and spawned threads
+static Reactor *reactor = NULL;      // Runs the sources in place of their threads when set
 Child* child = NULL;                 // shared by Child.cpp and main.cpp
 
 extern void cleanUp();
@@ -87,6 +90,11 @@ static void child_handler(int signum) {
 	}
 }
 
+static void durationExpired() {
+	logg->logMessage("Duration expired.");
+	child->endSession();
+}
+
 static void *durationThread(void *) {
 	prctl(PR_SET_NAME, (unsigned long)&"gatord-duration", 0, 0, 0);
 	sem_wait(&startProfile);
@@ -95,45 +103,75 @@ static void *durationThread(void *) {
 		// Add a second for host-side filtering
 		sleep(gSessionData->mDuration + 1);
 		if (gSessionData->mSessionIsActive) {
-			logg->logMessage("Duration expired.");
-			child->endSession();
+			durationExpired();
 		}
 	}
 	logg->logMessage("Exit duration thread");
 	return 0;
 }
 
-static void *stopThread(void *) {
-	OlySocket* socket = child->socket;
+// Handles the APC_STOP or PING command from Streamline
+static void handleCommand(const unsigned char *const header) {
+	const char type = header[0];
+	const int length = (header[1] << 0) | (header[2] << 8) | (header[3] << 16) | (header[4] << 24);
+	if ((type != COMMAND_APC_STOP) && (type != COMMAND_PING)) {
+		logg->logMessage("INVESTIGATE: Received unknown command type %d", type);
+	} else {
+		// verify a length of zero
+		if (length == 0) {
+			if (type == COMMAND_APC_STOP) {
+				logg->logMessage("Stop command received.");
+				child->endSession();
+			} else {
+				// Ping is used to make sure gator is alive and requires an ACK as the response
+				logg->logMessage("Ping command received.");
+				sender->writeData(NULL, 0, RESPONSE_ACK);
+			}
+		} else {
+			logg->logMessage("INVESTIGATE: Received stop command but with length = %d", length);
+		}
+	}
+}
 
+// Receives a command, blocking until it is received or the socket is disconnected
+static void receiveCommand() {
+	unsigned char header[5];
+	const int result = child->socket->receiveNBytes((char*)&header, sizeof(header));
+	if (result == -1) {
+		child->endSession();
+	} else if (result > 0) {
+		handleCommand(header);
+	}
+}
+
+// The part of a command header received so far by the reactor
+static unsigned char commandHeader[5];
+static int commandHeaderLength = 0;
+
+// Called by the reactor when the socket is readable, receives what has arrived without blocking the reactor. A header may arrive in pieces so the part received is kept until the rest is readable
+static void receiveCommandNonBlocking() {
+	for (;;) {
+		const int bytes = child->socket->receiveNonBlocking((char*)commandHeader + commandHeaderLength, sizeof(commandHeader) - commandHeaderLength);
+		if (bytes < 0) {
+			child->endSession();
+			return;
+		}
+		if (bytes == 0) {
+			return;
+		}
+		commandHeaderLength += bytes;
+		if (commandHeaderLength == sizeof(commandHeader)) {
+			commandHeaderLength = 0;
+			handleCommand(commandHeader);
+		}
+	}
+}
+
+static void *stopThread(void *) {
 	prctl(PR_SET_NAME, (unsigned long)&"gatord-stopper", 0, 0, 0);
 	while (gSessionData->mSessionIsActive) {
 		// This thread will stall until the APC_STOP or PING command is received over the socket or the socket is disconnected
-		unsigned char header[5];
-		const int result = socket->receiveNBytes((char*)&header, sizeof(header));
-		const char type = header[0];
-		const int length = (header[1] << 0) | (header[2] << 8) | (header[3] << 16) | (header[4] << 24);
-		if (result == -1) {
-			child->endSession();
-		} else if (result > 0) {
-			if ((type != COMMAND_APC_STOP) && (type != COMMAND_PING)) {
-				logg->logMessage("INVESTIGATE: Received unknown command type %d", type);
-			} else {
-				// verify a length of zero
-				if (length == 0) {
-					if (type == COMMAND_APC_STOP) {
-						logg->logMessage("Stop command received.");
-						child->endSession();
-					} else {
-						// Ping is used to make sure gator is alive and requires an ACK as the response
-						logg->logMessage("Ping command received.");
-						sender->writeData(NULL, 0, RESPONSE_ACK);
-					}
-				} else {
-					logg->logMessage("INVESTIGATE: Received stop command but with length = %d", length);
-				}
-			}
-		}
+		receiveCommand();
 	}
 
 	logg->logMessage("Exit stop thread");
@@ -162,6 +200,8 @@ static void *senderThread(void *) {
 	// write end-of-capture sequence
 	if (!gSessionData->mLocalCapture) {
 		sender->writeData(end_sequence, sizeof(end_sequence), RESPONSE_APC_DATA);
+		// Send any data queued while the connection stalled before the connection is shut down
+		sender->flush();
 	}
 
 	logg->logMessage("Exit sender thread");
@@ -206,11 +246,15 @@ void Child::endSession() {
 	if (userSpaceSource != NULL) {
 		userSpaceSource->interrupt();
 	}
+	if (reactor != NULL) {
+		reactor->interrupt();
+	}
 	sem_post(&haltPipeline);
 }
 
 void Child::run() {
 	LocalCapture* localCapture = NULL;
+	CaptureSummary* summary = NULL;
 	pthread_t durationThreadID, stopThreadID, senderThreadID;
 
 	prctl(PR_SET_NAME, (unsigned long)&"gatord-child", 0, 0, 0);
@@ -249,10 +293,27 @@ void Child::run() {
 		}
 	}
 
+	for (Driver *driver = Driver::getHead(); driver != NULL; driver = driver->getNext()) {
+		driver->commitCounters();
+	}
+
 	// Start up and parse session xml
 	if (socket) {
 		// Respond to Streamline requests
 		StreamlineSetup ss(socket);
+		if (gSessionData->mArchivePath != NULL) {
+			if (ss.getSessionXML() == NULL) {
+				logg->logError(__FILE__, __LINE__, "Unable to archive the capture as Streamline did not send a session xml");
+				handleException();
+			}
+			localCapture = new LocalCapture();
+			localCapture->createAPCDirectory(gSessionData->mArchivePath);
+			localCapture->copyImages(gSessionData->mImages);
+			localCapture->write(ss.getSessionXML());
+		}
+		if (gSessionData->mArchivePath != NULL || gSessionData->mLiveDownsample > 1) {
+			sender->createLiveFilter(gSessionData->mLiveDownsample);
+		}
 	} else {
 		char* xmlString;
 		xmlString = util->readFromDisk(gSessionData->mSessionXMLPath);
@@ -265,10 +326,24 @@ void Child::run() {
 		localCapture->createAPCDirectory(gSessionData->mTargetPath);
 		localCapture->copyImages(gSessionData->mImages);
 		localCapture->write(xmlString);
-		sender->createDataFile(gSessionData->mAPCDir);
+		if (gSessionData->mSummaryPath != NULL) {
+			summary = new CaptureSummary();
+			sender->setSummary(summary);
+		}
 		free(xmlString);
 	}
 
+	// Must be after the counters are set up and the session XML is parsed, which set the rates the buffers are sized by, and before any buffers are created
+	gSessionData->bufferBudget.calculate();
+
+	// Must be after session XML is parsed and before any of the capture threads are created, including those of the Sender
+	gSessionData->threadPlacement.apply();
+
+	if (localCapture != NULL) {
+		sender->createDataFile(gSessionData->mAPCDir);
+	}
+	sender->createSpillQueue();
+
 	// Must be after session XML is parsed
 	if (!primarySource->prepare()) {
 		logg->logError(__FILE__, __LINE__, "Unable to prepare for capture");
@@ -278,11 +353,19 @@ void Child::run() {
 	// Sender thread shall be halted until it is signaled for one shot mode
 	sem_init(&haltPipeline, 0, gSessionData->mOneShot ? 0 : 2);
 
-	// Create the duration, stop, and sender threads
+	if (gSessionData->mReactor) {
+		reactor = new Reactor();
+		if (!reactor->init()) {
+			logg->logError(__FILE__, __LINE__, "Unable to create the reactor");
+			handleException();
+		}
+	}
+
+	// Create the duration, stop, and sender threads, the reactor handles the duration and stop commands itself
 	bool thread_creation_success = true;
-	if (gSessionData->mDuration > 0 && pthread_create(&durationThreadID, NULL, durationThread, NULL)) {
+	if (reactor == NULL && gSessionData->mDuration > 0 && pthread_create(&durationThreadID, NULL, durationThread, NULL)) {
 		thread_creation_success = false;
-	} else if (socket && pthread_create(&stopThreadID, NULL, stopThread, NULL)) {
+	} else if (reactor == NULL && socket && pthread_create(&stopThreadID, NULL, stopThread, NULL)) {
 		thread_creation_success = false;
 	} else if (pthread_create(&senderThreadID, NULL, senderThread, NULL)) {
 		thread_creation_success = false;
@@ -293,7 +376,9 @@ void Child::run() {
 		logg->logError(__FILE__, __LINE__, "Unable to prepare for capture");
 		handleException();
 	}
-	externalSource->start();
+	if (reactor == NULL) {
+		externalSource->start();
+	}
 
 	if (gSessionData->hwmon.countersEnabled() || gSessionData->fsDriver.countersEnabled()) {
 		userSpaceSource = new UserSpaceSource(&senderSem);
@@ -301,7 +386,9 @@ void Child::run() {
 			logg->logError(__FILE__, __LINE__, "Unable to prepare for capture");
 			handleException();
 		}
-		userSpaceSource->start();
+		if (reactor == NULL) {
+			userSpaceSource->start();
+		}
 	}
 
 	if (!thread_creation_success) {
@@ -313,34 +400,87 @@ void Child::run() {
 	sem_wait(&senderThreadStarted);
 
 	// Start profiling
-	primarySource->run();
+	if (reactor != NULL) {
+		runReactor();
+	} else {
+		primarySource->run();
 
-	if (userSpaceSource != NULL) {
-		userSpaceSource->join();
+		if (userSpaceSource != NULL) {
+			userSpaceSource->join();
+		}
+		externalSource->join();
 	}
-	externalSource->join();
 
 	// Wait for the other threads to exit
 	pthread_join(senderThreadID, NULL);
 
 	// Shutting down the connection should break the stop thread which is stalling on the socket recv() function
-	if (socket) {
+	if (socket && reactor == NULL) {
 		logg->logMessage("Waiting on stop thread");
 		socket->shutdownConnection();
 		pthread_join(stopThreadID, NULL);
 	}
 
 	// Write the captured xml file
-	if (gSessionData->mLocalCapture) {
+	if (gSessionData->mLocalCapture || gSessionData->mArchivePath != NULL) {
 		CapturedXML capturedXML;
 		capturedXML.write(gSessionData->mAPCDir);
 	}
 
+	// The sender thread has exited so all the data has been passed to the summary
+	if (summary != NULL && !summary->writeJSON(gSessionData->mSummaryPath)) {
+		logg->logError(__FILE__, __LINE__, "Unable to write the capture summary: %s", gSessionData->mSummaryPath);
+		handleException();
+	}
+
 	logg->logMessage("Profiling ended.");
 
+	delete reactor;
+	reactor = NULL;
 	delete userSpaceSource;
 	delete externalSource;
 	delete primarySource;
 	delete sender;
+	delete summary;
 	delete localCapture;
 }
+
+void Child::runReactor() {
+	// Sources that can't be polled, like the driver whose reads block, keep their own thread
+	bool primaryThread = false, externalThread = false, userSpaceThread = false;
+	if (!reactor->add(primarySource)) {
+		primarySource->start();
+		primaryThread = true;
+	}
+	if (!reactor->add(externalSource)) {
+		externalSource->start();
+		externalThread = true;
+	}
+	if (userSpaceSource != NULL && !reactor->add(userSpaceSource)) {
+		userSpaceSource->start();
+		userSpaceThread = true;
+	}
+
+	commandHeaderLength = 0;
+	if (socket && !reactor->addFd(socket->getFd(), receiveCommandNonBlocking)) {
+		logg->logError(__FILE__, __LINE__, "Unable to add the socket to the reactor");
+		handleException();
+	}
+	// Add a second for host-side filtering
+	if (gSessionData->mDuration > 0 && !reactor->addTimer((gSessionData->mDuration + 1)*NS_PER_S, durationExpired)) {
+		logg->logError(__FILE__, __LINE__, "Unable to add the duration timer to the reactor");
+		handleException();
+	}
+
+	reactor->run();
+
+	if (userSpaceThread) {
+		userSpaceSource->join();
+	}
+	if (externalThread) {
+		externalSource->join();
+	}
+	if (primaryThread) {
+		primarySource->join();
+	}
+}
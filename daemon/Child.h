@@ -24,6 +24,7 @@ private:
 	int mNumConnections;
 
 	void initialization();
+	void runReactor();
 
 	// Intentionally unimplemented
 	Child(const Child &);
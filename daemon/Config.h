@@ -14,4 +14,6 @@
 #define MAX_PERFORMANCE_COUNTERS 50
 #define NR_CPUS 16
 
+#define DEFAULT_PORT 8080
+
 #endif // CONFIG_H
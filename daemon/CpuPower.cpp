@@ -0,0 +1,125 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "CpuPower.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Buffer.h"
+#include "DriverSource.h"
+#include "Logging.h"
+#include "SessionData.h"
+
+// cpu_idle reports PWR_EVENT_EXIT when leaving idle
+#define PWR_EVENT_EXIT 0xffffffffU
+
+CpuPower::CpuPower() : mFreqKey(-1), mIdleKey(-1), mIdleTimeKey(-1), mFreqTracepoint(-1) {
+	memset(mFreq, 0, sizeof(mFreq));
+	memset(mIdle, 0, sizeof(mIdle));
+	memset(mIdleStart, 0, sizeof(mIdleStart));
+	memset(mIdleTime, 0, sizeof(mIdleTime));
+}
+
+bool CpuPower::init(PerfAnalytics *const analytics) {
+	mFreqKey = gSessionData->perf.getEnabledKey("Linux_power_cpu_freq");
+	mIdleKey = gSessionData->perf.getEnabledKey("Linux_power_cpu_idle");
+	mIdleTimeKey = gSessionData->perf.getEnabledKey("Linux_power_cpu_idle_time");
+
+	DynBuf format;
+	if (mFreqKey >= 0) {
+		if ((mFreqTracepoint = analytics->addTracepoint(CPU_FREQUENCY, this, &format)) < 0
+				|| !PerfAnalytics::getField(format.getBuf(), "state", &mFreqState.offset, &mFreqState.size)
+				|| !PerfAnalytics::getField(format.getBuf(), "cpu_id", &mFreqCpu.offset, &mFreqCpu.size)) {
+			logg->logMessage("%s(%s:%i): Unable to add the cpu_frequency tracepoint", __FUNCTION__, __FILE__, __LINE__);
+			return false;
+		}
+
+		// The tracepoint only fires on changes so start with the current frequency
+		char buf[128];
+		for (int cpu = 0; cpu < gSessionData->mCores && cpu < NR_CPUS; ++cpu) {
+			int64_t freq;
+			snprintf(buf, sizeof(buf), "/sys/devices/system/cpu/cpu%i/cpufreq/scaling_cur_freq", cpu);
+			if (DriverSource::readInt64Driver(buf, &freq) == 0) {
+				set(mFreq, cpu, freq);
+			}
+		}
+	}
+
+	if (mIdleKey >= 0 || mIdleTimeKey >= 0) {
+		if (analytics->addTracepoint(CPU_IDLE, this, &format) < 0
+				|| !PerfAnalytics::getField(format.getBuf(), "state", &mIdleState.offset, &mIdleState.size)
+				|| !PerfAnalytics::getField(format.getBuf(), "cpu_id", &mIdleCpu.offset, &mIdleCpu.size)) {
+			logg->logMessage("%s(%s:%i): Unable to add the cpu_idle tracepoint", __FUNCTION__, __FILE__, __LINE__);
+			return false;
+		}
+
+		for (int cpu = 0; cpu < gSessionData->mCores && cpu < NR_CPUS; ++cpu) {
+			set(mIdle, cpu, 0);
+		}
+	}
+
+	return mFreqKey >= 0 || mIdleKey >= 0 || mIdleTimeKey >= 0;
+}
+
+void CpuPower::set(State *const states, const int cpu, const int64_t value) {
+	if (cpu < 0 || cpu >= NR_CPUS) {
+		return;
+	}
+	states[cpu].value = value;
+	states[cpu].dirty = true;
+}
+
+void CpuPower::sample(const int, const uint64_t time, const int tracepoint, const char *const raw, const int size) {
+	// cpu_id is the cpu the value applies to, which is not always the cpu that took the sample
+	if (tracepoint == mFreqTracepoint) {
+		set(mFreq, PerfAnalytics::readField(raw, size, mFreqCpu.offset, mFreqCpu.size), (uint32_t)PerfAnalytics::readField(raw, size, mFreqState.offset, mFreqState.size));
+	} else {
+		// As in gator.ko, the counter is the idle state + 1 so that running is 0
+		const uint32_t state = PerfAnalytics::readField(raw, size, mIdleState.offset, mIdleState.size);
+		const int cpu = PerfAnalytics::readField(raw, size, mIdleCpu.offset, mIdleCpu.size);
+		set(mIdle, cpu, state == PWR_EVENT_EXIT ? 0 : state + 1);
+
+		if (cpu < 0 || cpu >= NR_CPUS) {
+			return;
+		}
+		if (state != PWR_EVENT_EXIT) {
+			// Changing between idle states continues the same idle period
+			if (mIdleStart[cpu] == 0) {
+				mIdleStart[cpu] = time;
+			}
+		} else if (mIdleStart[cpu] != 0) {
+			if (time > mIdleStart[cpu]) {
+				mIdleTime[cpu] += time - mIdleStart[cpu];
+			}
+			mIdleStart[cpu] = 0;
+		}
+	}
+}
+
+void CpuPower::flushCpu(const int cpu, const uint64_t time, Buffer *const buffer) {
+	if (mFreqKey >= 0 && mFreq[cpu].dirty) {
+		// The tracepoint is in kHz
+		buffer->event64(mFreqKey, mFreq[cpu].value * 1000);
+		mFreq[cpu].dirty = false;
+	}
+	if (mIdleKey >= 0 && mIdle[cpu].dirty) {
+		buffer->event64(mIdleKey, mIdle[cpu].value);
+		mIdle[cpu].dirty = false;
+	}
+
+	// An idle period that spans the end of the window is split between the windows
+	if (mIdleStart[cpu] != 0 && time > mIdleStart[cpu]) {
+		mIdleTime[cpu] += time - mIdleStart[cpu];
+		mIdleStart[cpu] = time;
+	}
+	if (mIdleTimeKey >= 0 && mIdleTime[cpu] != 0) {
+		buffer->event64(mIdleTimeKey, mIdleTime[cpu]);
+	}
+	mIdleTime[cpu] = 0;
+}
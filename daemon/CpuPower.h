@@ -0,0 +1,65 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef CPUPOWER_H
+#define CPUPOWER_H
+
+#include <stdint.h>
+
+#include "Config.h"
+#include "PerfAnalytics.h"
+
+#define CPU_FREQUENCY "power/cpu_frequency"
+#define CPU_IDLE "power/cpu_idle"
+
+// Per cpu frequency and idle state from the cpu_frequency and cpu_idle tracepoints, the last value of each window is sent.
+// The time spent idle is accumulated over each window as a state sampled once per window would miss most idle periods
+class CpuPower : public PerfAnalyzer {
+public:
+	CpuPower();
+
+	// Returns false if none of the counters are enabled or the tracepoints are not available
+	bool init(PerfAnalytics *const analytics);
+
+	void sample(const int cpu, const uint64_t time, const int tracepoint, const char *const raw, const int size);
+	bool isPerCpu() const { return true; }
+	void flushCpu(const int cpu, const uint64_t time, Buffer *const buffer);
+
+private:
+	struct Field {
+		int offset;
+		int size;
+	};
+
+	struct State {
+		int64_t value;
+		bool dirty;
+	};
+
+	void set(State *const states, const int cpu, const int64_t value);
+
+	State mFreq[NR_CPUS];
+	State mIdle[NR_CPUS];
+	// Start of the current idle period or 0 if running, and the idle time of the window so far
+	uint64_t mIdleStart[NR_CPUS];
+	int64_t mIdleTime[NR_CPUS];
+	int mFreqKey;
+	int mIdleKey;
+	int mIdleTimeKey;
+	int mFreqTracepoint;
+	Field mFreqState;
+	Field mFreqCpu;
+	Field mIdleState;
+	Field mIdleCpu;
+
+	// Intentionally unimplemented
+	CpuPower(const CpuPower &);
+	CpuPower &operator=(const CpuPower &);
+};
+
+#endif // CPUPOWER_H
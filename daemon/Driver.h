@@ -25,6 +25,8 @@ public:
 	virtual void resetCounters() = 0;
 	// Enables and prepares the counter for capture
 	virtual void setupCounter(Counter &counter) = 0;
+	// Applies any counter setup deferred by setupCounter, called once all counters have been set up
+	virtual void commitCounters() {}
 
 	// Emits available counters
 	virtual int writeCounters(mxml_node_t *root) const = 0;
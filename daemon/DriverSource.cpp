@@ -86,7 +86,7 @@ DriverSource::~DriverSource() {
 
 bool DriverSource::prepare() {
 	// Create user-space buffers, add 5 to the size to account for the 1-byte type and 4-byte length
-	logg->logMessage("Created %d MB collector buffer with a %d-byte ragged end", gSessionData->mTotalBufferSize, mBufferSize);
+	logg->logMessage("Created %d MB collector buffer for %d-byte driver reads", gSessionData->mTotalBufferSize, mBufferSize);
 	mFifo = new Fifo(mBufferSize + 5, gSessionData->mTotalBufferSize*1024*1024, mSenderSem);
 
 	return true;
@@ -121,12 +121,6 @@ void DriverSource::run() {
 
 	logg->logMessage("********** Profiling started **********");
 
-	// Set the maximum backtrace depth
-	if (writeReadDriver("/dev/gator/backtrace_depth", &gSessionData->mBacktraceDepth)) {
-		logg->logError(__FILE__, __LINE__, "Unable to set the driver backtrace depth");
-		handleException();
-	}
-
 	// open the buffer which calls userspace_buffer_open() in the driver
 	mBufferFD = open("/dev/gator/buffer", O_RDONLY);
 	if (mBufferFD < 0) {
@@ -134,23 +128,50 @@ void DriverSource::run() {
 		handleException();
 	}
 
-	// set the tick rate of the profiling timer
-	if (writeReadDriver("/dev/gator/tick", &gSessionData->mSampleRate) != 0) {
-		logg->logError(__FILE__, __LINE__, "Unable to set the driver tick");
-		handleException();
-	}
+	const int response_type = gSessionData->mLocalCapture ? 0 : RESPONSE_APC_DATA;
+
+	// Set the backtrace depth, tick, response type, live rate and block counter format with a single write if the driver supports it
+	GatorConfigHeader config;
+	memset(&config, 0, sizeof(config));
+	config.flags = GATOR_CONFIG_SESSION;
+	config.backtraceDepth = gSessionData->mBacktraceDepth;
+	config.tick = gSessionData->mSampleRate;
+	config.responseType = response_type;
+	config.compactCounters = gSessionData->mCompactCounters;
+	config.liveRate = gSessionData->mLiveRate;
+	if (writeReadConfig(&config, sizeof(config)) == 0) {
+		gSessionData->mBacktraceDepth = config.backtraceDepth;
+		gSessionData->mSampleRate = config.tick;
+		gSessionData->mLiveRate = config.liveRate;
+	} else {
+		// Set the maximum backtrace depth
+		if (writeReadDriver("/dev/gator/backtrace_depth", &gSessionData->mBacktraceDepth)) {
+			logg->logError(__FILE__, __LINE__, "Unable to set the driver backtrace depth");
+			handleException();
+		}
 
-	// notify the kernel of the response type
-	int response_type = gSessionData->mLocalCapture ? 0 : RESPONSE_APC_DATA;
-	if (writeDriver("/dev/gator/response_type", response_type)) {
-		logg->logError(__FILE__, __LINE__, "Unable to write the response type");
-		handleException();
-	}
+		// set the tick rate of the profiling timer
+		if (writeReadDriver("/dev/gator/tick", &gSessionData->mSampleRate) != 0) {
+			logg->logError(__FILE__, __LINE__, "Unable to set the driver tick");
+			handleException();
+		}
 
-	// Set the live rate
-	if (writeReadDriver("/dev/gator/live_rate", &gSessionData->mLiveRate)) {
-		logg->logError(__FILE__, __LINE__, "Unable to set the driver live rate");
-		handleException();
+		// notify the kernel of the response type
+		if (writeDriver("/dev/gator/response_type", response_type)) {
+			logg->logError(__FILE__, __LINE__, "Unable to write the response type");
+			handleException();
+		}
+
+		// Set the live rate
+		if (writeReadDriver("/dev/gator/live_rate", &gSessionData->mLiveRate)) {
+			logg->logError(__FILE__, __LINE__, "Unable to set the driver live rate");
+			handleException();
+		}
+
+		// Older drivers only produce uncompressed block counter frames
+		if (gSessionData->mCompactCounters) {
+			writeDriver("/dev/gator/compact_counters", 1);
+		}
 	}
 
 	logg->logMessage("Start the driver");
@@ -319,3 +340,27 @@ int DriverSource::writeReadDriver(const char *path, int64_t *value) {
 	}
 	return 0;
 }
+
+int DriverSource::writeReadConfig(GatorConfigHeader *config, size_t size) {
+	const int fd = open("/dev/gator/session_config", O_RDWR);
+	if (fd < 0) {
+		return -1;
+	}
+
+	config->magic = GATOR_CONFIG_MAGIC;
+	config->version = GATOR_CONFIG_VERSION;
+	if (::write(fd, config, size) != (ssize_t)size) {
+		close(fd);
+		logg->logMessage("Driver rejected the session configuration");
+		return -1;
+	}
+
+	if (pread(fd, config, size, 0) != (ssize_t)size) {
+		close(fd);
+		logg->logMessage("Unable to read back the session configuration");
+		return -1;
+	}
+
+	close(fd);
+	return 0;
+}
@@ -14,6 +14,34 @@
 
 #include "Source.h"
 
+// Binary session configuration written to /dev/gator/session_config, must be kept in sync with gator_main.c in the driver
+#define GATOR_CONFIG_MAGIC    0x47434647
+#define GATOR_CONFIG_VERSION  1
+#define GATOR_CONFIG_SESSION  (1 << 0)
+#define GATOR_CONFIG_COUNTERS (1 << 1)
+#define GATOR_CONFIG_NAME_LEN 80
+
+struct GatorConfigHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t flags;
+	uint32_t count;
+	int32_t backtraceDepth;
+	int32_t tick;
+	int32_t responseType;
+	int32_t compactCounters;
+	int64_t liveRate;
+};
+
+struct GatorConfigCounter {
+	char name[GATOR_CONFIG_NAME_LEN];
+	int32_t enabled;
+	int32_t event;
+	int32_t count;
+	int32_t key;
+	int32_t cores;
+};
+
 class Buffer;
 class Fifo;
 
@@ -36,6 +64,8 @@ public:
 	static int writeDriver(const char *path, int64_t value);
 	static int writeReadDriver(const char *path, int *value);
 	static int writeReadDriver(const char *path, int64_t *value);
+	// Writes a GatorConfigHeader and the GatorConfigCounters that follow it then reads back what the driver applied
+	static int writeReadConfig(GatorConfigHeader *config, size_t size);
 
 private:
 	static void *bootstrapThreadStatic(void *arg);
@@ -12,6 +12,7 @@
 #include <fcntl.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "Logging.h"
@@ -100,6 +101,20 @@ int DynBuf::readlink(const char *const path) {
 	return 0;
 }
 
+bool DynBuf::append(const void *const data, const size_t size) {
+	if (capacity < length + size) {
+		if (resize(length + size) != 0) {
+			logg->logMessage("%s(%s:%i): DynBuf::resize failed", __FUNCTION__, __FILE__, __LINE__);
+			return false;
+		}
+	}
+
+	memcpy(buf + length, data, size);
+	length += size;
+
+	return true;
+}
+
 bool DynBuf::printf(const char *format, ...) {
 	va_list ap;
 
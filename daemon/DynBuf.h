@@ -27,11 +27,17 @@ public:
 		}
 	}
 
+	// Empties the buffer but keeps the memory for reuse
+	inline void clear() {
+		length = 0;
+	}
+
 	bool read(const char *const path);
 	// On error instead of printing the error and returning false, this returns -errno
 	int readlink(const char *const path);
 	__attribute__ ((format(printf, 2, 3)))
 	bool printf(const char *format, ...);
+	bool append(const void *const data, const size_t size);
 
 	size_t getLength() const { return length; }
 	const char *getBuf() const { return buf; }
@@ -41,7 +41,8 @@ mxml_node_t *EventsXML::getTree() {
 	return xml;
 }
 
-char *EventsXML::getXML() {
+// The events xml including the events added by the drivers
+mxml_node_t *EventsXML::getDynamicTree() {
 	mxml_node_t *xml = getTree();
 
 	// Add dynamic events from the drivers
@@ -54,12 +55,52 @@ char *EventsXML::getXML() {
 		driver->writeEvents(events);
 	}
 
+	return xml;
+}
+
+char *EventsXML::getXML() {
+	mxml_node_t *xml = getDynamicTree();
+
 	char *string = mxmlSaveAllocString(xml, mxmlWhitespaceCB);
 	mxmlDelete(xml);
 
 	return string;
 }
 
+void EventsXML::getDeltaCounters(bool *const deltas) {
+	mxml_node_t *xml = getDynamicTree();
+
+	for (int i = 0; i < MAX_PERFORMANCE_COUNTERS; ++i) {
+		// Streamline treats events without a class as delta
+		deltas[i] = true;
+	}
+
+	for (mxml_node_t *node = mxmlFindElement(xml, xml, "event", NULL, NULL, MXML_DESCEND); node != NULL; node = mxmlFindElement(node, xml, "event", NULL, NULL, MXML_DESCEND)) {
+		const char *const counterClass = mxmlElementGetAttr(node, "class");
+		if (counterClass == NULL || strcmp(counterClass, "delta") == 0 || strcmp(counterClass, "incident") == 0) {
+			continue;
+		}
+
+		// Events either name their counter or are one of the events of the counter set of their category, eg ARM_Cortex-A9_cnt0
+		const char *const counter = mxmlElementGetAttr(node, "counter");
+		mxml_node_t *const category = mxmlGetParent(node);
+		const char *const counterSet = counter != NULL || category == NULL ? NULL : mxmlElementGetAttr(category, "counter_set");
+		const char *const event = mxmlElementGetAttr(node, "event");
+		for (int i = 0; i < MAX_PERFORMANCE_COUNTERS; ++i) {
+			const Counter &c = gSessionData->mCounters[i];
+			if (!c.isEnabled()) {
+				continue;
+			}
+			if ((counter != NULL && strcmp(counter, c.getType()) == 0) ||
+					(counterSet != NULL && event != NULL && strncmp(counterSet, c.getType(), strlen(counterSet)) == 0 && strtol(event, NULL, 16) == c.getEvent())) {
+				deltas[i] = false;
+			}
+		}
+	}
+
+	mxmlDelete(xml);
+}
+
 void EventsXML::write(const char *path) {
 	char file[PATH_MAX];
 
@@ -16,6 +16,11 @@ public:
 	mxml_node_t *getTree();
 	char *getXML();
 	void write(const char* path);
+	// Sets deltas[i] if the values of gSessionData->mCounters[i] are the change since the previous value, ie its class is delta or incident, rather than a level
+	void getDeltaCounters(bool *const deltas);
+
+private:
+	mxml_node_t *getDynamicTree();
 };
 
 #endif // EVENTS_XML
@@ -37,7 +37,7 @@ static bool setNonblock(const int fd) {
 	return true;
 }
 
-ExternalSource::ExternalSource(sem_t *senderSem) : mBuffer(0, FRAME_EXTERNAL, 128*1024, senderSem), mMonitor(), mMveStartupUds(MALI_VIDEO_STARTUP, sizeof(MALI_VIDEO_STARTUP)), mInterruptFd(-1), mMveUds(-1) {
+ExternalSource::ExternalSource(sem_t *senderSem) : mBuffer(0, FRAME_EXTERNAL, 128*1024, senderSem), mMonitor(), mMveStartupUds(MALI_VIDEO_STARTUP, sizeof(MALI_VIDEO_STARTUP)), mInterruptFd(-1), mInterruptReadFd(-1), mMveUds(-1) {
 	sem_init(&mBufferSem, 0, 0);
 }
 
@@ -108,6 +108,7 @@ void ExternalSource::run() {
 		logg->logError(__FILE__, __LINE__, "pipe failed");
 		handleException();
 	}
+	mInterruptReadFd = pipefd[0];
 	mInterruptFd = pipefd[1];
 
 	if (!mMonitor.add(pipefd[0])) {
@@ -116,76 +117,93 @@ void ExternalSource::run() {
 	}
 
 	while (gSessionData->mSessionIsActive) {
-		struct epoll_event events[16];
-		// Clear any pending sem posts
-		while (sem_trywait(&mBufferSem) == 0);
-		int ready = mMonitor.wait(events, ARRAY_LENGTH(events), -1);
-		if (ready < 0) {
-			logg->logError(__FILE__, __LINE__, "Monitor::wait failed");
-			handleException();
-		}
+		process(-1);
+	}
 
-		const uint64_t currTime = getTime();
-
-		for (int i = 0; i < ready; ++i) {
-			const int fd = events[i].data.fd;
-			if (fd == mMveStartupUds.getFd()) {
-				// Mali Video Engine says it's alive
-				int client = mMveStartupUds.acceptConnection();
-				// Don't read from this connection, establish a new connection to Mali-V500
-				close(client);
-				if (!connectMve()) {
-					logg->logError(__FILE__, __LINE__, "Unable to configure incoming Mali video connection");
-					handleException();
-				}
-			} else if (fd == pipefd[0]) {
-				// Means interrupt has been called and mSessionIsActive should be reread
-			} else {
-				while (true) {
-					waitFor(currTime, Buffer::MAXSIZE_PACK32 + 4);
-
-					mBuffer.packInt(fd);
-					char *const bytesPos = mBuffer.getWritePos();
-					mBuffer.advanceWrite(4);
-					const int contiguous = mBuffer.contiguousSpaceAvailable();
-					const int bytes = read(fd, mBuffer.getWritePos(), contiguous);
-					if (bytes < 0) {
-						if (errno == EAGAIN) {
-							// Nothing left to read, and Buffer convention dictates that writePos can't go backwards
-							mBuffer.writeLEInt((unsigned char *)bytesPos, 0);
-							break;
-						}
-						// Something else failed, close the socket
-						mBuffer.writeLEInt((unsigned char *)bytesPos, -1);
-						close(fd);
-						break;
-					} else if (bytes == 0) {
-						// The other side is closed
-						mBuffer.writeLEInt((unsigned char *)bytesPos, -1);
-						close(fd);
-						break;
-					}
+	mBuffer.setDone();
 
-					mBuffer.writeLEInt((unsigned char *)bytesPos, bytes);
-					mBuffer.advanceWrite(bytes);
+	mInterruptFd = -1;
+	mInterruptReadFd = -1;
+	close(pipefd[0]);
+	close(pipefd[1]);
+}
 
-					// Short reads also mean nothing is left to read
-					if (bytes < contiguous) {
+void ExternalSource::process(const int timeout) {
+	struct epoll_event events[16];
+	// Clear any pending sem posts
+	while (sem_trywait(&mBufferSem) == 0);
+	int ready = mMonitor.wait(events, ARRAY_LENGTH(events), timeout);
+	if (ready < 0) {
+		logg->logError(__FILE__, __LINE__, "Monitor::wait failed");
+		handleException();
+	}
+
+	const uint64_t currTime = getTime();
+
+	for (int i = 0; i < ready; ++i) {
+		const int fd = events[i].data.fd;
+		if (fd == mMveStartupUds.getFd()) {
+			// Mali Video Engine says it's alive
+			int client = mMveStartupUds.acceptConnection();
+			// Don't read from this connection, establish a new connection to Mali-V500
+			close(client);
+			if (!connectMve()) {
+				logg->logError(__FILE__, __LINE__, "Unable to configure incoming Mali video connection");
+				handleException();
+			}
+		} else if (fd == mInterruptReadFd) {
+			// Means interrupt has been called and mSessionIsActive should be reread
+		} else {
+			while (true) {
+				waitFor(currTime, Buffer::MAXSIZE_PACK32 + 4);
+
+				mBuffer.packInt(fd);
+				char *const bytesPos = mBuffer.getWritePos();
+				mBuffer.advanceWrite(4);
+				const int contiguous = mBuffer.contiguousSpaceAvailable();
+				const int bytes = read(fd, mBuffer.getWritePos(), contiguous);
+				if (bytes < 0) {
+					if (errno == EAGAIN) {
+						// Nothing left to read, and Buffer convention dictates that writePos can't go backwards
+						mBuffer.writeLEInt((unsigned char *)bytesPos, 0);
 						break;
 					}
+					// Something else failed, close the socket
+					mBuffer.writeLEInt((unsigned char *)bytesPos, -1);
+					close(fd);
+					break;
+				} else if (bytes == 0) {
+					// The other side is closed
+					mBuffer.writeLEInt((unsigned char *)bytesPos, -1);
+					close(fd);
+					break;
+				}
+
+				mBuffer.writeLEInt((unsigned char *)bytesPos, bytes);
+				mBuffer.advanceWrite(bytes);
+
+				// Short reads also mean nothing is left to read
+				if (bytes < contiguous) {
+					break;
 				}
 			}
 		}
-
-		// Only call mBufferCheck once per iteration
-		mBuffer.check(currTime);
 	}
 
-	mBuffer.setDone();
+	// Only call mBufferCheck once per iteration
+	mBuffer.check(currTime);
+}
 
-	mInterruptFd = -1;
-	close(pipefd[0]);
-	close(pipefd[1]);
+int ExternalSource::pollStart() {
+	return mMonitor.getFd();
+}
+
+void ExternalSource::poll() {
+	process(0);
+}
+
+void ExternalSource::pollStop() {
+	mBuffer.setDone();
 }
 
 void ExternalSource::interrupt() {
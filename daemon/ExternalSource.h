@@ -29,7 +29,12 @@ public:
 	bool isDone();
 	void write(Sender *sender);
 
+	int pollStart();
+	void poll();
+	void pollStop();
+
 private:
+	void process(const int timeout);
 	void waitFor(const uint64_t currTime, const int bytes);
 	void configureConnection(const int fd, const char *const handshake, size_t size);
 	bool connectMve();
@@ -39,6 +44,7 @@ private:
 	Monitor mMonitor;
 	OlyServerSocket mMveStartupUds;
 	int mInterruptFd;
+	int mInterruptReadFd;
 	int mMveUds;
 
 	// Intentionally unimplemented
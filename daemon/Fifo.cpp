@@ -8,26 +8,23 @@
 
 #include "Fifo.h"
 
-#include <stdlib.h>
-#ifdef WIN32
-#define valloc malloc
-#endif
-
 #include "Logging.h"
+#include "MirroredMemory.h"
 
 // bufferSize is the amount of data to be filled
 // singleBufferSize is the maximum size that may be filled during a single write
-// (bufferSize + singleBufferSize) will be allocated
+// At least (bufferSize + singleBufferSize) will be mapped twice back to back so that every write and read is contiguous
 Fifo::Fifo(int singleBufferSize, int bufferSize, sem_t* readerSem) {
-  mWrite = mRead = mReadCommit = mRaggedEnd = 0;
-  mWrapThreshold = bufferSize;
+  mWrite = mRead = mReadCommit = 0;
   mSingleBufferSize = singleBufferSize;
   mReaderSem = readerSem;
-  mBuffer = (char*)valloc(bufferSize + singleBufferSize);
+  size_t size = bufferSize + singleBufferSize;
+  mBuffer = mirroredMap(&size);
+  mSize = size;
   mEnd = false;
 
   if (mBuffer == NULL) {
-    logg->logError(__FILE__, __LINE__, "failed to allocate %d bytes", bufferSize + singleBufferSize);
+    logg->logError(__FILE__, __LINE__, "failed to map %d bytes", bufferSize + singleBufferSize);
     handleException();
   }
 
@@ -38,12 +35,16 @@ Fifo::Fifo(int singleBufferSize, int bufferSize, sem_t* readerSem) {
 }
 
 Fifo::~Fifo() {
-  free(mBuffer);
+  mirroredUnmap(mBuffer, mSize);
   sem_destroy(&mWaitForSpaceSem);
 }
 
 int Fifo::numBytesFilled() const {
-  return mWrite - mRead + mRaggedEnd;
+  int filled = mWrite - mRead;
+  if (filled < 0) {
+    filled += mSize;
+  }
+  return filled;
 }
 
 char* Fifo::start() const {
@@ -51,7 +52,7 @@ char* Fifo::start() const {
 }
 
 bool Fifo::isEmpty() const {
-  return mRead == mWrite && mRaggedEnd == 0;
+  return mRead == mWrite;
 }
 
 bool Fifo::isFull() const {
@@ -59,35 +60,24 @@ bool Fifo::isFull() const {
 }
 
 // Determines if the buffer will fill assuming 'additional' bytes will be added to the buffer
-// 'full' means there is less than singleBufferSize bytes available contiguously; it does not mean there are zero bytes available
+// 'full' means there is not more than singleBufferSize bytes available; it does not mean there are zero bytes available
 bool Fifo::willFill(int additional) const {
-  if (mWrite > mRead) {
-    if (numBytesFilled() + additional < mWrapThreshold) {
-      return false;
-    }
-  } else {
-    if (numBytesFilled() + additional < mWrapThreshold - mSingleBufferSize) {
-      return false;
-    }
-  }
-  return true;
+  return numBytesFilled() + additional >= mSize - mSingleBufferSize;
 }
 
-// This function will stall until contiguous singleBufferSize bytes are available
+// This function will stall until singleBufferSize bytes are available
 char* Fifo::write(int length) {
   if (length <= 0) {
     length = 0;
     mEnd = true;
   }
 
-  // update the write pointer
-  mWrite += length;
-
-  // handle the wrap-around
-  if (mWrite >= mWrapThreshold) {
-    mRaggedEnd = mWrite;
-    mWrite = 0;
+  // update the write pointer, mBuffer is mirrored so the data written past mSize is also at the start
+  int write = mWrite + length;
+  if (write >= mSize) {
+    write -= mSize;
   }
+  mWrite = write;
 
   // send a notification that data is ready
   sem_post(mReaderSem);
@@ -104,11 +94,6 @@ void Fifo::release() {
   // update the read pointer now that the data has been handled
   mRead = mReadCommit;
 
-  // handle the wrap-around
-  if (mRead >= mWrapThreshold) {
-    mRaggedEnd = mRead = mReadCommit = 0;
-  }
-
   // send a notification that data is free (space is available)
   sem_post(&mWaitForSpaceSem);
 }
@@ -120,11 +105,12 @@ char* Fifo::read(int *const length) {
     return NULL;
   }
 
-  // obtain the length
-  do {
-    mReadCommit = mRaggedEnd ? mRaggedEnd : mWrite;
-    *length = mReadCommit - mRead;
-  } while (*length < 0); // plugs race condition without using semaphores
+  // obtain the length, mBuffer is mirrored so the data is contiguous even if it wraps
+  mReadCommit = mWrite;
+  *length = mReadCommit - mRead;
+  if (*length < 0) {
+    *length += mSize;
+  }
 
   return &mBuffer[mRead];
 }
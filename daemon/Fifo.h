@@ -34,7 +34,7 @@ public:
   char* read(int *const length);
 
 private:
-  int mSingleBufferSize, mWrite, mRead, mReadCommit, mRaggedEnd, mWrapThreshold;
+  int mSingleBufferSize, mSize, mWrite, mRead, mReadCommit;
   sem_t	mWaitForSpaceSem;
   sem_t* mReaderSem;
   char*	mBuffer;
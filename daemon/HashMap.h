@@ -0,0 +1,143 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef HASHMAP_H
+#define HASHMAP_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Logging.h"
+
+// Open addressing map from a 64-bit key to a zero initialized T, T must be plain data
+template <typename T>
+class HashMap {
+public:
+	HashMap() : mCapacity(0), mCount(0), mEntries(NULL) {}
+	~HashMap() { free(mEntries); }
+
+	T *get(const uint64_t key);
+	T *find(const uint64_t key) const;
+	void remove(const uint64_t key);
+
+	int getCount() const { return mCount; }
+	int getCapacity() const { return mCapacity; }
+	bool isUsed(const int i) const { return mEntries[i].used; }
+	uint64_t getKey(const int i) const { return mEntries[i].key; }
+	T *getValue(const int i) const { return &mEntries[i].value; }
+
+private:
+	struct Entry {
+		uint64_t key;
+		bool used;
+		T value;
+	};
+
+	static int hash(const uint64_t key, const int capacity);
+	void grow();
+
+	int mCapacity;
+	int mCount;
+	Entry *mEntries;
+
+	// Intentionally unimplemented
+	HashMap(const HashMap &);
+	HashMap &operator=(const HashMap &);
+};
+
+template <typename T>
+int HashMap<T>::hash(const uint64_t key, const int capacity) {
+	// Fibonacci hashing, capacity is always a power of 2
+	return (int)((key * 0x9E3779B97F4A7C15ULL) >> 32) & (capacity - 1);
+}
+
+template <typename T>
+void HashMap<T>::grow() {
+	const int capacity = mCapacity == 0 ? 64 : 2*mCapacity;
+	Entry *const entries = (Entry *)calloc(capacity, sizeof(Entry));
+	if (entries == NULL) {
+		logg->logError(__FILE__, __LINE__, "Unable to grow the hash map");
+		handleException();
+	}
+
+	for (int i = 0; i < mCapacity; ++i) {
+		if (!mEntries[i].used) {
+			continue;
+		}
+		int pos = hash(mEntries[i].key, capacity);
+		while (entries[pos].used) {
+			pos = (pos + 1) & (capacity - 1);
+		}
+		entries[pos] = mEntries[i];
+	}
+
+	free(mEntries);
+	mEntries = entries;
+	mCapacity = capacity;
+}
+
+template <typename T>
+T *HashMap<T>::find(const uint64_t key) const {
+	if (mCapacity == 0) {
+		return NULL;
+	}
+	for (int pos = hash(key, mCapacity); mEntries[pos].used; pos = (pos + 1) & (mCapacity - 1)) {
+		if (mEntries[pos].key == key) {
+			return &mEntries[pos].value;
+		}
+	}
+	return NULL;
+}
+
+template <typename T>
+T *HashMap<T>::get(const uint64_t key) {
+	T *const value = find(key);
+	if (value != NULL) {
+		return value;
+	}
+
+	// Keep the load factor at or below 1/2
+	if (2*(mCount + 1) > mCapacity) {
+		grow();
+	}
+	int pos = hash(key, mCapacity);
+	while (mEntries[pos].used) {
+		pos = (pos + 1) & (mCapacity - 1);
+	}
+	mEntries[pos].key = key;
+	mEntries[pos].used = true;
+	++mCount;
+	return &mEntries[pos].value;
+}
+
+template <typename T>
+void HashMap<T>::remove(const uint64_t key) {
+	T *const value = find(key);
+	if (value == NULL) {
+		return;
+	}
+
+	int pos = (int)(((char *)value - (char *)mEntries) / sizeof(Entry));
+	mEntries[pos].used = false;
+	--mCount;
+
+	// Shift back the following entries of the run so that find does not stop early
+	for (int next = (pos + 1) & (mCapacity - 1); mEntries[next].used; next = (next + 1) & (mCapacity - 1)) {
+		const int home = hash(mEntries[next].key, mCapacity);
+		// Move the entry if pos lies cyclically between its home and its current position
+		if (((next - home) & (mCapacity - 1)) >= ((next - pos) & (mCapacity - 1))) {
+			mEntries[pos] = mEntries[next];
+			mEntries[next].used = false;
+			pos = next;
+		}
+	}
+	memset(&mEntries[pos].value, 0, sizeof(T));
+}
+
+#endif // HASHMAP_H
@@ -0,0 +1,409 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "Hub.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Buffer.h"
+#include "CaptureFile.h"
+#include "Config.h"
+#include "Logging.h"
+#include "OlySocket.h"
+#include "OlyUtility.h"
+#include "Sender.h"
+#include "SessionData.h"
+#include "StreamlineSetup.h"
+#include "Varint.h"
+
+// The first message of the summary frame, see Buffer::summary
+static const int MESSAGE_SUMMARY = 1;
+// Limits the memory used for a response, perf frames are at most the size of a perf ring
+static const int MAX_RESPONSE = 256 << 20;
+static const int SEND_BUFFER_SIZE = 64 << 10;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void stopHandler(int) {
+	stopRequested = 1;
+}
+
+Hub::Hub() : mDeviceCount(0), mRealtimeOffset(0) {
+	memset(mDevices, 0, sizeof(mDevices));
+}
+
+Hub::~Hub() {
+	for (int i = 0; i < mDeviceCount; ++i) {
+		Device *const device = &mDevices[i];
+		delete device->file;
+		delete device->socket;
+		free(device->apcDir);
+		free(device->data);
+	}
+}
+
+void Hub::parseTargets(const char *const targets) {
+	const char *pos = targets;
+	while (*pos != '\0') {
+		const char *end = strchr(pos, ',');
+		if (end == NULL) {
+			end = pos + strlen(pos);
+		}
+		if (mDeviceCount >= MAX_DEVICES) {
+			logg->logError(__FILE__, __LINE__, "--hub supports at most %i targets", MAX_DEVICES);
+			handleException();
+		}
+
+		Device *const device = &mDevices[mDeviceCount];
+		device->hub = this;
+		device->port = DEFAULT_PORT;
+		device->rtt = -1;
+		// The port follows the last colon so that the host may be an IPv6 address
+		const char *colon = end;
+		while (colon > pos && *colon != ':') {
+			--colon;
+		}
+		if (*colon != ':') {
+			colon = end;
+		} else {
+			char *portEnd;
+			device->port = strtol(colon + 1, &portEnd, 10);
+			if (portEnd != end || device->port <= 0) {
+				logg->logError(__FILE__, __LINE__, "Invalid --hub target %.*s, expected host:port", (int)(end - pos), pos);
+				handleException();
+			}
+		}
+		if (colon == pos || colon - pos >= (int)sizeof(device->host)) {
+			logg->logError(__FILE__, __LINE__, "Invalid --hub target %.*s, expected host:port", (int)(end - pos), pos);
+			handleException();
+		}
+		memcpy(device->host, pos, colon - pos);
+		device->host[colon - pos] = '\0';
+		++mDeviceCount;
+
+		pos = (*end == ',' ? end + 1 : end);
+	}
+
+	if (mDeviceCount == 0) {
+		logg->logError(__FILE__, __LINE__, "--hub needs at least one target");
+		handleException();
+	}
+}
+
+void Hub::sendCommand(Device *const device, const int type, const char *const data) {
+	const int length = (data == NULL ? 0 : strlen(data));
+	unsigned char header[5];
+	header[0] = type;
+	Buffer::writeLEInt(header + 1, length);
+	device->socket->send((const char *)header, sizeof(header));
+	device->socket->send(data, length);
+}
+
+bool Hub::readResponse(Device *const device, int *const type, int *const length) {
+	unsigned char header[5];
+	if (device->socket->receiveNBytes((char *)header, sizeof(header)) < 0) {
+		return false;
+	}
+	*type = header[0];
+	*length = header[1] | (header[2] << 8) | (header[3] << 16) | (header[4] << 24);
+	if (*length < 0 || *length > MAX_RESPONSE) {
+		logg->logError(__FILE__, __LINE__, "Invalid response length %i from %s:%i", *length, device->host, device->port);
+		handleException();
+	}
+
+	// Room for the length in front, a terminator and for alignSummary to grow the timestamp
+	const int needed = 4 + *length + 1 + Buffer::MAXSIZE_PACK64;
+	if (needed > device->capacity) {
+		device->capacity = needed;
+		device->data = (char *)realloc(device->data, device->capacity);
+		if (device->data == NULL) {
+			logg->logError(__FILE__, __LINE__, "Unable to allocate %i bytes", device->capacity);
+			handleException();
+		}
+	}
+	memcpy(device->data, header + 1, 4);
+	if (*length > 0 && device->socket->receiveNBytes(device->data + 4, *length) < 0) {
+		return false;
+	}
+	device->data[4 + *length] = '\0';
+
+	return true;
+}
+
+void Hub::requestXML(Device *const device, const char *const type, const char *const file) {
+	char request[128];
+	snprintf(request, sizeof(request), "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<request type=\"%s\"/>", type);
+	sendCommand(device, COMMAND_REQUEST_XML, request);
+
+	int responseType, length;
+	if (!readResponse(device, &responseType, &length) || responseType != RESPONSE_XML) {
+		logg->logError(__FILE__, __LINE__, "%s:%i did not send the %s xml", device->host, device->port, type);
+		handleException();
+	}
+
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s/%s", device->apcDir, file);
+	if (util->writeToDisk(path, device->data + 4) < 0) {
+		logg->logError(__FILE__, __LINE__, "Error writing %s", path);
+		handleException();
+	}
+}
+
+void Hub::connect(Device *const device, const char *const sessionXML) {
+	const int fd = OlySocket::connectTcp(device->host, device->port);
+	if (fd < 0) {
+		logg->logError(__FILE__, __LINE__, "Unable to connect to gatord on %s:%i", device->host, device->port);
+		handleException();
+	}
+	device->socket = new OlySocket(fd);
+	// Commands are small and the ping round trips must not wait for Nagle's algorithm
+	device->socket->setSendOptions(SEND_BUFFER_SIZE);
+
+	// Same handshake as Streamline, see Sender::Sender
+	static const char streamline[] = "STREAMLINE\n";
+	device->socket->send(streamline, sizeof(streamline) - 1);
+	char magic[64];
+	do {
+		if (device->socket->receiveString(magic, sizeof(magic)) < 0) {
+			logg->logError(__FILE__, __LINE__, "%s:%i disconnected during the handshake", device->host, device->port);
+			handleException();
+		}
+	} while (strncmp(magic, "GATOR ", 6) != 0);
+	logg->logMessage("Connected to %s:%i, %s", device->host, device->port, magic);
+
+	sendCommand(device, COMMAND_DELIVER_XML, sessionXML);
+	int type, length;
+	if (!readResponse(device, &type, &length)) {
+		logg->logError(__FILE__, __LINE__, "%s:%i disconnected", device->host, device->port);
+		handleException();
+	} else if (type != RESPONSE_ACK) {
+		logg->logError(__FILE__, __LINE__, "%s:%i did not accept the session xml: %s", device->host, device->port, device->data + 4);
+		handleException();
+	}
+
+	// A local capture of the target, with the target's own events and captured xml
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s/%i_%s_%i.apc", gSessionData->mTargetPath, (int)(device - mDevices), device->host, device->port);
+	device->apcDir = strdup(path);
+	if (mkdir(device->apcDir, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) != 0 && errno != EEXIST) {
+		logg->logError(__FILE__, __LINE__, "Unable to create directory %s", device->apcDir);
+		handleException();
+	}
+	snprintf(path, sizeof(path), "%s/session.xml", device->apcDir);
+	if (util->writeToDisk(path, sessionXML) < 0) {
+		logg->logError(__FILE__, __LINE__, "Error writing %s", path);
+		handleException();
+	}
+	requestXML(device, "events", "events.xml");
+	requestXML(device, "captured", "captured.xml");
+
+	estimateClock(device);
+}
+
+void Hub::estimateClock(Device *const device) {
+	for (int i = 0; i < CLOCK_PINGS; ++i) {
+		const uint64_t sent = getTime();
+		sendCommand(device, COMMAND_PING, PING_CLOCK);
+		int type, length;
+		if (!readResponse(device, &type, &length) || type != RESPONSE_ACK) {
+			logg->logError(__FILE__, __LINE__, "%s:%i did not answer a ping", device->host, device->port);
+			handleException();
+		}
+		const uint64_t received = getTime();
+		if (length != 8) {
+			logg->logMessage("%s:%i can not report its clock, its capture will not be aligned", device->host, device->port);
+			return;
+		}
+
+		const unsigned char *const d = (const unsigned char *)device->data + 4;
+		uint64_t targetTime = 0;
+		for (int j = 7; j >= 0; --j) {
+			targetTime = (targetTime << 8) | d[j];
+		}
+		// Assume the target read its clock halfway through the round trip
+		const int64_t rtt = received - sent;
+		if (device->rtt < 0 || rtt < device->rtt) {
+			device->rtt = rtt;
+			device->clockOffset = (int64_t)(targetTime - (sent + rtt / 2));
+		}
+	}
+	logg->logMessage("%s:%i clock offset %lld ns, round trip %lld ns", device->host, device->port, (long long)device->clockOffset, (long long)device->rtt);
+}
+
+void Hub::alignSummary(Device *const device, int *const length) {
+	char *const frame = device->data + 4;
+	const char *pos = frame;
+	const char *const end = frame + *length;
+	int64_t frameType, messageType, canaryLength, timestamp, uptime;
+	if (!varintRead(&pos, end, &frameType) || frameType != FRAME_SUMMARY ||
+			!varintRead(&pos, end, &messageType) || messageType != MESSAGE_SUMMARY ||
+			!varintRead(&pos, end, &canaryLength) || canaryLength < 0 || canaryLength > end - pos) {
+		return;
+	}
+	pos += canaryLength;
+	char *const timestampPos = frame + (pos - frame);
+	if (!varintRead(&pos, end, &timestamp)) {
+		return;
+	}
+	const char *const timestampEnd = pos;
+	if (!varintRead(&pos, end, &uptime)) {
+		return;
+	}
+
+	// The wall clock time of the start on the hub's clock
+	char packed[Buffer::MAXSIZE_PACK64];
+	const int packedLength = Buffer::packInt64(packed, uptime - device->clockOffset + mRealtimeOffset);
+	memmove(timestampPos + packedLength, timestampEnd, end - timestampEnd);
+	memcpy(timestampPos, packed, packedLength);
+	*length += packedLength - (timestampEnd - timestampPos);
+	Buffer::writeLEInt((unsigned char *)device->data, *length);
+}
+
+void *Hub::receiveThreadStatic(void *arg) {
+	prctl(PR_SET_NAME, (unsigned long)&"gatord-hub", 0, 0, 0);
+	Device *const device = static_cast<Device *>(arg);
+	device->hub->receiveThread(device);
+	return NULL;
+}
+
+void Hub::receiveThread(Device *const device) {
+	int type, length;
+	while (readResponse(device, &type, &length)) {
+		if (type == RESPONSE_APC_DATA) {
+			if (length == 0) {
+				// End of capture sequence
+				break;
+			}
+			if (device->rtt >= 0 && device->bytes == 0) {
+				// The summary is the first frame
+				alignSummary(device, &length);
+			}
+			device->file->write(device->data, 4 + length);
+			device->bytes += length;
+		} else if (type == RESPONSE_ERROR) {
+			logg->logMessage("%s:%i failed: %s", device->host, device->port, device->data + 4);
+			break;
+		}
+	}
+
+	logg->logMessage("Capture of %s:%i ended after %lld bytes", device->host, device->port, (long long)device->bytes);
+	device->ended = true;
+}
+
+bool Hub::writeJSON() {
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s/hub.json", gSessionData->mTargetPath);
+	FILE *const f = fopen(path, "w");
+	if (f == NULL) {
+		return false;
+	}
+
+	fprintf(f, "{\n  \"targets\": [");
+	for (int i = 0; i < mDeviceCount; ++i) {
+		const Device *const device = &mDevices[i];
+		fprintf(f, "%s\n    { \"host\": \"%s\", \"port\": %i, \"capture\": \"%s\", \"bytes\": %lld, ", i == 0 ? "" : ",", device->host, device->port, device->apcDir, (long long)device->bytes);
+		if (device->rtt >= 0) {
+			fprintf(f, "\"clock_offset_ns\": %lld, \"round_trip_ns\": %lld }", (long long)device->clockOffset, (long long)device->rtt);
+		} else {
+			fprintf(f, "\"clock_offset_ns\": null, \"round_trip_ns\": null }");
+		}
+	}
+	fprintf(f, "\n  ]\n}\n");
+
+	return fclose(f) == 0;
+}
+
+void Hub::run(const char *const targets) {
+	// Sends to a target that has disconnected fail instead of raising SIGPIPE
+	signal(SIGPIPE, SIG_IGN);
+	signal(SIGINT, stopHandler);
+	signal(SIGTERM, stopHandler);
+
+	char *const sessionXML = util->readFromDisk(gSessionData->mSessionXMLPath);
+	if (sessionXML == NULL) {
+		logg->logError(__FILE__, __LINE__, "Unable to read session xml file: %s", gSessionData->mSessionXMLPath);
+		handleException();
+	}
+	// Only for the duration, the targets parse it themselves
+	gSessionData->parseSessionXML(sessionXML);
+
+	if (mkdir(gSessionData->mTargetPath, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) != 0 && errno != EEXIST) {
+		logg->logError(__FILE__, __LINE__, "Unable to create directory %s", gSessionData->mTargetPath);
+		handleException();
+	}
+
+	parseTargets(targets);
+	for (int i = 0; i < mDeviceCount; ++i) {
+		connect(&mDevices[i], sessionXML);
+	}
+	free(sessionXML);
+
+	struct timespec ts;
+	if (clock_gettime(CLOCK_REALTIME, &ts) != 0) {
+		logg->logError(__FILE__, __LINE__, "clock_gettime failed");
+		handleException();
+	}
+	mRealtimeOffset = (int64_t)ts.tv_sec * NS_PER_S + ts.tv_nsec - getTime();
+
+	// Start all the targets together
+	for (int i = 0; i < mDeviceCount; ++i) {
+		Device *const device = &mDevices[i];
+		device->file = new CaptureFile(device->apcDir);
+		sendCommand(device, COMMAND_APC_START, NULL);
+	}
+	for (int i = 0; i < mDeviceCount; ++i) {
+		Device *const device = &mDevices[i];
+		if (pthread_create(&device->thread, NULL, receiveThreadStatic, device) != 0) {
+			logg->logError(__FILE__, __LINE__, "Failed to create the hub threads");
+			handleException();
+		}
+		device->threadStarted = true;
+	}
+	logg->logMessage("Capturing %i targets", mDeviceCount);
+
+	// Until the duration expires, a signal is received or every target has ended
+	const uint64_t start = getTime();
+	for (;;) {
+		bool running = false;
+		for (int i = 0; i < mDeviceCount; ++i) {
+			running = running || !mDevices[i].ended;
+		}
+		if (!running || stopRequested || (gSessionData->mDuration > 0 && getTime() - start >= (uint64_t)gSessionData->mDuration * NS_PER_S)) {
+			break;
+		}
+		usleep(100000);
+	}
+
+	for (int i = 0; i < mDeviceCount; ++i) {
+		Device *const device = &mDevices[i];
+		if (!device->ended) {
+			sendCommand(device, COMMAND_APC_STOP, NULL);
+		}
+	}
+	for (int i = 0; i < mDeviceCount; ++i) {
+		if (mDevices[i].threadStarted) {
+			pthread_join(mDevices[i].thread, NULL);
+		}
+		// Flushes the capture file
+		delete mDevices[i].file;
+		mDevices[i].file = NULL;
+	}
+
+	if (!writeJSON()) {
+		logg->logError(__FILE__, __LINE__, "Unable to write %s/hub.json", gSessionData->mTargetPath);
+		handleException();
+	}
+}
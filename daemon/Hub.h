@@ -0,0 +1,75 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef HUB_H
+#define HUB_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+class CaptureFile;
+class OlySocket;
+
+// Captures several targets at once by connecting to the gatord of each, like Streamline does, and writing a local capture per target.
+// The targets are started together and the clock offset of each is estimated from ping round trips before the start, see PING_CLOCK.
+// The summary frame of each capture is rewritten so that its wall clock time is on the hub's clock, which lines the captures up,
+// and hub.json in the output directory records the offsets
+class Hub {
+public:
+	Hub();
+	~Hub();
+
+	// targets is a comma separated list of host:port, the session xml and output directory come from gSessionData
+	void run(const char *const targets);
+
+private:
+	static const int MAX_DEVICES = 16;
+	// The estimate with the shortest round trip is used
+	static const int CLOCK_PINGS = 16;
+
+	struct Device {
+		Hub *hub;
+		char host[256];
+		int port;
+		OlySocket *socket;
+		char *apcDir;
+		CaptureFile *file;
+		// Response buffer, 4 bytes of length followed by the data as in the local capture file
+		char *data;
+		int capacity;
+		// Target time minus hub time, valid if rtt >= 0
+		int64_t clockOffset;
+		int64_t rtt;
+		int64_t bytes;
+		pthread_t thread;
+		bool threadStarted;
+		volatile bool ended;
+	};
+
+	static void *receiveThreadStatic(void *arg);
+	void receiveThread(Device *const device);
+	void parseTargets(const char *const targets);
+	void connect(Device *const device, const char *const sessionXML);
+	void estimateClock(Device *const device);
+	void sendCommand(Device *const device, const int type, const char *const data);
+	bool readResponse(Device *const device, int *const type, int *const length);
+	void requestXML(Device *const device, const char *const type, const char *const file);
+	void alignSummary(Device *const device, int *const length);
+	bool writeJSON();
+
+	Device mDevices[MAX_DEVICES];
+	int mDeviceCount;
+	// Hub CLOCK_REALTIME minus CLOCK_MONOTONIC_RAW
+	int64_t mRealtimeOffset;
+
+	// Intentionally unimplemented
+	Hub(const Hub &);
+	Hub &operator=(const Hub &);
+};
+
+#endif // HUB_H
@@ -10,6 +10,8 @@
 
 #include <sys/types.h>
 #include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 #include "ConfigurationXML.h"
@@ -25,6 +27,15 @@ bool KMod::claimCounter(const Counter &counter) const {
 }
 
 void KMod::resetCounters() {
+	mPendingCount = 0;
+	mUseConfig = access("/dev/gator/session_config", F_OK) == 0;
+	if (!mUseConfig) {
+		resetCounterFiles();
+	}
+	// Otherwise counters are reset by the driver when the configuration is written in commitCounters
+}
+
+void KMod::resetCounterFiles() {
 	char base[128];
 	char text[128];
 
@@ -47,6 +58,15 @@ void KMod::resetCounters() {
 }
 
 void KMod::setupCounter(Counter &counter) {
+	if (mUseConfig && mPendingCount < ARRAY_LENGTH(mPending)) {
+		mPending[mPendingCount++] = &counter;
+		return;
+	}
+
+	setupCounterFiles(counter);
+}
+
+void KMod::setupCounterFiles(Counter &counter) {
 	char base[128];
 	char text[128];
 	snprintf(base, sizeof(base), "/dev/gator/events/%s", counter.getType());
@@ -85,6 +105,60 @@ void KMod::setupCounter(Counter &counter) {
 	}
 }
 
+void KMod::commitCounters() {
+	if (!mUseConfig) {
+		return;
+	}
+
+	const size_t size = sizeof(GatorConfigHeader) + mPendingCount*sizeof(GatorConfigCounter);
+	GatorConfigHeader *const config = (GatorConfigHeader *)calloc(1, size);
+	if (config == NULL) {
+		logg->logError(__FILE__, __LINE__, "malloc failed");
+		handleException();
+	}
+	GatorConfigCounter *const counters = (GatorConfigCounter *)(config + 1);
+
+	config->flags = GATOR_CONFIG_COUNTERS;
+	config->count = mPendingCount;
+	for (int i = 0; i < mPendingCount; ++i) {
+		snprintf(counters[i].name, sizeof(counters[i].name), "%s", mPending[i]->getType());
+		counters[i].enabled = true;
+		counters[i].event = mPending[i]->getEvent();
+		counters[i].count = mPending[i]->getCount();
+	}
+
+	if (DriverSource::writeReadConfig(config, size) != 0) {
+		// Fall back to configuring each counter through its own files
+		logg->logMessage("Unable to write the counter configuration, falling back to gatorfs files");
+		resetCounterFiles();
+		for (int i = 0; i < mPendingCount; ++i) {
+			setupCounterFiles(*mPending[i]);
+		}
+	} else {
+		for (int i = 0; i < mPendingCount; ++i) {
+			Counter &counter = *mPending[i];
+			if (!counters[i].enabled) {
+				counter.setEnabled(false);
+				continue;
+			}
+			counter.setKey(counters[i].key);
+			if (counters[i].cores >= 0) {
+				counter.setCores(counters[i].cores);
+			}
+			if (counters[i].count >= 0) {
+				counter.setCount(counters[i].count);
+			} else if (counter.getCount() > 0) {
+				ConfigurationXML::remove();
+				logg->logError(__FILE__, __LINE__, "Event Based Sampling is only supported with kernel versions 3.0.0 and higher with CONFIG_PERF_EVENTS=y, and CONFIG_HW_PERF_EVENTS=y. The invalid configuration.xml has been removed.\n");
+				handleException();
+			}
+		}
+	}
+
+	free(config);
+	mPendingCount = 0;
+}
+
 int KMod::writeCounters(mxml_node_t *root) const {
 	struct dirent *ent;
 	mxml_node_t *counter;
@@ -9,19 +9,34 @@
 #ifndef KMOD_H
 #define KMOD_H
 
+#include "Config.h"
 #include "Driver.h"
 
 // Driver for the gator kernel module
 class KMod : public Driver {
 public:
-	KMod() {}
+	KMod() : mUseConfig(false), mPendingCount(0) {}
 	~KMod() {}
 
 	bool claimCounter(const Counter &counter) const;
 	void resetCounters();
 	void setupCounter(Counter &counter);
+	void commitCounters();
 
 	int writeCounters(mxml_node_t *root) const;
+
+private:
+	void resetCounterFiles();
+	void setupCounterFiles(Counter &counter);
+
+	// Counters are batched into a single /dev/gator/session_config write when the driver supports it
+	bool mUseConfig;
+	int mPendingCount;
+	Counter *mPending[MAX_PERFORMANCE_COUNTERS];
+
+	// Intentionally unimplemented
+	KMod(const KMod &);
+	KMod &operator=(const KMod &);
 };
 
 #endif // KMOD_H
@@ -0,0 +1,298 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "LazyMaps.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+
+#include "DynBuf.h"
+#include "Logging.h"
+#include "PerfAnalytics.h"
+#include "PerfGroup.h"
+#include "SessionData.h"
+
+static const int BUFFER_SIZE = 1024*1024;
+
+// Copies length bytes at pos of the data that is split in two parts when it wraps around the end of the ring
+static bool readBytes(const char *const data1, const int length1, const char *const data2, const int length2, const int pos, void *const dest, const int length) {
+	if (pos < 0 || length < 0 || pos + length > length1 + length2) {
+		return false;
+	}
+	char *const d = static_cast<char *>(dest);
+	const int first = pos >= length1 ? 0 : (pos + length > length1 ? length1 - pos : length);
+	if (first > 0) {
+		memcpy(d, data1 + pos, first);
+	}
+	if (length > first) {
+		memcpy(d + first, data2 + pos + first - length1, length - first);
+	}
+	return true;
+}
+
+LazyMaps::LazyMaps(sem_t *senderSem) : mBuffer(0, FRAME_PERF_ATTRS, BUFFER_SIZE, senderSem), mSeen(), mSampleTypes(), mGroup(NULL), mSchedSwitchId(-1), mNextPidOffset(-1), mNextPidSize(0), mQueueRead(0), mQueueCount(0), mStopping(false), mThreadStarted(false) {
+	sem_init(&mBufferSem, 0, 0);
+	sem_init(&mQueueSem, 0, 0);
+	pthread_mutex_init(&mQueueMutex, NULL);
+}
+
+LazyMaps::~LazyMaps() {
+	if (mThreadStarted) {
+		stop();
+	}
+	pthread_mutex_destroy(&mQueueMutex);
+	sem_destroy(&mQueueSem);
+	sem_destroy(&mBufferSem);
+}
+
+bool LazyMaps::start(const PerfGroup *const group, const int schedSwitchId, const char *const schedSwitchFormat) {
+	mGroup = group;
+	mSchedSwitchId = schedSwitchId;
+	if (!PerfAnalytics::getField(schedSwitchFormat, "next_pid", &mNextPidOffset, &mNextPidSize)) {
+		// Processes that never take a sample are not read
+		logg->logMessage("%s(%s:%i): sched_switch has no next_pid", __FUNCTION__, __FILE__, __LINE__);
+		mNextPidOffset = -1;
+	}
+
+	if (pthread_create(&mThread, NULL, readThread, this) != 0) {
+		logg->logMessage("%s(%s:%i): pthread_create failed", __FUNCTION__, __FILE__, __LINE__);
+		return false;
+	}
+	mThreadStarted = true;
+
+	return true;
+}
+
+void LazyMaps::stop() {
+	pthread_mutex_lock(&mQueueMutex);
+	mStopping = true;
+	pthread_mutex_unlock(&mQueueMutex);
+
+	if (mThreadStarted) {
+		// Wake the thread, it exits once the queue is empty
+		sem_post(&mQueueSem);
+		pthread_join(mThread, NULL);
+		mThreadStarted = false;
+	}
+
+	mBuffer.setDone();
+}
+
+void LazyMaps::observe(void *arg, const int, const char *const data1, const int length1, const char *const data2, const int length2) {
+	LazyMaps *const lazyMaps = static_cast<LazyMaps *>(arg);
+	const int length = length1 + length2;
+	int pos = 0;
+	while (length - pos >= (int)sizeof(struct perf_event_header)) {
+		struct perf_event_header header;
+		readBytes(data1, length1, data2, length2, pos, &header, sizeof(header));
+		if (header.size < sizeof(header) || header.size > length - pos) {
+			break;
+		}
+		lazyMaps->observeRecord(data1, length1, data2, length2, pos, header.size);
+		pos += header.size;
+	}
+}
+
+void LazyMaps::observeRecord(const char *const data1, const int length1, const char *const data2, const int length2, const int pos, const int size) {
+	struct perf_event_header header;
+	readBytes(data1, length1, data2, length2, pos, &header, sizeof(header));
+	const int start = pos + sizeof(header);
+	const int end = pos + size;
+	__u32 pid;
+
+	if (header.type == PERF_RECORD_FORK) {
+		// The kernel describes the mappings of processes started during the capture itself, so don't read them. A new thread of an
+		// existing process has the same pid as its parent and is looked up like any other thread. The pid, ppid, tid and ptid are u32
+		__u32 ids[4];
+		if (end - start >= (int)sizeof(ids) && readBytes(data1, length1, data2, length2, start, ids, sizeof(ids)) && ids[0] != ids[1]) {
+			queue(ids[0], true);
+		}
+		return;
+	}
+
+	if (header.type != PERF_RECORD_SAMPLE) {
+		return;
+	}
+
+	if (gSessionData->perf.getLegacySupport()) {
+		// Legacy samples always start with IP then TID, see DEFAULT_PEA_ARGS
+		if (end - start >= 2*(int)sizeof(__u64) && readBytes(data1, length1, data2, length2, start + sizeof(__u64), &pid, sizeof(pid))) {
+			queue(pid, false);
+		}
+		return;
+	}
+
+	// Otherwise PERF_SAMPLE_IDENTIFIER is first and gives the sample_type of the rest
+	__u64 id;
+	if (end - start < (int)sizeof(id) || !readBytes(data1, length1, data2, length2, start, &id, sizeof(id))) {
+		return;
+	}
+	uint64_t *sampleType = mSampleTypes.find(id);
+	if (sampleType == NULL) {
+		__u64 st;
+		sampleType = mSampleTypes.get(id);
+		// Unknown ids are remembered as 0 so they are only looked up once
+		*sampleType = mGroup->getSampleType(id, &st) ? st : 0;
+	}
+	if (*sampleType == 0) {
+		return;
+	}
+
+	// The u64 fields that precede READ, in the order they appear in a sample, see perf_event.h
+	static const uint64_t FIELDS[] = {
+		PERF_SAMPLE_IDENTIFIER, PERF_SAMPLE_IP, PERF_SAMPLE_TID, PERF_SAMPLE_TIME, PERF_SAMPLE_ADDR,
+		PERF_SAMPLE_ID, PERF_SAMPLE_STREAM_ID, PERF_SAMPLE_CPU, PERF_SAMPLE_PERIOD,
+	};
+	int offset = start;
+	for (int i = 0; i < ARRAY_LENGTH(FIELDS); ++i) {
+		if ((*sampleType & FIELDS[i]) == 0) {
+			continue;
+		}
+		if (FIELDS[i] == PERF_SAMPLE_TID) {
+			if (readBytes(data1, length1, data2, length2, offset, &pid, sizeof(pid)) && offset + (int)sizeof(__u64) <= end) {
+				queue(pid, false);
+			}
+			return;
+		}
+		offset += sizeof(__u64);
+	}
+
+	// Samples without TID are sched_switch, use the thread being switched to
+	if ((*sampleType & PERF_SAMPLE_READ) == 0 || (*sampleType & PERF_SAMPLE_RAW) == 0 || mNextPidOffset < 0) {
+		return;
+	}
+	// Group format with ids, see DEFAULT_PEA_ARGS
+	__u64 nr;
+	if (!readBytes(data1, length1, data2, length2, offset, &nr, sizeof(nr)) || nr > (__u64)(end - offset) / (2*sizeof(__u64))) {
+		return;
+	}
+	offset += sizeof(nr) + nr * 2*sizeof(__u64);
+	__u32 rawSize;
+	uint16_t type;
+	if (!readBytes(data1, length1, data2, length2, offset, &rawSize, sizeof(rawSize)) || rawSize > (__u32)(end - offset - sizeof(rawSize)) ||
+			!readBytes(data1, length1, data2, length2, offset + sizeof(rawSize), &type, sizeof(type)) || type != mSchedSwitchId) {
+		return;
+	}
+	char raw[64];
+	const int nextPidEnd = mNextPidOffset + mNextPidSize;
+	if (nextPidEnd > (int)sizeof(raw) || nextPidEnd > (int)rawSize ||
+			!readBytes(data1, length1, data2, length2, offset + sizeof(rawSize), raw, nextPidEnd)) {
+		return;
+	}
+	queue(PerfAnalytics::readField(raw, nextPidEnd, mNextPidOffset, mNextPidSize), false);
+}
+
+void LazyMaps::queue(const int id, const bool forked) {
+	// The idle task has no maps. The main thread of a forked process has the tid of the process so is marked as seen too
+	if (id <= 0 || mSeen.find(id) != NULL) {
+		return;
+	}
+	mSeen.get(id);
+
+	pthread_mutex_lock(&mQueueMutex);
+	const bool queued = !mStopping && mQueueCount < QUEUE_SIZE;
+	if (queued) {
+		QueueEntry *const entry = &mQueue[(mQueueRead + mQueueCount) % QUEUE_SIZE];
+		entry->id = id;
+		entry->forked = forked;
+		++mQueueCount;
+	}
+	pthread_mutex_unlock(&mQueueMutex);
+
+	if (queued) {
+		sem_post(&mQueueSem);
+	} else {
+		// Try again the next time the thread is seen
+		mSeen.remove(id);
+	}
+}
+
+void *LazyMaps::readThread(void *arg) {
+	prctl(PR_SET_NAME, (unsigned long)&"gatord-maps", 0, 0, 0);
+	static_cast<LazyMaps *>(arg)->run();
+	return NULL;
+}
+
+void LazyMaps::run() {
+	// Threads of the same process share the maps so only send them once per process
+	HashMap<bool> sent;
+	DynBuf printb;
+	DynBuf b;
+
+	for (;;) {
+		sem_wait(&mQueueSem);
+		pthread_mutex_lock(&mQueueMutex);
+		if (mQueueCount == 0) {
+			const bool stopping = mStopping;
+			pthread_mutex_unlock(&mQueueMutex);
+			if (stopping) {
+				break;
+			}
+			continue;
+		}
+		const QueueEntry entry = mQueue[mQueueRead];
+		mQueueRead = (mQueueRead + 1) % QUEUE_SIZE;
+		--mQueueCount;
+		pthread_mutex_unlock(&mQueueMutex);
+
+		if (entry.forked) {
+			// Keep the other threads of the process from reading its maps
+			sent.get(entry.id);
+			continue;
+		}
+		const int tid = entry.id;
+
+		// Processes may exit before they are read, this is not an error
+		if (!printb.printf("/proc/%i/status", tid) || !b.read(printb.getBuf())) {
+			logg->logMessage("%s(%s:%i): Unable to read the status of %i, likely because it exited", __FUNCTION__, __FILE__, __LINE__, tid);
+			continue;
+		}
+		const char *const tgidLine = strstr(b.getBuf(), "\nTgid:");
+		if (tgidLine == NULL) {
+			logg->logMessage("%s(%s:%i): Unable to find the Tgid of %i", __FUNCTION__, __FILE__, __LINE__, tid);
+			continue;
+		}
+		const int pid = strtol(tgidLine + sizeof("\nTgid:") - 1, NULL, 10);
+		if (pid <= 0 || sent.find(pid) != NULL) {
+			continue;
+		}
+		sent.get(pid);
+
+		if (!printb.printf("/proc/%i/maps", pid) || !b.read(printb.getBuf())) {
+			logg->logMessage("%s(%s:%i): Unable to read the maps of %i, likely because it exited", __FUNCTION__, __FILE__, __LINE__, pid);
+			continue;
+		}
+		// Interned maps can be larger than the text when the paths are new
+		const int bytes = 3*Buffer::MAXSIZE_PACK32 + 2*b.getLength() + 1;
+		if (bytes >= BUFFER_SIZE) {
+			logg->logMessage("%s(%s:%i): The maps of %i are too large", __FUNCTION__, __FILE__, __LINE__, pid);
+			continue;
+		}
+		waitFor(bytes);
+		mBuffer.maps(pid, pid, b.getBuf());
+		mBuffer.commit(1);
+	}
+}
+
+void LazyMaps::waitFor(const int bytes) {
+	while (mBuffer.bytesAvailable() <= bytes) {
+		sem_wait(&mBufferSem);
+	}
+}
+
+void LazyMaps::write(Sender *const sender) {
+	if (!mBuffer.isDone()) {
+		mBuffer.write(sender);
+		sem_post(&mBufferSem);
+	}
+}
+
+bool LazyMaps::isDone() const {
+	return mBuffer.isDone();
+}
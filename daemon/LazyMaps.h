@@ -0,0 +1,80 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef LAZYMAPS_H
+#define LAZYMAPS_H
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdint.h>
+
+#include "Buffer.h"
+#include "HashMap.h"
+
+class PerfGroup;
+class Sender;
+
+// Sends /proc/<pid>/maps only for the processes that appear in the perf data instead of for every process at the start of the
+// capture. The perf data is observed as it is sent, the pids seen for the first time are queued and the maps are read by a
+// thread of their own. Processes started during the capture are described by the kernel's mmap records and are not read
+class LazyMaps {
+public:
+	LazyMaps(sem_t *senderSem);
+	~LazyMaps();
+
+	// schedSwitchFormat is used to find the next_pid of sched_switch samples, which don't have PERF_SAMPLE_TID
+	bool start(const PerfGroup *const group, const int schedSwitchId, const char *const schedSwitchFormat);
+	// Reads the maps still queued and stops the thread
+	void stop();
+
+	// PerfObserver, called by the sender thread with the perf data of a cpu
+	static void observe(void *arg, const int cpu, const char *const data1, const int length1, const char *const data2, const int length2);
+
+	void write(Sender *const sender);
+	bool isDone() const;
+
+private:
+	static const int QUEUE_SIZE = 1024;
+
+	struct QueueEntry {
+		// A tid seen in the perf data, or the pid of a process forked during the capture
+		int id;
+		bool forked;
+	};
+
+	static void *readThread(void *arg);
+	void run();
+	void observeRecord(const char *const data1, const int length1, const char *const data2, const int length2, const int pos, const int size);
+	void queue(const int id, const bool forked);
+	void waitFor(const int bytes);
+
+	Buffer mBuffer;
+	sem_t mBufferSem;
+	// Only used by the sender thread
+	HashMap<bool> mSeen;
+	HashMap<uint64_t> mSampleTypes;
+	const PerfGroup *mGroup;
+	int mSchedSwitchId;
+	int mNextPidOffset;
+	int mNextPidSize;
+	// Protected by mQueueMutex, mQueueSem counts the queued tids
+	pthread_mutex_t mQueueMutex;
+	sem_t mQueueSem;
+	QueueEntry mQueue[QUEUE_SIZE];
+	int mQueueRead;
+	int mQueueCount;
+	bool mStopping;
+	pthread_t mThread;
+	bool mThreadStarted;
+
+	// Intentionally unimplemented
+	LazyMaps(const LazyMaps &);
+	LazyMaps &operator=(const LazyMaps &);
+};
+
+#endif // LAZYMAPS_H
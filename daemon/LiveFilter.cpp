@@ -0,0 +1,499 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "LiveFilter.h"
+
+#include <string.h>
+
+#include "Buffer.h"
+#include "CaptureFile.h"
+#include "EventsXML.h"
+#include "Logging.h"
+#include "Sender.h"
+#include "SessionData.h"
+#include "Varint.h"
+#include "k/perf_event.h"
+
+// From gator_main.c
+enum {
+	LIVE_FRAME_BACKTRACE = 2,
+};
+
+enum {
+	MESSAGE_END_BACKTRACE = 1,
+};
+
+// From Buffer.cpp
+enum {
+	CODE_PEA      = 1,
+	CODE_KEYS     = 2,
+	CODE_FORMAT   = 3,
+	CODE_MAPS     = 4,
+	CODE_COMM     = 5,
+	CODE_KEYS_OLD = 6,
+	CODE_STRING   = 7,
+	CODE_COMM_ID  = 8,
+	CODE_MAPS_ID  = 9,
+};
+
+// Must match Buffer::MAX_COMPACT_RECORDS
+static const int MAX_COMPACT_RECORDS = 128;
+static const int COMPACT_KEY_RUN = -1;
+
+static bool unpackInt(const char **const pos, const char *const end, int *const value) {
+	int64_t v;
+	if (!varintRead(pos, end, &v)) {
+		return false;
+	}
+	*value = v;
+	return true;
+}
+
+static bool skipString(const char **const pos, const char *const end) {
+	const char *const nul = (const char *)memchr(*pos, '\0', end - *pos);
+	if (nul == NULL) {
+		return false;
+	}
+	*pos = nul + 1;
+	return true;
+}
+
+static void pack(DynBuf *const buf, const int64_t x) {
+	char b[Buffer::MAXSIZE_PACK64];
+	buf->append(b, Buffer::packInt64(b, x));
+}
+
+// Starts a frame in live and returns its offset for endFrame
+int LiveFilter::beginFrame(DynBuf *const live, const int frameType, const int core) {
+	const int start = live->getLength();
+	const char header[FRAME_HEADER_SIZE] = { RESPONSE_APC_DATA };
+	live->append(header, sizeof(header));
+	pack(live, frameType);
+	pack(live, core);
+	return start;
+}
+
+void LiveFilter::endFrame(DynBuf *const live, const int start) {
+	Buffer::writeLEInt((unsigned char *)live->getBuf() + start + 1, live->getLength() - start - FRAME_HEADER_SIZE);
+}
+
+LiveFilter::LiveFilter(const int downsample) : mDownsample(downsample), mHeaderLength(0), mFrameRemaining(0), mFrame(), mWindowCount(0), mWindowTimestamps(0), mWindowTime(0), mTracepointKeyCount(0), mTracepointIds(NULL), mTracepointIdCount(0), mTracepointIdCapacity(0) {
+	for (int i = 0; i < MAX_PERFORMANCE_COUNTERS; ++i) {
+		mKeys[i] = gSessionData->mCounters[i].isEnabled() ? gSessionData->mCounters[i].getKey() : 0;
+	}
+	EventsXML eventsXML;
+	eventsXML.getDeltaCounters(mDeltas);
+
+	memset(mBacktraces, 0, sizeof(mBacktraces));
+	memset(mPerfSamples, 0, sizeof(mPerfSamples));
+}
+
+LiveFilter::~LiveFilter() {
+	free(mTracepointIds);
+}
+
+void LiveFilter::write(const char *data, int length, CaptureFile *const archive, DynBuf *const live) {
+	while (length > 0) {
+		if (mHeaderLength < FRAME_HEADER_SIZE) {
+			mHeader[mHeaderLength++] = *data++;
+			--length;
+			if (mHeaderLength < FRAME_HEADER_SIZE) {
+				continue;
+			}
+			mFrameRemaining = (mHeader[1] & 0xFF) | (mHeader[2] & 0xFF) << 8 | (mHeader[3] & 0xFF) << 16 | (mHeader[4] & 0xFF) << 24;
+			mFrame.clear();
+			// The end of stream marker is an empty frame
+			if (mFrameRemaining > 0) {
+				continue;
+			}
+		}
+
+		// Filter whole frames in place and only copy frames split across calls
+		if (mFrame.getLength() == 0 && length >= mFrameRemaining) {
+			frame(data, mFrameRemaining, archive, live);
+		} else {
+			const int bytes = length < mFrameRemaining ? length : mFrameRemaining;
+			if (!mFrame.append(data, bytes)) {
+				logg->logError(__FILE__, __LINE__, "Unable to buffer a frame for the live stream");
+				handleException();
+			}
+			if (bytes < mFrameRemaining) {
+				mFrameRemaining -= bytes;
+				return;
+			}
+			frame(mFrame.getBuf(), mFrame.getLength(), archive, live);
+			mFrame.clear();
+		}
+		data += mFrameRemaining;
+		length -= mFrameRemaining;
+		mFrameRemaining = 0;
+		mHeaderLength = 0;
+	}
+}
+
+void LiveFilter::frame(const char *const payload, const int length, CaptureFile *const archive, DynBuf *const live) {
+	if (archive != NULL && length > 0) {
+		// The local capture format is the same without the response type
+		archive->write(mHeader + 1, FRAME_HEADER_SIZE - 1);
+		archive->write(payload, length);
+	}
+
+	const char *pos = payload;
+	const char *const end = payload + length;
+	int frameType, core = 0;
+	if (mDownsample > 1 && unpackInt(&pos, end, &frameType) && pos < end) {
+		// PerfBuffer writes the cpu as a byte, every other frame uses a packed int
+		if (frameType == FRAME_PERF) {
+			core = (unsigned char)*pos++;
+		} else if (!unpackInt(&pos, end, &core)) {
+			frameType = -1;
+		}
+		if (core < 0 || core >= NR_CPUS) {
+			frameType = -1;
+		}
+
+		switch (frameType) {
+		case FRAME_BLOCK_COUNTER:
+		case FRAME_BLOCK_COUNTER_COMPACT:
+			counterFrame(core, frameType == FRAME_BLOCK_COUNTER_COMPACT, pos, end, live);
+			return;
+		case LIVE_FRAME_BACKTRACE:
+			backtraceFrame(core, pos, end, live);
+			return;
+		case FRAME_PERF_ATTRS:
+			perfAttrsFrame(pos, end);
+			break;
+		case FRAME_PERF:
+			perfFrame(core, pos, end, live);
+			return;
+		}
+	}
+
+	if (!live->append(mHeader, FRAME_HEADER_SIZE) || !live->append(payload, length)) {
+		logg->logError(__FILE__, __LINE__, "Unable to buffer the live stream");
+		handleException();
+	}
+}
+
+bool LiveFilter::isDelta(const int key) const {
+	for (int i = 0; i < MAX_PERFORMANCE_COUNTERS; ++i) {
+		if (mKeys[i] == key) {
+			return mDeltas[i];
+		}
+	}
+	// As Streamline treats counters without a class
+	return true;
+}
+
+// See Buffer::compactEvent for the compact format. Aggregated frames are always written as plain block counter frames
+void LiveFilter::counterFrame(const int core, const bool compact, const char *pos, const char *const end, DynBuf *const live) {
+	int prevKeys[MAX_COMPACT_RECORDS];
+	int64_t prevValues[MAX_COMPACT_RECORDS];
+	int currKeys[MAX_COMPACT_RECORDS];
+	int64_t currValues[MAX_COMPACT_RECORDS];
+	int prevCount = 0;
+	int currCount = 0;
+	int64_t time = 0;
+	int tid = 0;
+
+	const int start = beginFrame(live, FRAME_BLOCK_COUNTER, core);
+	mWindowCount = 0;
+	mWindowTimestamps = 0;
+
+	while (pos < end) {
+		int key;
+		int64_t value;
+		if (!unpackInt(&pos, end, &key) || !varintRead(&pos, end, &value)) {
+			break;
+		}
+
+		const int64_t repeat = compact && key == COMPACT_KEY_RUN ? value : 1;
+		for (int64_t i = 0; i < repeat; ++i) {
+			if (compact && key != 0) {
+				const int p = currCount++;
+				if (key == COMPACT_KEY_RUN || (repeat > 1 && i > 0)) {
+					if (p >= prevCount) {
+						pos = end;
+						break;
+					}
+					key = prevKeys[p];
+					value = prevValues[p];
+				} else if (p < prevCount && prevKeys[p] == key) {
+					value += prevValues[p];
+				}
+				if (p < MAX_COMPACT_RECORDS) {
+					currKeys[p] = key;
+					currValues[p] = value;
+				}
+			}
+
+			if (key == 0) {
+				if (compact) {
+					time += value;
+					const int count = currCount < MAX_COMPACT_RECORDS ? currCount : MAX_COMPACT_RECORDS;
+					memcpy(prevKeys, currKeys, count * sizeof(prevKeys[0]));
+					memcpy(prevValues, currValues, count * sizeof(prevValues[0]));
+					prevCount = count;
+					currCount = 0;
+				} else {
+					time = value;
+				}
+				if (mWindowTimestamps == mDownsample) {
+					flushWindow(live);
+				}
+				++mWindowTimestamps;
+				mWindowTime = time;
+				tid = 0;
+			} else if (key == 1) {
+				tid = value;
+			} else {
+				int r;
+				for (r = 0; r < mWindowCount; ++r) {
+					if (mWindow[r].key == key && mWindow[r].tid == tid) {
+						break;
+					}
+				}
+				if (r == mWindowCount) {
+					if (mWindowCount == MAX_WINDOW_RECORDS) {
+						// Start a new window at the same time
+						flushWindow(live);
+						mWindowTimestamps = 1;
+						r = 0;
+					}
+					mWindow[r].key = key;
+					mWindow[r].tid = tid;
+					mWindow[r].value = 0;
+					++mWindowCount;
+				}
+				mWindow[r].value = isDelta(key) ? mWindow[r].value + value : value;
+			}
+		}
+	}
+
+	flushWindow(live);
+	endFrame(live, start);
+}
+
+// Writes the window as a single timestamp, the time of the last timestamp in the window as the deltas are up to then
+void LiveFilter::flushWindow(DynBuf *const live) {
+	if (mWindowTimestamps == 0) {
+		return;
+	}
+
+	pack(live, 0);
+	pack(live, mWindowTime);
+	int tid = 0;
+	for (int r = 0; r < mWindowCount; ++r) {
+		if (mWindow[r].tid != tid) {
+			tid = mWindow[r].tid;
+			pack(live, 1);
+			pack(live, tid);
+		}
+		pack(live, mWindow[r].key);
+		pack(live, mWindow[r].value);
+	}
+
+	mWindowCount = 0;
+	mWindowTimestamps = 0;
+}
+
+void LiveFilter::backtraceFrame(const int core, const char *pos, const char *const end, DynBuf *const live) {
+	const int start = beginFrame(live, LIVE_FRAME_BACKTRACE, core);
+
+	while (pos < end) {
+		const char *const sample = pos;
+		int64_t time;
+		int execCookie, tgid, pid, cookie;
+		if (!varintRead(&pos, end, &time) || !unpackInt(&pos, end, &execCookie) || !unpackInt(&pos, end, &tgid) || !unpackInt(&pos, end, &pid)) {
+			break;
+		}
+		for (;;) {
+			int64_t address;
+			if (!unpackInt(&pos, end, &cookie) || cookie == MESSAGE_END_BACKTRACE || !varintRead(&pos, end, &address)) {
+				break;
+			}
+		}
+		if (cookie != MESSAGE_END_BACKTRACE) {
+			break;
+		}
+
+		if (mBacktraces[core]++ % mDownsample == 0) {
+			live->append(sample, pos - sample);
+		}
+	}
+
+	// The frame is sent even if every sample was dropped as an empty frame is valid
+	endFrame(live, start);
+}
+
+bool LiveFilter::isTracepointId(const uint64_t id) const {
+	for (int i = 0; i < mTracepointIdCount; ++i) {
+		if (mTracepointIds[i] == id) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void LiveFilter::addTracepointId(const uint64_t id) {
+	if (mTracepointIdCount >= mTracepointIdCapacity) {
+		mTracepointIdCapacity = mTracepointIdCapacity == 0 ? 2 * NR_CPUS : 2 * mTracepointIdCapacity;
+		mTracepointIds = (uint64_t *)realloc(mTracepointIds, mTracepointIdCapacity * sizeof(uint64_t));
+		if (mTracepointIds == NULL) {
+			logg->logError(__FILE__, __LINE__, "realloc failed");
+			handleException();
+		}
+	}
+	mTracepointIds[mTracepointIdCount++] = id;
+}
+
+// Tracks which perf event ids are tracepoints, the frame itself is sent unchanged
+void LiveFilter::perfAttrsFrame(const char *pos, const char *const end) {
+	while (pos < end) {
+		int code;
+		if (!unpackInt(&pos, end, &code)) {
+			return;
+		}
+		int pid, tid, key, count;
+		int64_t value;
+		switch (code) {
+		case CODE_PEA: {
+			struct perf_event_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			if (end - pos < (int)(sizeof(attr.type) + sizeof(attr.size))) {
+				return;
+			}
+			memcpy(&attr, pos, sizeof(attr.type) + sizeof(attr.size));
+			if (attr.size < sizeof(attr.type) + sizeof(attr.size) || end - pos < (int)attr.size) {
+				return;
+			}
+			pos += attr.size;
+			if (!unpackInt(&pos, end, &key)) {
+				return;
+			}
+			if (attr.type == PERF_TYPE_TRACEPOINT && mTracepointKeyCount < MAX_PERFORMANCE_COUNTERS + 1) {
+				mTracepointKeys[mTracepointKeyCount++] = key;
+			}
+			break;
+		}
+		case CODE_KEYS:
+			if (!unpackInt(&pos, end, &count)) {
+				return;
+			}
+			for (int i = 0; i < count; ++i) {
+				if (!varintRead(&pos, end, &value) || !unpackInt(&pos, end, &key)) {
+					return;
+				}
+				for (int j = 0; j < mTracepointKeyCount; ++j) {
+					if (mTracepointKeys[j] == key) {
+						addTracepointId(value);
+					}
+				}
+			}
+			break;
+		case CODE_KEYS_OLD: {
+			int keys[MAX_PERFORMANCE_COUNTERS + 1];
+			if (!unpackInt(&pos, end, &count) || count < 0 || count > MAX_PERFORMANCE_COUNTERS + 1) {
+				return;
+			}
+			for (int i = 0; i < count; ++i) {
+				if (!unpackInt(&pos, end, &keys[i])) {
+					return;
+				}
+			}
+			// Followed by the result of reading the group, { u64 nr; { u64 value; u64 id; } values[nr]; }
+			uint64_t nr;
+			if (end - pos < (int)sizeof(nr)) {
+				return;
+			}
+			memcpy(&nr, pos, sizeof(nr));
+			pos += sizeof(nr);
+			for (uint64_t i = 0; i < nr; ++i) {
+				uint64_t values[2];
+				if (end - pos < (int)sizeof(values)) {
+					return;
+				}
+				memcpy(values, pos, sizeof(values));
+				pos += sizeof(values);
+				for (int j = 0; i < (uint64_t)count && j < mTracepointKeyCount; ++j) {
+					if (mTracepointKeys[j] == keys[i]) {
+						addTracepointId(values[1]);
+					}
+				}
+			}
+			break;
+		}
+		case CODE_FORMAT:
+		case CODE_STRING:
+			if ((code == CODE_STRING && !unpackInt(&pos, end, &key)) || !skipString(&pos, end)) {
+				return;
+			}
+			break;
+		case CODE_MAPS:
+			if (!unpackInt(&pos, end, &pid) || !unpackInt(&pos, end, &tid) || !skipString(&pos, end)) {
+				return;
+			}
+			break;
+		case CODE_COMM:
+			if (!unpackInt(&pos, end, &pid) || !unpackInt(&pos, end, &tid) || !skipString(&pos, end) || !skipString(&pos, end)) {
+				return;
+			}
+			break;
+		case CODE_COMM_ID:
+			if (!unpackInt(&pos, end, &pid) || !unpackInt(&pos, end, &tid) || !unpackInt(&pos, end, &key) || !unpackInt(&pos, end, &key)) {
+				return;
+			}
+			break;
+		case CODE_MAPS_ID:
+			if (!unpackInt(&pos, end, &pid) || !unpackInt(&pos, end, &tid) || !unpackInt(&pos, end, &count)) {
+				return;
+			}
+			// start, end, offset, flags and path id
+			for (int i = 0; i < 5 * count; ++i) {
+				if (!varintRead(&pos, end, &value)) {
+					return;
+				}
+			}
+			break;
+		default:
+			return;
+		}
+	}
+}
+
+void LiveFilter::perfFrame(const int cpu, const char *pos, const char *const end, DynBuf *const live) {
+	const int start = live->getLength();
+	// As written by PerfBuffer::send
+	const char header[FRAME_HEADER_SIZE + 2] = { RESPONSE_APC_DATA, 0, 0, 0, 0, FRAME_PERF, (char)cpu };
+	live->append(header, sizeof(header));
+
+	// The event id is first unless the kernel predates PERF_SAMPLE_IDENTIFIER, see DEFAULT_PEA_ARGS in PerfGroup.cpp
+	const int idOffset = sizeof(struct perf_event_header) + (gSessionData->perf.getLegacySupport() ? 3 * sizeof(uint64_t) : 0);
+	while (end - pos >= (int)sizeof(struct perf_event_header)) {
+		struct perf_event_header peh;
+		memcpy(&peh, pos, sizeof(peh));
+		if (peh.size < sizeof(peh) || end - pos < peh.size) {
+			break;
+		}
+
+		bool keep = true;
+		if (peh.type == PERF_RECORD_SAMPLE) {
+			uint64_t id = 0;
+			if (idOffset + (int)sizeof(id) <= peh.size) {
+				memcpy(&id, pos + idOffset, sizeof(id));
+			}
+			keep = isTracepointId(id) || mPerfSamples[cpu]++ % mDownsample == 0;
+		}
+		if (keep) {
+			live->append(pos, peh.size);
+		}
+		pos += peh.size;
+	}
+
+	endFrame(live, start);
+}
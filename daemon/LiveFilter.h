@@ -0,0 +1,91 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef LIVEFILTER_H
+#define LIVEFILTER_H
+
+#include <stdint.h>
+
+#include "Config.h"
+#include "DynBuf.h"
+
+class CaptureFile;
+
+// Splits the data of a live capture into a full resolution archive, in the local capture format, and a reduced stream for a slow connection to Streamline.
+// Both come from the same frames so the capture overhead is unchanged
+// - Block counter frames are aggregated into windows of downsample timestamps. Deltas are summed and levels keep their last value, see EventsXML::getDeltaCounters
+// - One in downsample PC samples is kept, from both the driver and perf, so the live profile has the same shape from fewer samples.
+//   sched_switch tracepoint samples are always kept as Streamline needs every switch to draw the threads
+// - Every other frame is sent unchanged
+class LiveFilter {
+public:
+	LiveFilter(const int downsample);
+	~LiveFilter();
+
+	// Receives the data sent to Streamline, frames may be split across calls. Complete frames are written to archive, if it is not NULL, and the reduced frames are appended to live
+	void write(const char *data, int length, CaptureFile *const archive, DynBuf *const live);
+
+private:
+	// Response type and length
+	static const int FRAME_HEADER_SIZE = 5;
+	// Counters aggregated in a window, additional counters start a new window
+	static const int MAX_WINDOW_RECORDS = 256;
+
+	struct Record {
+		int64_t value;
+		int tid;
+		int key;
+	};
+
+	static int beginFrame(DynBuf *const live, const int frameType, const int core);
+	static void endFrame(DynBuf *const live, const int start);
+	void frame(const char *const payload, const int length, CaptureFile *const archive, DynBuf *const live);
+	void counterFrame(const int core, const bool compact, const char *pos, const char *const end, DynBuf *const live);
+	void flushWindow(DynBuf *const live);
+	void backtraceFrame(const int core, const char *pos, const char *const end, DynBuf *const live);
+	void perfAttrsFrame(const char *pos, const char *const end);
+	void perfFrame(const int cpu, const char *pos, const char *const end, DynBuf *const live);
+	bool isDelta(const int key) const;
+	bool isTracepointId(const uint64_t id) const;
+	void addTracepointId(const uint64_t id);
+
+	const int mDownsample;
+
+	// Frame reassembly
+	char mHeader[FRAME_HEADER_SIZE];
+	int mHeaderLength;
+	int mFrameRemaining;
+	DynBuf mFrame;
+
+	// Counter keys and whether they are deltas, see EventsXML::getDeltaCounters
+	int mKeys[MAX_PERFORMANCE_COUNTERS];
+	bool mDeltas[MAX_PERFORMANCE_COUNTERS];
+
+	// The window being aggregated
+	Record mWindow[MAX_WINDOW_RECORDS];
+	int mWindowCount;
+	int mWindowTimestamps;
+	int64_t mWindowTime;
+
+	// Samples seen per core, a sample is kept when this is a multiple of mDownsample
+	int mBacktraces[NR_CPUS];
+	int mPerfSamples[NR_CPUS];
+
+	// Perf event ids and keys of tracepoints
+	int mTracepointKeys[MAX_PERFORMANCE_COUNTERS + 1];
+	int mTracepointKeyCount;
+	uint64_t *mTracepointIds;
+	int mTracepointIdCount;
+	int mTracepointIdCapacity;
+
+	// Intentionally unimplemented
+	LiveFilter(const LiveFilter &);
+	LiveFilter &operator=(const LiveFilter &);
+};
+
+#endif // LIVEFILTER_H
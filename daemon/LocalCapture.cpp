@@ -32,7 +32,7 @@ void LocalCapture::createAPCDirectory(char* target_path) {
 	}
 }
 
-void LocalCapture::write(char* string) {
+void LocalCapture::write(const char* string) {
 	char file[PATH_MAX];
 
 	// Set full path
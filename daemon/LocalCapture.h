@@ -15,7 +15,7 @@ class LocalCapture {
 public:
 	LocalCapture();
 	~LocalCapture();
-	void write(char* string);
+	void write(const char* string);
 	void copyImages(ImageLinkList* ptr);
 	void createAPCDirectory(char* target_path);
 private:
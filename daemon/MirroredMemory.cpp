@@ -0,0 +1,91 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "MirroredMemory.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "Logging.h"
+
+// Older libc headers do not define it, memfd_create was added in Linux 3.17
+#ifndef __NR_memfd_create
+#if defined(__aarch64__)
+#define __NR_memfd_create 279
+#elif defined(__arm__)
+#define __NR_memfd_create 385
+#elif defined(__x86_64__)
+#define __NR_memfd_create 319
+#elif defined(__i386__)
+#define __NR_memfd_create 356
+#endif
+#endif
+
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+#ifndef MREMAP_FIXED
+#define MREMAP_FIXED 2
+#endif
+
+// Maps fd at both halves of the 2*size reservation at buf
+static bool mapFd(char *const buf, const size_t size, const int fd) {
+	return mmap(buf, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED &&
+		mmap(buf + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+}
+
+// Transparent huge pages cut TLB misses on large rings, this is only a hint and is ignored unless shmem_enabled allows it
+static void adviseHugePages(char *const buf, const size_t size) {
+#ifdef MADV_HUGEPAGE
+	if (size >= HUGE_PAGE_SIZE) {
+		madvise(buf, 2 * size, MADV_HUGEPAGE);
+	}
+#else
+	(void)buf;
+	(void)size;
+#endif
+}
+
+char *mirroredMap(size_t *const size) {
+	const size_t pageSize = sysconf(_SC_PAGESIZE);
+	*size = (*size + pageSize - 1) & ~(pageSize - 1);
+
+	// Reserve the address space for both copies
+	char *const buf = (char *)mmap(NULL, 2 * *size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (buf == MAP_FAILED) {
+		return NULL;
+	}
+
+#ifdef __NR_memfd_create
+	const int fd = syscall(__NR_memfd_create, "gatord", 0);
+	if (fd >= 0) {
+		const bool mapped = ftruncate(fd, *size) == 0 && mapFd(buf, *size, fd);
+		// The mappings keep the memory alive
+		close(fd);
+		if (mapped) {
+			adviseHugePages(buf, *size);
+			return buf;
+		}
+	}
+#endif
+
+	// memfd_create is not available, map shared anonymous memory and then mirror it by remapping it with an old size of zero, which creates a second mapping of the same pages
+	logg->logMessage("memfd_create failed, mirroring the ring buffer with mremap");
+	if (mmap(buf, *size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != MAP_FAILED &&
+	    mremap(buf, 0, *size, MREMAP_MAYMOVE | MREMAP_FIXED, buf + *size) != MAP_FAILED) {
+		adviseHugePages(buf, *size);
+		return buf;
+	}
+
+	munmap(buf, 2 * *size);
+	return NULL;
+}
+
+void mirroredUnmap(char *const buf, const size_t size) {
+	munmap(buf, 2 * size);
+}
@@ -0,0 +1,19 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef MIRROREDMEMORY_H
+#define MIRROREDMEMORY_H
+
+#include <stddef.h>
+
+// Maps the same *size bytes twice back to back so that a span of up to *size bytes starting anywhere in the first copy is contiguous, which lets a ring buffer be written and read without handling the wrap.
+// *size is rounded up to a multiple of the page size. Returns NULL on failure
+char *mirroredMap(size_t *const size);
+void mirroredUnmap(char *const buf, const size_t size);
+
+#endif // MIRROREDMEMORY_H
@@ -20,6 +20,8 @@ public:
 	bool init();
 	bool add(const int fd);
 	int wait(struct epoll_event *const events, int maxevents, int timeout);
+	// Readable when any of the fds are, so that a monitor can be added to another
+	int getFd() const { return mFd; }
 
 private:
 
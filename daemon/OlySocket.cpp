@@ -14,7 +14,10 @@
 #include <Winsock2.h>
 #include <ws2tcpip.h>
 #else
+#include <errno.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unistd.h>
@@ -104,6 +107,36 @@ int OlySocket::connect(const char* path, const size_t pathSize) {
   return fd;
 }
 
+int OlySocket::connectTcp(const char* host, const int port) {
+  char service[16];
+  snprintf(service, sizeof(service), "%i", port);
+
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo *res;
+  if (getaddrinfo(host, service, &hints, &res) != 0) {
+    return -1;
+  }
+
+  int fd = -1;
+  for (struct addrinfo *ai = res; ai != NULL; ai = ai->ai_next) {
+    fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd < 0) {
+      continue;
+    }
+    if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+      break;
+    }
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(res);
+
+  return fd;
+}
+
 #endif
 
 OlySocket::~OlySocket() {
@@ -214,7 +247,81 @@ void OlySocket::send(const char* buffer, int size) {
   }
 }
 
+#ifndef WIN32
+int OlySocket::sendNonBlocking(const char* buffer, int size, bool more) {
+  if (size <= 0 || buffer == NULL) {
+    return 0;
+  }
+
+  for (;;) {
+    int n = ::send(mSocketID, buffer, size, MSG_DONTWAIT | MSG_NOSIGNAL | (more ? MSG_MORE : 0));
+    if (n >= 0) {
+      return n;
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return 0;
+    }
+    if (errno != EINTR) {
+      logg->logMessage("%s(%s:%i): Socket send error: %s", __FUNCTION__, __FILE__, __LINE__, strerror(errno));
+      return -1;
+    }
+  }
+}
+
+bool OlySocket::waitWritable(int timeoutMs) {
+  struct pollfd pfd;
+  pfd.fd = mSocketID;
+  pfd.events = POLLOUT;
+  pfd.revents = 0;
+  int ready = poll(&pfd, 1, timeoutMs);
+  if (ready < 0 && errno != EINTR) {
+    logg->logMessage("%s(%s:%i): Socket poll error: %s", __FUNCTION__, __FILE__, __LINE__, strerror(errno));
+  }
+  // Errors are reported by the next send
+  return ready > 0;
+}
+
+void OlySocket::setSendOptions(int sendBufferSize) {
+  // Not supported on unix domain sockets, which don't need them
+  int on = 1;
+  if (setsockopt(mSocketID, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)) != 0) {
+    logg->logMessage("%s(%s:%i): Unable to set TCP_NODELAY", __FUNCTION__, __FILE__, __LINE__);
+  }
+  // SO_SNDBUFFORCE is not limited by wmem_max but needs CAP_NET_ADMIN
+  if (setsockopt(mSocketID, SOL_SOCKET, SO_SNDBUFFORCE, &sendBufferSize, sizeof(sendBufferSize)) != 0 &&
+      setsockopt(mSocketID, SOL_SOCKET, SO_SNDBUF, &sendBufferSize, sizeof(sendBufferSize)) != 0) {
+    logg->logMessage("%s(%s:%i): Unable to set SO_SNDBUF", __FUNCTION__, __FILE__, __LINE__);
+  }
+}
+#endif
+
 // Returns the number of bytes received
+#ifndef WIN32
+int OlySocket::receiveNonBlocking(char* buffer, int size) {
+  if (size <= 0 || buffer == NULL) {
+    return 0;
+  }
+
+  for (;;) {
+    int n = recv(mSocketID, buffer, size, MSG_DONTWAIT);
+    if (n > 0) {
+      return n;
+    }
+    if (n == 0) {
+      logg->logMessage("Socket disconnected");
+      return -1;
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return 0;
+    }
+    if (errno != EINTR) {
+      logg->logMessage("%s(%s:%i): Socket receive error: %s", __FUNCTION__, __FILE__, __LINE__, strerror(errno));
+      return -1;
+    }
+  }
+}
+#endif
+
 int OlySocket::receive(char* buffer, int size) {
   if (size <= 0 || buffer == NULL) {
     return 0;
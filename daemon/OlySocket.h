@@ -15,6 +15,8 @@ class OlySocket {
 public:
 #ifndef WIN32
   static int connect(const char* path, const size_t pathSize);
+  // Connects to a TCP port of host, which is a name or an address
+  static int connectTcp(const char* host, const int port);
 #endif
 
   OlySocket(int socketID);
@@ -23,11 +25,26 @@ public:
   void closeSocket();
   void shutdownConnection();
   void send(const char* buffer, int size);
+#ifndef WIN32
+  // Sends immediately without waiting for the socket buffer, returns the number of bytes sent which is 0 if the buffer is full.
+  // more is a hint that more data follows soon, like TCP_CORK. Errors are logged and return -1 rather than being raised, the caller ends the session
+  int sendNonBlocking(const char* buffer, int size, bool more);
+  // Returns false if the socket did not become writable before the timeout
+  bool waitWritable(int timeoutMs);
+  // Sends small responses immediately and sizes the socket buffer for the data stream
+  void setSendOptions(int sendBufferSize);
+#endif
+#ifndef WIN32
+  // Receives what has already arrived without waiting, returns the number of bytes received which is 0 if there are none, or -1 if the socket is disconnected.
+  // Errors are logged and return -1 rather than being raised, the caller ends the session
+  int receiveNonBlocking(char* buffer, int size);
+#endif
   int receive(char* buffer, int size);
   int receiveNBytes(char* buffer, int size);
   int receiveString(char* buffer, int size);
 
   bool isValid() const { return mSocketID >= 0; }
+  int getFd() const { return mSocketID; }
 
 private:
   int mSocketID;
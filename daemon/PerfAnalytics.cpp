@@ -0,0 +1,390 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "PerfAnalytics.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "Logging.h"
+#include "PerfDriver.h"
+#include "SessionData.h"
+
+PerfAnalytics::PerfAnalytics(sem_t *senderSem) : mBuffer(0, FRAME_BLOCK_COUNTER, 256*1024, senderSem), mRings(RING_SIZE), mGroup(&mRings), mSenderSem(senderSem), mRecords(NULL), mRecordCapacity(0), mAnalyzerCount(0), mTracepointCount(0), mSampleType(0), mInterval(0), mWindowEnd(0), mLost(0) {
+	for (int cpu = 0; cpu < ARRAY_LENGTH(mCpuBuffers); ++cpu) {
+		mCpuBuffers[cpu] = NULL;
+	}
+}
+
+PerfAnalytics::~PerfAnalytics() {
+	for (int cpu = 0; cpu < ARRAY_LENGTH(mCpuBuffers); ++cpu) {
+		delete mCpuBuffers[cpu];
+	}
+	free(mRecords);
+}
+
+bool PerfAnalytics::addAnalyzer(PerfAnalyzer *const analyzer) {
+	for (int i = 0; i < mAnalyzerCount; ++i) {
+		if (mAnalyzers[i] == analyzer) {
+			return true;
+		}
+	}
+	if (mAnalyzerCount >= MAX_ANALYZERS) {
+		logg->logMessage("%s(%s:%i): Too many analyzers", __FUNCTION__, __FILE__, __LINE__);
+		return false;
+	}
+
+	mAnalyzers[mAnalyzerCount++] = analyzer;
+	return true;
+}
+
+int PerfAnalytics::addTracepoint(const char *const name, PerfAnalyzer *const analyzer, DynBuf *const format) {
+	if (mTracepointCount >= MAX_TRACEPOINTS || !addAnalyzer(analyzer)) {
+		logg->logMessage("%s(%s:%i): Too many tracepoints", __FUNCTION__, __FILE__, __LINE__);
+		return -1;
+	}
+
+	DynBuf printb;
+	const long long id = PerfDriver::getTracepointId(name, &printb);
+	if (id < 0) {
+		return -1;
+	}
+	if (!printb.printf(EVENTS_PATH "/%s/format", name) || !format->read(printb.getBuf())) {
+		logg->logMessage("%s(%s:%i): Unable to read the format of %s", __FUNCTION__, __FILE__, __LINE__, name);
+		return -1;
+	}
+
+	// The first tracepoint leads the group. Only RAW is needed, the group format read is part of DEFAULT_PEA_ARGS
+	if (!mGroup.add(NULL, mTracepointCount, PERF_TYPE_TRACEPOINT, id, 1, PERF_SAMPLE_RAW, PERF_GROUP_PER_CPU, NULL)) {
+		return -1;
+	}
+
+	mTracepointIds[mTracepointCount] = (int)id;
+	mTracepointAnalyzers[mTracepointCount] = analyzer;
+	return mTracepointCount++;
+}
+
+bool PerfAnalytics::prepare(Monitor *const monitor) {
+	// See DEFAULT_PEA_ARGS in PerfGroup.cpp
+	mSampleType = (gSessionData->perf.getLegacySupport()
+		       ? PERF_SAMPLE_TID | PERF_SAMPLE_IP | PERF_SAMPLE_TIME | PERF_SAMPLE_READ | PERF_SAMPLE_ID
+		       : PERF_SAMPLE_TIME | PERF_SAMPLE_READ | PERF_SAMPLE_IDENTIFIER) | PERF_SAMPLE_RAW;
+	mInterval = gSessionData->mLiveRate > 0 ? gSessionData->mLiveRate : NS_PER_S/10;
+
+	for (int i = 0; i < mAnalyzerCount; ++i) {
+		if (mAnalyzers[i]->isPerCpu()) {
+			for (int cpu = 0; cpu < gSessionData->mCores; ++cpu) {
+				mCpuBuffers[cpu] = new Buffer(cpu, FRAME_BLOCK_COUNTER, 32*1024, mSenderSem);
+			}
+			break;
+		}
+	}
+
+	if (mTracepointCount == 0) {
+		return true;
+	}
+
+	int numEvents = 0;
+	for (int cpu = 0; cpu < gSessionData->mCores; ++cpu) {
+		if (mGroup.prepareCPU(cpu)) {
+			const int count = mGroup.onlineCPU(cpu, false, NULL, monitor);
+			if (count > 0) {
+				numEvents += count;
+			}
+		}
+	}
+
+	return numEvents > 0;
+}
+
+bool PerfAnalytics::onlineCPU(const int cpu, Monitor *const monitor) {
+	return mTracepointCount == 0 || (mGroup.prepareCPU(cpu) && mGroup.onlineCPU(cpu, true, NULL, monitor));
+}
+
+bool PerfAnalytics::offlineCPU(const int cpu) {
+	return mGroup.offlineCPU(cpu);
+}
+
+bool PerfAnalytics::start() {
+	mWindowEnd = getTime() + mInterval;
+	return mTracepointCount == 0 || mGroup.start();
+}
+
+void PerfAnalytics::stop() {
+	mGroup.stop();
+	// Reduce what is left in the rings and send the last window
+	process();
+	flush(getTime());
+	if (mLost > 0) {
+		logg->logMessage("%s(%s:%i): %lli analytics records were lost", __FUNCTION__, __FILE__, __LINE__, (long long)mLost);
+	}
+}
+
+void PerfAnalytics::consume(void *arg, const int cpu, const char *const data, const int length) {
+	PerfAnalytics *const analytics = static_cast<PerfAnalytics *>(arg);
+	if (!analytics->mData[cpu].append(data, length)) {
+		logg->logError(__FILE__, __LINE__, "Unable to copy the analytics data");
+		handleException();
+	}
+}
+
+bool PerfAnalytics::parseSample(const char *pos, const char *const end, Record *const record) const {
+	// The u64 fields that precede READ, in the order they appear in a sample, see perf_event.h
+	static const uint64_t FIELDS[] = {
+		PERF_SAMPLE_IDENTIFIER, PERF_SAMPLE_IP, PERF_SAMPLE_TID, PERF_SAMPLE_TIME, PERF_SAMPLE_ADDR,
+		PERF_SAMPLE_ID, PERF_SAMPLE_STREAM_ID, PERF_SAMPLE_CPU, PERF_SAMPLE_PERIOD,
+	};
+	uint64_t value;
+
+	for (int i = 0; i < ARRAY_LENGTH(FIELDS); ++i) {
+		if ((mSampleType & FIELDS[i]) == 0) {
+			continue;
+		}
+		if (end - pos < (int)sizeof(value)) {
+			return false;
+		}
+		memcpy(&value, pos, sizeof(value));
+		pos += sizeof(value);
+		if (FIELDS[i] == PERF_SAMPLE_TIME) {
+			record->time = value;
+		}
+	}
+
+	// Group format with ids, see DEFAULT_PEA_ARGS
+	if (end - pos < (int)sizeof(value)) {
+		return false;
+	}
+	memcpy(&value, pos, sizeof(value));
+	if (value > (uint64_t)(end - pos) / (2*sizeof(uint64_t))) {
+		return false;
+	}
+	pos += sizeof(value) + value * 2*sizeof(uint64_t);
+
+	__u32 size;
+	if (end - pos < (int)sizeof(size)) {
+		return false;
+	}
+	memcpy(&size, pos, sizeof(size));
+	pos += sizeof(size);
+	if (size > (__u32)(end - pos) || size < sizeof(uint16_t)) {
+		return false;
+	}
+
+	// common_type is the id of the tracepoint
+	uint16_t type;
+	memcpy(&type, pos, sizeof(type));
+	for (int i = 0; i < mTracepointCount; ++i) {
+		if (mTracepointIds[i] == type) {
+			record->raw = pos;
+			record->size = size;
+			record->tracepoint = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int PerfAnalytics::compareRecords(const void *a, const void *b) {
+	const Record *const ra = static_cast<const Record *>(a);
+	const Record *const rb = static_cast<const Record *>(b);
+	if (ra->time != rb->time) {
+		return ra->time < rb->time ? -1 : 1;
+	}
+	return ra->cpu - rb->cpu;
+}
+
+void PerfAnalytics::process() {
+	if (mAnalyzerCount == 0) {
+		return;
+	}
+
+	mRings.consume(consume, this);
+
+	// Samples are only ordered within a cpu, so sort the samples of all cpus by time
+	int count = 0;
+	for (int cpu = 0; cpu < gSessionData->mCores; ++cpu) {
+		const char *pos = mData[cpu].getBuf();
+		const char *const end = pos + mData[cpu].getLength();
+		while (end - pos >= (int)sizeof(struct perf_event_header)) {
+			struct perf_event_header header;
+			memcpy(&header, pos, sizeof(header));
+			if (header.size < sizeof(header) || header.size > end - pos) {
+				break;
+			}
+
+			if (header.type == PERF_RECORD_SAMPLE) {
+				if (count >= mRecordCapacity) {
+					mRecordCapacity = mRecordCapacity == 0 ? 1024 : 2*mRecordCapacity;
+					mRecords = (Record *)realloc(mRecords, mRecordCapacity*sizeof(Record));
+					if (mRecords == NULL) {
+						logg->logError(__FILE__, __LINE__, "Unable to grow the analytics records");
+						handleException();
+					}
+				}
+				Record *const record = &mRecords[count];
+				record->time = 0;
+				record->cpu = cpu;
+				if (parseSample(pos + sizeof(header), pos + header.size, record)) {
+					++count;
+				}
+			} else if (header.type == PERF_RECORD_LOST) {
+				// id and then the number of records lost
+				uint64_t lost[2];
+				if (header.size >= sizeof(header) + sizeof(lost)) {
+					memcpy(lost, pos + sizeof(header), sizeof(lost));
+					mLost += lost[1];
+				}
+			}
+
+			pos += header.size;
+		}
+	}
+
+	qsort(mRecords, count, sizeof(Record), compareRecords);
+
+	for (int i = 0; i < count; ++i) {
+		const Record *const record = &mRecords[i];
+		if (record->time >= mWindowEnd) {
+			nextWindow(record->time);
+		}
+		mTracepointAnalyzers[record->tracepoint]->sample(record->cpu, record->time, record->tracepoint, record->raw, record->size);
+	}
+
+	for (int cpu = 0; cpu < gSessionData->mCores; ++cpu) {
+		mData[cpu].clear();
+	}
+
+	// Windows also end without samples so that analyzers that only read counters are flushed
+	const uint64_t now = getTime();
+	if (now >= mWindowEnd) {
+		nextWindow(now);
+	}
+}
+
+void PerfAnalytics::nextWindow(const uint64_t time) {
+	flush(mWindowEnd);
+	// Skip the empty windows
+	mWindowEnd = time + mInterval - (time - mWindowEnd) % mInterval;
+}
+
+void PerfAnalytics::flush(const uint64_t time) {
+	// Start each analyzer with a new timestamp so that the tid written by one analyzer does not apply to the counters of the next
+	for (int i = 0; i < mAnalyzerCount; ++i) {
+		if (mBuffer.eventHeader(time)) {
+			mAnalyzers[i]->flush(&mBuffer);
+		}
+	}
+	// Only check after writing all counters so that time and corresponding counters appear in the same frame
+	mBuffer.check(time);
+
+	for (int cpu = 0; cpu < ARRAY_LENGTH(mCpuBuffers); ++cpu) {
+		Buffer *const buffer = mCpuBuffers[cpu];
+		if (buffer == NULL || !buffer->eventHeader(time)) {
+			continue;
+		}
+		for (int i = 0; i < mAnalyzerCount; ++i) {
+			if (mAnalyzers[i]->isPerCpu()) {
+				mAnalyzers[i]->flushCpu(cpu, time, buffer);
+			}
+		}
+		buffer->check(time);
+	}
+}
+
+void PerfAnalytics::write(Sender *const sender) {
+	if (!mBuffer.isDone()) {
+		mBuffer.write(sender);
+	}
+	for (int cpu = 0; cpu < ARRAY_LENGTH(mCpuBuffers); ++cpu) {
+		if (mCpuBuffers[cpu] != NULL && !mCpuBuffers[cpu]->isDone()) {
+			mCpuBuffers[cpu]->write(sender);
+		}
+	}
+}
+
+void PerfAnalytics::setDone() {
+	mBuffer.setDone();
+	for (int cpu = 0; cpu < ARRAY_LENGTH(mCpuBuffers); ++cpu) {
+		if (mCpuBuffers[cpu] != NULL) {
+			mCpuBuffers[cpu]->setDone();
+		}
+	}
+}
+
+bool PerfAnalytics::isDone() const {
+	for (int cpu = 0; cpu < ARRAY_LENGTH(mCpuBuffers); ++cpu) {
+		if (mCpuBuffers[cpu] != NULL && !mCpuBuffers[cpu]->isDone()) {
+			return false;
+		}
+	}
+	return mBuffer.isDone();
+}
+
+bool PerfAnalytics::getField(const char *const format, const char *const name, int *const offset, int *const size) {
+	const int nameLength = strlen(name);
+	for (const char *field = strstr(format, "field:"); field != NULL; field = strstr(field + 1, "field:")) {
+		const char *const semicolon = strchr(field, ';');
+		if (semicolon == NULL) {
+			return false;
+		}
+		// The name is the last word before the semicolon, or before the dimension of an array
+		const char *nameEnd = semicolon;
+		if (nameEnd[-1] == ']') {
+			while (nameEnd > field && *nameEnd != '[') {
+				--nameEnd;
+			}
+		}
+		if (nameEnd - field < nameLength + 1 || strncmp(nameEnd - nameLength, name, nameLength) != 0 ||
+				(nameEnd[-nameLength - 1] != ' ' && nameEnd[-nameLength - 1] != '*')) {
+			continue;
+		}
+
+		const char *const offsetPos = strstr(semicolon, "offset:");
+		const char *const sizePos = strstr(semicolon, "size:");
+		if (offsetPos == NULL || sizePos == NULL) {
+			return false;
+		}
+		*offset = strtol(offsetPos + strlen("offset:"), NULL, 10);
+		*size = strtol(sizePos + strlen("size:"), NULL, 10);
+		return true;
+	}
+
+	return false;
+}
+
+int64_t PerfAnalytics::readField(const char *const raw, const int rawSize, const int offset, const int size) {
+	if (offset < 0 || offset + size > rawSize) {
+		return 0;
+	}
+
+	switch (size) {
+	case 1: {
+		int8_t value;
+		memcpy(&value, raw + offset, sizeof(value));
+		return value;
+	}
+	case 2: {
+		int16_t value;
+		memcpy(&value, raw + offset, sizeof(value));
+		return value;
+	}
+	case 4: {
+		int32_t value;
+		memcpy(&value, raw + offset, sizeof(value));
+		return value;
+	}
+	case 8: {
+		int64_t value;
+		memcpy(&value, raw + offset, sizeof(value));
+		return value;
+	}
+	default:
+		return 0;
+	}
+}
@@ -0,0 +1,113 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef PERFANALYTICS_H
+#define PERFANALYTICS_H
+
+#include <semaphore.h>
+#include <stdint.h>
+
+#include "Buffer.h"
+#include "Config.h"
+#include "DynBuf.h"
+#include "PerfBuffer.h"
+#include "PerfGroup.h"
+
+class Monitor;
+class Sender;
+
+// Reduces tracepoint samples inside gatord, see PerfAnalytics
+class PerfAnalyzer {
+public:
+	virtual ~PerfAnalyzer() {}
+
+	// Called for each sample of the tracepoints added by this analyzer, in time order across all cpus. raw is the tracepoint data, see the tracepoint's format
+	virtual void sample(const int, const uint64_t, const int, const char *const, const int) {}
+	// Writes the values accumulated since the last flush as block counters
+	virtual void flush(Buffer *const) {}
+	// Per cpu counters are written by flushCpu to a buffer for each cpu, time is the end of the window
+	virtual bool isPerCpu() const { return false; }
+	virtual void flushCpu(const int, const uint64_t, Buffer *const) {}
+};
+
+// Tracepoints that are sampled into rings of their own, that gatord reads instead of sending, and reduced to block counters by analyzers
+// so that only the results, not every raw sample, are sent to Streamline. Results are sent once per live rate, or ten times a second,
+// together with counters that analyzers read without tracepoints
+class PerfAnalytics {
+public:
+	PerfAnalytics(sem_t *senderSem);
+	~PerfAnalytics();
+
+	// Adds an analyzer that is flushed every window, analyzers that don't need tracepoints read their values in flush
+	bool addAnalyzer(PerfAnalyzer *const analyzer);
+	// Returns the index passed to analyzer->sample for the tracepoint, or -1 if it is not available. format is set to the tracepoint's format
+	int addTracepoint(const char *const name, PerfAnalyzer *const analyzer, DynBuf *const format);
+	bool isEnabled() const { return mAnalyzerCount > 0; }
+	uint64_t getInterval() const { return mInterval; }
+
+	bool prepare(Monitor *const monitor);
+	bool onlineCPU(const int cpu, Monitor *const monitor);
+	bool offlineCPU(const int cpu);
+	bool start();
+	void stop();
+
+	// Reads the rings and flushes the analyzers at each window boundary
+	void process();
+
+	void write(Sender *const sender);
+	void setDone();
+	bool isDone() const;
+
+	// Finds a field like 'field:pid_t pid;	offset:8;	size:4;	signed:1;' in a tracepoint format, for arrays size is the size of the whole array
+	static bool getField(const char *const format, const char *const name, int *const offset, int *const size);
+	// Reads an integer field of size bytes from raw
+	static int64_t readField(const char *const raw, const int rawSize, const int offset, const int size);
+
+private:
+	static const int MAX_TRACEPOINTS = 8;
+	static const int MAX_ANALYZERS = 8;
+	static const int RING_SIZE = 128*1024;
+
+	struct Record {
+		uint64_t time;
+		const char *raw;
+		int size;
+		int cpu;
+		int tracepoint;
+	};
+
+	static void consume(void *arg, const int cpu, const char *const data, const int length);
+	static int compareRecords(const void *a, const void *b);
+	bool parseSample(const char *pos, const char *const end, Record *const record) const;
+	void nextWindow(const uint64_t time);
+	void flush(const uint64_t time);
+
+	Buffer mBuffer;
+	PerfBuffer mRings;
+	PerfGroup mGroup;
+	Buffer *mCpuBuffers[NR_CPUS];
+	sem_t *const mSenderSem;
+	DynBuf mData[NR_CPUS];
+	Record *mRecords;
+	int mRecordCapacity;
+	PerfAnalyzer *mAnalyzers[MAX_ANALYZERS];
+	int mAnalyzerCount;
+	int mTracepointIds[MAX_TRACEPOINTS];
+	PerfAnalyzer *mTracepointAnalyzers[MAX_TRACEPOINTS];
+	int mTracepointCount;
+	uint64_t mSampleType;
+	uint64_t mInterval;
+	uint64_t mWindowEnd;
+	int64_t mLost;
+
+	// Intentionally unimplemented
+	PerfAnalytics(const PerfAnalytics &);
+	PerfAnalytics &operator=(const PerfAnalytics &);
+};
+
+#endif // PERFANALYTICS_H
@@ -16,9 +16,10 @@
 #include "Sender.h"
 #include "SessionData.h"
 
-PerfBuffer::PerfBuffer() {
+PerfBuffer::PerfBuffer(const int ringSize) : mRingSize(ringSize), mObserver(NULL), mObserverArg(NULL) {
 	for (int cpu = 0; cpu < ARRAY_LENGTH(mBuf); ++cpu) {
 		mBuf[cpu] = MAP_FAILED;
+		mSize[cpu] = 0;
 		mDiscard[cpu] = false;
 	}
 }
@@ -26,11 +27,15 @@ PerfBuffer::PerfBuffer() {
 PerfBuffer::~PerfBuffer() {
 	for (int cpu = ARRAY_LENGTH(mBuf) - 1; cpu >= 0; --cpu) {
 		if (mBuf[cpu] != MAP_FAILED) {
-			munmap(mBuf[cpu], gSessionData->mPageSize + BUF_SIZE);
+			munmap(mBuf[cpu], gSessionData->mPageSize + mSize[cpu]);
 		}
 	}
 }
 
+int PerfBuffer::getRingSize(const int cpu) const {
+	return mRingSize > 0 ? mRingSize : gSessionData->bufferBudget.getPerfRingSize(cpu);
+}
+
 bool PerfBuffer::useFd(const int cpu, const int fd, const int groupFd) {
 	if (fd == groupFd) {
 		if (mBuf[cpu] != MAP_FAILED) {
@@ -39,7 +44,8 @@ bool PerfBuffer::useFd(const int cpu, const int fd, const int groupFd) {
 		}
 
 		// The buffer isn't mapped yet
-		mBuf[cpu] = mmap(NULL, gSessionData->mPageSize + BUF_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		mSize[cpu] = getRingSize(cpu);
+		mBuf[cpu] = mmap(NULL, gSessionData->mPageSize + mSize[cpu], PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
 		if (mBuf[cpu] == MAP_FAILED) {
 			logg->logMessage("%s(%s:%i): mmap failed", __FUNCTION__, __FILE__, __LINE__);
 			return false;
@@ -101,6 +107,7 @@ bool PerfBuffer::send(Sender *const sender) {
 		const __u64 tail = pemp->data_tail;
 
 		if (head > tail) {
+			const __u64 mask = mSize[cpu] - 1;
 			const uint8_t *const b = static_cast<uint8_t *>(mBuf[cpu]) + gSessionData->mPageSize;
 			const int offset = gSessionData->mLocalCapture ? 1 : 0;
 			unsigned char header[7];
@@ -114,21 +121,29 @@ bool PerfBuffer::send(Sender *const sender) {
 			sender->writeData(reinterpret_cast<const char *>(&header) + offset, sizeof(header) - offset, RESPONSE_APC_DATA);
 
 			// Write data
-			if ((head & ~BUF_MASK) == (tail & ~BUF_MASK)) {
+			if ((head & ~mask) == (tail & ~mask)) {
 				// Not wrapped
-				sender->writeData(reinterpret_cast<const char *>(b + (tail & BUF_MASK)), head - tail, RESPONSE_APC_DATA);
+				if (mObserver != NULL) {
+					mObserver(mObserverArg, cpu, reinterpret_cast<const char *>(b + (tail & mask)), head - tail, NULL, 0);
+				}
+				sender->writeData(reinterpret_cast<const char *>(b + (tail & mask)), head - tail, RESPONSE_APC_DATA);
 			} else {
 				// Wrapped
-				sender->writeData(reinterpret_cast<const char *>(b + (tail & BUF_MASK)), BUF_SIZE - (tail & BUF_MASK), RESPONSE_APC_DATA);
-				sender->writeData(reinterpret_cast<const char *>(b), head & BUF_MASK, RESPONSE_APC_DATA);
+				if (mObserver != NULL) {
+					mObserver(mObserverArg, cpu, reinterpret_cast<const char *>(b + (tail & mask)), mSize[cpu] - (tail & mask), reinterpret_cast<const char *>(b), head & mask);
+				}
+				sender->writeData(reinterpret_cast<const char *>(b + (tail & mask)), mSize[cpu] - (tail & mask), RESPONSE_APC_DATA);
+				sender->writeData(reinterpret_cast<const char *>(b), head & mask, RESPONSE_APC_DATA);
 			}
 
 			// Update tail with the data read
 			pemp->data_tail = head;
+
+			gSessionData->bufferBudget.perfRingSent(cpu, head - tail);
 		}
 
 		if (mDiscard[cpu]) {
-			munmap(mBuf[cpu], gSessionData->mPageSize + BUF_SIZE);
+			munmap(mBuf[cpu], gSessionData->mPageSize + mSize[cpu]);
 			mBuf[cpu] = MAP_FAILED;
 			mDiscard[cpu] = false;
 			logg->logMessage("%s(%s:%i): Unmaped cpu %i", __FUNCTION__, __FILE__, __LINE__, cpu);
@@ -137,3 +152,43 @@ bool PerfBuffer::send(Sender *const sender) {
 
 	return true;
 }
+
+void PerfBuffer::consume(void (*consumer)(void *arg, const int cpu, const char *const data, const int length), void *arg) {
+	for (int cpu = 0; cpu < gSessionData->mCores; ++cpu) {
+		if (mBuf[cpu] == MAP_FAILED) {
+			continue;
+		}
+
+		// Take a snapshot of the positions
+		struct perf_event_mmap_page *pemp = static_cast<struct perf_event_mmap_page *>(mBuf[cpu]);
+		const __u64 head = pemp->data_head;
+		const __u64 tail = pemp->data_tail;
+		// Read the data only after reading data_head, see perf_event.h
+		__sync_synchronize();
+
+		if (head > tail) {
+			const __u64 mask = mSize[cpu] - 1;
+			const char *const b = static_cast<char *>(mBuf[cpu]) + gSessionData->mPageSize;
+
+			if ((head & ~mask) == (tail & ~mask)) {
+				// Not wrapped
+				consumer(arg, cpu, b + (tail & mask), head - tail);
+			} else {
+				// Wrapped
+				consumer(arg, cpu, b + (tail & mask), mSize[cpu] - (tail & mask));
+				consumer(arg, cpu, b, head & mask);
+			}
+
+			// Finish reading the data before the kernel can overwrite it
+			__sync_synchronize();
+			pemp->data_tail = head;
+		}
+
+		if (mDiscard[cpu]) {
+			munmap(mBuf[cpu], gSessionData->mPageSize + mSize[cpu]);
+			mBuf[cpu] = MAP_FAILED;
+			mDiscard[cpu] = false;
+			logg->logMessage("%s(%s:%i): Unmaped cpu %i", __FUNCTION__, __FILE__, __LINE__, cpu);
+		}
+	}
+}
@@ -11,25 +11,36 @@
 
 #include "Config.h"
 
-#define BUF_SIZE (gSessionData->mTotalBufferSize * 1024 * 1024)
-#define BUF_MASK (BUF_SIZE - 1)
-
 class Sender;
 
+// Called with the data of a cpu before it is sent. data2 is the part that wrapped around the end of the ring, or NULL
+typedef void (*PerfObserver)(void *arg, const int cpu, const char *const data1, const int length1, const char *const data2, const int length2);
+
 class PerfBuffer {
 public:
-	PerfBuffer();
+	// A ringSize of 0 sizes the rings from BufferBudget, otherwise the rings are of a fixed size and are consumed by gatord instead of sent, see PerfAnalytics
+	PerfBuffer(const int ringSize = 0);
 	~PerfBuffer();
 
+	int getRingSize(const int cpu) const;
 	bool useFd(const int cpu, const int fd, const int groupFd);
 	void discard(const int cpu);
 	bool isEmpty();
 	bool send(Sender *const sender);
+	void setObserver(PerfObserver observer, void *arg) { mObserver = observer; mObserverArg = arg; }
+	// Passes the new data of each cpu to consumer instead of sending it. The data is passed in two parts when it wraps around the end of the ring
+	void consume(void (*consumer)(void *arg, const int cpu, const char *const data, const int length), void *arg);
 
 private:
 	void *mBuf[NR_CPUS];
+	// Size of the data pages of each ring, from BufferBudget when the ring is mapped
+	int mSize[NR_CPUS];
 	// After the buffer is flushed it should be unmaped
 	bool mDiscard[NR_CPUS];
+	// 0 to size the rings from BufferBudget
+	const int mRingSize;
+	PerfObserver mObserver;
+	void *mObserverArg;
 
 	// Intentionally undefined
 	PerfBuffer(const PerfBuffer &);
@@ -13,19 +13,24 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "BlockIo.h"
 #include "Buffer.h"
 #include "Config.h"
 #include "ConfigurationXML.h"
 #include "Counter.h"
+#include "CpuPower.h"
 #include "DriverSource.h"
 #include "DynBuf.h"
 #include "Logging.h"
 #include "PerfGroup.h"
+#include "PerfPmu.h"
+#include "ProcStats.h"
+#include "SchedLatency.h"
 #include "SessionData.h"
 
-#define PERF_DEVICES "/sys/bus/event_source/devices"
-
 #define TYPE_DERIVED ~0U
+// Computed by gatord from tracepoints, see PerfAnalytics
+#define TYPE_ANALYTICS (~0U - 1)
 
 // From gator.h
 struct gator_cpu {
@@ -76,7 +81,7 @@ static const struct uncore_counter uncore_counters[] = {
 
 class PerfCounter {
 public:
-	PerfCounter(PerfCounter *next, const char *name, uint32_t type, uint64_t config, bool perCpu) : mNext(next), mName(name), mType(type), mCount(0), mKey(getEventKey()), mConfig(config), mEnabled(false), mPerCpu(perCpu) {}
+	PerfCounter(PerfCounter *next, const char *name, uint32_t type, uint64_t config, bool perCpu) : mNext(next), mName(name), mType(type), mCount(0), mKey(getEventKey()), mConfig(config), mCpuId(-1), mEnabled(false), mPerCpu(perCpu), mHasCpus(false) {}
 	~PerfCounter() {
 		delete [] mName;
 	}
@@ -92,6 +97,14 @@ public:
 	bool isEnabled() const { return mEnabled; }
 	void setEnabled(const bool enabled) { mEnabled = enabled; }
 	bool isPerCpu() const { return mPerCpu; }
+	// Counted by a PMU outside the cores, like a CCI
+	bool isUncore() const { return !mPerCpu && mType != TYPE_DERIVED && mType != TYPE_ANALYTICS; }
+	// Restricts the counter to some cpus, like the cpumask of an uncore PMU
+	void setCpus(const cpu_set_t &cpus) { mCpus = cpus; mHasCpus = true; }
+	const cpu_set_t *getCpus() const { return mHasCpus ? &mCpus : NULL; }
+	// The cpuid of the cores this counter is for, used when the PMU does not list its cpus
+	int getCpuId() const { return mCpuId; }
+	void setCpuId(const int cpuId) { mCpuId = cpuId; }
 
 private:
 	PerfCounter *const mNext;
@@ -100,11 +113,14 @@ private:
 	int mCount;
 	const int mKey;
 	uint64_t mConfig;
+	cpu_set_t mCpus;
+	int mCpuId;
 	int mEnabled : 1,
-		mPerCpu : 1;
+		mPerCpu : 1,
+		mHasCpus : 1;
 };
 
-PerfDriver::PerfDriver() : mCounters(NULL), mIsSetup(false), mLegacySupport(false) {
+PerfDriver::PerfDriver() : mCounters(NULL), mPmuCount(0), mIsSetup(false), mLegacySupport(false), mBlockIo(false) {
 }
 
 PerfDriver::~PerfDriver() {
@@ -115,17 +131,89 @@ PerfDriver::~PerfDriver() {
 	}
 }
 
-void PerfDriver::addCpuCounters(const char *const counterName, const int type, const int numCounters) {
+void PerfDriver::addCpuCounters(const char *const counterName, const int type, const int numCounters, const int cpuId, const char *const pmu) {
+	// On big.LITTLE each cluster has its own PMU, so only open the counters on the cpus of this PMU
+	char buf[256];
+	cpu_set_t cpus;
+	bool hasCpus = false;
+	if (pmu != NULL) {
+		snprintf(buf, sizeof(buf), PERF_DEVICES "/%s/cpus", pmu);
+		hasCpus = PerfPmu::readCpus(buf, &cpus);
+	}
+
 	int len = snprintf(NULL, 0, "%s_ccnt", counterName) + 1;
 	char *name = new char[len];
 	snprintf(name, len, "%s_ccnt", counterName);
 	mCounters = new PerfCounter(mCounters, name, type, -1, true);
+	if (hasCpus) {
+		mCounters->setCpus(cpus);
+	}
+	mCounters->setCpuId(cpuId);
 
 	for (int j = 0; j < numCounters; ++j) {
 		len = snprintf(NULL, 0, "%s_cnt%d", counterName, j) + 1;
 		name = new char[len];
 		snprintf(name, len, "%s_cnt%d", counterName, j);
 		mCounters = new PerfCounter(mCounters, name, type, -1, true);
+		if (hasCpus) {
+			mCounters->setCpus(cpus);
+		}
+		mCounters->setCpuId(cpuId);
+	}
+}
+
+void PerfDriver::getCpus(const int cpuId, cpu_set_t *const cpus) {
+	CPU_ZERO(cpus);
+	bool found = false;
+	for (int cpu = 0; cpu < NR_CPUS; ++cpu) {
+		if (gSessionData->mCpuIds[cpu] == cpuId) {
+			CPU_SET(cpu, cpus);
+			found = true;
+		} else if (gSessionData->mCpuIds[cpu] == -1) {
+			// Offline when cpuinfo was read, the open will fail if it is the wrong PMU
+			CPU_SET(cpu, cpus);
+		}
+	}
+
+	if (!found) {
+		// cpuinfo does not have the full topology, so assume every cpu is this type
+		for (int cpu = 0; cpu < NR_CPUS; ++cpu) {
+			CPU_SET(cpu, cpus);
+		}
+	}
+}
+
+struct PmuCounterArgs {
+	PerfCounter **counters;
+	int type;
+	cpu_set_t cpus;
+	bool uncore;
+};
+
+static void addPmuCounter(void *arg, const char *const pmu, const char *const event, const uint64_t config) {
+	PmuCounterArgs *const args = static_cast<PmuCounterArgs *>(arg);
+	const int len = snprintf(NULL, 0, "%s_%s", pmu, event) + 1;
+	char *const name = new char[len];
+	snprintf(name, len, "%s_%s", pmu, event);
+	*args->counters = new PerfCounter(*args->counters, name, args->type, config, !args->uncore);
+	(*args->counters)->setCpus(args->cpus);
+}
+
+void PerfDriver::addPmuCounters(const char *const pmu) {
+	if (mPmuCount >= ARRAY_LENGTH(mPmus) || strlen(pmu) >= sizeof(mPmus[0])) {
+		logg->logMessage("%s(%s:%i): Too many PMUs, ignoring %s", __FUNCTION__, __FILE__, __LINE__, pmu);
+		return;
+	}
+
+	PmuCounterArgs args;
+	args.counters = &mCounters;
+	if (!PerfPmu::read(pmu, &args.type, &args.cpus, &args.uncore)) {
+		return;
+	}
+
+	// Each named event becomes a counter, uncore events are only opened on one cpu of each instance
+	if (PerfPmu::readEvents(pmu, addPmuCounter, &args) > 0) {
+		strcpy(mPmus[mPmuCount++], pmu);
 	}
 }
 
@@ -188,6 +276,7 @@ bool PerfDriver::setup() {
 
 	struct dirent *dirent;
 	while ((dirent = readdir(dir)) != NULL) {
+		bool known = false;
 		for (int i = 0; i < ARRAY_LENGTH(gator_cpus); ++i) {
 			// Do the names match exactly?
 			if (strcmp(dirent->d_name, gator_cpus[i].pmnc_name) != 0 &&
@@ -206,7 +295,8 @@ bool PerfDriver::setup() {
 			}
 
 			foundCpu = true;
-			addCpuCounters(gator_cpus[i].pmnc_name, type, gator_cpus[i].pmnc_counters);
+			known = true;
+			addCpuCounters(gator_cpus[i].pmnc_name, type, gator_cpus[i].pmnc_counters, gator_cpus[i].cpuid, dirent->d_name);
 		}
 
 		for (int i = 0; i < ARRAY_LENGTH(uncore_counters); ++i) {
@@ -221,20 +311,29 @@ bool PerfDriver::setup() {
 				continue;
 			}
 
+			known = true;
 			addUncoreCounters(uncore_counters[i].name, type, uncore_counters[i].count);
 		}
+
+		if (!known && !PerfPmu::isSpecial(dirent->d_name)) {
+			addPmuCounters(dirent->d_name);
+		}
 	}
 	closedir(dir);
 
 	if (!foundCpu) {
-		// If no cpu was found based on pmu names, try by cpuid
+		// If no cpu was found based on pmu names, try by cpuid, adding the counters of each type of core found on heterogeneous systems
 		for (int i = 0; i < ARRAY_LENGTH(gator_cpus); ++i) {
-			if (gSessionData->mMaxCpuId != gator_cpus[i].cpuid) {
+			bool found = gSessionData->mMaxCpuId == gator_cpus[i].cpuid;
+			for (int cpu = 0; cpu < NR_CPUS && !found; ++cpu) {
+				found = gSessionData->mCpuIds[cpu] == gator_cpus[i].cpuid;
+			}
+			if (!found) {
 				continue;
 			}
 
 			foundCpu = true;
-			addCpuCounters(gator_cpus[i].pmnc_name, PERF_TYPE_RAW, gator_cpus[i].pmnc_counters);
+			addCpuCounters(gator_cpus[i].pmnc_name, PERF_TYPE_RAW, gator_cpus[i].pmnc_counters, gator_cpus[i].cpuid, NULL);
 		}
 	}
 
@@ -260,25 +359,59 @@ bool PerfDriver::setup() {
 		mCounters = new PerfCounter(mCounters, "Linux_irq_irq", PERF_TYPE_TRACEPOINT, id, true);
 	}
 
-	//Linux_block_rq_wr
-	//Linux_block_rq_rd
-	//Linux_net_rx
-	//Linux_net_tx
+	if (getTracepointId(BLOCK_RQ_ISSUE, &printb) >= 0 && getTracepointId(BLOCK_RQ_COMPLETE, &printb) >= 0) {
+		mCounters = new PerfCounter(mCounters, "Linux_block_rq_wr", TYPE_ANALYTICS, -1, false);
+		mCounters = new PerfCounter(mCounters, "Linux_block_rq_rd", TYPE_ANALYTICS, -1, false);
+		for (int i = 0; i < BlockIo::BUCKET_COUNT; ++i) {
+			mCounters = new PerfCounter(mCounters, BlockIo::LATENCY_COUNTERS[i], TYPE_ANALYTICS, -1, false);
+		}
+
+		BlockIo::Disk disks[BlockIo::MAX_DISKS];
+		const int count = BlockIo::readDisks(disks, ARRAY_LENGTH(disks));
+		for (int i = 0; i < count; ++i) {
+			for (int write = 0; write < 2; ++write) {
+				char *const name = new char[128];
+				BlockIo::getDiskCounter(name, 128, disks[i], write);
+				mCounters = new PerfCounter(mCounters, name, TYPE_ANALYTICS, -1, false);
+			}
+		}
+		mBlockIo = true;
+	}
+
+	if (access(PROC_NET_DEV, R_OK) == 0) {
+		mCounters = new PerfCounter(mCounters, "Linux_net_rx", TYPE_ANALYTICS, -1, false);
+		mCounters = new PerfCounter(mCounters, "Linux_net_tx", TYPE_ANALYTICS, -1, false);
+	}
 
 	id = getTracepointId(SCHED_SWITCH, &printb);
 	if (id >= 0) {
 		mCounters = new PerfCounter(mCounters, "Linux_sched_switch", PERF_TYPE_TRACEPOINT, id, true);
+
+		if (getTracepointId(SCHED_WAKEUP, &printb) >= 0) {
+			for (int i = 0; i < SchedLatency::BUCKET_COUNT; ++i) {
+				mCounters = new PerfCounter(mCounters, SchedLatency::RUNQ_COUNTERS[i], TYPE_ANALYTICS, -1, false);
+				mCounters = new PerfCounter(mCounters, SchedLatency::OFFCPU_COUNTERS[i], TYPE_ANALYTICS, -1, false);
+			}
+		}
+	}
+
+	if (access(PROC_MEMINFO, R_OK) == 0) {
+		mCounters = new PerfCounter(mCounters, "Linux_meminfo_memused", TYPE_ANALYTICS, -1, false);
+		mCounters = new PerfCounter(mCounters, "Linux_meminfo_memfree", TYPE_ANALYTICS, -1, false);
+		mCounters = new PerfCounter(mCounters, "Linux_meminfo_bufferram", TYPE_ANALYTICS, -1, false);
 	}
 
-	//Linux_meminfo_memused
-	//Linux_meminfo_memfree
-	//Linux_meminfo_bufferram
-	//Linux_power_cpu_freq
-	//Linux_power_cpu_idle
+	if (getTracepointId(CPU_FREQUENCY, &printb) >= 0) {
+		mCounters = new PerfCounter(mCounters, "Linux_power_cpu_freq", TYPE_ANALYTICS, -1, true);
+	}
 
-	mCounters = new PerfCounter(mCounters, "Linux_cpu_wait_contention", TYPE_DERIVED, -1, false);
+	if (getTracepointId(CPU_IDLE, &printb) >= 0) {
+		mCounters = new PerfCounter(mCounters, "Linux_power_cpu_idle", TYPE_ANALYTICS, -1, true);
+		mCounters = new PerfCounter(mCounters, "Linux_power_cpu_idle_time", TYPE_ANALYTICS, -1, true);
+	}
 
-	//Linux_cpu_wait_io
+	mCounters = new PerfCounter(mCounters, "Linux_cpu_wait_contention", TYPE_DERIVED, -1, false);
+	mCounters = new PerfCounter(mCounters, "Linux_cpu_wait_io", TYPE_DERIVED, -1, false);
 
 	mIsSetup = true;
 	return true;
@@ -380,10 +513,50 @@ int PerfDriver::writeCounters(mxml_node_t *root) const {
 	return count;
 }
 
+struct PmuEventArgs {
+	mxml_node_t *category;
+	bool uncore;
+};
+
+static void writePmuEvent(void *arg, const char *const pmu, const char *const event, const uint64_t) {
+	PmuEventArgs *const args = static_cast<PmuEventArgs *>(arg);
+	mxml_node_t *node = mxmlNewElement(args->category, "event");
+	mxmlElementSetAttrf(node, "counter", "%s_%s", pmu, event);
+	mxmlElementSetAttr(node, "title", pmu);
+	mxmlElementSetAttr(node, "name", event);
+	mxmlElementSetAttr(node, "per_cpu", args->uncore ? "no" : "yes");
+	mxmlElementSetAttrf(node, "description", "%s event of the %s PMU", event, pmu);
+}
+
+void PerfDriver::writeEvents(mxml_node_t *root) const {
+	if (mBlockIo) {
+		BlockIo::writeEvents(root);
+	}
+
+	for (int i = 0; i < mPmuCount; ++i) {
+		int type;
+		cpu_set_t cpus;
+		PmuEventArgs args;
+		if (!PerfPmu::read(mPmus[i], &type, &cpus, &args.uncore)) {
+			continue;
+		}
+		args.category = mxmlNewElement(root, "category");
+		mxmlElementSetAttr(args.category, "name", mPmus[i]);
+		PerfPmu::readEvents(mPmus[i], writePmuEvent, &args);
+	}
+}
+
 bool PerfDriver::enable(PerfGroup *const group, Buffer *const buffer) const {
 	for (PerfCounter * counter = mCounters; counter != NULL; counter = counter->getNext()) {
-		if (counter->isEnabled() && (counter->getType() != TYPE_DERIVED)) {
-			if (!group->add(buffer, counter->getKey(), counter->getType(), counter->getConfig(), counter->getCount(), counter->getCount() > 0 ? PERF_SAMPLE_TID | PERF_SAMPLE_IP : 0, counter->isPerCpu() ? PERF_GROUP_PER_CPU : 0)) {
+		if (counter->isEnabled() && (counter->getType() != TYPE_DERIVED) && (counter->getType() != TYPE_ANALYTICS) && !counter->isUncore()) {
+			// Use the cpuids read in PerfSource::prepare as cores may have come online since setup
+			cpu_set_t cpus;
+			const cpu_set_t *counterCpus = counter->getCpus();
+			if (counterCpus == NULL && counter->getCpuId() >= 0) {
+				getCpus(counter->getCpuId(), &cpus);
+				counterCpus = &cpus;
+			}
+			if (!group->add(buffer, counter->getKey(), counter->getType(), counter->getConfig(), counter->getCount(), counter->getCount() > 0 ? PERF_SAMPLE_TID | PERF_SAMPLE_IP : 0, counter->isPerCpu() ? PERF_GROUP_PER_CPU : 0, counterCpus)) {
 				logg->logMessage("%s(%s:%i): PerfGroup::add failed", __FUNCTION__, __FILE__, __LINE__);
 				return false;
 			}
@@ -393,6 +566,43 @@ bool PerfDriver::enable(PerfGroup *const group, Buffer *const buffer) const {
 	return true;
 }
 
+int PerfDriver::enableUncore(PerfGroup *const group) const {
+	int count = 0;
+	for (PerfCounter * counter = mCounters; counter != NULL; counter = counter->getNext()) {
+		if (!counter->isEnabled() || !counter->isUncore()) {
+			continue;
+		}
+
+		// The first counter of each PMU leads the group of that PMU
+		bool isLeader = true;
+		for (PerfCounter * prev = mCounters; prev != counter; prev = prev->getNext()) {
+			if (prev->isEnabled() && prev->isUncore() && prev->getType() == counter->getType()) {
+				isLeader = false;
+				break;
+			}
+		}
+
+		// Uncore PMUs can't sample, the counters are read by PerfUncore. The counters are opened on the cpus of the PMU's cpumask, one for each instance, or on cpu 0
+		if (!group->add(NULL, counter->getKey(), counter->getType(), counter->getConfig(), 0, 0, isLeader ? PERF_GROUP_LEADER : 0, counter->getCpus())) {
+			logg->logMessage("%s(%s:%i): PerfGroup::add failed", __FUNCTION__, __FILE__, __LINE__);
+			return -1;
+		}
+		++count;
+	}
+
+	return count;
+}
+
+int PerfDriver::getEnabledKey(const char *const name) const {
+	for (PerfCounter * counter = mCounters; counter != NULL; counter = counter->getNext()) {
+		if (counter->isEnabled() && strcmp(counter->getName(), name) == 0) {
+			return counter->getKey();
+		}
+	}
+
+	return -1;
+}
+
 long long PerfDriver::getTracepointId(const char *const name, DynBuf *const printb) {
 	if (!printb->printf(EVENTS_PATH "/%s/id", name)) {
 		logg->logMessage("%s(%s:%i): DynBuf::printf failed", __FUNCTION__, __FILE__, __LINE__);
@@ -9,6 +9,8 @@
 #ifndef PERFDRIVER_H
 #define PERFDRIVER_H
 
+#include <sched.h>
+
 #include "Driver.h"
 
 // If debugfs is not mounted at /sys/kernel/debug, update DEBUGFS_PATH
@@ -16,6 +18,9 @@
 #define EVENTS_PATH DEBUGFS_PATH "/tracing/events"
 
 #define SCHED_SWITCH "sched/sched_switch"
+#define SCHED_WAKEUP "sched/sched_wakeup"
+#define SCHED_WAKEUP_NEW "sched/sched_wakeup_new"
+#define SCHED_PROCESS_EXIT "sched/sched_process_exit"
 
 class Buffer;
 class DynBuf;
@@ -38,19 +43,32 @@ public:
 	void setupCounter(Counter &counter);
 
 	int writeCounters(mxml_node_t *root) const;
+	void writeEvents(mxml_node_t *root) const;
 
 	bool enable(PerfGroup *const group, Buffer *const buffer) const;
+	// Adds the uncore counters to group, the counters of each uncore PMU are a group of their own. Returns the number of counters added or -1 on failure
+	int enableUncore(PerfGroup *const group) const;
+	// Returns the key of a counter computed by gatord, or -1 if it is not enabled
+	int getEnabledKey(const char *const name) const;
 
 	static long long getTracepointId(const char *const name, DynBuf *const printb);
 
 private:
 	PerfCounter *findCounter(const Counter &counter) const;
-	void addCpuCounters(const char *const counterName, const int type, const int numCounters);
+	// pmu is the name of the PMU in PERF_DEVICES or NULL if the counters are raw events
+	void addCpuCounters(const char *const counterName, const int type, const int numCounters, const int cpuId, const char *const pmu);
+	// The cpus with cpuId according to /proc/cpuinfo
+	static void getCpus(const int cpuId, cpu_set_t *const cpus);
 	void addUncoreCounters(const char *const counterName, const int type, const int numCounters);
+	void addPmuCounters(const char *const pmu);
 
 	PerfCounter *mCounters;
+	// PMUs found by addPmuCounters, their events are advertised by writeEvents
+	char mPmus[16][64];
+	int mPmuCount;
 	bool mIsSetup;
 	bool mLegacySupport;
+	bool mBlockIo;
 
 	// Intentionally undefined
 	PerfDriver(const PerfDriver &);
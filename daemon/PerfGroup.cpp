@@ -30,10 +30,8 @@
 	pea.read_format = PERF_FORMAT_ID | PERF_FORMAT_GROUP; \
 	/* start out disabled */ \
 	pea.disabled = 1; \
-	/* have a sampling interrupt happen when we cross the wakeup_watermark boundary */ \
-	pea.watermark = 1; \
-	/* Be conservative in flush size as only one buffer set is monitored */ \
-	pea.wakeup_watermark = 3 * BUF_SIZE / 4
+	/* have a sampling interrupt happen when we cross the wakeup_watermark boundary, which is set per CPU in prepareCPU */ \
+	pea.watermark = 1
 
 static int sys_perf_event_open(struct perf_event_attr *const attr, const pid_t pid, const int cpu, const int group_fd, const unsigned long flags) {
 	return syscall(__NR_perf_event_open, attr, pid, cpu, group_fd, flags);
@@ -41,9 +39,12 @@ static int sys_perf_event_open(struct perf_event_attr *const attr, const pid_t p
 
 PerfGroup::PerfGroup(PerfBuffer *const pb) : mPb(pb) {
 	memset(&mAttrs, 0, sizeof(mAttrs));
-	memset(&mPerCpu, 0, sizeof(mPerCpu));
+	memset(&mCpus, 0, sizeof(mCpus));
 	memset(&mKeys, -1, sizeof(mKeys));
+	memset(&mLeaders, 0, sizeof(mLeaders));
 	memset(&mFds, -1, sizeof(mFds));
+	memset(&mIds, 0, sizeof(mIds));
+	memset(&mValues, 0, sizeof(mValues));
 }
 
 PerfGroup::~PerfGroup() {
@@ -54,7 +55,7 @@ PerfGroup::~PerfGroup() {
 	}
 }
 
-bool PerfGroup::add(Buffer *const buffer, const int key, const __u32 type, const __u64 config, const __u64 sample, const __u64 sampleType, const int flags) {
+bool PerfGroup::add(Buffer *const buffer, const int key, const __u32 type, const __u64 config, const __u64 sample, const __u64 sampleType, const int flags, const cpu_set_t *const cpus) {
 	int i;
 	for (i = 0; i < ARRAY_LENGTH(mKeys); ++i) {
 		if (mKeys[i] < 0) {
@@ -67,22 +68,47 @@ bool PerfGroup::add(Buffer *const buffer, const int key, const __u32 type, const
 		return false;
 	}
 
+	// PMUs like the ARM PMU reject groups with events of other PMUs, so each uncore PMU leads its own group
+	mLeaders[i] = 0;
+	if (flags & PERF_GROUP_LEADER) {
+		mLeaders[i] = i;
+	} else {
+		for (int j = i - 1; j > 0; --j) {
+			if (mLeaders[j] == j && mAttrs[j].type == type) {
+				mLeaders[i] = j;
+				break;
+			}
+		}
+	}
+
 	DEFAULT_PEA_ARGS(mAttrs[i], sampleType);
 	mAttrs[i].type = type;
 	mAttrs[i].config = config;
 	mAttrs[i].sample_period = sample;
 	// always be on the CPU but only a group leader can be pinned
-	mAttrs[i].pinned = (i == 0 ? 1 : 0);
+	mAttrs[i].pinned = (mLeaders[i] == i ? 1 : 0);
 	mAttrs[i].mmap = (flags & PERF_GROUP_MMAP ? 1 : 0);
 	mAttrs[i].comm = (flags & PERF_GROUP_COMM ? 1 : 0);
 	mAttrs[i].freq = (flags & PERF_GROUP_FREQ ? 1 : 0);
 	mAttrs[i].task = (flags & PERF_GROUP_TASK ? 1 : 0);
 	mAttrs[i].sample_id_all = (flags & PERF_GROUP_SAMPLE_ID_ALL ? 1 : 0);
-	mPerCpu[i] = (flags & PERF_GROUP_PER_CPU);
+	if (cpus != NULL) {
+		mCpus[i] = *cpus;
+	} else {
+		CPU_ZERO(&mCpus[i]);
+		for (int cpu = 0; cpu < NR_CPUS; ++cpu) {
+			if ((flags & PERF_GROUP_PER_CPU) || cpu == 0) {
+				CPU_SET(cpu, &mCpus[i]);
+			}
+		}
+	}
 
 	mKeys[i] = key;
 
-	buffer->pea(&mAttrs[i], key);
+	// Groups that are consumed by gatord are not described to Streamline
+	if (buffer != NULL) {
+		buffer->pea(&mAttrs[i], key);
+	}
 
 	return true;
 }
@@ -95,7 +121,7 @@ bool PerfGroup::prepareCPU(const int cpu) {
 			continue;
 		}
 
-		if ((cpu != 0) && !mPerCpu[i]) {
+		if (!CPU_ISSET(cpu, &mCpus[i])) {
 			continue;
 		}
 
@@ -105,14 +131,27 @@ bool PerfGroup::prepareCPU(const int cpu) {
 			return false;
 		}
 
+		const bool isLeader = mLeaders[i] == i;
+		const int leaderFd = mFds[cpu + mLeaders[i] * gSessionData->mCores];
+		if (!isLeader && leaderFd < 0) {
+			logg->logMessage("%s(%s:%i): The group leader is not open on cpu %i", __FUNCTION__, __FILE__, __LINE__, cpu);
+			continue;
+		}
+
 		logg->logMessage("%s(%s:%i): perf_event_open cpu: %i type: %lli config: %lli sample: %lli sample_type: 0x%llx pinned: %i mmap: %i comm: %i freq: %i task: %i sample_id_all: %i", __FUNCTION__, __FILE__, __LINE__, cpu, (long long)mAttrs[i].type, (long long)mAttrs[i].config, (long long)mAttrs[i].sample_period, (long long)mAttrs[i].sample_type, mAttrs[i].pinned, mAttrs[i].mmap, mAttrs[i].comm, mAttrs[i].freq, mAttrs[i].task, mAttrs[i].sample_id_all);
-		mFds[cpu + offset] = sys_perf_event_open(&mAttrs[i], -1, cpu, i == 0 ? -1 : mFds[cpu], i == 0 ? 0 : PERF_FLAG_FD_OUTPUT);
+		// prepareCPU is called in parallel so use a copy of the attributes
+		struct perf_event_attr attr = mAttrs[i];
+		if (mPb != NULL) {
+			// Be conservative in flush size as only one buffer set is monitored
+			attr.wakeup_watermark = 3 * mPb->getRingSize(cpu) / 4;
+		}
+		mFds[cpu + offset] = sys_perf_event_open(&attr, -1, cpu, isLeader ? -1 : leaderFd, isLeader || mPb == NULL ? 0 : PERF_FLAG_FD_OUTPUT);
 		if (mFds[cpu + offset] < 0) {
 			logg->logMessage("%s(%s:%i): failed %s", __FUNCTION__, __FILE__, __LINE__, strerror(errno));
 			continue;
 		}
 
-		if (!mPb->useFd(cpu, mFds[cpu + offset], mFds[cpu])) {
+		if (mPb != NULL && !mPb->useFd(cpu, mFds[cpu + offset], mFds[cpu])) {
 			logg->logMessage("%s(%s:%i): PerfBuffer::useFd failed", __FUNCTION__, __FILE__, __LINE__);
 			return false;
 		}
@@ -139,6 +178,9 @@ int PerfGroup::onlineCPU(const int cpu, const bool start, Buffer *const buffer,
 			logg->logMessage("%s(%s:%i): ioctl failed", __FUNCTION__, __FILE__, __LINE__);
 			return false;
 		}
+		if (!gSessionData->perf.getLegacySupport()) {
+			mIds[cpu + i * gSessionData->mCores] = ids[idCount];
+		}
 		++idCount;
 	}
 
@@ -147,7 +189,9 @@ int PerfGroup::onlineCPU(const int cpu, const bool start, Buffer *const buffer,
 		return false;
 	}
 
-	if (!gSessionData->perf.getLegacySupport()) {
+	if (buffer == NULL) {
+		// Groups that are consumed by gatord don't need the keys
+	} else if (!gSessionData->perf.getLegacySupport()) {
 		buffer->keys(idCount, ids, coreKeys);
 	} else {
 		char buf[1024];
@@ -184,7 +228,9 @@ bool PerfGroup::offlineCPU(const int cpu) {
 	}
 
 	// Mark the buffer so that it will be released next time it's read
-	mPb->discard(cpu);
+	if (mPb != NULL) {
+		mPb->discard(cpu);
+	}
 
 	for (int i = 0; i < ARRAY_LENGTH(mKeys); ++i) {
 		if (mKeys[i] < 0) {
@@ -195,6 +241,7 @@ bool PerfGroup::offlineCPU(const int cpu) {
 		if (mFds[offset] >= 0) {
 			close(mFds[offset]);
 			mFds[offset] = -1;
+			mValues[offset] = 0;
 		}
 	}
 
@@ -217,6 +264,58 @@ bool PerfGroup::start() {
 	return false;
 }
 
+bool PerfGroup::getSampleType(const __u64 id, __u64 *const sampleType) const {
+	for (int i = 0; i < ARRAY_LENGTH(mKeys); ++i) {
+		if (mKeys[i] < 0) {
+			continue;
+		}
+		for (int cpu = 0; cpu < gSessionData->mCores; ++cpu) {
+			if (mIds[cpu + i * gSessionData->mCores] == id) {
+				*sampleType = mAttrs[i].sample_type;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+bool PerfGroup::readGroups(void (*handler)(void *arg, const int key, const __s64 delta), void *arg) {
+	for (int leader = 0; leader < ARRAY_LENGTH(mKeys); ++leader) {
+		if (mKeys[leader] < 0 || mLeaders[leader] != leader) {
+			continue;
+		}
+		for (int cpu = 0; cpu < gSessionData->mCores; ++cpu) {
+			const int leaderFd = mFds[cpu + leader * gSessionData->mCores];
+			if (leaderFd < 0) {
+				continue;
+			}
+
+			// With PERF_FORMAT_GROUP | PERF_FORMAT_ID the values are nr then a value and id for each event, in the order the events joined the group
+			__u64 values[1 + 2 * ARRAY_LENGTH(mKeys)];
+			const ssize_t bytes = read(leaderFd, values, sizeof(values));
+			if (bytes < (ssize_t)sizeof(values[0]) || bytes < (ssize_t)((1 + 2 * values[0]) * sizeof(values[0]))) {
+				logg->logMessage("%s(%s:%i): read failed", __FUNCTION__, __FILE__, __LINE__);
+				return false;
+			}
+
+			__u64 pos = 0;
+			for (int i = leader; i < ARRAY_LENGTH(mKeys) && pos < values[0]; ++i) {
+				const int offset = cpu + i * gSessionData->mCores;
+				if (mKeys[i] < 0 || mLeaders[i] != leader || mFds[offset] < 0) {
+					continue;
+				}
+				const __u64 value = values[1 + 2 * pos];
+				handler(arg, mKeys[i], value - mValues[offset]);
+				mValues[offset] = value;
+				++pos;
+			}
+		}
+	}
+
+	return true;
+}
+
 void PerfGroup::stop() {
 	for (int pos = ARRAY_LENGTH(mFds) - 1; pos >= 0; --pos) {
 		if (mFds[pos] >= 0) {
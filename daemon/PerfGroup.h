@@ -9,6 +9,8 @@
 #ifndef PERF_GROUP
 #define PERF_GROUP
 
+#include <sched.h>
+
 // Use a snapshot of perf_event.h as it may be more recent than what is on the target and if not newer features won't be supported anyways
 #include "k/perf_event.h"
 
@@ -25,14 +27,18 @@ enum PerfGroupFlags {
 	PERF_GROUP_TASK          = 1 << 3,
 	PERF_GROUP_SAMPLE_ID_ALL = 1 << 4,
 	PERF_GROUP_PER_CPU       = 1 << 5,
+	// The event leads a group of its own that the events of the same type added after it join, other events join the group of the first event
+	PERF_GROUP_LEADER        = 1 << 6,
 };
 
 class PerfGroup {
 public:
+	// Without a PerfBuffer the events are only counted and their values are read with readGroups
 	PerfGroup(PerfBuffer *const pb);
 	~PerfGroup();
 
-	bool add(Buffer *const buffer, const int key, const __u32 type, const __u64 config, const __u64 sample, const __u64 sampleType, const int flags);
+	// cpus restricts the event to those cpus, otherwise it is opened on every cpu if flags has PERF_GROUP_PER_CPU or only on cpu 0
+	bool add(Buffer *const buffer, const int key, const __u32 type, const __u64 config, const __u64 sample, const __u64 sampleType, const int flags, const cpu_set_t *const cpus);
 	// Safe to call concurrently
 	bool prepareCPU(const int cpu);
 	// Not safe to call concurrently. Returns the number of events enabled
@@ -40,13 +46,21 @@ public:
 	bool offlineCPU(int cpu);
 	bool start();
 	void stop();
+	// Finds the sample_type of the event with the id from PERF_EVENT_IOC_ID, safe to call from another thread
+	bool getSampleType(const __u64 id, __u64 *const sampleType) const;
+	// Reads the groups on every cpu and calls handler with the key of each event and how much it counted since the last read
+	bool readGroups(void (*handler)(void *arg, const int key, const __s64 delta), void *arg);
 
 private:
 	// +1 for the group leader
 	struct perf_event_attr mAttrs[MAX_PERFORMANCE_COUNTERS + 1];
-	bool mPerCpu[MAX_PERFORMANCE_COUNTERS + 1];
+	cpu_set_t mCpus[MAX_PERFORMANCE_COUNTERS + 1];
 	int mKeys[MAX_PERFORMANCE_COUNTERS + 1];
+	// The index of the leader of each event's group
+	int mLeaders[MAX_PERFORMANCE_COUNTERS + 1];
 	int mFds[NR_CPUS * (MAX_PERFORMANCE_COUNTERS + 1)];
+	__u64 mIds[NR_CPUS * (MAX_PERFORMANCE_COUNTERS + 1)];
+	__u64 mValues[NR_CPUS * (MAX_PERFORMANCE_COUNTERS + 1)];
 	PerfBuffer *const mPb;
 
 	// Intentionally undefined
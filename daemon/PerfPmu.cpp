@@ -0,0 +1,166 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "PerfPmu.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Config.h"
+#include "DriverSource.h"
+#include "DynBuf.h"
+#include "Logging.h"
+#include "ThreadPlacement.h"
+
+bool PerfPmu::isSpecial(const char *const pmu) {
+	static const char *const SPECIAL[] = {
+		"breakpoint",
+		"kprobe",
+		"software",
+		"tracepoint",
+		"uprobe",
+	};
+
+	for (int i = 0; i < ARRAY_LENGTH(SPECIAL); ++i) {
+		if (strcmp(pmu, SPECIAL[i]) == 0) {
+			return true;
+		}
+	}
+	return pmu[0] == '.';
+}
+
+bool PerfPmu::readCpus(const char *const path, cpu_set_t *const cpus) {
+	DynBuf b;
+	if (access(path, R_OK) != 0 || !b.read(path)) {
+		return false;
+	}
+
+	// Remove the trailing newline
+	char *const buf = b.getBuf();
+	buf[strcspn(buf, "\n")] = '\0';
+	return ThreadPlacement::parseCpus(buf, cpus);
+}
+
+bool PerfPmu::read(const char *const pmu, int *const type, cpu_set_t *const cpus, bool *const uncore) {
+	char buf[256];
+	snprintf(buf, sizeof(buf), PERF_DEVICES "/%s/type", pmu);
+	if (DriverSource::readIntDriver(buf, type) != 0) {
+		return false;
+	}
+
+	snprintf(buf, sizeof(buf), PERF_DEVICES "/%s/cpumask", pmu);
+	*uncore = readCpus(buf, cpus);
+	if (*uncore) {
+		return true;
+	}
+
+	snprintf(buf, sizeof(buf), PERF_DEVICES "/%s/cpus", pmu);
+	if (!readCpus(buf, cpus)) {
+		CPU_ZERO(cpus);
+		for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+			CPU_SET(cpu, cpus);
+		}
+	}
+
+	return true;
+}
+
+bool PerfPmu::getConfig(const char *const pmu, const char *const event, uint64_t *const config) {
+	*config = 0;
+
+	char buf[256];
+	DynBuf format;
+	const char *term = event;
+	while (*term != '\0' && *term != '\n') {
+		const int length = strcspn(term, "=,\n");
+		if (length <= 0 || length >= 64) {
+			return false;
+		}
+		char name[64];
+		memcpy(name, term, length);
+		name[length] = '\0';
+
+		// A term without a value is a flag
+		uint64_t value = 1;
+		const char *next = term + length;
+		if (*next == '=') {
+			char *end;
+			value = strtoull(next + 1, &end, 0);
+			if (end == next + 1) {
+				// Like 'event=?', the user must provide the value
+				return false;
+			}
+			next = end;
+		}
+
+		// The format is like 'config:0-7' or 'config:0-7,32-35'
+		snprintf(buf, sizeof(buf), PERF_DEVICES "/%s/format/%s", pmu, name);
+		if (!format.read(buf) || strncmp(format.getBuf(), "config:", strlen("config:")) != 0) {
+			return false;
+		}
+		const char *range = format.getBuf() + strlen("config:");
+		int shift = 0;
+		while (*range >= '0' && *range <= '9') {
+			char *end;
+			const int first = strtol(range, &end, 10);
+			int last = first;
+			if (*end == '-') {
+				last = strtol(end + 1, &end, 10);
+			}
+			if (first < 0 || last < first || last > 63) {
+				return false;
+			}
+			const int bits = last - first + 1;
+			const uint64_t mask = bits == 64 ? ~0ULL : (1ULL << bits) - 1;
+			*config |= ((value >> shift) & mask) << first;
+			shift += bits;
+			range = *end == ',' ? end + 1 : end;
+		}
+
+		if (*next == ',') {
+			++next;
+		}
+		term = next;
+	}
+
+	return true;
+}
+
+int PerfPmu::readEvents(const char *const pmu, void (*handler)(void *arg, const char *const pmu, const char *const event, const uint64_t config), void *arg) {
+	char buf[256];
+	snprintf(buf, sizeof(buf), PERF_DEVICES "/%s/events", pmu);
+	DIR *dir = opendir(buf);
+	if (dir == NULL) {
+		return 0;
+	}
+
+	int count = 0;
+	DynBuf b;
+	struct dirent *dirent;
+	while ((dirent = readdir(dir)) != NULL) {
+		// Skip the . and .. entries and the .scale, .unit and similar attributes of other events
+		if (strchr(dirent->d_name, '.') != NULL) {
+			continue;
+		}
+
+		uint64_t config;
+		if (snprintf(buf, sizeof(buf), PERF_DEVICES "/%s/events/%s", pmu, dirent->d_name) >= (int)sizeof(buf) || !b.read(buf) || !getConfig(pmu, b.getBuf(), &config)) {
+			logg->logMessage("%s(%s:%i): Unsupported event %s/%s", __FUNCTION__, __FILE__, __LINE__, pmu, dirent->d_name);
+			continue;
+		}
+
+		handler(arg, pmu, dirent->d_name, config);
+		++count;
+	}
+	closedir(dir);
+
+	return count;
+}
@@ -0,0 +1,37 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef PERFPMU_H
+#define PERFPMU_H
+
+#include <sched.h>
+#include <stdint.h>
+
+#define PERF_DEVICES "/sys/bus/event_source/devices"
+
+// Reads the description of a PMU in PERF_DEVICES
+class PerfPmu {
+public:
+	// PMUs that are not counters, like software and tracepoint
+	static bool isSpecial(const char *const pmu);
+	// Reads the type and the cpus to open the PMU's events on. Uncore PMUs have a cpumask with one cpu per instance, core PMUs of
+	// heterogeneous systems list their cpus in cpus, otherwise the PMU counts on every cpu
+	static bool read(const char *const pmu, int *const type, cpu_set_t *const cpus, bool *const uncore);
+	// Builds the config of an event like 'event=0x11,umask=0x2' using the PMU's format directory. Events that need config1, config2 or a parameter are not supported
+	static bool getConfig(const char *const pmu, const char *const event, uint64_t *const config);
+	// Calls handler with each event in the PMU's events directory that has a config, returns the number of events
+	static int readEvents(const char *const pmu, void (*handler)(void *arg, const char *const pmu, const char *const event, const uint64_t config), void *arg);
+	// Reads a cpu list like 0,2-3 from a sysfs file
+	static bool readCpus(const char *const path, cpu_set_t *const cpus);
+
+private:
+	// Intentionally unimplemented
+	PerfPmu();
+};
+
+#endif // PERFPMU_H
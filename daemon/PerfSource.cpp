@@ -10,6 +10,7 @@
 
 #include <errno.h>
 #include <string.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
 
 #include "Child.h"
@@ -37,7 +38,7 @@ static bool sendTracepointFormat(Buffer *const buffer, const char *const name, D
 	return true;
 }
 
-PerfSource::PerfSource(sem_t *senderSem, sem_t *startProfile) : mSummary(0, FRAME_SUMMARY, 1024, senderSem), mBuffer(0, FRAME_PERF_ATTRS, 4*1024*1024, senderSem), mCountersBuf(), mCountersGroup(&mCountersBuf), mMonitor(), mUEvent(), mSenderSem(senderSem), mStartProfile(startProfile), mInterruptFd(-1), mIsDone(false) {
+PerfSource::PerfSource(sem_t *senderSem, sem_t *startProfile) : mSummary(0, FRAME_SUMMARY, 1024, senderSem), mBuffer(0, FRAME_PERF_ATTRS, 4*1024*1024, senderSem), mCountersBuf(), mCountersGroup(&mCountersBuf), mLazyMaps(senderSem), mAnalytics(senderSem), mSchedLatency(), mBlockIo(), mProcStats(), mCpuPower(), mUncore(), mMonitor(), mUEvent(), mSenderSem(senderSem), mStartProfile(startProfile), mInterruptFd(-1), mLiveTimerFd(-1), mIsDone(false) {
 	long l = sysconf(_SC_PAGE_SIZE);
 	if (l < 0) {
 		logg->logError(__FILE__, __LINE__, "Unable to obtain the page size");
@@ -86,10 +87,10 @@ bool PerfSource::prepare() {
 			|| !sendTracepointFormat(&mBuffer, SCHED_SWITCH, &printb, &b1)
 
 			// Only want RAW but not IP on sched_switch and don't want TID on SAMPLE_ID
-			|| !mCountersGroup.add(&mBuffer, 100/**/, PERF_TYPE_TRACEPOINT, schedSwitchId, 1, PERF_SAMPLE_RAW, PERF_GROUP_MMAP | PERF_GROUP_COMM | PERF_GROUP_TASK | PERF_GROUP_SAMPLE_ID_ALL | PERF_GROUP_PER_CPU)
+			|| !mCountersGroup.add(&mBuffer, 100/**/, PERF_TYPE_TRACEPOINT, schedSwitchId, 1, PERF_SAMPLE_RAW, PERF_GROUP_MMAP | PERF_GROUP_COMM | PERF_GROUP_TASK | PERF_GROUP_SAMPLE_ID_ALL | PERF_GROUP_PER_CPU, NULL)
 
 			// Only want TID and IP but not RAW on timer
-			|| (gSessionData->mSampleRate > 0 && !gSessionData->mIsEBS && !mCountersGroup.add(&mBuffer, 99/**/, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_CLOCK, 1000000000UL / gSessionData->mSampleRate, PERF_SAMPLE_TID | PERF_SAMPLE_IP, PERF_GROUP_PER_CPU))
+			|| (gSessionData->mSampleRate > 0 && !gSessionData->mIsEBS && !mCountersGroup.add(&mBuffer, 99/**/, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_CLOCK, 1000000000UL / gSessionData->mSampleRate, PERF_SAMPLE_TID | PERF_SAMPLE_IP, PERF_GROUP_PER_CPU, NULL))
 
 			|| !gSessionData->perf.enable(&mCountersGroup, &mBuffer)
 			|| 0) {
@@ -131,13 +132,32 @@ bool PerfSource::prepare() {
 		return false;
 	}
 
+	// Analytics are optional, perf mode works without them
+	mSchedLatency.init(&mAnalytics);
+	mBlockIo.init(&mAnalytics);
+	mProcStats.init(&mAnalytics);
+	mCpuPower.init(&mAnalytics);
+	mUncore.init(&mAnalytics);
+	if (mAnalytics.isEnabled() && !mAnalytics.prepare(&mMonitor)) {
+		logg->logMessage("%s(%s:%i): PerfAnalytics::prepare failed", __FUNCTION__, __FILE__, __LINE__);
+		return false;
+	}
+
+	// b1 still holds the sched_switch format
+	if (!mLazyMaps.start(&mCountersGroup, schedSwitchId, b1.getBuf())) {
+		logg->logMessage("%s(%s:%i): LazyMaps::start failed", __FUNCTION__, __FILE__, __LINE__);
+		return false;
+	}
+	mCountersBuf.setObserver(LazyMaps::observe, &mLazyMaps);
+
 	// Start events before reading proc to avoid race conditions
-	if (!mCountersGroup.start()) {
+	if (!mCountersGroup.start() || (mAnalytics.isEnabled() && !mAnalytics.start())) {
 		logg->logMessage("%s(%s:%i): PerfGroup::start failed", __FUNCTION__, __FILE__, __LINE__);
 		return false;
 	}
 
-	if (!readProc(&mBuffer, true, &printb, &b1, &b2, &b3)) {
+	// Only send the comms now, the maps are sent by mLazyMaps once a process is seen in the perf data
+	if (!readProc(&mBuffer, false, &printb, &b1, &b2, &b3)) {
 		logg->logMessage("%s(%s:%i): readProc failed", __FUNCTION__, __FILE__, __LINE__);
 		return false;
 	}
@@ -166,50 +186,104 @@ void PerfSource::run() {
 	int timeout = -1;
 	if (gSessionData->mLiveRate > 0) {
 		timeout = gSessionData->mLiveRate/MS_PER_US;
+	} else if (mAnalytics.isEnabled()) {
+		// Wake up every window even without samples so that counters read from /proc are sent
+		timeout = mAnalytics.getInterval()/MS_PER_US;
 	}
 
 	sem_post(mStartProfile);
 
 	while (gSessionData->mSessionIsActive) {
-		// +1 for uevents, +1 for pipe
-		struct epoll_event events[NR_CPUS + 2];
-		int ready = mMonitor.wait(events, ARRAY_LENGTH(events), timeout);
-		if (ready < 0) {
-			logg->logError(__FILE__, __LINE__, "Monitor::wait failed");
-			handleException();
-		}
+		process(timeout);
+	}
+
+	stop();
+
+	mInterruptFd = -1;
+	close(pipefd[0]);
+	close(pipefd[1]);
+}
 
-		for (int i = 0; i < ready; ++i) {
-			if (events[i].data.fd == mUEvent.getFd()) {
-				if (!handleUEvent()) {
-					logg->logError(__FILE__, __LINE__, "PerfSource::handleUEvent failed");
-					handleException();
-				}
-				break;
+void PerfSource::process(const int timeout) {
+	// +1 for uevents, +1 for pipe, +1 for the live timer
+	struct epoll_event events[NR_CPUS + 3];
+	int ready = mMonitor.wait(events, ARRAY_LENGTH(events), timeout);
+	if (ready < 0) {
+		logg->logError(__FILE__, __LINE__, "Monitor::wait failed");
+		handleException();
+	}
+
+	for (int i = 0; i < ready; ++i) {
+		if (events[i].data.fd == mUEvent.getFd()) {
+			if (!handleUEvent()) {
+				logg->logError(__FILE__, __LINE__, "PerfSource::handleUEvent failed");
+				handleException();
+			}
+			break;
+		} else if (events[i].data.fd == mLiveTimerFd) {
+			uint64_t expirations;
+			if (read(mLiveTimerFd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+				logg->logMessage("%s(%s:%i): read of timerfd failed", __FUNCTION__, __FILE__, __LINE__);
 			}
 		}
+	}
 
-		// send a notification that data is ready
-		sem_post(mSenderSem);
+	mAnalytics.process();
 
-		// In one shot mode, stop collection once all the buffers are filled
-		// Assume timeout == 0 in this case
-		if (gSessionData->mOneShot && gSessionData->mSessionIsActive) {
-			logg->logMessage("%s(%s:%i): One shot", __FUNCTION__, __FILE__, __LINE__);
-			child->endSession();
-		}
+	// send a notification that data is ready
+	sem_post(mSenderSem);
+
+	// In one shot mode, stop collection once all the buffers are filled
+	// Assume timeout == 0 in this case
+	if (gSessionData->mOneShot && gSessionData->mSessionIsActive) {
+		logg->logMessage("%s(%s:%i): One shot", __FUNCTION__, __FILE__, __LINE__);
+		child->endSession();
 	}
+}
 
+void PerfSource::stop() {
 	mCountersGroup.stop();
+	mAnalytics.stop();
+	mAnalytics.setDone();
+	mLazyMaps.stop();
 	mBuffer.setDone();
 	mIsDone = true;
 
 	// send a notification that data is ready
 	sem_post(mSenderSem);
+}
 
-	mInterruptFd = -1;
-	close(pipefd[0]);
-	close(pipefd[1]);
+int PerfSource::pollStart() {
+	// Replaces the epoll timeout used by run to send the data at the live rate, or every analytics window
+	const uint64_t interval = gSessionData->mLiveRate > 0 ? gSessionData->mLiveRate : (mAnalytics.isEnabled() ? mAnalytics.getInterval() : 0);
+	if (interval > 0) {
+		mLiveTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+		struct itimerspec spec;
+		spec.it_interval.tv_sec = interval / NS_PER_S;
+		spec.it_interval.tv_nsec = interval % NS_PER_S;
+		spec.it_value = spec.it_interval;
+		if (mLiveTimerFd < 0 || timerfd_settime(mLiveTimerFd, 0, &spec, NULL) != 0 || !mMonitor.add(mLiveTimerFd)) {
+			logg->logError(__FILE__, __LINE__, "Unable to create the live rate timer");
+			handleException();
+		}
+	}
+
+	sem_post(mStartProfile);
+
+	return mMonitor.getFd();
+}
+
+void PerfSource::poll() {
+	process(0);
+}
+
+void PerfSource::pollStop() {
+	stop();
+
+	if (mLiveTimerFd >= 0) {
+		close(mLiveTimerFd);
+		mLiveTimerFd = -1;
+	}
 }
 
 bool PerfSource::handleUEvent() {
@@ -236,8 +310,14 @@ bool PerfSource::handleUEvent() {
 			const bool result = mCountersGroup.prepareCPU(cpu) &&
 				mCountersGroup.onlineCPU(cpu, true, &mBuffer, &mMonitor);
 			mBuffer.commit(1);
+			if (result && mAnalytics.isEnabled() && !mAnalytics.onlineCPU(cpu, &mMonitor)) {
+				logg->logMessage("%s(%s:%i): PerfAnalytics::onlineCPU failed", __FUNCTION__, __FILE__, __LINE__);
+			}
 			return result;
 		} else if (strcmp(result.mAction, "offline") == 0) {
+			if (mAnalytics.isEnabled()) {
+				mAnalytics.offlineCPU(cpu);
+			}
 			return mCountersGroup.offlineCPU(cpu);
 		}
 	}
@@ -257,7 +337,7 @@ void PerfSource::interrupt() {
 }
 
 bool PerfSource::isDone () {
-	return mBuffer.isDone() && mIsDone && mCountersBuf.isEmpty();
+	return mBuffer.isDone() && mLazyMaps.isDone() && mAnalytics.isDone() && mIsDone && mCountersBuf.isEmpty();
 }
 
 void PerfSource::write (Sender *sender) {
@@ -268,6 +348,8 @@ void PerfSource::write (Sender *sender) {
 	if (!mBuffer.isDone()) {
 		mBuffer.write(sender);
 	}
+	mLazyMaps.write(sender);
+	mAnalytics.write(sender);
 	if (!mCountersBuf.send(sender)) {
 		logg->logError(__FILE__, __LINE__, "PerfBuffer::send failed");
 		handleException();
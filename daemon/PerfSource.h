@@ -11,10 +11,17 @@
 
 #include <semaphore.h>
 
+#include "BlockIo.h"
 #include "Buffer.h"
+#include "CpuPower.h"
+#include "LazyMaps.h"
 #include "Monitor.h"
+#include "PerfAnalytics.h"
 #include "PerfBuffer.h"
 #include "PerfGroup.h"
+#include "PerfUncore.h"
+#include "ProcStats.h"
+#include "SchedLatency.h"
 #include "Source.h"
 #include "UEvent.h"
 
@@ -32,18 +39,32 @@ public:
 	bool isDone();
 	void write(Sender *sender);
 
+	int pollStart();
+	void poll();
+	void pollStop();
+
 private:
+	void process(const int timeout);
+	void stop();
 	bool handleUEvent();
 
 	Buffer mSummary;
 	Buffer mBuffer;
 	PerfBuffer mCountersBuf;
 	PerfGroup mCountersGroup;
+	LazyMaps mLazyMaps;
+	PerfAnalytics mAnalytics;
+	SchedLatency mSchedLatency;
+	BlockIo mBlockIo;
+	ProcStats mProcStats;
+	CpuPower mCpuPower;
+	PerfUncore mUncore;
 	Monitor mMonitor;
 	UEvent mUEvent;
 	sem_t *const mSenderSem;
 	sem_t *const mStartProfile;
 	int mInterruptFd;
+	int mLiveTimerFd;
 	bool mIsDone;
 
 	// Intentionally undefined
@@ -0,0 +1,78 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "PerfUncore.h"
+
+#include "Logging.h"
+#include "SessionData.h"
+
+PerfUncore::PerfUncore() : mGroup(NULL), mKeyCount(0) {
+}
+
+bool PerfUncore::init(PerfAnalytics *const analytics) {
+	if (gSessionData->perf.enableUncore(&mGroup) <= 0) {
+		return false;
+	}
+
+	for (int cpu = 0; cpu < gSessionData->mCores; ++cpu) {
+		if (!mGroup.prepareCPU(cpu)) {
+			logg->logMessage("%s(%s:%i): PerfGroup::prepareCPU failed", __FUNCTION__, __FILE__, __LINE__);
+			return false;
+		}
+	}
+
+	// The counters start from zero so the first flush sends what was counted since now
+	if (!mGroup.start()) {
+		logg->logMessage("%s(%s:%i): PerfGroup::start failed", __FUNCTION__, __FILE__, __LINE__);
+		return false;
+	}
+
+	return analytics->addAnalyzer(this);
+}
+
+void PerfUncore::addDelta(void *arg, const int key, const __s64 delta) {
+	PerfUncore *const uncore = static_cast<PerfUncore *>(arg);
+	int i;
+	for (i = 0; i < uncore->mKeyCount; ++i) {
+		if (uncore->mKeys[i] == key) {
+			break;
+		}
+	}
+	if (i == uncore->mKeyCount) {
+		if (i >= ARRAY_LENGTH(uncore->mKeys)) {
+			return;
+		}
+		uncore->mKeys[i] = key;
+		uncore->mDeltas[i] = 0;
+		++uncore->mKeyCount;
+	}
+	uncore->mDeltas[i] += delta;
+}
+
+void PerfUncore::flush(Buffer *const buffer) {
+	mKeyCount = 0;
+	if (!mGroup.readGroups(addDelta, this)) {
+		logg->logMessage("%s(%s:%i): PerfGroup::readGroups failed", __FUNCTION__, __FILE__, __LINE__);
+	}
+
+	bool systemWide = false;
+	for (int i = 0; i < mKeyCount; ++i) {
+		if (mDeltas[i] == 0) {
+			continue;
+		}
+		// As in ProcStats, tid -1 marks the values as system wide
+		if (!systemWide) {
+			buffer->eventTid(-1);
+			systemWide = true;
+		}
+		buffer->event64(mKeys[i], mDeltas[i]);
+	}
+	if (systemWide) {
+		buffer->eventTid(0);
+	}
+}
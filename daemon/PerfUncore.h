@@ -0,0 +1,43 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef PERFUNCORE_H
+#define PERFUNCORE_H
+
+#include <stdint.h>
+
+#include "Config.h"
+#include "PerfAnalytics.h"
+#include "PerfGroup.h"
+
+// Uncore PMU counters, like those of a CCI. Each uncore PMU is a group of its own as PMUs reject groups that span PMUs, and as uncore PMUs can't sample
+// the groups are read once per window and sent as block counters rather than with the sched_switch samples
+class PerfUncore : public PerfAnalyzer {
+public:
+	PerfUncore();
+
+	// Opens and starts the counters, returns false if none of the counters are enabled
+	bool init(PerfAnalytics *const analytics);
+
+	void flush(Buffer *const buffer);
+
+private:
+	static void addDelta(void *arg, const int key, const __s64 delta);
+
+	PerfGroup mGroup;
+	// The sum of each key over the instances of its PMU during a flush
+	int mKeys[MAX_PERFORMANCE_COUNTERS + 1];
+	int64_t mDeltas[MAX_PERFORMANCE_COUNTERS + 1];
+	int mKeyCount;
+
+	// Intentionally unimplemented
+	PerfUncore(const PerfUncore &);
+	PerfUncore &operator=(const PerfUncore &);
+};
+
+#endif // PERFUNCORE_H
@@ -0,0 +1,144 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "ProcStats.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "Buffer.h"
+#include "Logging.h"
+#include "SessionData.h"
+
+const char *const ProcStats::COUNTERS[] = {
+	"Linux_meminfo_memused",
+	"Linux_meminfo_memfree",
+	"Linux_meminfo_bufferram",
+	"Linux_net_rx",
+	"Linux_net_tx",
+};
+
+ProcStats::ProcStats() : mBuf(), mSystemWide(false) {
+	memset(mValues, 0, sizeof(mValues));
+	memset(mSent, 0, sizeof(mSent));
+}
+
+bool ProcStats::init(PerfAnalytics *const analytics) {
+	bool enabled = false;
+	for (int i = 0; i < COUNTER_COUNT; ++i) {
+		mKeys[i] = gSessionData->perf.getEnabledKey(COUNTERS[i]);
+		enabled = enabled || mKeys[i] >= 0;
+	}
+
+	return enabled && analytics->addAnalyzer(this);
+}
+
+int64_t ProcStats::getMeminfo(const char *const meminfo, const char *const name) {
+	// Lines are like 'MemFree:          123456 kB'
+	const int length = strlen(name);
+	for (const char *line = meminfo; line != NULL; line = strchr(line, '\n')) {
+		if (*line == '\n') {
+			++line;
+		}
+		if (strncmp(line, name, length) == 0 && line[length] == ':') {
+			return strtoll(line + length + 1, NULL, 10) * 1024;
+		}
+	}
+
+	return -1;
+}
+
+void ProcStats::write(Buffer *const buffer, const int counter, const int64_t value) {
+	if (mKeys[counter] < 0 || (mSent[counter] && mValues[counter] == value)) {
+		return;
+	}
+	event(buffer, counter, value);
+	mValues[counter] = value;
+	mSent[counter] = true;
+}
+
+void ProcStats::event(Buffer *const buffer, const int counter, const int64_t value) {
+	// As in gator.ko, tid -1 marks the values as system wide rather than belonging to the last thread written
+	if (!mSystemWide) {
+		buffer->eventTid(-1);
+		mSystemWide = true;
+	}
+	buffer->event64(mKeys[counter], value);
+}
+
+void ProcStats::readMeminfo(Buffer *const buffer) {
+	if (!mBuf.read(PROC_MEMINFO)) {
+		return;
+	}
+
+	const int64_t total = getMeminfo(mBuf.getBuf(), "MemTotal");
+	const int64_t free = getMeminfo(mBuf.getBuf(), "MemFree");
+	const int64_t buffers = getMeminfo(mBuf.getBuf(), "Buffers");
+	if (total >= 0 && free >= 0) {
+		write(buffer, MEMUSED, total - free);
+		write(buffer, MEMFREE, free);
+	}
+	if (buffers >= 0) {
+		write(buffer, BUFFERRAM, buffers);
+	}
+}
+
+void ProcStats::readNetDev(Buffer *const buffer) {
+	if (!mBuf.read(PROC_NET_DEV)) {
+		return;
+	}
+
+	// After two header lines, each line is like 'eth0: rx_bytes rx_packets ... tx_bytes tx_packets ...' with 8 receive columns
+	int64_t rx = 0;
+	int64_t tx = 0;
+	const char *line = strchr(mBuf.getBuf(), '\n');
+	if (line != NULL) {
+		line = strchr(line + 1, '\n');
+	}
+	for (; line != NULL; line = strchr(line + 1, '\n')) {
+		const char *const colon = strchr(line, ':');
+		if (colon == NULL) {
+			break;
+		}
+		char *pos = (char *)colon + 1;
+		for (int column = 0; column < 9; ++column) {
+			const int64_t value = strtoll(pos, &pos, 10);
+			if (column == 0) {
+				rx += value;
+			} else if (column == 8) {
+				tx += value;
+			}
+		}
+	}
+
+	// The counters are deltas, the first read only sets the baseline
+	if (mSent[NET_RX] && mKeys[NET_RX] >= 0 && rx != mValues[NET_RX]) {
+		event(buffer, NET_RX, rx - mValues[NET_RX]);
+	}
+	if (mSent[NET_TX] && mKeys[NET_TX] >= 0 && tx != mValues[NET_TX]) {
+		event(buffer, NET_TX, tx - mValues[NET_TX]);
+	}
+	mValues[NET_RX] = rx;
+	mValues[NET_TX] = tx;
+	mSent[NET_RX] = true;
+	mSent[NET_TX] = true;
+}
+
+void ProcStats::flush(Buffer *const buffer) {
+	mSystemWide = false;
+	if (mKeys[MEMUSED] >= 0 || mKeys[MEMFREE] >= 0 || mKeys[BUFFERRAM] >= 0) {
+		readMeminfo(buffer);
+	}
+	if (mKeys[NET_RX] >= 0 || mKeys[NET_TX] >= 0) {
+		readNetDev(buffer);
+	}
+	if (mSystemWide) {
+		// Clear the tid
+		buffer->eventTid(0);
+	}
+}
@@ -0,0 +1,60 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef PROCSTATS_H
+#define PROCSTATS_H
+
+#include <stdint.h>
+
+#include "DynBuf.h"
+#include "PerfAnalytics.h"
+
+#define PROC_MEMINFO "/proc/meminfo"
+#define PROC_NET_DEV "/proc/net/dev"
+
+// System wide memory and network counters read from /proc once per window, there are no tracepoints that give these directly
+class ProcStats : public PerfAnalyzer {
+public:
+	ProcStats();
+
+	// Returns false if none of the counters are enabled
+	bool init(PerfAnalytics *const analytics);
+
+	void flush(Buffer *const buffer);
+
+private:
+	enum {
+		MEMUSED,
+		MEMFREE,
+		BUFFERRAM,
+		NET_RX,
+		NET_TX,
+		COUNTER_COUNT,
+	};
+
+	static const char *const COUNTERS[];
+
+	static int64_t getMeminfo(const char *const meminfo, const char *const name);
+	void readMeminfo(Buffer *const buffer);
+	void readNetDev(Buffer *const buffer);
+	void write(Buffer *const buffer, const int counter, const int64_t value);
+	void event(Buffer *const buffer, const int counter, const int64_t value);
+
+	DynBuf mBuf;
+	int mKeys[COUNTER_COUNT];
+	int64_t mValues[COUNTER_COUNT];
+	bool mSent[COUNTER_COUNT];
+	// Set once the tid of the system wide values has been written in this flush
+	bool mSystemWide;
+
+	// Intentionally unimplemented
+	ProcStats(const ProcStats &);
+	ProcStats &operator=(const ProcStats &);
+};
+
+#endif // PROCSTATS_H
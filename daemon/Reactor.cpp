@@ -0,0 +1,163 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "Reactor.h"
+
+#include <sys/prctl.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "Config.h"
+#include "Logging.h"
+#include "SessionData.h"
+#include "Source.h"
+
+Reactor::Reactor() : mMonitor(), mEntryCount(0) {
+	mInterruptFds[0] = -1;
+	mInterruptFds[1] = -1;
+}
+
+Reactor::~Reactor() {
+	for (int i = 0; i < mEntryCount; ++i) {
+		if (mEntries[i].isTimer) {
+			close(mEntries[i].fd);
+		}
+	}
+	if (mInterruptFds[0] >= 0) {
+		close(mInterruptFds[0]);
+		close(mInterruptFds[1]);
+	}
+}
+
+bool Reactor::init() {
+	if (!mMonitor.init()) {
+		return false;
+	}
+
+	if (pipe(mInterruptFds) != 0) {
+		logg->logMessage("%s(%s:%i): pipe failed", __FUNCTION__, __FILE__, __LINE__);
+		return false;
+	}
+
+	return mMonitor.add(mInterruptFds[0]);
+}
+
+bool Reactor::addEntry(const int fd, Source *const source, void (*handler)(), const bool isTimer) {
+	if (mEntryCount >= MAX_ENTRIES) {
+		logg->logMessage("%s(%s:%i): Too many reactor entries", __FUNCTION__, __FILE__, __LINE__);
+		return false;
+	}
+
+	if (!mMonitor.add(fd)) {
+		return false;
+	}
+
+	Entry *const entry = &mEntries[mEntryCount++];
+	entry->fd = fd;
+	entry->source = source;
+	entry->handler = handler;
+	entry->isTimer = isTimer;
+
+	return true;
+}
+
+bool Reactor::add(Source *const source) {
+	const int fd = source->pollStart();
+	if (fd < 0) {
+		return false;
+	}
+
+	if (!addEntry(fd, source, NULL, false)) {
+		logg->logError(__FILE__, __LINE__, "Unable to add the source to the reactor");
+		handleException();
+	}
+
+	return true;
+}
+
+bool Reactor::addFd(const int fd, void (*handler)()) {
+	return addEntry(fd, NULL, handler, false);
+}
+
+bool Reactor::addTimer(const uint64_t ns, void (*handler)()) {
+	const int fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+	if (fd < 0) {
+		logg->logMessage("%s(%s:%i): timerfd_create failed", __FUNCTION__, __FILE__, __LINE__);
+		return false;
+	}
+
+	struct itimerspec spec;
+	spec.it_interval.tv_sec = 0;
+	spec.it_interval.tv_nsec = 0;
+	spec.it_value.tv_sec = ns / NS_PER_S;
+	spec.it_value.tv_nsec = ns % NS_PER_S;
+	if (timerfd_settime(fd, 0, &spec, NULL) != 0 || !addEntry(fd, NULL, handler, true)) {
+		logg->logMessage("%s(%s:%i): Unable to start the timer", __FUNCTION__, __FILE__, __LINE__);
+		close(fd);
+		return false;
+	}
+
+	return true;
+}
+
+void Reactor::run() {
+	prctl(PR_SET_NAME, (unsigned long)&"gatord-reactor", 0, 0, 0);
+
+	while (gSessionData->mSessionIsActive) {
+		struct epoll_event events[MAX_ENTRIES + 1];
+		const int ready = mMonitor.wait(events, ARRAY_LENGTH(events), -1);
+		if (ready < 0) {
+			logg->logError(__FILE__, __LINE__, "Monitor::wait failed");
+			handleException();
+		}
+
+		for (int i = 0; i < ready && gSessionData->mSessionIsActive; ++i) {
+			const int fd = events[i].data.fd;
+			if (fd == mInterruptFds[0]) {
+				// Means interrupt has been called and mSessionIsActive should be reread
+				continue;
+			}
+
+			for (int j = 0; j < mEntryCount; ++j) {
+				Entry *const entry = &mEntries[j];
+				if (entry->fd != fd) {
+					continue;
+				}
+				if (entry->source != NULL) {
+					entry->source->poll();
+				} else {
+					if (entry->isTimer) {
+						uint64_t expirations;
+						if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+							break;
+						}
+					}
+					entry->handler();
+				}
+				break;
+			}
+		}
+	}
+
+	for (int i = 0; i < mEntryCount; ++i) {
+		if (mEntries[i].source != NULL) {
+			mEntries[i].source->pollStop();
+		}
+	}
+}
+
+void Reactor::interrupt() {
+	if (mInterruptFds[1] >= 0) {
+		int8_t c = 0;
+		// Write to the pipe to wake the monitor which will cause mSessionIsActive to be reread
+		if (::write(mInterruptFds[1], &c, sizeof(c)) != sizeof(c)) {
+			logg->logError(__FILE__, __LINE__, "write failed");
+			handleException();
+		}
+	}
+}
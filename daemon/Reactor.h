@@ -0,0 +1,60 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <stdint.h>
+
+#include "Monitor.h"
+
+class Source;
+
+// Runs the sources, the capture duration and the Streamline commands from one epoll loop on the calling thread instead of a thread each.
+// Sources that can't be polled, see Source::pollStart, still need their own thread
+class Reactor {
+public:
+	Reactor();
+	~Reactor();
+
+	bool init();
+	// Returns false if the source can't be polled
+	bool add(Source *const source);
+	// handler is called whenever fd is readable
+	bool addFd(const int fd, void (*handler)());
+	// handler is called once, ns from now
+	bool addTimer(const uint64_t ns, void (*handler)());
+
+	// Returns once the session has ended and the sources have been stopped
+	void run();
+	// Wakes run so that mSessionIsActive is reread
+	void interrupt();
+
+private:
+	static const int MAX_ENTRIES = 16;
+
+	struct Entry {
+		int fd;
+		Source *source;
+		void (*handler)();
+		bool isTimer;
+	};
+
+	bool addEntry(const int fd, Source *const source, void (*handler)(), const bool isTimer);
+
+	Monitor mMonitor;
+	Entry mEntries[MAX_ENTRIES];
+	int mEntryCount;
+	int mInterruptFds[2];
+
+	// Intentionally unimplemented
+	Reactor(const Reactor &);
+	Reactor &operator=(const Reactor &);
+};
+
+#endif // REACTOR_H
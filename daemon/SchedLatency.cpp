@@ -0,0 +1,173 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "SchedLatency.h"
+
+#include "Buffer.h"
+#include "Logging.h"
+#include "PerfDriver.h"
+#include "SessionData.h"
+
+#define NS_PER_US 1000ULL
+#define NS_PER_MS 1000000ULL
+// EXIT_ZOMBIE | EXIT_DEAD
+#define EXIT_STATES 0x30
+
+// Buckets are powers of 10 starting at 10us for the run queue and 1ms for off-cpu, the last bucket is everything slower
+const char *const SchedLatency::RUNQ_COUNTERS[] = {
+	"Linux_sched_runq_10us",
+	"Linux_sched_runq_100us",
+	"Linux_sched_runq_1ms",
+	"Linux_sched_runq_10ms",
+	"Linux_sched_runq_slow",
+};
+
+const char *const SchedLatency::OFFCPU_COUNTERS[] = {
+	"Linux_sched_offcpu_1ms",
+	"Linux_sched_offcpu_10ms",
+	"Linux_sched_offcpu_100ms",
+	"Linux_sched_offcpu_1s",
+	"Linux_sched_offcpu_slow",
+};
+
+SchedLatency::SchedLatency() : mThreads(), mSwitch(-1), mExit(-1) {
+}
+
+bool SchedLatency::init(PerfAnalytics *const analytics) {
+	bool enabled = false;
+	for (int i = 0; i < BUCKET_COUNT; ++i) {
+		mRunqKeys[i] = gSessionData->perf.getEnabledKey(RUNQ_COUNTERS[i]);
+		mOffcpuKeys[i] = gSessionData->perf.getEnabledKey(OFFCPU_COUNTERS[i]);
+		enabled = enabled || mRunqKeys[i] >= 0 || mOffcpuKeys[i] >= 0;
+	}
+	if (!enabled) {
+		return false;
+	}
+
+	DynBuf format;
+	// sched_switch is added first so that it leads the group
+	if ((mSwitch = analytics->addTracepoint(SCHED_SWITCH, this, &format)) < 0
+			|| !PerfAnalytics::getField(format.getBuf(), "prev_pid", &mPrevPid.offset, &mPrevPid.size)
+			|| !PerfAnalytics::getField(format.getBuf(), "prev_state", &mPrevState.offset, &mPrevState.size)
+			|| !PerfAnalytics::getField(format.getBuf(), "next_pid", &mNextPid.offset, &mNextPid.size)
+			|| analytics->addTracepoint(SCHED_WAKEUP, this, &format) < 0
+			|| !PerfAnalytics::getField(format.getBuf(), "pid", &mWakeupPid.offset, &mWakeupPid.size)) {
+		logg->logMessage("%s(%s:%i): Unable to add the scheduler tracepoints", __FUNCTION__, __FILE__, __LINE__);
+		return false;
+	}
+
+	// The format of sched_wakeup_new is the same as sched_wakeup, it is optional as it is only needed for the first run of a new thread
+	analytics->addTracepoint(SCHED_WAKEUP_NEW, this, &format);
+
+	// Optional too, without it only the threads whose final switch reports an exit state are forgotten
+	if ((mExit = analytics->addTracepoint(SCHED_PROCESS_EXIT, this, &format)) >= 0
+			&& !PerfAnalytics::getField(format.getBuf(), "pid", &mExitPid.offset, &mExitPid.size)) {
+		mExit = -1;
+	}
+
+	return true;
+}
+
+int SchedLatency::getBucket(const uint64_t delta, const uint64_t first) {
+	uint64_t limit = first;
+	int bucket = 0;
+	while (bucket < BUCKET_COUNT - 1 && delta >= limit) {
+		limit *= 10;
+		++bucket;
+	}
+	return bucket;
+}
+
+void SchedLatency::sample(const int, const uint64_t time, const int tracepoint, const char *const raw, const int size) {
+	if (tracepoint == mExit) {
+		// The thread switches out for the last time after this
+		const int pid = PerfAnalytics::readField(raw, size, mExitPid.offset, mExitPid.size);
+		if (pid != 0) {
+			mThreads.get(pid)->exiting = true;
+		}
+		return;
+	}
+
+	if (tracepoint != mSwitch) {
+		// sched_wakeup or sched_wakeup_new, the thread is now waiting for a cpu
+		const int pid = PerfAnalytics::readField(raw, size, mWakeupPid.offset, mWakeupPid.size);
+		if (pid != 0) {
+			mThreads.get(pid)->wakeTime = time;
+		}
+		return;
+	}
+
+	const int prevPid = PerfAnalytics::readField(raw, size, mPrevPid.offset, mPrevPid.size);
+	const int64_t prevState = PerfAnalytics::readField(raw, size, mPrevState.offset, mPrevState.size);
+	const int nextPid = PerfAnalytics::readField(raw, size, mNextPid.offset, mNextPid.size);
+
+	// The idle task is not interesting
+	if (prevPid != 0) {
+		Thread *const thread = mThreads.get(prevPid);
+		// A preempted thread is TASK_RUNNING possibly or'ed with a TASK_STATE_MAX marker, which is above the low byte.
+		// A thread that has exited never runs again, the exit states have the same bits in all kernel versions
+		if (thread->exiting || (prevState & EXIT_STATES) != 0) {
+			thread->wakeTime = 0;
+			thread->offTime = 0;
+			thread->exiting = false;
+		} else if ((prevState & 0xff) == 0) {
+			thread->wakeTime = time;
+			thread->offTime = 0;
+		} else {
+			thread->offTime = time;
+			thread->wakeTime = 0;
+		}
+	}
+
+	if (nextPid != 0) {
+		Thread *const thread = mThreads.get(nextPid);
+		if (thread->wakeTime != 0 && time >= thread->wakeTime) {
+			++thread->runq[getBucket(time - thread->wakeTime, 10*NS_PER_US)];
+			thread->dirty = true;
+		}
+		// Off-cpu time runs until the thread is runnable again, or until it runs if the wakeup was missed
+		if (thread->offTime != 0) {
+			const uint64_t end = thread->wakeTime != 0 ? thread->wakeTime : time;
+			if (end >= thread->offTime) {
+				++thread->offcpu[getBucket(end - thread->offTime, NS_PER_MS)];
+				thread->dirty = true;
+			}
+		}
+		thread->wakeTime = 0;
+		thread->offTime = 0;
+	}
+}
+
+void SchedLatency::flush(Buffer *const buffer) {
+	for (int i = 0; i < mThreads.getCapacity(); ++i) {
+		if (!mThreads.isUsed(i)) {
+			continue;
+		}
+		Thread *const thread = mThreads.getValue(i);
+		if (thread->dirty) {
+			buffer->eventTid(mThreads.getKey(i));
+			for (int bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+				if (mRunqKeys[bucket] >= 0 && thread->runq[bucket] != 0) {
+					buffer->event64(mRunqKeys[bucket], thread->runq[bucket]);
+				}
+				if (mOffcpuKeys[bucket] >= 0 && thread->offcpu[bucket] != 0) {
+					buffer->event64(mOffcpuKeys[bucket], thread->offcpu[bucket]);
+				}
+				thread->runq[bucket] = 0;
+				thread->offcpu[bucket] = 0;
+			}
+			thread->dirty = false;
+		}
+
+		// Forget threads that are running or have exited, removing may shift another entry into this slot so look at it again
+		if (thread->wakeTime == 0 && thread->offTime == 0 && !thread->exiting) {
+			mThreads.remove(mThreads.getKey(i));
+			--i;
+		}
+	}
+}
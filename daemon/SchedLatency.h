@@ -0,0 +1,64 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef SCHEDLATENCY_H
+#define SCHEDLATENCY_H
+
+#include "HashMap.h"
+#include "PerfAnalytics.h"
+
+// Per thread histograms of the time spent runnable but waiting for a cpu (run queue latency) and of the time spent blocked (off-cpu time)
+class SchedLatency : public PerfAnalyzer {
+public:
+	SchedLatency();
+
+	// Returns false if none of the counters are enabled or the tracepoints are not available
+	bool init(PerfAnalytics *const analytics);
+
+	void sample(const int cpu, const uint64_t time, const int tracepoint, const char *const raw, const int size);
+	void flush(Buffer *const buffer);
+
+	static const char *const RUNQ_COUNTERS[];
+	static const char *const OFFCPU_COUNTERS[];
+	static const int BUCKET_COUNT = 5;
+
+private:
+	struct Field {
+		int offset;
+		int size;
+	};
+
+	struct Thread {
+		uint64_t wakeTime;
+		uint64_t offTime;
+		int64_t runq[BUCKET_COUNT];
+		int64_t offcpu[BUCKET_COUNT];
+		bool dirty;
+		// Set by sched_process_exit until the final switch out of the thread
+		bool exiting;
+	};
+
+	static int getBucket(const uint64_t delta, const uint64_t first);
+
+	HashMap<Thread> mThreads;
+	int mRunqKeys[BUCKET_COUNT];
+	int mOffcpuKeys[BUCKET_COUNT];
+	int mSwitch;
+	int mExit;
+	Field mWakeupPid;
+	Field mPrevPid;
+	Field mPrevState;
+	Field mNextPid;
+	Field mExitPid;
+
+	// Intentionally unimplemented
+	SchedLatency(const SchedLatency &);
+	SchedLatency &operator=(const SchedLatency &);
+};
+
+#endif // SCHEDLATENCY_H
@@ -13,12 +13,19 @@
 #include <unistd.h>
 
 #include "Buffer.h"
+#include "CaptureFile.h"
+#include "CaptureSummary.h"
+#include "LiveFilter.h"
 #include "Logging.h"
 #include "OlySocket.h"
 #include "SessionData.h"
+#include "SpillQueue.h"
 
 Sender::Sender(OlySocket* socket) {
 	mDataFile = NULL;
+	mSummary = NULL;
+	mLiveFilter = NULL;
+	mSpill = NULL;
 	mDataSocket = NULL;
 
 	// Set up the socket connection
@@ -42,20 +49,25 @@ Sender::Sender(OlySocket* socket) {
 
 		gSessionData->mWaitingOnCommand = true;
 		logg->logMessage("Completed magic sequence");
+
+		mDataSocket->setSendOptions(SEND_BUFFER_SIZE);
 	}
 
 	pthread_mutex_init(&mSendMutex, NULL);
 }
 
 Sender::~Sender() {
+	// Sends the queued data
+	delete mSpill;
+	mSpill = NULL;
 	// Just close it as the client socket is on the stack
 	if (mDataSocket != NULL) {
 		mDataSocket->closeSocket();
 		mDataSocket = NULL;
 	}
-	if (mDataFile != NULL) {
-		fclose(mDataFile);
-	}
+	delete mLiveFilter;
+	// Flushes and syncs the data file
+	delete mDataFile;
 }
 
 void Sender::createDataFile(char* apcDir) {
@@ -63,18 +75,64 @@ void Sender::createDataFile(char* apcDir) {
 		return;
 	}
 
-	mDataFileName = (char*)malloc(strlen(apcDir) + 12);
-	sprintf(mDataFileName, "%s/0000000000", apcDir);
-	mDataFile = fopen(mDataFileName, "wb");
-	if (!mDataFile) {
-		logg->logError(__FILE__, __LINE__, "Failed to open binary file: %s", mDataFileName);
+	mDataFile = new CaptureFile(apcDir);
+}
+
+void Sender::createSpillQueue() {
+	if (mDataSocket == NULL) {
+		return;
+	}
+
+	mSpill = new SpillQueue(sendStatic, this, gSessionData->mSpillDir, (int64_t)gSessionData->mSpillLimit * 1024 * 1024);
+}
+
+void Sender::createLiveFilter(int downsample) {
+	mLiveFilter = new LiveFilter(downsample);
+}
+
+void Sender::flush() {
+	if (mSpill != NULL && !mSpill->flush()) {
+		logg->logError(__FILE__, __LINE__, "%s", mSpill->getError());
 		handleException();
 	}
 }
 
-template<typename T>
-inline T min(const T a, const T b) {
-	return (a < b ? a : b);
+bool Sender::sendStatic(void *arg, const char *const data, const int length, const bool more) {
+	return static_cast<Sender *>(arg)->send(data, length, more);
+}
+
+bool Sender::send(const char *const data, const int length, const bool more) {
+	// Wait for the socket with a deadline instead of blocking in send under an alarm, the SpillQueue absorbs short stalls
+	uint64_t lastProgress = getTime();
+	bool stalled = false;
+	int pos = 0;
+	while (pos < length) {
+		const int bytes = mDataSocket->sendNonBlocking(data + pos, length - pos, more);
+		if (bytes < 0) {
+			return false;
+		}
+		if (bytes > 0) {
+			pos += bytes;
+			lastProgress = getTime();
+			if (stalled) {
+				logg->logMessage("The host is reading the data again");
+				stalled = false;
+			}
+			continue;
+		}
+
+		if (!mDataSocket->waitWritable(1000) && !stalled) {
+			logg->logMessage("The host is not reading the data");
+			stalled = true;
+		}
+		if (getTime() - lastProgress > (uint64_t)SEND_TIMEOUT_S * NS_PER_S) {
+			// The caller ends the session, this may be the gatord-live thread which must not raise the error itself
+			logg->logMessage("%s(%s:%i): The host has not read any data for %i seconds", __FUNCTION__, __FILE__, __LINE__, SEND_TIMEOUT_S);
+			return false;
+		}
+	}
+
+	return true;
 }
 
 void Sender::writeData(const char* data, int length, int type) {
@@ -85,50 +143,87 @@ void Sender::writeData(const char* data, int length, int type) {
 	// Multiple threads call writeData()
 	pthread_mutex_lock(&mSendMutex);
 
-	// Send data over the socket connection
-	if (mDataSocket) {
-		// Start alarm
-		const int alarmDuration = 8;
-		alarm(alarmDuration);
+	// Archive the full stream and replace it with the reduced one
+	const bool filtered = mLiveFilter != NULL && type == RESPONSE_APC_DATA;
+	if (filtered) {
+		mLive.clear();
+		mLiveFilter->write(data, length, mDataFile, &mLive);
+		data = mLive.getBuf();
+		length = mLive.getLength();
+	}
 
-		// Send data over the socket, sending the type and size first
+	// Send data over the socket connection
+	bool queued = false;
+	bool sent = true;
+	uint64_t headerTicket = 0;
+	uint64_t ticket = 0;
+	// type and length already added by the Collector for apc data
+	unsigned char header[HEADER_SIZE];
+	header[0] = type;
+	Buffer::writeLEInt(header + 1, length);
+	if (mDataSocket && (length > 0 || !filtered)) {
 		logg->logMessage("Sending data with length %d", length);
-		if (type != RESPONSE_APC_DATA) {
-			// type and length already added by the Collector for apc data
-			unsigned char header[5];
-			header[0] = type;
-			Buffer::writeLEInt(header + 1, length);
-			mDataSocket->send((char*)&header, sizeof(header));
-		}
-
-		// 100Kbits/sec * alarmDuration sec / 8 bits/byte
-		const int chunkSize = 100*1000 * alarmDuration / 8;
-		int pos = 0;
-		while (true) {
-			mDataSocket->send((const char*)data + pos, min(length - pos, chunkSize));
-			pos += chunkSize;
-			if (pos >= length) {
-				break;
+		if (mSpill != NULL && type != RESPONSE_ERROR) {
+			// Keep the other responses in order with the apc data by queueing them too, the data is queued once mSendMutex is released
+			queued = true;
+			if (type != RESPONSE_APC_DATA) {
+				headerTicket = mSpill->reserve();
 			}
-
-			// Reset the alarm
-			alarm(alarmDuration);
-			logg->logMessage("Resetting the alarm");
+			ticket = mSpill->reserve();
+		} else {
+			// Errors are sent directly as the queue may be why the capture failed, sending the type and size first
+			if (type != RESPONSE_APC_DATA) {
+				sent = send((char*)&header, sizeof(header), length > 0);
+			}
+			sent = sent && send(data, length, false);
 		}
-
-		// Stop alarm
-		alarm(0);
 	}
 
 	// Write data to disk as long as it is not meta data
-	if (mDataFile && type == RESPONSE_APC_DATA) {
+	if (mDataFile && type == RESPONSE_APC_DATA && !filtered) {
 		logg->logMessage("Writing data with length %d", length);
-		// Send data to the data file
-		if (fwrite(data, 1, length, mDataFile) != (unsigned int)length) {
-			logg->logError(__FILE__, __LINE__, "Failed writing binary file %s", mDataFileName);
+		// Queue the data for the writer thread, write errors are reported by the writer thread
+		mDataFile->write(data, length);
+	}
+
+	if (mSummary && type == RESPONSE_APC_DATA) {
+		mSummary->write(data, length);
+	}
+
+	pthread_mutex_unlock(&mSendMutex);
+
+	if (queued) {
+		queue(headerTicket, header, ticket, data, length, type);
+	}
+
+	if (!sent) {
+		// handleException sends an error, so one that can't be sent is only logged. It takes mSendMutex so it is called after that is released
+		if (type == RESPONSE_ERROR) {
+			logg->logMessage("%s(%s:%i): Unable to send the error response", __FUNCTION__, __FILE__, __LINE__);
+		} else {
+			logg->logError(__FILE__, __LINE__, "Unable to send a response of type %i to the host", type);
 			handleException();
 		}
 	}
+}
 
-	pthread_mutex_unlock(&mSendMutex);
+void Sender::queue(const uint64_t headerTicket, const unsigned char *const header, const uint64_t ticket, const char *const data, const int length, const int type) {
+	// The queue may wait for the host, so this is not done while holding mSendMutex which handleException needs to send the error.
+	// Only the sender thread writes apc data so mLive is not reused before it is queued
+	bool sent = true;
+	if (type != RESPONSE_APC_DATA) {
+		sent = mSpill->write(headerTicket, (const char *)header, HEADER_SIZE);
+	}
+	// Every reserved ticket is written
+	sent = mSpill->write(ticket, data, length) && sent;
+	if (sent) {
+		return;
+	}
+
+	// The capture ends when the apc data can't be sent, which is only written by the sender thread
+	if (type == RESPONSE_APC_DATA) {
+		logg->logError(__FILE__, __LINE__, "%s", mSpill->getError());
+		handleException();
+	}
+	logg->logMessage("%s(%s:%i): Unable to send a response of type %i: %s", __FUNCTION__, __FILE__, __LINE__, type, mSpill->getError());
 }
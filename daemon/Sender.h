@@ -9,10 +9,17 @@
 #ifndef	__SENDER_H__
 #define	__SENDER_H__
 
+#include <stdint.h>
 #include <stdio.h>
 #include <pthread.h>
 
+#include "DynBuf.h"
+
+class CaptureFile;
+class CaptureSummary;
+class LiveFilter;
 class OlySocket;
+class SpillQueue;
 
 enum {
 	RESPONSE_XML = 1,
@@ -28,10 +35,33 @@ public:
 	~Sender();
 	void writeData(const char* data, int length, int type);
 	void createDataFile(char* apcDir);
+	// Queues the apc data of a live capture on a thread of its own, until then responses are sent directly
+	void createSpillQueue();
+	// Also passes the apc data to summary, which is not owned by the Sender
+	void setSummary(CaptureSummary* summary) { mSummary = summary; }
+	// Sends a reduced stream to Streamline and, if there is a data file, archives the full stream to it
+	void createLiveFilter(int downsample);
+	// Blocks until the queued live data has been sent
+	void flush();
 private:
+	// The session ends if the host reads nothing for this long
+	static const int SEND_TIMEOUT_S = 30;
+	static const int SEND_BUFFER_SIZE = 4 << 20;
+	// The type and length that precede the data of responses other than apc data
+	static const int HEADER_SIZE = 5;
+
+	static bool sendStatic(void *arg, const char *const data, const int length, const bool more);
+	// Returns false if the connection failed or the host stopped reading, the caller raises the error
+	bool send(const char *const data, const int length, const bool more);
+	void queue(const uint64_t headerTicket, const unsigned char *const header, const uint64_t ticket, const char *const data, const int length, const int type);
+
 	OlySocket* mDataSocket;
-	FILE* mDataFile;
-	char* mDataFileName;
+	CaptureFile* mDataFile;
+	CaptureSummary* mSummary;
+	LiveFilter* mLiveFilter;
+	// Queues the apc data of a live capture so that a stalled connection does not stall the sender thread
+	SpillQueue* mSpill;
+	DynBuf mLive;
 	pthread_mutex_t mSendMutex;
 
 	// Intentionally unimplemented
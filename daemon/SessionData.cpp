@@ -29,6 +29,9 @@ void SessionData::initialize() {
 	mLocalCapture = false;
 	mOneShot = false;
 	mSentSummary = false;
+	mCompactCounters = false;
+	mInternStrings = false;
+	mReactor = false;
 	const size_t cpuIdSize = sizeof(int)*NR_CPUS;
 	// Share mCpuIds across all instances of gatord
 	mCpuIds = (int *)mmap(NULL, cpuIdSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
@@ -43,9 +46,18 @@ void SessionData::initialize() {
 	mEventsXMLPath = NULL;
 	mTargetPath = NULL;
 	mAPCDir = NULL;
+	mSummaryPath = NULL;
+	mArchivePath = NULL;
+	mSpillDir = "/tmp";
 	mSampleRate = 0;
 	mLiveRate = 0;
+	mLiveDownsample = 1;
+	mSpillLimit = 256;
 	mDuration = 0;
+	mSegmentSize = 0;
+	mSegmentDuration = 0;
+	mRetainSize = 0;
+	mRetainDuration = 0;
 	mBacktraceDepth = 0;
 	mTotalBufferSize = 0;
 	// sysconf(_SC_NPROCESSORS_CONF) is unreliable on 2.6 Android, get the value from the kernel module
@@ -71,7 +83,14 @@ void SessionData::parseSessionXML(char* xmlString) {
 		handleException();
 	}
 	mBacktraceDepth = session.parameters.call_stack_unwinding == true ? 128 : 0;
+	mCompactCounters = session.parameters.compact_counters;
+	mInternStrings = session.parameters.intern_strings;
 	mDuration = session.parameters.duration;
+	// Convert MB to bytes and seconds to nanoseconds
+	mSegmentSize = session.parameters.segment_size * (int64_t)1024 * 1024;
+	mSegmentDuration = session.parameters.segment_duration * (int64_t)NS_PER_S;
+	mRetainSize = session.parameters.retain_size * (int64_t)1024 * 1024;
+	mRetainDuration = session.parameters.retain_duration * (int64_t)NS_PER_S;
 
 	// Determine buffer size (in MB) based on buffer mode
 	mOneShot = true;
@@ -96,6 +115,19 @@ void SessionData::parseSessionXML(char* xmlString) {
 		logg->logMessage("Local capture is not compatable with live, disabling live");
 		mLiveRate = 0;
 	}
+
+	// The command line takes precedence over the session xml
+	if (session.parameters.daemon_cpus[0] != '\0' && !threadPlacement.hasCpus() && !threadPlacement.setCpus(session.parameters.daemon_cpus)) {
+		logg->logError(__FILE__, __LINE__, "Invalid daemon_cpus (%s) in session xml.", session.parameters.daemon_cpus);
+		handleException();
+	}
+	if (session.parameters.daemon_sched[0] != '\0' && !threadPlacement.hasSched() && !threadPlacement.setSched(session.parameters.daemon_sched)) {
+		logg->logError(__FILE__, __LINE__, "Invalid daemon_sched (%s) in session xml.", session.parameters.daemon_sched);
+		handleException();
+	}
+	if (session.parameters.daemon_cgroup[0] != '\0' && !threadPlacement.hasCgroup()) {
+		threadPlacement.setCgroup(session.parameters.daemon_cgroup);
+	}
 }
 
 void SessionData::readCpuInfo() {
@@ -11,12 +11,14 @@
 
 #include <stdint.h>
 
+#include "BufferBudget.h"
 #include "Config.h"
 #include "Counter.h"
 #include "FSDriver.h"
 #include "Hwmon.h"
 #include "MaliVideoDriver.h"
 #include "PerfDriver.h"
+#include "ThreadPlacement.h"
 
 #define PROTOCOL_VERSION	19
 #define PROTOCOL_DEV		1000	// Differentiates development versions (timestamp) from release versions
@@ -42,6 +44,8 @@ public:
 	FSDriver fsDriver;
 	PerfDriver perf;
 	MaliVideoDriver maliVideo;
+	BufferBudget bufferBudget;
+	ThreadPlacement threadPlacement;
 
 	char mCoreName[MAX_STRING_LEN];
 	struct ImageLinkList *mImages;
@@ -50,6 +54,12 @@ public:
 	char* mEventsXMLPath;
 	char* mTargetPath;
 	char* mAPCDir;
+	// Where to write the json summary of a local capture, see CaptureSummary
+	char* mSummaryPath;
+	// Where to archive the full resolution data of a live capture
+	char* mArchivePath;
+	// Where to spill the live stream when the connection stalls, see SpillQueue
+	const char* mSpillDir;
 
 	bool mWaitingOnCommand;
 	bool mSessionIsActive;
@@ -57,12 +67,23 @@ public:
 	bool mOneShot;		// halt processing of the driver data until profiling is complete or the buffer is filled
 	bool mIsEBS;
 	bool mSentSummary;
+	bool mCompactCounters;	// send block counters as FRAME_BLOCK_COUNTER_COMPACT
+	bool mInternStrings;	// send comm and maps using the string table
+	bool mReactor;		// run the sources from one event loop, see Reactor
 
 	int mBacktraceDepth;
-	int mTotalBufferSize;	// number of MB to use for the entire collection buffer
+	int mTotalBufferSize;	// number of MB to use for the entire collection buffer, see BufferBudget
 	int mSampleRate;
 	int64_t mLiveRate;
+	// Only one in this many samples and counter values are sent to Streamline in a live capture, see LiveFilter
+	int mLiveDownsample;
+	int mSpillLimit;	// number of MB the live stream can spill to disk, 0 to not spill
 	int mDuration;
+	// Local capture segment and retention limits, 0 for no limit
+	int64_t mSegmentSize;	// bytes
+	int64_t mSegmentDuration;	// ns
+	int64_t mRetainSize;	// bytes
+	int64_t mRetainDuration;	// ns
 	int mCores;
 	int mPageSize;
 	int *mCpuIds;
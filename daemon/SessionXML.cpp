@@ -26,6 +26,15 @@ static const char*	ATTR_SAMPLE_RATE        = "sample_rate";
 static const char*	ATTR_DURATION           = "duration";
 static const char*	ATTR_PATH               = "path";
 static const char*	ATTR_LIVE_RATE          = "live_rate";
+static const char*	ATTR_COMPACT_COUNTERS   = "compact_counters";
+static const char*	ATTR_INTERN_STRINGS     = "intern_strings";
+static const char*	ATTR_SEGMENT_SIZE       = "segment_size";
+static const char*	ATTR_SEGMENT_DURATION   = "segment_duration";
+static const char*	ATTR_RETAIN_SIZE        = "retain_size";
+static const char*	ATTR_RETAIN_DURATION    = "retain_duration";
+static const char*	ATTR_DAEMON_CPUS        = "daemon_cpus";
+static const char*	ATTR_DAEMON_SCHED       = "daemon_sched";
+static const char*	ATTR_DAEMON_CGROUP      = "daemon_cgroup";
 
 SessionXML::SessionXML(const char *str) {
 	parameters.buffer_mode[0] = 0;
@@ -33,6 +42,15 @@ SessionXML::SessionXML(const char *str) {
 	parameters.duration = 0;
 	parameters.call_stack_unwinding = false;
 	parameters.live_rate = 0;
+	parameters.compact_counters = false;
+	parameters.intern_strings = false;
+	parameters.segment_size = 0;
+	parameters.segment_duration = 0;
+	parameters.retain_size = 0;
+	parameters.retain_duration = 0;
+	parameters.daemon_cpus[0] = 0;
+	parameters.daemon_sched[0] = 0;
+	parameters.daemon_cgroup[0] = 0;
 	parameters.images = NULL;
 	mPath = 0;
 	mSessionXML = (const char *)str;
@@ -82,8 +100,26 @@ void SessionXML::sessionTag(mxml_node_t *tree, mxml_node_t *node) {
 
 	// integers/bools
 	parameters.call_stack_unwinding = util->stringToBool(mxmlElementGetAttr(node, ATTR_CALL_STACK_UNWINDING), false);
+	parameters.compact_counters = util->stringToBool(mxmlElementGetAttr(node, ATTR_COMPACT_COUNTERS), false);
+	parameters.intern_strings = util->stringToBool(mxmlElementGetAttr(node, ATTR_INTERN_STRINGS), false);
 	if (mxmlElementGetAttr(node, ATTR_DURATION)) parameters.duration = strtol(mxmlElementGetAttr(node, ATTR_DURATION), NULL, 10);
 	if (mxmlElementGetAttr(node, ATTR_LIVE_RATE)) parameters.live_rate = strtol(mxmlElementGetAttr(node, ATTR_LIVE_RATE), NULL, 10);
+	if (mxmlElementGetAttr(node, ATTR_SEGMENT_SIZE)) parameters.segment_size = strtol(mxmlElementGetAttr(node, ATTR_SEGMENT_SIZE), NULL, 10);
+	if (mxmlElementGetAttr(node, ATTR_SEGMENT_DURATION)) parameters.segment_duration = strtol(mxmlElementGetAttr(node, ATTR_SEGMENT_DURATION), NULL, 10);
+	if (mxmlElementGetAttr(node, ATTR_RETAIN_SIZE)) parameters.retain_size = strtol(mxmlElementGetAttr(node, ATTR_RETAIN_SIZE), NULL, 10);
+	if (mxmlElementGetAttr(node, ATTR_RETAIN_DURATION)) parameters.retain_duration = strtol(mxmlElementGetAttr(node, ATTR_RETAIN_DURATION), NULL, 10);
+	if (mxmlElementGetAttr(node, ATTR_DAEMON_CPUS)) {
+		strncpy(parameters.daemon_cpus, mxmlElementGetAttr(node, ATTR_DAEMON_CPUS), sizeof(parameters.daemon_cpus));
+		parameters.daemon_cpus[sizeof(parameters.daemon_cpus) - 1] = 0; // strncpy does not guarantee a null-terminated string
+	}
+	if (mxmlElementGetAttr(node, ATTR_DAEMON_SCHED)) {
+		strncpy(parameters.daemon_sched, mxmlElementGetAttr(node, ATTR_DAEMON_SCHED), sizeof(parameters.daemon_sched));
+		parameters.daemon_sched[sizeof(parameters.daemon_sched) - 1] = 0; // strncpy does not guarantee a null-terminated string
+	}
+	if (mxmlElementGetAttr(node, ATTR_DAEMON_CGROUP)) {
+		strncpy(parameters.daemon_cgroup, mxmlElementGetAttr(node, ATTR_DAEMON_CGROUP), sizeof(parameters.daemon_cgroup));
+		parameters.daemon_cgroup[sizeof(parameters.daemon_cgroup) - 1] = 0; // strncpy does not guarantee a null-terminated string
+	}
 
 	// parse subtags
 	node = mxmlGetFirstChild(node);
@@ -9,6 +9,8 @@
 #ifndef SESSION_XML_H
 #define SESSION_XML_H
 
+#include <limits.h>
+
 #include "mxml/mxml.h"
 
 struct ImageLinkList;
@@ -19,6 +21,15 @@ struct ConfigParameters {
 	int duration;		// length of profile in seconds
 	bool call_stack_unwinding;	// whether stack unwinding is performed
 	int live_rate;
+	bool compact_counters;	// whether block counters are sent as FRAME_BLOCK_COUNTER_COMPACT
+	bool intern_strings;	// whether comm and maps messages reference strings by id
+	int segment_size;	// size in MB of each local capture segment file, 0 for no limit
+	int segment_duration;	// length in seconds of each local capture segment file, 0 for no limit
+	int retain_size;	// size in MB of the local capture segment files to keep, 0 to keep all
+	int retain_duration;	// length in seconds of the local capture segment files to keep, 0 to keep all
+	char daemon_cpus[128];	// cpus to run gatord on, see ThreadPlacement
+	char daemon_sched[32];	// scheduling policy of gatord
+	char daemon_cgroup[PATH_MAX];	// cgroup to run gatord in
 	struct ImageLinkList *images;	// linked list of image strings
 };
 
@@ -27,6 +27,12 @@ public:
 	virtual bool isDone() = 0;
 	virtual void write(Sender *sender) = 0;
 
+	// Used instead of start, run and join when the session runs on a single thread, see Reactor. pollStart returns a fd to wait on,
+	// or -1 if the source needs its own thread. poll is then called whenever the fd is readable and pollStop once the session has ended
+	virtual int pollStart() { return -1; }
+	virtual void poll() {}
+	virtual void pollStop() {}
+
 private:
 	static void *runStatic(void *arg);
 
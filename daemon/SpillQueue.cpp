@@ -0,0 +1,280 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "SpillQueue.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <unistd.h>
+
+#include "Logging.h"
+
+static char *allocate(const int size) {
+	char *const buf = (char *)malloc(size);
+	if (buf == NULL) {
+		logg->logError(__FILE__, __LINE__, "failed to allocate %d bytes", size);
+		handleException();
+	}
+	return buf;
+}
+
+SpillQueue::SpillQueue(SpillSend send, void *arg, const char *const dir, const int64_t limit) : mSend(send), mSendArg(arg), mDir(dir), mLimit(limit), mMemory(allocate(MEMORY_SIZE)), mChunk(allocate(CHUNK_SIZE)), mMemoryRead(0), mMemoryUsed(0), mFd(-1), mCanSpill(limit > 0), mSpillRead(0), mSpillWrite(0), mStopping(false), mFailed(false), mError(NULL), mNextTicket(0), mServing(0), mSpilled(0), mSpillPeak(0), mStalls(0) {
+	pthread_mutex_init(&mMutex, NULL);
+	pthread_cond_init(&mCond, NULL);
+
+	if (pthread_create(&mThread, NULL, senderThreadStatic, this) != 0) {
+		logg->logError(__FILE__, __LINE__, "Failed to create the live sender thread");
+		handleException();
+	}
+}
+
+SpillQueue::~SpillQueue() {
+	pthread_mutex_lock(&mMutex);
+	mStopping = true;
+	pthread_cond_broadcast(&mCond);
+	pthread_mutex_unlock(&mMutex);
+	pthread_join(mThread, NULL);
+
+	if (mFailed) {
+		logg->logMessage("The live stream was dropped after a send failed");
+	}
+	if (mStalls > 0) {
+		logg->logMessage("Spilled %lld bytes of the live stream to disk during %d stalls, at most %lld bytes at once", (long long)mSpilled, mStalls, (long long)mSpillPeak);
+	}
+
+	if (mFd >= 0) {
+		close(mFd);
+	}
+	pthread_cond_destroy(&mCond);
+	pthread_mutex_destroy(&mMutex);
+	free(mChunk);
+	free(mMemory);
+}
+
+bool SpillQueue::openSpill() {
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s/gatord-spill-XXXXXX", mDir);
+	mFd = mkstemp(path);
+	if (mFd < 0) {
+		logg->logMessage("%s(%s:%i): Unable to create a spill file in %s: %s, the live stream will block instead", __FUNCTION__, __FILE__, __LINE__, mDir, strerror(errno));
+		return false;
+	}
+	// Removed when closed, including if gatord exits abnormally
+	unlink(path);
+
+	return true;
+}
+
+bool SpillQueue::spill(const char *const data, const int length) {
+	int pos = 0;
+	while (pos < length) {
+		const ssize_t bytes = pwrite(mFd, data + pos, length - pos, mSpillWrite + pos);
+		if (bytes <= 0) {
+			if (bytes < 0 && errno == EINTR) {
+				continue;
+			}
+			logg->logMessage("%s(%s:%i): Unable to write the spill file: %s", __FUNCTION__, __FILE__, __LINE__, strerror(errno));
+			return false;
+		}
+		pos += bytes;
+	}
+	mSpillWrite += length;
+	mSpilled += length;
+	if (mSpillWrite - mSpillRead > mSpillPeak) {
+		mSpillPeak = mSpillWrite - mSpillRead;
+	}
+
+	return true;
+}
+
+void SpillQueue::fail(const char *const error) {
+	// Drop the queued data and release the writers, they report the error
+	mFailed = true;
+	mError = error;
+	mMemoryUsed = 0;
+	mSpillRead = 0;
+	mSpillWrite = 0;
+	pthread_cond_broadcast(&mCond);
+}
+
+uint64_t SpillQueue::reserve() {
+	pthread_mutex_lock(&mMutex);
+	const uint64_t ticket = mNextTicket++;
+	pthread_mutex_unlock(&mMutex);
+	return ticket;
+}
+
+bool SpillQueue::write(const uint64_t ticket, const char *data, int length) {
+	pthread_mutex_lock(&mMutex);
+
+	while (!mFailed && ticket != mServing) {
+		pthread_cond_wait(&mCond, &mMutex);
+	}
+
+	while (length > 0 && !mFailed) {
+		const bool spilling = mSpillWrite > mSpillRead;
+		if (spilling || (mCanSpill && mMemoryUsed >= HIGH_WATERMARK)) {
+			if (mFd < 0 && !openSpill()) {
+				mCanSpill = false;
+				continue;
+			}
+			// Keep the data in order by spilling everything until the spill file has been replayed
+			const int64_t space = mLimit - (mSpillWrite - mSpillRead);
+			if (space <= 0) {
+				pthread_cond_wait(&mCond, &mMutex);
+				continue;
+			}
+			if (!spilling) {
+				logg->logMessage("The connection is stalled, spilling the live stream to disk");
+				++mStalls;
+			}
+			const int bytes = length < space ? length : (int)space;
+			if (!spill(data, bytes)) {
+				fail("Unable to write the live data to the spill file");
+				break;
+			}
+			data += bytes;
+			length -= bytes;
+			pthread_cond_broadcast(&mCond);
+			continue;
+		}
+
+		// Fill the memory up to the high watermark, or completely if the data can't be spilled
+		const int space = (mCanSpill ? HIGH_WATERMARK : MEMORY_SIZE) - mMemoryUsed;
+		if (space <= 0) {
+			pthread_cond_wait(&mCond, &mMutex);
+			continue;
+		}
+		const int bytes = length < space ? length : space;
+		const int writePos = (mMemoryRead + mMemoryUsed) % MEMORY_SIZE;
+		const int first = bytes < MEMORY_SIZE - writePos ? bytes : MEMORY_SIZE - writePos;
+		memcpy(mMemory + writePos, data, first);
+		memcpy(mMemory, data + first, bytes - first);
+		mMemoryUsed += bytes;
+		data += bytes;
+		length -= bytes;
+		pthread_cond_broadcast(&mCond);
+	}
+
+	// Let the next writer in
+	if (ticket == mServing) {
+		++mServing;
+	}
+	pthread_cond_broadcast(&mCond);
+	const bool sent = !mFailed;
+
+	pthread_mutex_unlock(&mMutex);
+
+	return sent;
+}
+
+bool SpillQueue::flush() {
+	pthread_mutex_lock(&mMutex);
+	while (!mFailed && (mMemoryUsed > 0 || mSpillWrite > mSpillRead)) {
+		pthread_cond_wait(&mCond, &mMutex);
+	}
+	const bool sent = !mFailed;
+	pthread_mutex_unlock(&mMutex);
+
+	return sent;
+}
+
+void *SpillQueue::senderThreadStatic(void *arg) {
+	prctl(PR_SET_NAME, (unsigned long)&"gatord-live", 0, 0, 0);
+	static_cast<SpillQueue *>(arg)->senderThread();
+	return NULL;
+}
+
+void SpillQueue::senderThread() {
+	pthread_mutex_lock(&mMutex);
+
+	for (;;) {
+		while (mMemoryUsed == 0 && mSpillWrite == mSpillRead && !mStopping) {
+			pthread_cond_wait(&mCond, &mMutex);
+		}
+
+		// The memory is always older than the spill file
+		if (mMemoryUsed > 0) {
+			int bytes = MEMORY_SIZE - mMemoryRead;
+			if (bytes > mMemoryUsed) {
+				bytes = mMemoryUsed;
+			}
+			if (bytes > CHUNK_SIZE) {
+				bytes = CHUNK_SIZE;
+			}
+			const char *const data = mMemory + mMemoryRead;
+			// Let the socket coalesce the chunks of a batch into full packets
+			const bool more = mMemoryUsed > bytes || mSpillWrite > mSpillRead;
+			pthread_mutex_unlock(&mMutex);
+
+			const bool sent = mSend(mSendArg, data, bytes, more);
+
+			pthread_mutex_lock(&mMutex);
+			if (mFailed) {
+				// The spill file failed while sending
+				break;
+			}
+			if (!sent) {
+				fail("Unable to send the live data to the host");
+				break;
+			}
+			mMemoryRead = (mMemoryRead + bytes) % MEMORY_SIZE;
+			mMemoryUsed -= bytes;
+		} else if (mSpillWrite > mSpillRead) {
+			const int bytes = mSpillWrite - mSpillRead < CHUNK_SIZE ? mSpillWrite - mSpillRead : CHUNK_SIZE;
+			const off_t offset = mSpillRead;
+			const bool more = mSpillWrite - mSpillRead > bytes;
+			pthread_mutex_unlock(&mMutex);
+
+			int pos = 0;
+			while (pos < bytes) {
+				const ssize_t read = pread(mFd, mChunk + pos, bytes - pos, offset + pos);
+				if (read <= 0) {
+					if (read < 0 && errno == EINTR) {
+						continue;
+					}
+					logg->logMessage("%s(%s:%i): Unable to read the spill file: %s", __FUNCTION__, __FILE__, __LINE__, strerror(errno));
+					break;
+				}
+				pos += read;
+			}
+			const bool sent = pos == bytes && mSend(mSendArg, mChunk, bytes, more);
+
+			pthread_mutex_lock(&mMutex);
+			if (mFailed) {
+				// The spill file failed while sending
+				break;
+			}
+			if (!sent) {
+				fail(pos == bytes ? "Unable to send the live data to the host" : "Unable to read the live data from the spill file");
+				break;
+			}
+			mSpillRead += bytes;
+			if (mSpillRead == mSpillWrite) {
+				// Caught up, reuse the file from the start
+				logg->logMessage("The connection has drained the spill file");
+				mSpillRead = 0;
+				mSpillWrite = 0;
+				if (ftruncate(mFd, 0) != 0) {
+					logg->logMessage("%s(%s:%i): ftruncate failed", __FUNCTION__, __FILE__, __LINE__);
+				}
+			}
+		} else {
+			// Stopping and everything has been sent
+			break;
+		}
+
+		pthread_cond_broadcast(&mCond);
+	}
+
+	pthread_mutex_unlock(&mMutex);
+}
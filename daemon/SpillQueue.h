@@ -0,0 +1,87 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef SPILLQUEUE_H
+#define SPILLQUEUE_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Sends the data to Streamline, more is set if more data is already queued. Returns false if the data could not be sent
+typedef bool (*SpillSend)(void *arg, const char *const data, const int length, const bool more);
+
+// Sends the live stream on its own thread so that the sender thread keeps draining the capture buffers while the connection to
+// the host stalls. Data is queued in memory and, once that is past the high watermark, appended to an unlinked temporary spill
+// file that is replayed in order when the connection drains. write only blocks when the spill file reaches its limit. The queue's
+// thread never raises errors itself: a failed send is recorded, the queued data is dropped and the writers are told by their return value
+class SpillQueue {
+public:
+	// dir is where the spill file is created, limit is its maximum size in bytes or 0 to only queue in memory
+	SpillQueue(SpillSend send, void *arg, const char *const dir, const int64_t limit);
+	// Sends the queued data before returning
+	~SpillQueue();
+
+	// Reserves the position in the stream of the next write, so that callers can keep their data in order without holding their own
+	// lock while write blocks
+	uint64_t reserve();
+	// Queues the data at the position reserved by ticket, every reserved ticket must be written. Returns false if a send has failed
+	bool write(const uint64_t ticket, const char *data, int length);
+	// Blocks until all the queued data has been sent, returns false if a send has failed
+	bool flush();
+	// Describes why the data could not be sent, only valid once write or flush has returned false
+	const char *getError() const { return mError; }
+
+private:
+	static const int MEMORY_SIZE = 4 << 20;
+	static const int HIGH_WATERMARK = 3 * MEMORY_SIZE / 4;
+	// Size of each send
+	static const int CHUNK_SIZE = 100 << 10;
+
+	static void *senderThreadStatic(void *arg);
+	void senderThread();
+	bool openSpill();
+	bool spill(const char *const data, const int length);
+	void fail(const char *const error);
+
+	const SpillSend mSend;
+	void *const mSendArg;
+	const char *const mDir;
+	const int64_t mLimit;
+	pthread_mutex_t mMutex;
+	// Signalled when data is queued and when it has been sent
+	pthread_cond_t mCond;
+	pthread_t mThread;
+	char *const mMemory;
+	char *const mChunk;
+	int mMemoryRead;
+	int mMemoryUsed;
+	int mFd;
+	// Cleared if the spill file can't be created
+	bool mCanSpill;
+	off_t mSpillRead;
+	off_t mSpillWrite;
+	bool mStopping;
+	// Set when a send or the spill file fails
+	bool mFailed;
+	const char *mError;
+	uint64_t mNextTicket;
+	// The ticket whose data is written next
+	uint64_t mServing;
+
+	// Statistics, logged when the queue is destroyed
+	int64_t mSpilled;
+	int64_t mSpillPeak;
+	int mStalls;
+
+	// Intentionally unimplemented
+	SpillQueue(const SpillQueue &);
+	SpillQueue &operator=(const SpillQueue &);
+};
+
+#endif // SPILLQUEUE_H
@@ -36,6 +36,7 @@ StreamlineSetup::StreamlineSetup(OlySocket* s) {
 	int type;
 
 	mSocket = s;
+	mSessionXML = NULL;
 
 	// Receive commands from Streamline (master)
 	while (!ready) {
@@ -65,7 +66,16 @@ StreamlineSetup::StreamlineSetup(OlySocket* s) {
 				break;
 			case COMMAND_PING:
 				logg->logMessage("Received ping command");
-				sendData(NULL, 0, RESPONSE_ACK);
+				if (strcmp(data, PING_CLOCK) == 0) {
+					// A hub estimating the clock offset, reply with the time used by the summary frame
+					unsigned char time[8];
+					const uint64_t now = getTime();
+					Buffer::writeLEInt(time, (int)now);
+					Buffer::writeLEInt(time + 4, (int)(now >> 32));
+					sendData((const char *)time, sizeof(time), RESPONSE_ACK);
+				} else {
+					sendData(NULL, 0, RESPONSE_ACK);
+				}
 				break;
 			default:
 				logg->logError(__FILE__, __LINE__, "Target error: Unknown command type, %d", type);
@@ -82,6 +92,7 @@ StreamlineSetup::StreamlineSetup(OlySocket* s) {
 }
 
 StreamlineSetup::~StreamlineSetup() {
+	free(mSessionXML);
 }
 
 char* StreamlineSetup::readCommand(int* command) {
@@ -176,6 +187,8 @@ void StreamlineSetup::handleDeliver(char* xml) {
 	if (mxmlFindElement(tree, tree, TAG_SESSION, NULL, NULL, MXML_DESCEND_FIRST)) {
 		// Session XML
 		gSessionData->parseSessionXML(xml);
+		free(mSessionXML);
+		mSessionXML = strdup(xml);
 		sendData(NULL, 0, RESPONSE_ACK);
 		logg->logMessage("Received session xml");
 	} else if (mxmlFindElement(tree, tree, TAG_CONFIGURATIONS, NULL, NULL, MXML_DESCEND_FIRST)) {
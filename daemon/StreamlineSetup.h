@@ -24,12 +24,18 @@ enum {
 	COMMAND_PING        = 5
 };
 
+// Payload of a ping that asks for the target's CLOCK_MONOTONIC_RAW time, which is returned as 8 little endian bytes in the ack. Used by Hub
+#define PING_CLOCK "clock"
+
 class StreamlineSetup {
 public:
 	StreamlineSetup(OlySocket *socket);
 	~StreamlineSetup();
+	// The last session xml delivered by Streamline, used to archive a live capture
+	const char* getSessionXML() const { return mSessionXML; }
 private:
 	OlySocket* mSocket;
+	char* mSessionXML;
 
 	char* readCommand(int*);
 	void handleRequest(char* xml);
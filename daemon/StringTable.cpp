@@ -0,0 +1,89 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "StringTable.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "Logging.h"
+
+StringTable::~StringTable() {
+	for (int i = 0; i < mCapacity; ++i) {
+		free(mEntries[i].str);
+	}
+	free(mEntries);
+}
+
+uint32_t StringTable::hash(const char *str) {
+	// FNV-1a
+	uint32_t hash = 2166136261U;
+	for (; *str != '\0'; ++str) {
+		hash = (hash ^ (unsigned char)*str) * 16777619U;
+	}
+	return hash;
+}
+
+bool StringTable::grow() {
+	const int capacity = mCapacity == 0 ? 256 : 2*mCapacity;
+	Entry *const entries = (Entry *)calloc(capacity, sizeof(Entry));
+	if (entries == NULL) {
+		return false;
+	}
+
+	// Rehash the existing entries, capacity is always a power of 2
+	for (int i = 0; i < mCapacity; ++i) {
+		if (mEntries[i].str == NULL) {
+			continue;
+		}
+		int pos = mEntries[i].hash & (capacity - 1);
+		while (entries[pos].str != NULL) {
+			pos = (pos + 1) & (capacity - 1);
+		}
+		entries[pos] = mEntries[i];
+	}
+
+	free(mEntries);
+	mEntries = entries;
+	mCapacity = capacity;
+
+	return true;
+}
+
+int StringTable::intern(const char *const str, bool *const isNew) {
+	*isNew = false;
+	if (str[0] == '\0') {
+		return 0;
+	}
+
+	// Keep the load factor at or below 1/2
+	if (2*(mCount + 1) > mCapacity && !grow()) {
+		logg->logError(__FILE__, __LINE__, "Unable to grow the string table");
+		handleException();
+	}
+
+	const uint32_t h = hash(str);
+	int pos = h & (mCapacity - 1);
+	while (mEntries[pos].str != NULL) {
+		if (mEntries[pos].hash == h && strcmp(mEntries[pos].str, str) == 0) {
+			return mEntries[pos].id;
+		}
+		pos = (pos + 1) & (mCapacity - 1);
+	}
+
+	mEntries[pos].str = strdup(str);
+	if (mEntries[pos].str == NULL) {
+		logg->logError(__FILE__, __LINE__, "strdup failed");
+		handleException();
+	}
+	mEntries[pos].hash = h;
+	mEntries[pos].id = ++mCount;
+	*isNew = true;
+
+	return mEntries[pos].id;
+}
@@ -0,0 +1,43 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef STRINGTABLE_H
+#define STRINGTABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Assigns each unique string an id so that it only needs to be sent once per session
+class StringTable {
+public:
+	StringTable() : mCapacity(0), mCount(0), mEntries(NULL) {}
+	~StringTable();
+
+	// Returns the id of str adding it to the table if necessary, isNew is set if it was added. The empty string is always id 0
+	int intern(const char *const str, bool *const isNew);
+
+private:
+	struct Entry {
+		char *str;
+		uint32_t hash;
+		int id;
+	};
+
+	static uint32_t hash(const char *str);
+	bool grow();
+
+	int mCapacity;
+	int mCount;
+	Entry *mEntries;
+
+	// Intentionally undefined
+	StringTable(const StringTable &);
+	StringTable &operator=(const StringTable &);
+};
+
+#endif // STRINGTABLE_H
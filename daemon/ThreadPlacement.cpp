@@ -0,0 +1,197 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "ThreadPlacement.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "Logging.h"
+
+ThreadPlacement::ThreadPlacement() : mPolicy(SCHED_OTHER), mPriority(0) {
+	CPU_ZERO(&mCpuSet);
+	mCpus[0] = '\0';
+	mSched[0] = '\0';
+	mCgroup[0] = '\0';
+}
+
+bool ThreadPlacement::parseCpus(const char *const cpus, cpu_set_t *const cpuSet) {
+	CPU_ZERO(cpuSet);
+
+	const char *pos = cpus;
+	while (*pos != '\0') {
+		char *end;
+		const long first = strtol(pos, &end, 10);
+		long last = first;
+		if (end == pos) {
+			return false;
+		}
+		if (*end == '-') {
+			pos = end + 1;
+			last = strtol(pos, &end, 10);
+			if (end == pos) {
+				return false;
+			}
+		}
+		if (first < 0 || last < first || last >= CPU_SETSIZE) {
+			return false;
+		}
+		for (long cpu = first; cpu <= last; ++cpu) {
+			CPU_SET(cpu, cpuSet);
+		}
+		if (*end == ',') {
+			++end;
+		} else if (*end != '\0') {
+			return false;
+		}
+		pos = end;
+	}
+
+	return CPU_COUNT(cpuSet) > 0;
+}
+
+bool ThreadPlacement::setCpus(const char *const cpus) {
+	cpu_set_t cpuSet;
+	if (!parseCpus(cpus, &cpuSet)) {
+		return false;
+	}
+
+	if (strlen(cpus) >= sizeof(mCpus)) {
+		return false;
+	}
+
+	mCpuSet = cpuSet;
+	strcpy(mCpus, cpus);
+	return true;
+}
+
+bool ThreadPlacement::setSched(const char *const sched) {
+	static const struct {
+		const char *name;
+		int policy;
+	} policies[] = {
+		{ "other", SCHED_OTHER },
+#ifdef SCHED_BATCH
+		{ "batch", SCHED_BATCH },
+#endif
+#ifdef SCHED_IDLE
+		{ "idle", SCHED_IDLE },
+#endif
+		{ "fifo", SCHED_FIFO },
+		{ "rr", SCHED_RR },
+	};
+
+	if (strlen(sched) >= sizeof(mSched)) {
+		return false;
+	}
+
+	const char *const colon = strchr(sched, ':');
+	const size_t nameLength = colon == NULL ? strlen(sched) : (size_t)(colon - sched);
+	int priority = 0;
+	if (colon != NULL) {
+		char *end;
+		priority = strtol(colon + 1, &end, 10);
+		if (end == colon + 1 || *end != '\0') {
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < sizeof(policies)/sizeof(policies[0]); ++i) {
+		if (strlen(policies[i].name) != nameLength || strncmp(policies[i].name, sched, nameLength) != 0) {
+			continue;
+		}
+
+		if (policies[i].policy == SCHED_FIFO || policies[i].policy == SCHED_RR) {
+			if (priority < sched_get_priority_min(policies[i].policy) || priority > sched_get_priority_max(policies[i].policy)) {
+				return false;
+			}
+		} else if (priority < -20 || priority > 19) {
+			// A nice value
+			return false;
+		}
+
+		mPolicy = policies[i].policy;
+		mPriority = priority;
+		strcpy(mSched, sched);
+		return true;
+	}
+
+	return false;
+}
+
+bool ThreadPlacement::setCgroup(const char *const cgroup) {
+	if (strlen(cgroup) >= sizeof(mCgroup)) {
+		return false;
+	}
+	strcpy(mCgroup, cgroup);
+	return true;
+}
+
+void ThreadPlacement::apply() const {
+	if (hasCgroup()) {
+		// cgroup.procs moves every thread of the process, older v1 hierarchies only have tasks
+		char path[sizeof(mCgroup) + sizeof("/cgroup.procs")];
+		snprintf(path, sizeof(path), "%s/cgroup.procs", mCgroup);
+		FILE *file = fopen(path, "w");
+		if (file == NULL) {
+			snprintf(path, sizeof(path), "%s/tasks", mCgroup);
+			file = fopen(path, "w");
+		}
+		if (file == NULL || fprintf(file, "%d\n", getpid()) < 0 || fclose(file) != 0) {
+			logg->logError(__FILE__, __LINE__, "Unable to move gatord to the cgroup %s: %s", mCgroup, strerror(errno));
+			handleException();
+		}
+	}
+
+	if (hasCpus() && sched_setaffinity(0, sizeof(mCpuSet), &mCpuSet) != 0) {
+		logg->logError(__FILE__, __LINE__, "Unable to confine gatord to cpus %s: %s", mCpus, strerror(errno));
+		handleException();
+	}
+
+	if (hasSched()) {
+		struct sched_param param;
+		memset(&param, 0, sizeof(param));
+		if (mPolicy == SCHED_FIFO || mPolicy == SCHED_RR) {
+			param.sched_priority = mPriority;
+		}
+		if (sched_setscheduler(0, mPolicy, &param) != 0) {
+			logg->logError(__FILE__, __LINE__, "Unable to set the gatord scheduling policy %s: %s", mSched, strerror(errno));
+			handleException();
+		}
+		// Threads created afterwards inherit the nice value of the calling thread
+		if (mPolicy != SCHED_FIFO && mPolicy != SCHED_RR && setpriority(PRIO_PROCESS, 0, mPriority) != 0) {
+			logg->logError(__FILE__, __LINE__, "Unable to set the gatord nice value %i: %s", mPriority, strerror(errno));
+			handleException();
+		}
+	}
+
+	if (hasCpus() || hasSched() || hasCgroup()) {
+		logg->logMessage("%s(%s:%i): gatord placed on cpus '%s' sched '%s' cgroup '%s'", __FUNCTION__, __FILE__, __LINE__, mCpus, mSched, mCgroup);
+	}
+}
+
+void ThreadPlacement::writeCaptured(mxml_node_t *const captured) const {
+	if (!hasCpus() && !hasSched() && !hasCgroup()) {
+		return;
+	}
+
+	mxml_node_t *const daemon = mxmlNewElement(captured, "daemon");
+	if (hasCpus()) {
+		mxmlElementSetAttr(daemon, "cpus", mCpus);
+	}
+	if (hasSched()) {
+		mxmlElementSetAttr(daemon, "sched", mSched);
+	}
+	if (hasCgroup()) {
+		mxmlElementSetAttr(daemon, "cgroup", mCgroup);
+	}
+}
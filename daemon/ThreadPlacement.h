@@ -0,0 +1,53 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef THREADPLACEMENT_H
+#define THREADPLACEMENT_H
+
+#include <limits.h>
+#include <sched.h>
+
+#include "mxml/mxml.h"
+
+// Confines the threads of a capture to a set of housekeeping cpus, scheduling class and cgroup so that gatord's own work does not land on the cores being profiled.
+// It is applied to the child before any of the capture threads are created so they all inherit it; the kernel side sampling still covers every cpu
+class ThreadPlacement {
+public:
+	ThreadPlacement();
+
+	// cpus is a list like 0,2-3, sched is other, batch or idle with an optional :nice or fifo or rr with a :priority, cgroup is a cgroup directory
+	bool setCpus(const char *const cpus);
+	bool setSched(const char *const sched);
+	bool setCgroup(const char *const cgroup);
+
+	// Parses a cpu list like 0,2-3, returns false if it is malformed or empty
+	static bool parseCpus(const char *const cpus, cpu_set_t *const cpuSet);
+
+	bool hasCpus() const { return mCpus[0] != '\0'; }
+	bool hasSched() const { return mSched[0] != '\0'; }
+	bool hasCgroup() const { return mCgroup[0] != '\0'; }
+
+	// Applies the placement to the calling process
+	void apply() const;
+	// Records the placement in the captured xml so that the overhead can be attributed
+	void writeCaptured(mxml_node_t *const captured) const;
+
+private:
+	cpu_set_t mCpuSet;
+	int mPolicy;
+	int mPriority;
+	char mCpus[128];
+	char mSched[32];
+	char mCgroup[PATH_MAX];
+
+	// Intentionally unimplemented
+	ThreadPlacement(const ThreadPlacement &);
+	ThreadPlacement &operator=(const ThreadPlacement &);
+};
+
+#endif // THREADPLACEMENT_H
@@ -9,6 +9,7 @@
 #include "UserSpaceSource.h"
 
 #include <sys/prctl.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
 
 #include "Child.h"
@@ -20,7 +21,7 @@
 
 extern Child *child;
 
-UserSpaceSource::UserSpaceSource(sem_t *senderSem) : mBuffer(0, FRAME_BLOCK_COUNTER, gSessionData->mTotalBufferSize*1024*1024, senderSem) {
+UserSpaceSource::UserSpaceSource(sem_t *senderSem) : mBuffer(0, FRAME_BLOCK_COUNTER, gSessionData->bufferBudget.getUserSpaceSize(), senderSem), mMonotonicStarted(0), mTimerFd(-1) {
 }
 
 UserSpaceSource::~UserSpaceSource() {
@@ -30,25 +31,43 @@ bool UserSpaceSource::prepare() {
 	return true;
 }
 
-void UserSpaceSource::run() {
-	prctl(PR_SET_NAME, (unsigned long)&"gatord-counters", 0, 0, 0);
-
+void UserSpaceSource::waitForStart() {
 	gSessionData->hwmon.start();
 	gSessionData->fsDriver.start();
 
-	int64_t monotonic_started = 0;
-	while (monotonic_started <= 0) {
+	mMonotonicStarted = 0;
+	while (mMonotonicStarted <= 0) {
 		usleep(10);
 
-		if (DriverSource::readInt64Driver("/dev/gator/started", &monotonic_started) == -1) {
+		if (DriverSource::readInt64Driver("/dev/gator/started", &mMonotonicStarted) == -1) {
 			logg->logError(__FILE__, __LINE__, "Error reading gator driver start time");
 			handleException();
 		}
 	}
+}
+
+void UserSpaceSource::sample(const uint64_t currTime) {
+	if (mBuffer.eventHeader(currTime)) {
+		gSessionData->hwmon.read(&mBuffer);
+		gSessionData->fsDriver.read(&mBuffer);
+		// Only check after writing all counters so that time and corresponding counters appear in the same frame
+		mBuffer.check(currTime);
+	}
+
+	if (mBuffer.bytesAvailable() <= 0) {
+		logg->logMessage("One shot (counters)");
+		child->endSession();
+	}
+}
+
+void UserSpaceSource::run() {
+	prctl(PR_SET_NAME, (unsigned long)&"gatord-counters", 0, 0, 0);
+
+	waitForStart();
 
 	uint64_t next_time = 0;
 	while (gSessionData->mSessionIsActive) {
-		const uint64_t curr_time = getTime() - monotonic_started;
+		const uint64_t curr_time = getTime() - mMonotonicStarted;
 		// Sample ten times a second ignoring gSessionData->mSampleRate
 		next_time += NS_PER_S/10;//gSessionData->mSampleRate;
 		if (next_time < curr_time) {
@@ -56,17 +75,7 @@ void UserSpaceSource::run() {
 			next_time = curr_time;
 		}
 
-		if (mBuffer.eventHeader(curr_time)) {
-			gSessionData->hwmon.read(&mBuffer);
-			gSessionData->fsDriver.read(&mBuffer);
-			// Only check after writing all counters so that time and corresponding counters appear in the same frame
-			mBuffer.check(curr_time);
-		}
-
-		if (mBuffer.bytesAvailable() <= 0) {
-			logg->logMessage("One shot (counters)");
-			child->endSession();
-		}
+		sample(curr_time);
 
 		usleep((next_time - curr_time)/NS_PER_US);
 	}
@@ -74,6 +83,46 @@ void UserSpaceSource::run() {
 	mBuffer.setDone();
 }
 
+int UserSpaceSource::pollStart() {
+	waitForStart();
+
+	// Sample ten times a second, as in run, from a periodic timer
+	mTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+	struct itimerspec spec;
+	spec.it_interval.tv_sec = 0;
+	spec.it_interval.tv_nsec = NS_PER_S/10;
+	spec.it_value = spec.it_interval;
+	if (mTimerFd < 0 || timerfd_settime(mTimerFd, 0, &spec, NULL) != 0) {
+		logg->logError(__FILE__, __LINE__, "Unable to create the counters timer");
+		handleException();
+	}
+
+	sample(getTime() - mMonotonicStarted);
+
+	return mTimerFd;
+}
+
+void UserSpaceSource::poll() {
+	uint64_t expirations;
+	if (read(mTimerFd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+		return;
+	}
+	if (expirations > 1) {
+		logg->logMessage("Too slow, %lli timer expirations missed", expirations - 1);
+	}
+
+	sample(getTime() - mMonotonicStarted);
+}
+
+void UserSpaceSource::pollStop() {
+	mBuffer.setDone();
+
+	if (mTimerFd >= 0) {
+		close(mTimerFd);
+		mTimerFd = -1;
+	}
+}
+
 void UserSpaceSource::interrupt() {
 	// Do nothing
 }
@@ -27,8 +27,17 @@ public:
 	bool isDone();
 	void write(Sender *sender);
 
+	int pollStart();
+	void poll();
+	void pollStop();
+
 private:
+	void waitForStart();
+	void sample(const uint64_t currTime);
+
 	Buffer mBuffer;
+	int64_t mMonotonicStarted;
+	int mTimerFd;
 
 	// Intentionally unimplemented
 	UserSpaceSource(const UserSpaceSource &);
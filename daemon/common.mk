@@ -5,7 +5,7 @@
 # -Werror treats warnings as errors
 # -std=c++0x is the planned new c++ standard
 # -std=c++98 is the 1998 c++ standard
-CPPFLAGS += -O3 -Wall -fno-exceptions -pthread -MMD -DETCDIR=\"/etc\" -Ilibsensors
+CPPFLAGS += -O3 -Wall -fno-exceptions -pthread -MMD -DETCDIR=\"/etc\" -Ilibsensors -I../decode
 CXXFLAGS += -fno-rtti -Wextra # -Weffc++
 ifeq ($(WERROR),1)
 	CPPFLAGS += -Werror
@@ -15,7 +15,8 @@ LDFLAGS += -s
 LDLIBS += -lrt -lm -pthread
 TARGET = gatord
 C_SRC = $(wildcard mxml/*.c) $(wildcard libsensors/*.c)
-CXX_SRC = $(wildcard *.cpp)
+# The capture decoder is shared with libgatordecode
+CXX_SRC = $(wildcard *.cpp) $(wildcard ../decode/*.cpp)
 
 all: $(TARGET)
 
@@ -24,6 +25,7 @@ events.xml: events_header.xml $(wildcard events-*.xml) events_footer.xml
 
 include $(wildcard *.d)
 include $(wildcard mxml/*.d)
+include $(wildcard ../decode/*.d)
 
 EventsXML.cpp: events_xml.h
 ConfigurationXML.cpp: defaults_xml.h
@@ -49,4 +51,4 @@ escape: escape.c
 	gcc $^ -o $@
 
 clean:
-	rm -f *.d *.o mxml/*.d mxml/*.o libsensors/*.d libsensors/*.o $(TARGET) escape events.xml events_xml.h defaults_xml.h
+	rm -f *.d *.o mxml/*.d mxml/*.o libsensors/*.d libsensors/*.o ../decode/*.d ../decode/*.o $(TARGET) escape events.xml events_xml.h defaults_xml.h
@@ -8,6 +8,7 @@
 
 #include <arpa/inet.h>
 #include <fcntl.h>
+#include <getopt.h>
 #include <pthread.h>
 #include <sys/mman.h>
 #include <sys/mount.h>
@@ -21,6 +22,7 @@
 
 #include "Child.h"
 #include "EventsXML.h"
+#include "Hub.h"
 #include "KMod.h"
 #include "Logging.h"
 #include "Monitor.h"
@@ -42,10 +44,10 @@ static bool driverMountedAtStart = false;
 struct cmdline_t {
 	int port;
 	char* module;
+	// Comma separated host:port list of the targets captured by a hub, see Hub
+	char* hub;
 };
 
-#define DEFAULT_PORT 8080
-
 void cleanUp() {
 	if (shutdownFilesystem() == -1) {
 		logg->logMessage("Error shutting down gator filesystem");
@@ -332,10 +334,39 @@ static int shutdownFilesystem() {
 	return 0; // success
 }
 
+// Long only options, chosen to not collide with any short option
+enum {
+	OPTION_SUMMARY = 0x100,
+	OPTION_ARCHIVE,
+	OPTION_LIVE_DOWNSAMPLE,
+	OPTION_REACTOR,
+	OPTION_DAEMON_CPUS,
+	OPTION_DAEMON_SCHED,
+	OPTION_DAEMON_CGROUP,
+	OPTION_SPILL_DIR,
+	OPTION_SPILL_LIMIT,
+	OPTION_HUB,
+};
+
+static const struct option longOptions[] = {
+	{ "summary", required_argument, NULL, OPTION_SUMMARY },
+	{ "archive", required_argument, NULL, OPTION_ARCHIVE },
+	{ "live-downsample", required_argument, NULL, OPTION_LIVE_DOWNSAMPLE },
+	{ "reactor", no_argument, NULL, OPTION_REACTOR },
+	{ "daemon-cpus", required_argument, NULL, OPTION_DAEMON_CPUS },
+	{ "daemon-sched", required_argument, NULL, OPTION_DAEMON_SCHED },
+	{ "daemon-cgroup", required_argument, NULL, OPTION_DAEMON_CGROUP },
+	{ "spill-dir", required_argument, NULL, OPTION_SPILL_DIR },
+	{ "spill-limit", required_argument, NULL, OPTION_SPILL_LIMIT },
+	{ "hub", required_argument, NULL, OPTION_HUB },
+	{ NULL, 0, NULL, 0 },
+};
+
 static struct cmdline_t parseCommandLine(int argc, char** argv) {
 	struct cmdline_t cmdline;
 	cmdline.port = DEFAULT_PORT;
 	cmdline.module = NULL;
+	cmdline.hub = NULL;
 	char version_string[256]; // arbitrary length to hold the version information
 	int c;
 
@@ -346,7 +377,7 @@ static struct cmdline_t parseCommandLine(int argc, char** argv) {
 		snprintf(version_string, sizeof(version_string), "Streamline gatord development version %d", PROTOCOL_VERSION);
 	}
 
-	while ((c = getopt(argc, argv, "hvp:s:c:e:m:o:")) != -1) {
+	while ((c = getopt_long(argc, argv, "hvp:s:c:e:m:o:", longOptions, NULL)) != -1) {
 		switch(c) {
 			case 'c':
 				gSessionData->mConfigurationXMLPath = optarg;
@@ -366,6 +397,45 @@ static struct cmdline_t parseCommandLine(int argc, char** argv) {
 			case 'o':
 				gSessionData->mTargetPath = optarg;
 				break;
+			case OPTION_SUMMARY:
+				gSessionData->mSummaryPath = optarg;
+				break;
+			case OPTION_ARCHIVE:
+				gSessionData->mArchivePath = optarg;
+				break;
+			case OPTION_LIVE_DOWNSAMPLE:
+				gSessionData->mLiveDownsample = strtol(optarg, NULL, 10);
+				break;
+			case OPTION_REACTOR:
+				gSessionData->mReactor = true;
+				break;
+			case OPTION_DAEMON_CPUS:
+				if (!gSessionData->threadPlacement.setCpus(optarg)) {
+					logg->logError(__FILE__, __LINE__, "Invalid --daemon-cpus %s, expected a list like 0,2-3", optarg);
+					handleException();
+				}
+				break;
+			case OPTION_DAEMON_SCHED:
+				if (!gSessionData->threadPlacement.setSched(optarg)) {
+					logg->logError(__FILE__, __LINE__, "Invalid --daemon-sched %s, expected other, batch or idle with an optional :nice or fifo or rr with a :priority", optarg);
+					handleException();
+				}
+				break;
+			case OPTION_DAEMON_CGROUP:
+				if (!gSessionData->threadPlacement.setCgroup(optarg)) {
+					logg->logError(__FILE__, __LINE__, "Invalid --daemon-cgroup %s", optarg);
+					handleException();
+				}
+				break;
+			case OPTION_SPILL_DIR:
+				gSessionData->mSpillDir = optarg;
+				break;
+			case OPTION_SPILL_LIMIT:
+				gSessionData->mSpillLimit = strtol(optarg, NULL, 10);
+				break;
+			case OPTION_HUB:
+				cmdline.hub = optarg;
+				break;
 			case 'h':
 			case '?':
 				logg->logError(__FILE__, __LINE__,
@@ -377,6 +447,23 @@ static struct cmdline_t parseCommandLine(int argc, char** argv) {
 					"-p port_number  port upon which the server listens; default is 8080\n"
 					"-s session_xml  path and filename of a session xml used for local capture\n"
 					"-o apc_dir      path and name of the output for a local capture\n"
+					"--summary json  path and filename of a json summary of a local capture\n"
+					"--archive apc_dir\n"
+					"                path and name of a full resolution copy of a live capture\n"
+					"--live-downsample n\n"
+					"                send only one in n samples and counter values to Streamline\n"
+					"--reactor       run the capture sources from a single event loop instead of a thread each\n"
+					"--daemon-cpus list\n"
+					"                cpus to run gatord's capture threads on, eg 0 or 0,2-3\n"
+					"--daemon-sched policy[:priority]\n"
+					"                scheduling policy of gatord's capture threads: other, batch or idle with a nice value or fifo or rr with a priority\n"
+					"--daemon-cgroup dir\n"
+					"                cgroup directory to run gatord's capture threads in\n"
+					"--spill-dir dir directory to spill a live capture to when the connection stalls; default is /tmp\n"
+					"--spill-limit mb\n"
+					"                maximum size of the spilled data, 0 to block instead; default is 256\n"
+					"--hub host:port[,host:port...]\n"
+					"                capture the gatord on each target with the -s session xml into a time aligned capture per target in the -o directory\n"
 					"-v              version information\n"
 					, version_string);
 				handleException();
@@ -394,11 +481,36 @@ static struct cmdline_t parseCommandLine(int argc, char** argv) {
 		handleException();
 	}
 
+	if (cmdline.hub != NULL && (gSessionData->mSessionXMLPath == NULL || gSessionData->mTargetPath == NULL || gSessionData->mSummaryPath != NULL)) {
+		logg->logError(__FILE__, __LINE__, "--hub requires the -s and -o command line options and can't be used with --summary");
+		handleException();
+	}
+
 	if (gSessionData->mTargetPath != NULL && gSessionData->mSessionXMLPath == NULL) {
 		logg->logError(__FILE__, __LINE__, "Missing -s command line option required for a local capture.");
 		handleException();
 	}
 
+	if (gSessionData->mSummaryPath != NULL && gSessionData->mSessionXMLPath == NULL) {
+		logg->logError(__FILE__, __LINE__, "Missing -s command line option required for --summary.");
+		handleException();
+	}
+
+	if ((gSessionData->mArchivePath != NULL || gSessionData->mLiveDownsample != 1) && gSessionData->mSessionXMLPath != NULL) {
+		logg->logError(__FILE__, __LINE__, "--archive and --live-downsample are only used with a live capture, not with -s");
+		handleException();
+	}
+
+	if (gSessionData->mSpillLimit < 0) {
+		logg->logError(__FILE__, __LINE__, "--spill-limit must not be negative");
+		handleException();
+	}
+
+	if (gSessionData->mLiveDownsample < 1) {
+		logg->logError(__FILE__, __LINE__, "--live-downsample must be at least 1");
+		handleException();
+	}
+
 	if (optind < argc) {
 		logg->logError(__FILE__, __LINE__, "Unknown argument: %s. Use '-h' for help.", argv[optind]);
 		handleException();
@@ -474,6 +586,13 @@ int main(int argc, char** argv) {
 	// Parse the command line parameters
 	struct cmdline_t cmdline = parseCommandLine(argc, argv);
 
+	// A hub only talks to the gatord on the targets so it doesn't need root or a driver
+	if (cmdline.hub != NULL) {
+		Hub hub;
+		hub.run(cmdline.hub);
+		return 0;
+	}
+
 	// Verify root permissions
 	uid_t euid = geteuid();
 	if (euid) {
@@ -0,0 +1,825 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "GatorDecode.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Varint.h"
+
+// From Sender.h
+enum {
+	RESPONSE_APC_DATA = 3,
+};
+
+// Summary frame messages
+enum {
+	MESSAGE_SUMMARY = 1,
+	MESSAGE_CORE_NAME = 3,
+};
+
+// Backtrace frame messages
+enum {
+	MESSAGE_END_BACKTRACE = 1,
+};
+
+// Name frame messages
+enum {
+	MESSAGE_COOKIE = 1,
+	MESSAGE_THREAD_NAME = 2,
+	MESSAGE_LINK = 4,
+};
+
+// Sched trace frame messages
+enum {
+	MESSAGE_SCHED_SWITCH = 1,
+	MESSAGE_SCHED_EXIT = 2,
+};
+
+// Activity frame messages
+enum {
+	MESSAGE_SWITCH = 2,
+};
+
+// Perf attrs frame messages
+enum {
+	CODE_PEA      = 1,
+	CODE_KEYS     = 2,
+	CODE_FORMAT   = 3,
+	CODE_MAPS     = 4,
+	CODE_COMM     = 5,
+	CODE_KEYS_OLD = 6,
+	CODE_STRING   = 7,
+	CODE_COMM_ID  = 8,
+	CODE_MAPS_ID  = 9,
+};
+
+// Compact block counter frame keys and limits, must match Buffer::MAX_COMPACT_RECORDS and COMPACT_MAX_RECORDS in the driver
+enum {
+	COMPACT_KEY_RUN = -1,
+	MAX_COMPACT_RECORDS = 128,
+};
+
+// Number of values decoded at once from block counter frames
+static const int COUNTER_BATCH = 256;
+
+static int32_t readLEInt(const uint8_t *const buf) {
+	return (int32_t)(buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t)buf[3] << 24));
+}
+
+static uint64_t readLEInt64(const uint8_t *const buf) {
+	return (uint64_t)(uint32_t)readLEInt(buf) | ((uint64_t)(uint32_t)readLEInt(buf + 4) << 32);
+}
+
+// Reads the messages of a frame, once a read fails all further reads fail
+class DecodeReader {
+public:
+	DecodeReader(const uint8_t *const data, const int length) : mPos(data), mEnd(data + length), mOk(true) {}
+
+	bool more() const { return mOk && mPos < mEnd; }
+	bool ok() const { return mOk; }
+	const uint8_t *pos() const { return mPos; }
+
+	int64_t packed() {
+		int64_t value;
+		const int bytes = varintDecode(mPos, mEnd, &value);
+		if (bytes == 0) {
+			return fail();
+		}
+		mPos += bytes;
+		return value;
+	}
+
+	int packedInt() {
+		return (int)packed();
+	}
+
+	// A packed length followed by that many bytes
+	const char *string(int *const length) {
+		const int64_t len = packed();
+		if (!mOk || len < 0 || len > mEnd - mPos) {
+			fail();
+			*length = 0;
+			return NULL;
+		}
+		const char *const str = (const char *)mPos;
+		mPos += len;
+		*length = len;
+		return str;
+	}
+
+	// A NUL terminated string, length does not include the NUL
+	const char *cstring(int *const length) {
+		const uint8_t *const nul = mOk ? (const uint8_t *)memchr(mPos, '\0', mEnd - mPos) : NULL;
+		if (nul == NULL) {
+			fail();
+			*length = 0;
+			return NULL;
+		}
+		const char *const str = (const char *)mPos;
+		*length = nul - mPos;
+		mPos = nul + 1;
+		return str;
+	}
+
+	const uint8_t *bytes(const int64_t length) {
+		if (!mOk || length < 0 || length > mEnd - mPos) {
+			fail();
+			return NULL;
+		}
+		const uint8_t *const data = mPos;
+		mPos += length;
+		return data;
+	}
+
+	// Decodes up to count values at once, returns the number decoded
+	int batch(int64_t *const values, const int count) {
+		if (!mOk) {
+			return 0;
+		}
+		const int decoded = varintDecodeBatch(mPos, mEnd, values, count, &mPos);
+		if (decoded < count && mPos < mEnd) {
+			fail();
+		}
+		return decoded;
+	}
+
+	int64_t fail() {
+		mOk = false;
+		return 0;
+	}
+
+private:
+	const uint8_t *mPos;
+	const uint8_t *const mEnd;
+	bool mOk;
+};
+
+static bool decodeSummary(GatorDecodeHandler *const handler, const int core, DecodeReader &reader) {
+	while (reader.more()) {
+		const uint8_t *const start = reader.pos();
+		const int code = reader.packedInt();
+		if (code == MESSAGE_SUMMARY) {
+			int length;
+			reader.string(&length);
+			const int64_t timestamp = reader.packed();
+			const int64_t uptime = reader.packed();
+			const int64_t monotonicDelta = reader.packed();
+			if (!reader.ok()) {
+				return false;
+			}
+			handler->summary(timestamp, uptime, monotonicDelta);
+			for (;;) {
+				int keyLength, valueLength;
+				const char *const key = reader.string(&keyLength);
+				if (!reader.ok()) {
+					return false;
+				}
+				if (keyLength == 0) {
+					break;
+				}
+				const char *const value = reader.string(&valueLength);
+				if (!reader.ok()) {
+					return false;
+				}
+				handler->summaryAttr(key, keyLength, value, valueLength);
+			}
+		} else if (code == MESSAGE_CORE_NAME) {
+			const int nameCore = reader.packedInt();
+			const int cpuid = reader.packedInt();
+			int length;
+			const char *const name = reader.string(&length);
+			if (!reader.ok()) {
+				return false;
+			}
+			handler->coreName(nameCore, cpuid, name, length);
+		} else {
+			return false;
+		}
+		handler->message(GATOR_FRAME_SUMMARY, core, start, reader.pos() - start);
+	}
+	return reader.ok();
+}
+
+static bool decodeBacktrace(GatorDecodeHandler *const handler, const int core, DecodeReader &reader) {
+	while (reader.more()) {
+		const int64_t time = reader.packed();
+		const int execCookie = reader.packedInt();
+		const int tgid = reader.packedInt();
+		const int pid = reader.packedInt();
+		if (!reader.ok()) {
+			return false;
+		}
+		handler->backtrace(core, time, execCookie, tgid, pid);
+		for (;;) {
+			const int cookie = reader.packedInt();
+			if (!reader.ok()) {
+				return false;
+			}
+			if (cookie == MESSAGE_END_BACKTRACE) {
+				break;
+			}
+			const int64_t address = reader.packed();
+			if (!reader.ok()) {
+				return false;
+			}
+			handler->backtraceAddress(core, cookie, address);
+		}
+	}
+	return reader.ok();
+}
+
+static bool decodeName(GatorDecodeHandler *const handler, const int core, DecodeReader &reader) {
+	while (reader.more()) {
+		const uint8_t *const start = reader.pos();
+		const int code = reader.packedInt();
+		if (code == MESSAGE_COOKIE) {
+			const int cookie = reader.packedInt();
+			int length;
+			const char *const name = reader.string(&length);
+			if (!reader.ok()) {
+				return false;
+			}
+			handler->cookie(core, cookie, name, length);
+		} else if (code == MESSAGE_THREAD_NAME) {
+			const int64_t time = reader.packed();
+			const int pid = reader.packedInt();
+			int length;
+			const char *const name = reader.string(&length);
+			if (!reader.ok()) {
+				return false;
+			}
+			handler->threadName(core, time, pid, name, length);
+		} else if (code == MESSAGE_LINK) {
+			const int64_t time = reader.packed();
+			const int cookie = reader.packedInt();
+			const int tgid = reader.packedInt();
+			const int pid = reader.packedInt();
+			if (!reader.ok()) {
+				return false;
+			}
+			handler->link(core, time, cookie, tgid, pid);
+		} else {
+			return false;
+		}
+		handler->message(GATOR_FRAME_NAME, core, start, reader.pos() - start);
+	}
+	return reader.ok();
+}
+
+static bool decodeCounter(GatorDecodeHandler *const handler, DecodeReader &reader) {
+	while (reader.more()) {
+		const int64_t time = reader.packed();
+		const int core = reader.packedInt();
+		const int key = reader.packedInt();
+		const int64_t value = reader.packed();
+		if (!reader.ok()) {
+			return false;
+		}
+		handler->counter(core, time, key, value);
+	}
+	return reader.ok();
+}
+
+// Expands the records of a compact block counter frame, see Buffer::compactEvent
+class DecodeCompactState {
+public:
+	DecodeCompactState() : mPrevCount(0), mCurrCount(0) {}
+
+	void timestamp() {
+		const int count = mCurrCount < MAX_COMPACT_RECORDS ? mCurrCount : MAX_COMPACT_RECORDS;
+		memcpy(mPrevKeys, mCurrKeys, count * sizeof(mPrevKeys[0]));
+		memcpy(mPrevValues, mCurrValues, count * sizeof(mPrevValues[0]));
+		mPrevCount = count;
+		mCurrCount = 0;
+	}
+
+	int64_t event(const int key, const int64_t value) {
+		const int pos = mCurrCount++;
+		const int64_t result = (pos < mPrevCount && mPrevKeys[pos] == key) ? mPrevValues[pos] + value : value;
+		store(pos, key, result);
+		return result;
+	}
+
+	// Returns false if there is no previous record at this position
+	bool repeat(int *const key, int64_t *const value) {
+		const int pos = mCurrCount++;
+		if (pos >= mPrevCount) {
+			return false;
+		}
+		*key = mPrevKeys[pos];
+		*value = mPrevValues[pos];
+		store(pos, *key, *value);
+		return true;
+	}
+
+private:
+	void store(const int pos, const int key, const int64_t value) {
+		if (pos < MAX_COMPACT_RECORDS) {
+			mCurrKeys[pos] = key;
+			mCurrValues[pos] = value;
+		}
+	}
+
+	int mPrevCount;
+	int mCurrCount;
+	int mPrevKeys[MAX_COMPACT_RECORDS];
+	int64_t mPrevValues[MAX_COMPACT_RECORDS];
+	int mCurrKeys[MAX_COMPACT_RECORDS];
+	int64_t mCurrValues[MAX_COMPACT_RECORDS];
+};
+
+// Block counter frames are nothing but packed ints so decode them in batches
+static bool decodeBlockCounter(GatorDecodeHandler *const handler, const int core, const bool compact, DecodeReader &reader) {
+	int64_t values[COUNTER_BATCH];
+	GatorCounter records[COUNTER_BATCH];
+	DecodeCompactState state;
+	int64_t time = 0;
+	int64_t key = 0;
+	bool haveKey = false;
+
+	while (reader.more()) {
+		const int count = reader.batch(values, COUNTER_BATCH);
+		int recordCount = 0;
+		for (int i = 0; i < count; ++i) {
+			if (!haveKey) {
+				key = values[i];
+				haveKey = true;
+				continue;
+			}
+			haveKey = false;
+			const int64_t value = values[i];
+
+			if (key == 0) {
+				if (compact) {
+					time += value;
+					state.timestamp();
+				} else {
+					time = value;
+				}
+			} else if (!compact) {
+				GatorCounter &record = records[recordCount++];
+				record.time = time;
+				record.key = key;
+				record.value = value;
+			} else if (key == COMPACT_KEY_RUN) {
+				for (int64_t run = 0; run < value; ++run) {
+					if (recordCount == COUNTER_BATCH) {
+						handler->counters(core, records, recordCount);
+						recordCount = 0;
+					}
+					GatorCounter &record = records[recordCount++];
+					record.time = time;
+					if (!state.repeat(&record.key, &record.value)) {
+						handler->counters(core, records, recordCount - 1);
+						return false;
+					}
+				}
+			} else {
+				GatorCounter &record = records[recordCount++];
+				record.time = time;
+				record.key = key;
+				record.value = state.event(key, value);
+			}
+
+			if (recordCount == COUNTER_BATCH) {
+				handler->counters(core, records, recordCount);
+				recordCount = 0;
+			}
+		}
+		if (recordCount > 0) {
+			handler->counters(core, records, recordCount);
+		}
+	}
+
+	return reader.ok() && !haveKey;
+}
+
+static bool decodeAnnotate(GatorDecodeHandler *const handler, DecodeReader &reader) {
+	while (reader.more()) {
+		const int core = reader.packedInt();
+		const int pid = reader.packedInt();
+		const int64_t time = reader.packed();
+		const int size = reader.packedInt();
+		const uint8_t *const data = reader.bytes(size);
+		if (!reader.ok()) {
+			return false;
+		}
+		handler->annotate(core, pid, time, data, size);
+	}
+	return reader.ok();
+}
+
+static bool decodeSchedTrace(GatorDecodeHandler *const handler, const int core, DecodeReader &reader) {
+	while (reader.more()) {
+		const int code = reader.packedInt();
+		if (code == MESSAGE_SCHED_SWITCH) {
+			const int64_t time = reader.packed();
+			const int pid = reader.packedInt();
+			const int state = reader.packedInt();
+			if (!reader.ok()) {
+				return false;
+			}
+			handler->schedSwitch(core, time, pid, state);
+		} else if (code == MESSAGE_SCHED_EXIT) {
+			const int64_t time = reader.packed();
+			const int pid = reader.packedInt();
+			if (!reader.ok()) {
+				return false;
+			}
+			handler->schedExit(core, time, pid);
+		} else {
+			return false;
+		}
+	}
+	return reader.ok();
+}
+
+static bool decodeIdle(GatorDecodeHandler *const handler, DecodeReader &reader) {
+	while (reader.more()) {
+		const int state = reader.packedInt();
+		const int64_t time = reader.packed();
+		const int core = reader.packedInt();
+		if (!reader.ok()) {
+			return false;
+		}
+		handler->idle(core, time, state);
+	}
+	return reader.ok();
+}
+
+static bool decodeExternal(GatorDecodeHandler *const handler, DecodeReader &reader) {
+	while (reader.more()) {
+		const int fd = reader.packedInt();
+		const uint8_t *const lengthBuf = reader.bytes(sizeof(int32_t));
+		if (!reader.ok()) {
+			return false;
+		}
+		const int length = readLEInt(lengthBuf);
+		const uint8_t *const data = length > 0 ? reader.bytes(length) : NULL;
+		if (!reader.ok()) {
+			return false;
+		}
+		handler->external(fd, data, length);
+	}
+	return reader.ok();
+}
+
+static bool decodePerfAttrs(GatorDecodeHandler *const handler, const int core, DecodeReader &reader) {
+	while (reader.more()) {
+		const uint8_t *const start = reader.pos();
+		const int code = reader.packedInt();
+		switch (code) {
+		case CODE_PEA: {
+			// perf_event_attr.size is the __u32 following the __u32 type
+			const uint8_t *const header = reader.bytes(2 * sizeof(uint32_t));
+			if (!reader.ok()) {
+				return false;
+			}
+			const int size = readLEInt(header + sizeof(uint32_t));
+			reader.bytes(size - 2 * sizeof(uint32_t));
+			const int key = reader.packedInt();
+			if (!reader.ok()) {
+				return false;
+			}
+			handler->pea(core, header, size, key);
+			break;
+		}
+		case CODE_KEYS: {
+			const int count = reader.packedInt();
+			for (int i = 0; i < count && reader.ok(); ++i) {
+				const uint64_t id = reader.packed();
+				const int key = reader.packedInt();
+				if (reader.ok()) {
+					handler->key(core, id, key);
+				}
+			}
+			break;
+		}
+		case CODE_FORMAT: {
+			int length;
+			const char *const format = reader.cstring(&length);
+			if (reader.ok()) {
+				handler->format(core, format, length);
+			}
+			break;
+		}
+		case CODE_MAPS: {
+			const int pid = reader.packedInt();
+			const int tid = reader.packedInt();
+			int length;
+			const char *const maps = reader.cstring(&length);
+			if (reader.ok()) {
+				handler->maps(core, pid, tid, maps, length);
+			}
+			break;
+		}
+		case CODE_COMM: {
+			const int pid = reader.packedInt();
+			const int tid = reader.packedInt();
+			int imageLength, commLength;
+			const char *const image = reader.cstring(&imageLength);
+			const char *const comm = reader.cstring(&commLength);
+			if (reader.ok()) {
+				handler->comm(core, pid, tid, image, imageLength, comm, commLength);
+			}
+			break;
+		}
+		case CODE_KEYS_OLD: {
+			const int keyCount = reader.packedInt();
+			if (!reader.ok() || keyCount < 0 || keyCount > 1024) {
+				return false;
+			}
+			int keys[1024];
+			for (int i = 0; i < keyCount; ++i) {
+				keys[i] = reader.packedInt();
+			}
+			// The read buffer is not length prefixed but starts with the number of values
+			const uint8_t *const nr = reader.bytes(sizeof(uint64_t));
+			if (!reader.ok()) {
+				return false;
+			}
+			const uint64_t values = readLEInt64(nr);
+			if (values > 1024) {
+				return false;
+			}
+			const int length = sizeof(uint64_t) + values * 2 * sizeof(uint64_t);
+			reader.bytes(length - sizeof(uint64_t));
+			if (reader.ok()) {
+				handler->keysOld(core, keys, keyCount, nr, length);
+			}
+			break;
+		}
+		case CODE_STRING: {
+			const int id = reader.packedInt();
+			int length;
+			const char *const str = reader.cstring(&length);
+			if (reader.ok()) {
+				handler->internedString(core, id, str, length);
+			}
+			break;
+		}
+		case CODE_COMM_ID: {
+			const int pid = reader.packedInt();
+			const int tid = reader.packedInt();
+			const int imageId = reader.packedInt();
+			const int commId = reader.packedInt();
+			if (reader.ok()) {
+				handler->commId(core, pid, tid, imageId, commId);
+			}
+			break;
+		}
+		case CODE_MAPS_ID: {
+			const int pid = reader.packedInt();
+			const int tid = reader.packedInt();
+			const int count = reader.packedInt();
+			for (int i = 0; i < count && reader.ok(); ++i) {
+				const uint64_t start = reader.packed();
+				const uint64_t end = reader.packed();
+				const uint64_t offset = reader.packed();
+				const int flags = reader.packedInt();
+				const int pathId = reader.packedInt();
+				if (reader.ok()) {
+					handler->mapping(core, pid, tid, start, end, offset, flags, pathId);
+				}
+			}
+			break;
+		}
+		default:
+			return false;
+		}
+		if (reader.ok()) {
+			handler->message(GATOR_FRAME_PERF_ATTRS, core, start, reader.pos() - start);
+		}
+	}
+	return reader.ok();
+}
+
+static bool decodeActivity(GatorDecodeHandler *const handler, DecodeReader &reader) {
+	while (reader.more()) {
+		const int code = reader.packedInt();
+		if (code != MESSAGE_SWITCH) {
+			return false;
+		}
+		const int64_t time = reader.packed();
+		const int core = reader.packedInt();
+		const int key = reader.packedInt();
+		const int activity = reader.packedInt();
+		const int pid = reader.packedInt();
+		const int state = reader.packedInt();
+		if (!reader.ok()) {
+			return false;
+		}
+		handler->activitySwitch(core, time, key, activity, pid, state);
+	}
+	return reader.ok();
+}
+
+bool GatorDecoder::decodeFrame(GatorDecodeHandler *const handler, const uint8_t *const payload, const int length, const int64_t offset) {
+	DecodeReader reader(payload, length);
+	const int type = reader.packedInt();
+	int core;
+	if (type == GATOR_FRAME_PERF) {
+		// PerfBuffer writes the cpu as a raw byte
+		const uint8_t *const cpu = reader.bytes(1);
+		core = cpu != NULL ? *cpu : 0;
+	} else {
+		core = reader.packedInt();
+	}
+	if (!reader.ok()) {
+		handler->error("Truncated frame header", offset);
+		return false;
+	}
+
+	handler->frame(type, core, payload, length);
+
+	bool result;
+	switch (type) {
+	case GATOR_FRAME_SUMMARY:
+		result = decodeSummary(handler, core, reader);
+		break;
+	case GATOR_FRAME_BACKTRACE:
+		result = decodeBacktrace(handler, core, reader);
+		break;
+	case GATOR_FRAME_NAME:
+		result = decodeName(handler, core, reader);
+		break;
+	case GATOR_FRAME_COUNTER:
+		result = decodeCounter(handler, reader);
+		break;
+	case GATOR_FRAME_BLOCK_COUNTER:
+		result = decodeBlockCounter(handler, core, false, reader);
+		break;
+	case GATOR_FRAME_BLOCK_COUNTER_COMPACT:
+		result = decodeBlockCounter(handler, core, true, reader);
+		break;
+	case GATOR_FRAME_ANNOTATE:
+		result = decodeAnnotate(handler, reader);
+		break;
+	case GATOR_FRAME_SCHED_TRACE:
+		result = decodeSchedTrace(handler, core, reader);
+		break;
+	case GATOR_FRAME_IDLE:
+		result = decodeIdle(handler, reader);
+		break;
+	case GATOR_FRAME_EXTERNAL:
+		result = decodeExternal(handler, reader);
+		break;
+	case GATOR_FRAME_PERF_ATTRS:
+		result = decodePerfAttrs(handler, core, reader);
+		break;
+	case GATOR_FRAME_PERF: {
+		const uint8_t *const data = reader.pos();
+		handler->perf(core, data, length - (data - payload));
+		result = true;
+		break;
+	}
+	case GATOR_FRAME_ACTIVITY:
+		result = decodeActivity(handler, reader);
+		break;
+	default:
+		// Unknown frames are skipped
+		result = true;
+		break;
+	}
+
+	if (!result) {
+		handler->error("Invalid message", offset + (reader.pos() - payload));
+	}
+	return result;
+}
+
+// Returns the size of the frame at data including the header, 0 if it is incomplete or -1 if it is corrupt
+static int64_t frameSize(const uint8_t *const data, const int64_t length, const bool hasResponseType, int *const headerSize) {
+	*headerSize = (hasResponseType ? 1 : 0) + sizeof(int32_t);
+	if (length < *headerSize) {
+		return 0;
+	}
+	const int32_t frameLength = readLEInt(data + *headerSize - sizeof(int32_t));
+	if (frameLength < 0) {
+		return -1;
+	}
+	if (length - *headerSize < frameLength) {
+		return 0;
+	}
+	return *headerSize + frameLength;
+}
+
+static int64_t decodeFrames(GatorDecodeHandler *const handler, const bool hasResponseType, const uint8_t *const data, const int64_t length, const int64_t offset) {
+	int64_t pos = 0;
+	while (pos < length) {
+		int headerSize;
+		const int64_t size = frameSize(data + pos, length - pos, hasResponseType, &headerSize);
+		if (size < 0) {
+			handler->error("Invalid frame length", offset + pos);
+			return -1;
+		}
+		if (size == 0) {
+			break;
+		}
+		// Only APC_DATA responses contain frames, the end of capture response has no payload
+		if ((!hasResponseType || data[pos] == RESPONSE_APC_DATA) && size > headerSize) {
+			GatorDecoder::decodeFrame(handler, data + pos + headerSize, size - headerSize, offset + pos + headerSize);
+		}
+		pos += size;
+	}
+	return pos;
+}
+
+int64_t GatorDecoder::decode(const uint8_t *const data, const int64_t length) {
+	const int64_t result = decodeFrames(mHandler, mHasResponseType, data, length, mOffset);
+	if (result > 0) {
+		mOffset += result;
+	}
+	return result;
+}
+
+struct DecodeJob {
+	GatorDecodeHandler *handler;
+	const uint8_t *data;
+	int64_t length;
+	int64_t offset;
+	bool hasResponseType;
+	bool ok;
+};
+
+static void *decodeThread(void *arg) {
+	DecodeJob *const job = (DecodeJob *)arg;
+	job->ok = decodeFrames(job->handler, job->hasResponseType, job->data, job->length, job->offset) == job->length;
+	return NULL;
+}
+
+bool gatorDecodeParallel(const uint8_t *const data, const int64_t length, const bool hasResponseType, GatorDecodeHandler *const *const handlers, const int threadCount) {
+	if (threadCount <= 0) {
+		return false;
+	}
+
+	DecodeJob *const jobs = (DecodeJob *)calloc(threadCount, sizeof(DecodeJob));
+	pthread_t *const threads = (pthread_t *)calloc(threadCount, sizeof(pthread_t));
+	bool *const started = (bool *)calloc(threadCount, sizeof(bool));
+	if (jobs == NULL || threads == NULL || started == NULL) {
+		free(jobs);
+		free(threads);
+		free(started);
+		return false;
+	}
+
+	// Only the frame lengths are read to find the split points, so this pass is cheap compared to decoding
+	bool ok = true;
+	int job = 0;
+	int64_t pos = 0;
+	while (pos < length) {
+		if (job + 1 < threadCount && pos >= (job + 1) * (length / threadCount)) {
+			jobs[++job].offset = pos;
+		}
+		int headerSize;
+		const int64_t size = frameSize(data + pos, length - pos, hasResponseType, &headerSize);
+		if (size < 0) {
+			ok = false;
+		}
+		if (size <= 0) {
+			// A trailing partial frame, as left by an interrupted capture, is ignored
+			break;
+		}
+		pos += size;
+	}
+	while (job + 1 < threadCount) {
+		jobs[++job].offset = pos;
+	}
+
+	for (int i = 0; i < threadCount; ++i) {
+		jobs[i].handler = handlers[i];
+		jobs[i].data = data + jobs[i].offset;
+		jobs[i].length = (i + 1 < threadCount ? jobs[i + 1].offset : pos) - jobs[i].offset;
+		jobs[i].hasResponseType = hasResponseType;
+	}
+
+	// Run the first job on this thread and any that could not be given a thread of their own
+	for (int i = 1; i < threadCount; ++i) {
+		started[i] = pthread_create(&threads[i], NULL, decodeThread, &jobs[i]) == 0;
+	}
+	decodeThread(&jobs[0]);
+	for (int i = 1; i < threadCount; ++i) {
+		if (started[i]) {
+			pthread_join(threads[i], NULL);
+		} else {
+			decodeThread(&jobs[i]);
+		}
+	}
+
+	for (int i = 0; i < threadCount; ++i) {
+		ok = ok && jobs[i].ok;
+	}
+
+	free(jobs);
+	free(threads);
+	free(started);
+	return ok;
+}
@@ -0,0 +1,141 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef GATORDECODE_H
+#define GATORDECODE_H
+
+#include <stdint.h>
+
+// Decoder for the APC_DATA frames written by the gator daemon (Buffer, PerfBuffer) and the gator driver (gator_marshaling.c)
+// A frame is [response type][LE32 length][packed frame type][packed core][messages] where the response type is only present when streaming
+
+enum {
+	GATOR_FRAME_SUMMARY       =  1,
+	GATOR_FRAME_BACKTRACE     =  2,
+	GATOR_FRAME_NAME          =  3,
+	GATOR_FRAME_COUNTER       =  4,
+	GATOR_FRAME_BLOCK_COUNTER =  5,
+	GATOR_FRAME_ANNOTATE      =  6,
+	GATOR_FRAME_SCHED_TRACE   =  7,
+	GATOR_FRAME_IDLE          =  9,
+	GATOR_FRAME_EXTERNAL      = 10,
+	GATOR_FRAME_PERF_ATTRS    = 11,
+	GATOR_FRAME_PERF          = 12,
+	GATOR_FRAME_ACTIVITY      = 13,
+	GATOR_FRAME_BLOCK_COUNTER_COMPACT = 14,
+};
+
+// Block counter key 0 is a timestamp and is never passed to the handler, key 1 marks the tid that following thread specific counters belong to
+enum {
+	GATOR_KEY_TID = 1,
+};
+
+struct GatorCounter {
+	int64_t time;
+	int64_t value;
+	int key;
+};
+
+// Receives the decoded messages, override the functions of interest. Strings are not NUL terminated unless noted, the strings of the perf attrs frame are.
+// A handler is only called from one thread at a time, but with gatorDecodeParallel each thread has its own handler
+class GatorDecodeHandler {
+public:
+	virtual ~GatorDecodeHandler() {}
+
+	// Called for every frame before its messages, including frames of an unknown type which are otherwise skipped
+	virtual void frame(int /*type*/, int /*core*/, const uint8_t * /*payload*/, int /*length*/) {}
+	// Called with a description of the problem when a frame can not be decoded, the rest of that frame is skipped
+	virtual void error(const char * /*message*/, int64_t /*offset*/) {}
+	// Called with the encoded bytes of each message of the summary, name and perf attrs frames after the callback for its contents
+	virtual void message(int /*type*/, int /*core*/, const uint8_t * /*data*/, int /*length*/) {}
+
+	// Summary frame
+	virtual void summary(int64_t /*timestamp*/, int64_t /*uptime*/, int64_t /*monotonicDelta*/) {}
+	virtual void summaryAttr(const char * /*key*/, int /*keyLength*/, const char * /*value*/, int /*valueLength*/) {}
+	virtual void coreName(int /*core*/, int /*cpuid*/, const char * /*name*/, int /*length*/) {}
+
+	// Backtrace frame
+	virtual void backtrace(int /*core*/, int64_t /*time*/, int /*execCookie*/, int /*tgid*/, int /*pid*/) {}
+	virtual void backtraceAddress(int /*core*/, int /*cookie*/, int64_t /*address*/) {}
+
+	// Name frame
+	virtual void cookie(int /*core*/, int /*cookie*/, const char * /*name*/, int /*length*/) {}
+	virtual void threadName(int /*core*/, int64_t /*time*/, int /*pid*/, const char * /*name*/, int /*length*/) {}
+	virtual void link(int /*core*/, int64_t /*time*/, int /*cookie*/, int /*tgid*/, int /*pid*/) {}
+
+	// Counter, block counter and compact block counter frames. Compact frames are expanded so are indistinguishable from block counter frames
+	virtual void counter(int /*core*/, int64_t /*time*/, int /*key*/, int64_t /*value*/) {}
+	// Called with batches of block counter records, by default passes each to counter
+	virtual void counters(int core, const GatorCounter *const records, int count) {
+		for (int i = 0; i < count; ++i) {
+			counter(core, records[i].time, records[i].key, records[i].value);
+		}
+	}
+
+	// Annotate frame
+	virtual void annotate(int /*core*/, int /*pid*/, int64_t /*time*/, const uint8_t * /*data*/, int /*length*/) {}
+
+	// Sched trace frame
+	virtual void schedSwitch(int /*core*/, int64_t /*time*/, int /*pid*/, int /*state*/) {}
+	virtual void schedExit(int /*core*/, int64_t /*time*/, int /*pid*/) {}
+
+	// Idle frame
+	virtual void idle(int /*core*/, int64_t /*time*/, int /*state*/) {}
+
+	// Activity frame
+	virtual void activitySwitch(int /*core*/, int64_t /*time*/, int /*key*/, int /*activity*/, int /*pid*/, int /*state*/) {}
+
+	// External frame, length is 0 for a closed connection and -1 for a failed read
+	virtual void external(int /*fd*/, const uint8_t * /*data*/, int /*length*/) {}
+
+	// Perf attrs frame
+	virtual void pea(int /*core*/, const uint8_t * /*attr*/, int /*size*/, int /*key*/) {}
+	virtual void key(int /*core*/, uint64_t /*id*/, int /*key*/) {}
+	// data is the result of read on a PERF_FORMAT_ID | PERF_FORMAT_GROUP event, { u64 nr; { u64 value; u64 id; } values[nr]; }
+	virtual void keysOld(int /*core*/, const int * /*keys*/, int /*keyCount*/, const uint8_t * /*data*/, int /*length*/) {}
+	virtual void format(int /*core*/, const char * /*format*/, int /*length*/) {}
+	virtual void maps(int /*core*/, int /*pid*/, int /*tid*/, const char * /*maps*/, int /*length*/) {}
+	virtual void comm(int /*core*/, int /*pid*/, int /*tid*/, const char * /*image*/, int /*imageLength*/, const char * /*comm*/, int /*commLength*/) {}
+	// Interned strings, an id is the same string throughout the capture. Each frame source defines an id before its first use of it but with gatorDecodeParallel
+	// the definition may be in the run of an earlier handler, so ids used before they are defined must be resolved once every handler is done
+	virtual void internedString(int /*core*/, int /*id*/, const char * /*str*/, int /*length*/) {}
+	virtual void commId(int /*core*/, int /*pid*/, int /*tid*/, int /*imageId*/, int /*commId*/) {}
+	virtual void mapping(int /*core*/, int /*pid*/, int /*tid*/, uint64_t /*start*/, uint64_t /*end*/, uint64_t /*offset*/, int /*flags*/, int /*pathId*/) {}
+
+	// Perf frame, the raw contents of the perf ring buffer for cpu
+	virtual void perf(int /*cpu*/, const uint8_t * /*data*/, int /*length*/) {}
+};
+
+class GatorDecoder {
+public:
+	// hasResponseType is set for data read from a Streamline connection and clear for the 0000000000 file of a local capture
+	GatorDecoder(GatorDecodeHandler *const handler, const bool hasResponseType) : mHandler(handler), mHasResponseType(hasResponseType), mOffset(0) {}
+
+	// Decodes the whole frames in data and returns the number of bytes used, any remaining bytes are the start of a frame and must be passed again with the following data.
+	// Returns -1 if the framing itself is corrupt
+	int64_t decode(const uint8_t *const data, const int64_t length);
+
+	// Decodes the payload of a single frame, starting with the frame type. Returns false if it could not be decoded
+	static bool decodeFrame(GatorDecodeHandler *const handler, const uint8_t *const payload, const int length, const int64_t offset = 0);
+
+private:
+	GatorDecodeHandler *const mHandler;
+	const bool mHasResponseType;
+	// Offset of data in the stream, only used to report errors
+	int64_t mOffset;
+
+	// Intentionally unimplemented
+	GatorDecoder(const GatorDecoder &);
+	GatorDecoder &operator=(const GatorDecoder &);
+};
+
+// Decodes a complete capture using threadCount threads. Frames are independent so the data is split into threadCount runs of consecutive frames of roughly
+// equal size and handlers[i] receives the frames of the i'th run. Returns false if the framing is corrupt
+bool gatorDecodeParallel(const uint8_t *const data, const int64_t length, const bool hasResponseType, GatorDecodeHandler *const *const handlers, const int threadCount);
+
+#endif // GATORDECODE_H
@@ -0,0 +1,270 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include "Varint.h"
+
+// Entry i is for the 8 bytes whose bit j of i is set if byte j ends a value. For the k'th value that ends in them, shifts[2*k] is 64 minus the bit after it
+// in the gathered 7-bit groups and shifts[2*k + 1] is 64 minus its width in bits. The unused shifts are zero
+const VarintShape VARINT_SHAPES[256] = {
+	{ 0, 0, { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 1, 1, { 57, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 1, 2, { 50, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 2, { 57, 57, 50, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 1, 3, { 43, 43, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 3, { 57, 57, 43, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 3, { 50, 50, 43, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 3, { 57, 57, 50, 57, 43, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 1, 4, { 36, 36, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 4, { 57, 57, 36, 43, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 4, { 50, 50, 36, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 4, { 57, 57, 50, 57, 36, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 4, { 43, 43, 36, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 4, { 57, 57, 43, 50, 36, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 4, { 50, 50, 43, 57, 36, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 4, { 57, 57, 50, 57, 43, 57, 36, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 1, 5, { 29, 29, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 5, { 57, 57, 29, 36, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 5, { 50, 50, 29, 43, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 5, { 57, 57, 50, 57, 29, 43, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 5, { 43, 43, 29, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 5, { 57, 57, 43, 50, 29, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 5, { 50, 50, 43, 57, 29, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 5, { 57, 57, 50, 57, 43, 57, 29, 50, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 5, { 36, 36, 29, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 5, { 57, 57, 36, 43, 29, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 5, { 50, 50, 36, 50, 29, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 5, { 57, 57, 50, 57, 36, 50, 29, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 5, { 43, 43, 36, 57, 29, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 5, { 57, 57, 43, 50, 36, 57, 29, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 5, { 50, 50, 43, 57, 36, 57, 29, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 5, { 57, 57, 50, 57, 43, 57, 36, 57, 29, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 1, 6, { 22, 22, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 6, { 57, 57, 22, 29, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 6, { 50, 50, 22, 36, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 6, { 57, 57, 50, 57, 22, 36, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 6, { 43, 43, 22, 43, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 6, { 57, 57, 43, 50, 22, 43, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 6, { 50, 50, 43, 57, 22, 43, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 6, { 57, 57, 50, 57, 43, 57, 22, 43, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 6, { 36, 36, 22, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 6, { 57, 57, 36, 43, 22, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 6, { 50, 50, 36, 50, 22, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 6, { 57, 57, 50, 57, 36, 50, 22, 50, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 6, { 43, 43, 36, 57, 22, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 6, { 57, 57, 43, 50, 36, 57, 22, 50, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 6, { 50, 50, 43, 57, 36, 57, 22, 50, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 6, { 57, 57, 50, 57, 43, 57, 36, 57, 22, 50, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 6, { 29, 29, 22, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 6, { 57, 57, 29, 36, 22, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 6, { 50, 50, 29, 43, 22, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 6, { 57, 57, 50, 57, 29, 43, 22, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 6, { 43, 43, 29, 50, 22, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 6, { 57, 57, 43, 50, 29, 50, 22, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 6, { 50, 50, 43, 57, 29, 50, 22, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 6, { 57, 57, 50, 57, 43, 57, 29, 50, 22, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 6, { 36, 36, 29, 57, 22, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 6, { 57, 57, 36, 43, 29, 57, 22, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 6, { 50, 50, 36, 50, 29, 57, 22, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 6, { 57, 57, 50, 57, 36, 50, 29, 57, 22, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 6, { 43, 43, 36, 57, 29, 57, 22, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 6, { 57, 57, 43, 50, 36, 57, 29, 57, 22, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 6, { 50, 50, 43, 57, 36, 57, 29, 57, 22, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 6, 6, { 57, 57, 50, 57, 43, 57, 36, 57, 29, 57, 22, 57, 0, 0, 0, 0 } },
+	{ 1, 7, { 15, 15, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 7, { 57, 57, 15, 22, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 7, { 50, 50, 15, 29, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 7, { 57, 57, 50, 57, 15, 29, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 7, { 43, 43, 15, 36, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 7, { 57, 57, 43, 50, 15, 36, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 7, { 50, 50, 43, 57, 15, 36, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 7, { 57, 57, 50, 57, 43, 57, 15, 36, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 7, { 36, 36, 15, 43, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 7, { 57, 57, 36, 43, 15, 43, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 7, { 50, 50, 36, 50, 15, 43, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 7, { 57, 57, 50, 57, 36, 50, 15, 43, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 7, { 43, 43, 36, 57, 15, 43, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 7, { 57, 57, 43, 50, 36, 57, 15, 43, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 7, { 50, 50, 43, 57, 36, 57, 15, 43, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 7, { 57, 57, 50, 57, 43, 57, 36, 57, 15, 43, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 7, { 29, 29, 15, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 7, { 57, 57, 29, 36, 15, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 7, { 50, 50, 29, 43, 15, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 7, { 57, 57, 50, 57, 29, 43, 15, 50, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 7, { 43, 43, 29, 50, 15, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 7, { 57, 57, 43, 50, 29, 50, 15, 50, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 7, { 50, 50, 43, 57, 29, 50, 15, 50, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 7, { 57, 57, 50, 57, 43, 57, 29, 50, 15, 50, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 7, { 36, 36, 29, 57, 15, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 7, { 57, 57, 36, 43, 29, 57, 15, 50, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 7, { 50, 50, 36, 50, 29, 57, 15, 50, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 7, { 57, 57, 50, 57, 36, 50, 29, 57, 15, 50, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 7, { 43, 43, 36, 57, 29, 57, 15, 50, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 7, { 57, 57, 43, 50, 36, 57, 29, 57, 15, 50, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 7, { 50, 50, 43, 57, 36, 57, 29, 57, 15, 50, 0, 0, 0, 0, 0, 0 } },
+	{ 6, 7, { 57, 57, 50, 57, 43, 57, 36, 57, 29, 57, 15, 50, 0, 0, 0, 0 } },
+	{ 2, 7, { 22, 22, 15, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 7, { 57, 57, 22, 29, 15, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 7, { 50, 50, 22, 36, 15, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 7, { 57, 57, 50, 57, 22, 36, 15, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 7, { 43, 43, 22, 43, 15, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 7, { 57, 57, 43, 50, 22, 43, 15, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 7, { 50, 50, 43, 57, 22, 43, 15, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 7, { 57, 57, 50, 57, 43, 57, 22, 43, 15, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 7, { 36, 36, 22, 50, 15, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 7, { 57, 57, 36, 43, 22, 50, 15, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 7, { 50, 50, 36, 50, 22, 50, 15, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 7, { 57, 57, 50, 57, 36, 50, 22, 50, 15, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 7, { 43, 43, 36, 57, 22, 50, 15, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 7, { 57, 57, 43, 50, 36, 57, 22, 50, 15, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 7, { 50, 50, 43, 57, 36, 57, 22, 50, 15, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 6, 7, { 57, 57, 50, 57, 43, 57, 36, 57, 22, 50, 15, 57, 0, 0, 0, 0 } },
+	{ 3, 7, { 29, 29, 22, 57, 15, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 7, { 57, 57, 29, 36, 22, 57, 15, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 7, { 50, 50, 29, 43, 22, 57, 15, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 7, { 57, 57, 50, 57, 29, 43, 22, 57, 15, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 7, { 43, 43, 29, 50, 22, 57, 15, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 7, { 57, 57, 43, 50, 29, 50, 22, 57, 15, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 7, { 50, 50, 43, 57, 29, 50, 22, 57, 15, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 6, 7, { 57, 57, 50, 57, 43, 57, 29, 50, 22, 57, 15, 57, 0, 0, 0, 0 } },
+	{ 4, 7, { 36, 36, 29, 57, 22, 57, 15, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 7, { 57, 57, 36, 43, 29, 57, 22, 57, 15, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 7, { 50, 50, 36, 50, 29, 57, 22, 57, 15, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 6, 7, { 57, 57, 50, 57, 36, 50, 29, 57, 22, 57, 15, 57, 0, 0, 0, 0 } },
+	{ 5, 7, { 43, 43, 36, 57, 29, 57, 22, 57, 15, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 6, 7, { 57, 57, 43, 50, 36, 57, 29, 57, 22, 57, 15, 57, 0, 0, 0, 0 } },
+	{ 6, 7, { 50, 50, 43, 57, 36, 57, 29, 57, 22, 57, 15, 57, 0, 0, 0, 0 } },
+	{ 7, 7, { 57, 57, 50, 57, 43, 57, 36, 57, 29, 57, 22, 57, 15, 57, 0, 0 } },
+	{ 1, 8, { 8, 8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 8, { 57, 57, 8, 15, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 8, { 50, 50, 8, 22, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 8, { 57, 57, 50, 57, 8, 22, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 8, { 43, 43, 8, 29, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 8, { 57, 57, 43, 50, 8, 29, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 8, { 50, 50, 43, 57, 8, 29, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 57, 57, 50, 57, 43, 57, 8, 29, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 8, { 36, 36, 8, 36, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 8, { 57, 57, 36, 43, 8, 36, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 8, { 50, 50, 36, 50, 8, 36, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 57, 57, 50, 57, 36, 50, 8, 36, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 8, { 43, 43, 36, 57, 8, 36, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 57, 57, 43, 50, 36, 57, 8, 36, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 50, 50, 43, 57, 36, 57, 8, 36, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 57, 57, 50, 57, 43, 57, 36, 57, 8, 36, 0, 0, 0, 0, 0, 0 } },
+	{ 2, 8, { 29, 29, 8, 43, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 8, { 57, 57, 29, 36, 8, 43, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 8, { 50, 50, 29, 43, 8, 43, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 57, 57, 50, 57, 29, 43, 8, 43, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 8, { 43, 43, 29, 50, 8, 43, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 57, 57, 43, 50, 29, 50, 8, 43, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 50, 50, 43, 57, 29, 50, 8, 43, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 57, 57, 50, 57, 43, 57, 29, 50, 8, 43, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 8, { 36, 36, 29, 57, 8, 43, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 57, 57, 36, 43, 29, 57, 8, 43, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 50, 50, 36, 50, 29, 57, 8, 43, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 57, 57, 50, 57, 36, 50, 29, 57, 8, 43, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 43, 43, 36, 57, 29, 57, 8, 43, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 57, 57, 43, 50, 36, 57, 29, 57, 8, 43, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 50, 50, 43, 57, 36, 57, 29, 57, 8, 43, 0, 0, 0, 0, 0, 0 } },
+	{ 6, 8, { 57, 57, 50, 57, 43, 57, 36, 57, 29, 57, 8, 43, 0, 0, 0, 0 } },
+	{ 2, 8, { 22, 22, 8, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 8, { 57, 57, 22, 29, 8, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 8, { 50, 50, 22, 36, 8, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 57, 57, 50, 57, 22, 36, 8, 50, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 8, { 43, 43, 22, 43, 8, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 57, 57, 43, 50, 22, 43, 8, 50, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 50, 50, 43, 57, 22, 43, 8, 50, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 57, 57, 50, 57, 43, 57, 22, 43, 8, 50, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 8, { 36, 36, 22, 50, 8, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 57, 57, 36, 43, 22, 50, 8, 50, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 50, 50, 36, 50, 22, 50, 8, 50, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 57, 57, 50, 57, 36, 50, 22, 50, 8, 50, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 43, 43, 36, 57, 22, 50, 8, 50, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 57, 57, 43, 50, 36, 57, 22, 50, 8, 50, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 50, 50, 43, 57, 36, 57, 22, 50, 8, 50, 0, 0, 0, 0, 0, 0 } },
+	{ 6, 8, { 57, 57, 50, 57, 43, 57, 36, 57, 22, 50, 8, 50, 0, 0, 0, 0 } },
+	{ 3, 8, { 29, 29, 22, 57, 8, 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 57, 57, 29, 36, 22, 57, 8, 50, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 50, 50, 29, 43, 22, 57, 8, 50, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 57, 57, 50, 57, 29, 43, 22, 57, 8, 50, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 43, 43, 29, 50, 22, 57, 8, 50, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 57, 57, 43, 50, 29, 50, 22, 57, 8, 50, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 50, 50, 43, 57, 29, 50, 22, 57, 8, 50, 0, 0, 0, 0, 0, 0 } },
+	{ 6, 8, { 57, 57, 50, 57, 43, 57, 29, 50, 22, 57, 8, 50, 0, 0, 0, 0 } },
+	{ 4, 8, { 36, 36, 29, 57, 22, 57, 8, 50, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 57, 57, 36, 43, 29, 57, 22, 57, 8, 50, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 50, 50, 36, 50, 29, 57, 22, 57, 8, 50, 0, 0, 0, 0, 0, 0 } },
+	{ 6, 8, { 57, 57, 50, 57, 36, 50, 29, 57, 22, 57, 8, 50, 0, 0, 0, 0 } },
+	{ 5, 8, { 43, 43, 36, 57, 29, 57, 22, 57, 8, 50, 0, 0, 0, 0, 0, 0 } },
+	{ 6, 8, { 57, 57, 43, 50, 36, 57, 29, 57, 22, 57, 8, 50, 0, 0, 0, 0 } },
+	{ 6, 8, { 50, 50, 43, 57, 36, 57, 29, 57, 22, 57, 8, 50, 0, 0, 0, 0 } },
+	{ 7, 8, { 57, 57, 50, 57, 43, 57, 36, 57, 29, 57, 22, 57, 8, 50, 0, 0 } },
+	{ 2, 8, { 15, 15, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 8, { 57, 57, 15, 22, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 8, { 50, 50, 15, 29, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 57, 57, 50, 57, 15, 29, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 8, { 43, 43, 15, 36, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 57, 57, 43, 50, 15, 36, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 50, 50, 43, 57, 15, 36, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 57, 57, 50, 57, 43, 57, 15, 36, 8, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 3, 8, { 36, 36, 15, 43, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 57, 57, 36, 43, 15, 43, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 50, 50, 36, 50, 15, 43, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 57, 57, 50, 57, 36, 50, 15, 43, 8, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 43, 43, 36, 57, 15, 43, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 57, 57, 43, 50, 36, 57, 15, 43, 8, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 50, 50, 43, 57, 36, 57, 15, 43, 8, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 6, 8, { 57, 57, 50, 57, 43, 57, 36, 57, 15, 43, 8, 57, 0, 0, 0, 0 } },
+	{ 3, 8, { 29, 29, 15, 50, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 57, 57, 29, 36, 15, 50, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 50, 50, 29, 43, 15, 50, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 57, 57, 50, 57, 29, 43, 15, 50, 8, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 43, 43, 29, 50, 15, 50, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 57, 57, 43, 50, 29, 50, 15, 50, 8, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 50, 50, 43, 57, 29, 50, 15, 50, 8, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 6, 8, { 57, 57, 50, 57, 43, 57, 29, 50, 15, 50, 8, 57, 0, 0, 0, 0 } },
+	{ 4, 8, { 36, 36, 29, 57, 15, 50, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 57, 57, 36, 43, 29, 57, 15, 50, 8, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 50, 50, 36, 50, 29, 57, 15, 50, 8, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 6, 8, { 57, 57, 50, 57, 36, 50, 29, 57, 15, 50, 8, 57, 0, 0, 0, 0 } },
+	{ 5, 8, { 43, 43, 36, 57, 29, 57, 15, 50, 8, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 6, 8, { 57, 57, 43, 50, 36, 57, 29, 57, 15, 50, 8, 57, 0, 0, 0, 0 } },
+	{ 6, 8, { 50, 50, 43, 57, 36, 57, 29, 57, 15, 50, 8, 57, 0, 0, 0, 0 } },
+	{ 7, 8, { 57, 57, 50, 57, 43, 57, 36, 57, 29, 57, 15, 50, 8, 57, 0, 0 } },
+	{ 3, 8, { 22, 22, 15, 57, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 57, 57, 22, 29, 15, 57, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 50, 50, 22, 36, 15, 57, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 57, 57, 50, 57, 22, 36, 15, 57, 8, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 4, 8, { 43, 43, 22, 43, 15, 57, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 57, 57, 43, 50, 22, 43, 15, 57, 8, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 50, 50, 43, 57, 22, 43, 15, 57, 8, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 6, 8, { 57, 57, 50, 57, 43, 57, 22, 43, 15, 57, 8, 57, 0, 0, 0, 0 } },
+	{ 4, 8, { 36, 36, 22, 50, 15, 57, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 57, 57, 36, 43, 22, 50, 15, 57, 8, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 50, 50, 36, 50, 22, 50, 15, 57, 8, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 6, 8, { 57, 57, 50, 57, 36, 50, 22, 50, 15, 57, 8, 57, 0, 0, 0, 0 } },
+	{ 5, 8, { 43, 43, 36, 57, 22, 50, 15, 57, 8, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 6, 8, { 57, 57, 43, 50, 36, 57, 22, 50, 15, 57, 8, 57, 0, 0, 0, 0 } },
+	{ 6, 8, { 50, 50, 43, 57, 36, 57, 22, 50, 15, 57, 8, 57, 0, 0, 0, 0 } },
+	{ 7, 8, { 57, 57, 50, 57, 43, 57, 36, 57, 22, 50, 15, 57, 8, 57, 0, 0 } },
+	{ 4, 8, { 29, 29, 22, 57, 15, 57, 8, 57, 0, 0, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 57, 57, 29, 36, 22, 57, 15, 57, 8, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 5, 8, { 50, 50, 29, 43, 22, 57, 15, 57, 8, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 6, 8, { 57, 57, 50, 57, 29, 43, 22, 57, 15, 57, 8, 57, 0, 0, 0, 0 } },
+	{ 5, 8, { 43, 43, 29, 50, 22, 57, 15, 57, 8, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 6, 8, { 57, 57, 43, 50, 29, 50, 22, 57, 15, 57, 8, 57, 0, 0, 0, 0 } },
+	{ 6, 8, { 50, 50, 43, 57, 29, 50, 22, 57, 15, 57, 8, 57, 0, 0, 0, 0 } },
+	{ 7, 8, { 57, 57, 50, 57, 43, 57, 29, 50, 22, 57, 15, 57, 8, 57, 0, 0 } },
+	{ 5, 8, { 36, 36, 29, 57, 22, 57, 15, 57, 8, 57, 0, 0, 0, 0, 0, 0 } },
+	{ 6, 8, { 57, 57, 36, 43, 29, 57, 22, 57, 15, 57, 8, 57, 0, 0, 0, 0 } },
+	{ 6, 8, { 50, 50, 36, 50, 29, 57, 22, 57, 15, 57, 8, 57, 0, 0, 0, 0 } },
+	{ 7, 8, { 57, 57, 50, 57, 36, 50, 29, 57, 22, 57, 15, 57, 8, 57, 0, 0 } },
+	{ 6, 8, { 43, 43, 36, 57, 29, 57, 22, 57, 15, 57, 8, 57, 0, 0, 0, 0 } },
+	{ 7, 8, { 57, 57, 43, 50, 36, 57, 29, 57, 22, 57, 15, 57, 8, 57, 0, 0 } },
+	{ 7, 8, { 50, 50, 43, 57, 36, 57, 29, 57, 22, 57, 15, 57, 8, 57, 0, 0 } },
+	{ 8, 8, { 57, 57, 50, 57, 43, 57, 36, 57, 29, 57, 22, 57, 15, 57, 8, 57 } }
+};
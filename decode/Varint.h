@@ -0,0 +1,218 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef VARINT_H
+#define VARINT_H
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+// Decodes the signed LEB128 ints written by Buffer::packInt and gator_pack_int. The 32 and 64-bit encodings are identical so all values are decoded as 64-bit
+
+#define VARINT_MAXSIZE 10
+
+static inline uint64_t varintLoad64(const uint8_t *const p) {
+	uint64_t word;
+	memcpy(&word, p, sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	word = __builtin_bswap64(word);
+#endif
+	return word;
+}
+
+// Returns the number of bytes used by the value at p or 0 if it is truncated or longer than VARINT_MAXSIZE
+static inline int varintDecodeSlow(const uint8_t *const p, const uint8_t *const end, int64_t *const value) {
+	uint64_t result = 0;
+	int shift = 0;
+	for (int i = 0; i < VARINT_MAXSIZE && p + i < end; ++i) {
+		const uint8_t b = p[i];
+		result |= (uint64_t)(b & 0x7f) << shift;
+		shift += 7;
+		if ((b & 0x80) == 0) {
+			if (shift < 64 && (b & 0x40) != 0) {
+				result |= ~(uint64_t)0 << shift;
+			}
+			*value = (int64_t)result;
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+// Packs the 7-bit groups of the 8 bytes in word together, the group of byte i becomes bits 7*i to 7*i + 6 of the result
+static inline uint64_t varintGather(uint64_t word) {
+	word &= 0x7f7f7f7f7f7f7f7fULL;
+	word = ((word & 0x7f007f007f007f00ULL) >> 1) | (word & 0x007f007f007f007fULL);
+	word = ((word & 0x3fff00003fff0000ULL) >> 2) | (word & 0x00003fff00003fffULL);
+	word = ((word & 0x0fffffff00000000ULL) >> 4) | (word & 0x000000000fffffffULL);
+	return word;
+}
+
+// Gathers the 7-bit groups of the len (1 to 8) byte value in word and sign extends the result
+static inline int64_t varintCompact(const uint64_t word, const int len) {
+	const int shift = 64 - 7 * len;
+	return (int64_t)(varintGather(word & (~0ULL >> (64 - 8 * len))) << shift) >> shift;
+}
+
+// Returns the number of bytes used by the value at p or 0 if it is truncated or longer than VARINT_MAXSIZE
+static inline int varintDecode(const uint8_t *const p, const uint8_t *const end, int64_t *const value) {
+	if (p < end && (*p & 0x80) == 0) {
+		*value = (int8_t)(*p << 1) >> 1;
+		return 1;
+	}
+	if (end - p >= 8) {
+		const uint64_t word = varintLoad64(p);
+		const uint64_t stops = ~word & 0x8080808080808080ULL;
+		if (stops != 0) {
+			const int len = (__builtin_ctzll(stops) >> 3) + 1;
+			*value = varintCompact(word, len);
+			return len;
+		}
+	}
+	return varintDecodeSlow(p, end, value);
+}
+
+// Decodes the value at *pos and advances *pos past it, returns false if it is truncated or invalid
+static inline bool varintRead(const char **const pos, const char *const end, int64_t *const value) {
+	const int len = varintDecode((const uint8_t *)*pos, (const uint8_t *)end, value);
+	*pos += len;
+	return len > 0;
+}
+
+#if !defined(__SSE2__) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+// Returns the top bit of each of the 16 bytes as a 16-bit mask, as _mm_movemask_epi8 does
+static inline unsigned int varintMovemask(const uint8x16_t bytes) {
+	static const int8_t shifts[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 0, 1, 2, 3, 4, 5, 6, 7 };
+	const uint8x16_t bits = vshlq_u8(vshrq_n_u8(bytes, 7), vld1q_s8(shifts));
+	uint8x8_t sum = vpadd_u8(vget_low_u8(bits), vget_high_u8(bits));
+	sum = vpadd_u8(sum, sum);
+	sum = vpadd_u8(sum, sum);
+	return vget_lane_u8(sum, 0) | (vget_lane_u8(sum, 1) << 8);
+}
+#endif
+
+// Returns a bit for each of the 16 bytes at p that has the continuation bit set
+static inline unsigned int varintContinuationMask(const uint8_t *const p) {
+#if defined(__SSE2__)
+	return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)p));
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	return varintMovemask(vld1q_u8(p));
+#else
+	const uint64_t lo = (varintLoad64(p) & 0x8080808080808080ULL) >> 7;
+	const uint64_t hi = (varintLoad64(p + 8) & 0x8080808080808080ULL) >> 7;
+	return (unsigned int)((lo * 0x0102040810204080ULL) >> 56) | (unsigned int)(((hi * 0x0102040810204080ULL) >> 56) << 8);
+#endif
+}
+
+// Returns a bit for each of the 16 bytes at p that is zero, a value of 0 is the single byte 0
+static inline unsigned int varintZeroMask(const uint8_t *const p) {
+#if defined(__SSE2__)
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), _mm_setzero_si128()));
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	return varintMovemask(vceqq_u8(vld1q_u8(p), vdupq_n_u8(0)));
+#else
+	unsigned int mask = 0;
+	for (int i = 0; i < 16; ++i) {
+		mask |= (unsigned int)(p[i] == 0) << i;
+	}
+	return mask;
+#endif
+}
+
+// Returns the number of bytes used by the value at p without decoding it, or 0 if it is truncated or longer than VARINT_MAXSIZE
+static inline int varintSkip(const uint8_t *const p, const uint8_t *const end) {
+	if (end - p >= 8) {
+		const uint64_t stops = ~varintLoad64(p) & 0x8080808080808080ULL;
+		if (stops != 0) {
+			return (__builtin_ctzll(stops) >> 3) + 1;
+		}
+	}
+	for (int i = 0; i < VARINT_MAXSIZE && p + i < end; ++i) {
+		if ((p[i] & 0x80) == 0) {
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+// Where the values that end in 8 bytes are in the gathered 7-bit groups of those bytes, see VARINT_SHAPES
+struct VarintShape {
+	// The number of values that end in the bytes and the number of bytes up to the end of the last of them
+	uint8_t count;
+	uint8_t length;
+	// For each value, the left then the arithmetic right shift that extracts and sign extends it from the result of varintGather
+	uint8_t shifts[2 * 8];
+};
+
+// Indexed by the bytes of 8 that end a value, bit i is set if byte i has no continuation bit
+extern const VarintShape VARINT_SHAPES[256];
+
+// Decodes up to count consecutive values into values and returns the number decoded, next is set to the byte following the last value decoded.
+// Fewer than count values are decoded only if the end of the data is reached or a value is invalid
+static inline int varintDecodeBatch(const uint8_t *p, const uint8_t *const end, int64_t *const values, const int count, const uint8_t **const next) {
+	int decoded = 0;
+
+	while (end - p >= 16 && count - decoded >= 16) {
+		const unsigned int continuation = varintContinuationMask(p);
+		if (continuation == 0) {
+			// Sixteen single byte values, the common case for keys and small deltas
+			for (int i = 0; i < 16; ++i) {
+				values[decoded + i] = (int8_t)(p[i] << 1) >> 1;
+			}
+			decoded += 16;
+			p += 16;
+			continue;
+		}
+
+		// Decode the values that end in the first 8 bytes and then in the 8 bytes following the last of them, which the mask still covers.
+		// The 7-bit groups of all 8 bytes are gathered at once and each value is shifted out of the result. All 8 slots are written whatever
+		// the number of values, so that mixed widths don't cost a mispredicted branch per value
+		unsigned int stops = ~continuation & 0xffff;
+		for (int half = 0; half < 2; ++half) {
+			const VarintShape &shape = VARINT_SHAPES[stops & 0xff];
+			if (shape.count == 0) {
+				// A value of more than 8 bytes
+				const int len = varintDecode(p, end, &values[decoded]);
+				if (len == 0) {
+					*next = p;
+					return decoded;
+				}
+				++decoded;
+				p += len;
+				break;
+			}
+			const uint64_t word = varintGather(varintLoad64(p));
+			for (int i = 0; i < 8; ++i) {
+				values[decoded + i] = (int64_t)(word << shape.shifts[2 * i]) >> shape.shifts[2 * i + 1];
+			}
+			decoded += shape.count;
+			p += shape.length;
+			stops >>= shape.length;
+		}
+	}
+
+	while (decoded < count && p < end) {
+		const int len = varintDecode(p, end, &values[decoded]);
+		if (len == 0) {
+			break;
+		}
+		++decoded;
+		p += len;
+	}
+
+	*next = p;
+	return decoded;
+}
+
+#endif // VARINT_H
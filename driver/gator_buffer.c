@@ -29,7 +29,7 @@ static void marshal_frame(int cpu, int buftype)
 		frame = FRAME_COUNTER;
 		break;
 	case BLOCK_COUNTER_BUF:
-		frame = FRAME_BLOCK_COUNTER;
+		frame = gator_compact_counters ? FRAME_BLOCK_COUNTER_COMPACT : FRAME_BLOCK_COUNTER;
 		break;
 	case ANNOTATE_BUF:
 		frame = FRAME_ANNOTATE;
@@ -59,6 +59,68 @@ static void marshal_frame(int cpu, int buftype)
 	// add frame type and core number
 	gator_buffer_write_packed_int(cpu, buftype, frame);
 	gator_buffer_write_packed_int(cpu, buftype, cpu);
+
+	if (buftype == BLOCK_COUNTER_BUF && gator_compact_counters) {
+		struct compact_state *const state = per_cpu(gator_compact_state, cpu);
+		state->time = 0;
+		state->run = 0;
+		state->prev_count = 0;
+		state->curr_count = 0;
+	}
+}
+
+// A compact block counter frame contains the same (key, value) records as a block counter frame with the following changes
+// - The timestamp (key 0) is the delta from the previous timestamp in the frame, or from zero for the first timestamp
+// - The records following a timestamp are compared to the records following the previous timestamp at the same position.
+//   If the keys match, the value is the delta from the previous value, otherwise it is the absolute value
+// - A run of records identical to the previous records at the same position are replaced with (COMPACT_KEY_RUN, length)
+// Callers must have interrupts disabled and check for 3 * MAXSIZE_PACK32 + MAXSIZE_PACK64 bytes of space per record
+static void compact_flush_run(int cpu)
+{
+	struct compact_state *const state = per_cpu(gator_compact_state, cpu);
+
+	if (state->run > 0) {
+		gator_buffer_write_packed_int(cpu, BLOCK_COUNTER_BUF, COMPACT_KEY_RUN);
+		gator_buffer_write_packed_int(cpu, BLOCK_COUNTER_BUF, state->run);
+		state->run = 0;
+	}
+}
+
+static void compact_timestamp(int cpu, u64 time)
+{
+	struct compact_state *const state = per_cpu(gator_compact_state, cpu);
+	const int count = min(state->curr_count, COMPACT_MAX_RECORDS);
+
+	compact_flush_run(cpu);
+	gator_buffer_write_packed_int(cpu, BLOCK_COUNTER_BUF, 0);
+	gator_buffer_write_packed_int64(cpu, BLOCK_COUNTER_BUF, time - state->time);
+	state->time = time;
+
+	memcpy(state->prev_keys, state->curr_keys, count * sizeof(state->prev_keys[0]));
+	memcpy(state->prev_values, state->curr_values, count * sizeof(state->prev_values[0]));
+	state->prev_count = count;
+	state->curr_count = 0;
+}
+
+static void compact_event(int cpu, int key, long long value)
+{
+	struct compact_state *const state = per_cpu(gator_compact_state, cpu);
+	const int pos = state->curr_count++;
+	const bool key_matches = pos < state->prev_count && state->prev_keys[pos] == key;
+
+	if (pos < COMPACT_MAX_RECORDS) {
+		state->curr_keys[pos] = key;
+		state->curr_values[pos] = value;
+	}
+
+	if (key_matches && state->prev_values[pos] == value) {
+		++state->run;
+		return;
+	}
+
+	compact_flush_run(cpu);
+	gator_buffer_write_packed_int(cpu, BLOCK_COUNTER_BUF, key);
+	gator_buffer_write_packed_int64(cpu, BLOCK_COUNTER_BUF, key_matches ? value - state->prev_values[pos] : value);
 }
 
 static int buffer_bytes_available(int cpu, int buftype)
@@ -116,6 +178,9 @@ static void gator_commit_buffer(int cpu, int buftype, u64 time)
 
 	// post-populate the length, which does not include the response type length nor the length itself, i.e. only the length of the payload
 	local_irq_save(flags);
+	if (buftype == BLOCK_COUNTER_BUF && gator_compact_counters) {
+		compact_flush_run(cpu);
+	}
 	type_length = gator_response_type ? 1 : 0;
 	commit = per_cpu(gator_buffer_commit, cpu)[buftype];
 	length = per_cpu(gator_buffer_write, cpu)[buftype] - commit;
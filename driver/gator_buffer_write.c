@@ -7,11 +7,9 @@
  *
  */
 
-static void gator_buffer_write_packed_int(int cpu, int buftype, int x)
+// Packs x into buf, which must have room for MAXSIZE_PACK32 bytes, and returns the number of bytes used
+static int gator_pack_int(char *buf, int x)
 {
-	uint32_t write = per_cpu(gator_buffer_write, cpu)[buftype];
-	uint32_t mask = gator_buffer_mask[buftype];
-	char *buffer = per_cpu(gator_buffer, cpu)[buftype];
 	int packedBytes = 0;
 	int more = true;
 	while (more) {
@@ -25,18 +23,16 @@ static void gator_buffer_write_packed_int(int cpu, int buftype, int x)
 			b |= 0x80;
 		}
 
-		buffer[(write + packedBytes) & mask] = b;
+		buf[packedBytes] = b;
 		packedBytes++;
 	}
 
-	per_cpu(gator_buffer_write, cpu)[buftype] = (write + packedBytes) & mask;
+	return packedBytes;
 }
 
-static void gator_buffer_write_packed_int64(int cpu, int buftype, long long x)
+// Packs x into buf, which must have room for MAXSIZE_PACK64 bytes, and returns the number of bytes used
+static int gator_pack_int64(char *buf, long long x)
 {
-	uint32_t write = per_cpu(gator_buffer_write, cpu)[buftype];
-	uint32_t mask = gator_buffer_mask[buftype];
-	char *buffer = per_cpu(gator_buffer, cpu)[buftype];
 	int packedBytes = 0;
 	int more = true;
 	while (more) {
@@ -50,26 +46,55 @@ static void gator_buffer_write_packed_int64(int cpu, int buftype, long long x)
 			b |= 0x80;
 		}
 
-		buffer[(write + packedBytes) & mask] = b;
+		buf[packedBytes] = b;
 		packedBytes++;
 	}
 
-	per_cpu(gator_buffer_write, cpu)[buftype] = (write + packedBytes) & mask;
+	return packedBytes;
 }
 
 static void gator_buffer_write_bytes(int cpu, int buftype, const char *x, int len)
 {
-	int i;
 	u32 write = per_cpu(gator_buffer_write, cpu)[buftype];
-	u32 mask = gator_buffer_mask[buftype];
+	u32 size = gator_buffer_size[buftype];
 	char *buffer = per_cpu(gator_buffer, cpu)[buftype];
 
-	for (i = 0; i < len; i++) {
-		buffer[write] = x[i];
-		write = (write + 1) & mask;
+	if (likely(write + len <= size)) {
+		// Common case, the record fits before the wrap point
+		memcpy(&buffer[write], x, len);
+	} else {
+		const u32 first = size - write;
+		memcpy(&buffer[write], x, first);
+		memcpy(buffer, x + first, len - first);
+	}
+
+	per_cpu(gator_buffer_write, cpu)[buftype] = (write + len) & gator_buffer_mask[buftype];
+}
+
+static void gator_buffer_write_packed_int(int cpu, int buftype, int x)
+{
+	u32 write = per_cpu(gator_buffer_write, cpu)[buftype];
+	char buf[MAXSIZE_PACK32];
+
+	if (likely(write + MAXSIZE_PACK32 <= gator_buffer_size[buftype])) {
+		// Pack directly into the buffer as it can not wrap
+		per_cpu(gator_buffer_write, cpu)[buftype] = (write + gator_pack_int(&per_cpu(gator_buffer, cpu)[buftype][write], x)) & gator_buffer_mask[buftype];
+	} else {
+		gator_buffer_write_bytes(cpu, buftype, buf, gator_pack_int(buf, x));
 	}
+}
 
-	per_cpu(gator_buffer_write, cpu)[buftype] = write;
+static void gator_buffer_write_packed_int64(int cpu, int buftype, long long x)
+{
+	u32 write = per_cpu(gator_buffer_write, cpu)[buftype];
+	char buf[MAXSIZE_PACK64];
+
+	if (likely(write + MAXSIZE_PACK64 <= gator_buffer_size[buftype])) {
+		// Pack directly into the buffer as it can not wrap
+		per_cpu(gator_buffer_write, cpu)[buftype] = (write + gator_pack_int64(&per_cpu(gator_buffer, cpu)[buftype][write], x)) & gator_buffer_mask[buftype];
+	} else {
+		gator_buffer_write_bytes(cpu, buftype, buf, gator_pack_int64(buf, x));
+	}
 }
 
 static void gator_buffer_write_string(int cpu, int buftype, const char *x)
@@ -10,11 +10,17 @@
 #include "gator.h"
 
 #include <linux/hardirq.h>
-#include <linux/kthread.h>
+#include <linux/mm.h>
 #include <linux/sched.h>
-#include <linux/semaphore.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/swap.h>
+#include <linux/timer.h>
+#include <linux/vmstat.h>
 #include <linux/workqueue.h>
-#include <trace/events/kmem.h>
+
+// Per process values are only sent when they differ from the last values sent for the process from any cpu
+#define PROC_CACHE_ENTRIES	256	/* must be power of 2 */
 
 enum {
 	MEMINFO_MEMFREE,
@@ -31,6 +37,15 @@ enum {
 	PROC_COUNT,
 };
 
+struct proc_cache {
+	spinlock_t lock;
+	// The process, the mm tells a reused tgid apart
+	pid_t tgid;
+	struct mm_struct *mm;
+	// PROC_COUNT values followed by the resident size
+	long long values[PROC_COUNT + 1];
+};
+
 static const char * const meminfo_names[] = {
 	"Linux_meminfo_memfree",
 	"Linux_meminfo_memused",
@@ -44,48 +59,42 @@ static const char * const proc_names[] = {
 	"Linux_proc_statm_data",
 };
 
+// Maximum number of times a second the system wide values are read, they are also read no more often than the sampling tick
+static ulong meminfo_rate = 100;
+module_param(meminfo_rate, ulong, 0644);
+
 static bool meminfo_global_enabled;
 static ulong meminfo_enabled[MEMINFO_TOTAL];
 static ulong meminfo_keys[MEMINFO_TOTAL];
 static long long meminfo_buffer[2 * (MEMINFO_TOTAL + 2)];
-static int meminfo_length = 0;
-static bool new_data_avail;
+static long long meminfo_prev[MEMINFO_TOTAL];
+static unsigned long meminfo_interval;
+static unsigned long meminfo_next_read;
+static unsigned long meminfo_bufferram;
 
 static bool proc_global_enabled;
 static ulong proc_enabled[PROC_COUNT];
 static ulong proc_keys[PROC_COUNT];
 static DEFINE_PER_CPU(long long, proc_buffer[2 * (PROC_COUNT + 3)]);
+static struct proc_cache *proc_caches;
 
-static int gator_meminfo_func(void *data);
-static bool gator_meminfo_run;
-// Initialize semaphore unlocked to initialize memory values
-#if LINUX_VERSION_CODE < KERNEL_VERSION(2, 6, 36)
-static DECLARE_MUTEX(gator_meminfo_sem);
-#else
-static DEFINE_SEMAPHORE(gator_meminfo_sem);
-#endif
+static struct timer_list meminfo_wake_up_timer;
 
-#if LINUX_VERSION_CODE < KERNEL_VERSION(3, 3, 0)
-GATOR_DEFINE_PROBE(mm_page_free_direct, TP_PROTO(struct page *page, unsigned int order))
-#else
-GATOR_DEFINE_PROBE(mm_page_free, TP_PROTO(struct page *page, unsigned int order))
-#endif
+// Must be run in process context as the kernel function si_meminfo() can sleep. Only bufferram needs it, the other values are read directly from the vmstat counters
+static void gator_meminfo_get_bufferram(struct work_struct *wsptr)
 {
-	up(&gator_meminfo_sem);
-}
+	struct sysinfo info;
 
-#if LINUX_VERSION_CODE < KERNEL_VERSION(3, 3, 0)
-GATOR_DEFINE_PROBE(mm_pagevec_free, TP_PROTO(struct page *page, int cold))
-#else
-GATOR_DEFINE_PROBE(mm_page_free_batched, TP_PROTO(struct page *page, int cold))
-#endif
-{
-	up(&gator_meminfo_sem);
+	si_meminfo(&info);
+	meminfo_bufferram = info.bufferram;
 }
 
-GATOR_DEFINE_PROBE(mm_page_alloc, TP_PROTO(struct page *page, unsigned int order, gfp_t gfp_flags, int migratetype))
+DECLARE_WORK(wq_get_bufferram, gator_meminfo_get_bufferram);
+
+static void meminfo_wake_up_handler(unsigned long unused_data)
 {
-	up(&gator_meminfo_sem);
+	// Work can't be scheduled from the context switch, see gator_events_net.c
+	schedule_work(&wq_get_bufferram);
 }
 
 static int gator_events_meminfo_create_files(struct super_block *sb, struct dentry *root)
@@ -118,7 +127,6 @@ static int gator_events_meminfo_start(void)
 {
 	int i;
 
-	new_data_avail = false;
 	meminfo_global_enabled = 0;
 	for (i = 0; i < MEMINFO_TOTAL; i++) {
 		if (meminfo_enabled[i]) {
@@ -138,140 +146,115 @@ static int gator_events_meminfo_start(void)
 		proc_global_enabled = 1;
 	}
 
+	if (proc_global_enabled) {
+		// Shared by all cpus so that a process that migrates is compared with the values last sent for it
+		proc_caches = (struct proc_cache *)kzalloc(PROC_CACHE_ENTRIES * sizeof(struct proc_cache), GFP_KERNEL);
+		if (!proc_caches)
+			return -1;
+		for (i = 0; i < PROC_CACHE_ENTRIES; ++i) {
+			spin_lock_init(&proc_caches[i].lock);
+		}
+	}
+
 	if (meminfo_global_enabled == 0)
 		return 0;
 
-#if LINUX_VERSION_CODE < KERNEL_VERSION(3, 3, 0)
-	if (GATOR_REGISTER_TRACE(mm_page_free_direct))
-#else
-	if (GATOR_REGISTER_TRACE(mm_page_free))
-#endif
-		goto mm_page_free_exit;
-#if LINUX_VERSION_CODE < KERNEL_VERSION(3, 3, 0)
-	if (GATOR_REGISTER_TRACE(mm_pagevec_free))
+	// -1 never matches a value so the first read sends every value
+	for (i = 0; i < MEMINFO_TOTAL; i++) {
+		meminfo_prev[i] = -1;
+	}
+	meminfo_interval = meminfo_rate > 0 && meminfo_rate < HZ ? HZ / meminfo_rate : 1;
+	meminfo_next_read = jiffies;
+	gator_meminfo_get_bufferram(NULL);
+#if LINUX_VERSION_CODE < KERNEL_VERSION(2, 6, 36)
+	setup_timer(&meminfo_wake_up_timer, meminfo_wake_up_handler, 0);
 #else
-	if (GATOR_REGISTER_TRACE(mm_page_free_batched))
+	setup_deferrable_timer_on_stack(&meminfo_wake_up_timer, meminfo_wake_up_handler, 0);
 #endif
-		goto mm_page_free_batched_exit;
-	if (GATOR_REGISTER_TRACE(mm_page_alloc))
-		goto mm_page_alloc_exit;
-
-	// Start worker thread
-	gator_meminfo_run = true;
-	// Since the mutex starts unlocked, memory values will be initialized
-	if (IS_ERR(kthread_run(gator_meminfo_func, NULL, "gator_meminfo")))
-		goto kthread_run_exit;
 
 	return 0;
-
-kthread_run_exit:
-	GATOR_UNREGISTER_TRACE(mm_page_alloc);
-mm_page_alloc_exit:
-#if LINUX_VERSION_CODE < KERNEL_VERSION(3, 3, 0)
-	GATOR_UNREGISTER_TRACE(mm_pagevec_free);
-#else
-	GATOR_UNREGISTER_TRACE(mm_page_free_batched);
-#endif
-mm_page_free_batched_exit:
-#if LINUX_VERSION_CODE < KERNEL_VERSION(3, 3, 0)
-	GATOR_UNREGISTER_TRACE(mm_page_free_direct);
-#else
-	GATOR_UNREGISTER_TRACE(mm_page_free);
-#endif
-mm_page_free_exit:
-	return -1;
 }
 
 static void gator_events_meminfo_stop(void)
 {
 	if (meminfo_global_enabled) {
-#if LINUX_VERSION_CODE < KERNEL_VERSION(3, 3, 0)
-		GATOR_UNREGISTER_TRACE(mm_page_free_direct);
-		GATOR_UNREGISTER_TRACE(mm_pagevec_free);
-#else
-		GATOR_UNREGISTER_TRACE(mm_page_free);
-		GATOR_UNREGISTER_TRACE(mm_page_free_batched);
-#endif
-		GATOR_UNREGISTER_TRACE(mm_page_alloc);
-
-		// Stop worker thread
-		gator_meminfo_run = false;
-		up(&gator_meminfo_sem);
+		del_timer_sync(&meminfo_wake_up_timer);
+		cancel_work_sync(&wq_get_bufferram);
 	}
+
+	kfree(proc_caches);
+	proc_caches = NULL;
 }
 
-// Must be run in process context as the kernel function si_meminfo() can sleep
-static int gator_meminfo_func(void *data)
+// Called from the sampling tick and the context switch so it must not sleep
+static int gator_events_meminfo_read(long long **buffer)
 {
-	struct sysinfo info;
-	int i, len;
-	unsigned long long value;
-
-	for (;;) {
-		if (down_killable(&gator_meminfo_sem)) {
-			break;
-		}
-
-		// Eat up any pending events
-		while (!down_trylock(&gator_meminfo_sem));
+	int i, len = 0;
+	unsigned long free, total;
+	long long value;
 
-		if (!gator_meminfo_run) {
-			break;
-		}
+	if (!on_primary_core() || !meminfo_global_enabled)
+		return 0;
 
-		meminfo_length = len = 0;
-
-		si_meminfo(&info);
-		for (i = 0; i < MEMINFO_TOTAL; i++) {
-			if (meminfo_enabled[i]) {
-				switch (i) {
-				case MEMINFO_MEMFREE:
-					value = info.freeram * PAGE_SIZE;
-					break;
-				case MEMINFO_MEMUSED:
-					// pid -1 means system wide
-					meminfo_buffer[len++] = 1;
-					meminfo_buffer[len++] = -1;
-					// Emit value
-					meminfo_buffer[len++] = meminfo_keys[MEMINFO_MEMUSED];
-					meminfo_buffer[len++] = (info.totalram - info.freeram) * PAGE_SIZE;
-					// Clear pid
-					meminfo_buffer[len++] = 1;
-					meminfo_buffer[len++] = 0;
-					continue;
-				case MEMINFO_BUFFERRAM:
-					value = info.bufferram * PAGE_SIZE;
-					break;
-				default:
-					value = 0;
-					break;
-				}
-				meminfo_buffer[len++] = meminfo_keys[i];
-				meminfo_buffer[len++] = value;
-			}
-		}
+	// Limit the system wide values to meminfo_rate a second
+	if (time_before(jiffies, meminfo_next_read))
+		return 0;
+	meminfo_next_read = jiffies + meminfo_interval;
 
-		meminfo_length = len;
-		new_data_avail = true;
+#ifndef CONFIG_PREEMPT_RT_FULL
+	// bufferram is refreshed for the next read, mod_timer is not used in RT-Preempt full so it is only read at start there
+	if (meminfo_enabled[MEMINFO_BUFFERRAM]) {
+		mod_timer(&meminfo_wake_up_timer, jiffies + 1);
 	}
+#endif
 
-	return 0;
-}
+	free = global_page_state(NR_FREE_PAGES);
+	total = totalram_pages;
 
-static int gator_events_meminfo_read(long long **buffer)
-{
-	if (!on_primary_core() || !meminfo_global_enabled)
-		return 0;
+	for (i = 0; i < MEMINFO_TOTAL; i++) {
+		if (!meminfo_enabled[i])
+			continue;
 
-	if (!new_data_avail)
-		return 0;
+		switch (i) {
+		case MEMINFO_MEMFREE:
+			value = free * PAGE_SIZE;
+			break;
+		case MEMINFO_MEMUSED:
+			value = (total - free) * PAGE_SIZE;
+			break;
+		case MEMINFO_BUFFERRAM:
+			value = meminfo_bufferram * PAGE_SIZE;
+			break;
+		default:
+			value = 0;
+			break;
+		}
 
-	new_data_avail = false;
+		// Only send values that have changed
+		if (value == meminfo_prev[i])
+			continue;
+		meminfo_prev[i] = value;
+
+		if (i == MEMINFO_MEMUSED) {
+			// pid -1 means system wide
+			meminfo_buffer[len++] = 1;
+			meminfo_buffer[len++] = -1;
+			// Emit value
+			meminfo_buffer[len++] = meminfo_keys[MEMINFO_MEMUSED];
+			meminfo_buffer[len++] = value;
+			// Clear pid
+			meminfo_buffer[len++] = 1;
+			meminfo_buffer[len++] = 0;
+		} else {
+			meminfo_buffer[len++] = meminfo_keys[i];
+			meminfo_buffer[len++] = value;
+		}
+	}
 
 	if (buffer)
 		*buffer = meminfo_buffer;
 
-	return meminfo_length;
+	return len;
 }
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 34) && LINUX_VERSION_CODE < KERNEL_VERSION(3, 4, 0)
@@ -299,14 +282,15 @@ static inline unsigned long gator_get_mm_counter(struct mm_struct *mm, int membe
 static int gator_events_meminfo_read_proc(long long **buffer, struct task_struct *task)
 {
 	struct mm_struct *mm;
+	struct proc_cache *cache;
 	u64 share = 0;
 	int i;
-	long long value;
+	long long values[PROC_COUNT + 1];
 	int len = 0;
-	int cpu = get_physical_cpu();
-	long long *buf = per_cpu(proc_buffer, cpu);
+	bool unchanged;
+	long long *buf = per_cpu(proc_buffer, get_physical_cpu());
 
-	if (!proc_global_enabled) {
+	if (!proc_global_enabled || proc_caches == NULL) {
 		return 0;
 	}
 
@@ -332,43 +316,68 @@ static int gator_events_meminfo_read_proc(long long **buffer, struct task_struct
 							   );
 	}
 
-	// key of 1 indicates a pid
-	buf[len++] = 1;
-	buf[len++] = task->pid;
-
+	// Read every value first so that they can be compared with the cache in one go
+	memset(values, 0, sizeof(values));
 	for (i = 0; i < PROC_COUNT; ++i) {
 		if (proc_enabled[i]) {
 			switch (i) {
 			case PROC_SIZE:
-				value = mm->total_vm;
+				values[i] = mm->total_vm;
 				break;
 			case PROC_SHARE:
-				value = share;
+				values[i] = share;
 				break;
 			case PROC_TEXT:
-				value = (PAGE_ALIGN(mm->end_code) - (mm->start_code & PAGE_MASK)) >> PAGE_SHIFT;
+				values[i] = (PAGE_ALIGN(mm->end_code) - (mm->start_code & PAGE_MASK)) >> PAGE_SHIFT;
 				break;
 			case PROC_DATA:
-				value = mm->total_vm - mm->shared_vm;
+				values[i] = mm->total_vm - mm->shared_vm;
 				break;
 			}
-
-			buf[len++] = proc_keys[i];
-			buf[len++] = value * PAGE_SIZE;
 		}
 	}
 
 	if (meminfo_enabled[MEMINFO_MEMUSED]) {
-		value = share + get_mm_counter(mm,
+		values[PROC_COUNT] = share + get_mm_counter(mm,
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 32) && LINUX_VERSION_CODE < KERNEL_VERSION(2, 6, 34)
 									   anon_rss
 #else
 									   MM_ANONPAGES
 #endif
 									   );
+	}
+
+	// The threads of a process share the cache entry, so switching between them does not resend the values. This runs from the
+	// context switch on every cpu, if another cpu is updating the entry the values are sent rather than waiting for it
+	cache = &proc_caches[task->tgid & (PROC_CACHE_ENTRIES - 1)];
+	if (!spin_trylock(&cache->lock)) {
+		unchanged = false;
+	} else {
+		unchanged = cache->tgid == task->tgid && cache->mm == mm && memcmp(cache->values, values, sizeof(values)) == 0;
+		cache->tgid = task->tgid;
+		cache->mm = mm;
+		memcpy(cache->values, values, sizeof(values));
+		spin_unlock(&cache->lock);
+	}
+	if (unchanged) {
+		return 0;
+	}
+
+	// key of 1 indicates a pid
+	buf[len++] = 1;
+	buf[len++] = task->tgid;
+
+	for (i = 0; i < PROC_COUNT; ++i) {
+		if (proc_enabled[i]) {
+			buf[len++] = proc_keys[i];
+			buf[len++] = values[i] * PAGE_SIZE;
+		}
+	}
+
+	if (meminfo_enabled[MEMINFO_MEMUSED]) {
 		// Send resident for this pid
 		buf[len++] = meminfo_keys[MEMINFO_MEMUSED];
-		buf[len++] = value * PAGE_SIZE;
+		buf[len++] = values[PROC_COUNT] * PAGE_SIZE;
 	}
 
 	// Clear pid
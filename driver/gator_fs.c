@@ -20,6 +20,52 @@
 #define TMPBUFSIZE 50
 DEFINE_SPINLOCK(gatorfs_lock);
 
+// Every ulong file created, so that the session configuration can be applied without going through the per-file text interface
+struct gatorfs_ulong {
+	struct list_head list;
+	struct dentry *dentry;
+	unsigned long *val;
+	bool writable;
+};
+
+static LIST_HEAD(gatorfs_ulongs);
+
+static void gatorfs_add_ulong(struct dentry *dentry, unsigned long *val, bool writable)
+{
+	struct gatorfs_ulong *ulong = kmalloc(sizeof(*ulong), GFP_KERNEL);
+
+	if (!ulong)
+		return;
+
+	ulong->dentry = dentry;
+	ulong->val = val;
+	ulong->writable = writable;
+	list_add_tail(&ulong->list, &gatorfs_ulongs);
+}
+
+static void gatorfs_free_ulongs(void)
+{
+	struct gatorfs_ulong *ulong, *next;
+
+	list_for_each_entry_safe(ulong, next, &gatorfs_ulongs, list) {
+		list_del(&ulong->list);
+		kfree(ulong);
+	}
+}
+
+// Finds the ulong file dir/name, ex: events/Linux_irq_irq/enabled
+static struct gatorfs_ulong *gatorfs_find_ulong(const char *dir, const char *name)
+{
+	struct gatorfs_ulong *ulong;
+
+	list_for_each_entry(ulong, &gatorfs_ulongs, list) {
+		if (strcmp(ulong->dentry->d_name.name, name) == 0 && strcmp(ulong->dentry->d_parent->d_name.name, dir) == 0)
+			return ulong;
+	}
+
+	return NULL;
+}
+
 static struct inode *gatorfs_get_inode(struct super_block *sb, int mode)
 {
 	struct inode *inode = new_inode(sb);
@@ -203,6 +249,7 @@ int gatorfs_create_ulong(struct super_block *sb, struct dentry *root,
 		return -EFAULT;
 
 	d->d_inode->i_private = val;
+	gatorfs_add_ulong(d, val, true);
 	return 0;
 }
 
@@ -227,6 +274,7 @@ int gatorfs_create_ro_ulong(struct super_block *sb, struct dentry *root,
 		return -EFAULT;
 
 	d->d_inode->i_private = val;
+	gatorfs_add_ulong(d, val, false);
 	return 0;
 }
 
@@ -322,6 +370,7 @@ static int gatorfs_fill_super(struct super_block *sb, void *data, int silent)
 
 	sb->s_root = root_dentry;
 
+	gatorfs_free_ulongs();
 	gator_op_create_files(sb, root_dentry);
 
 	return 0;
@@ -342,6 +391,12 @@ static struct dentry *gatorfs_mount(struct file_system_type *fs_type,
 }
 #endif
 
+static void gatorfs_kill_sb(struct super_block *sb)
+{
+	gatorfs_free_ulongs();
+	kill_litter_super(sb);
+}
+
 static struct file_system_type gatorfs_type = {
 	.owner = THIS_MODULE,
 	.name = "gatorfs",
@@ -351,7 +406,7 @@ static struct file_system_type gatorfs_type = {
 	.mount = gatorfs_mount,
 #endif
 
-	.kill_sb = kill_litter_super,
+	.kill_sb = gatorfs_kill_sb,
 };
 
 static int __init gatorfs_register(void)
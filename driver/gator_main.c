@@ -86,6 +86,7 @@ static unsigned long gator_protocol_version = PROTOCOL_VERSION;
 #define FRAME_SCHED_TRACE   7
 #define FRAME_IDLE          9
 #define FRAME_ACTIVITY     13
+#define FRAME_BLOCK_COUNTER_COMPACT 14
 
 #define MESSAGE_END_BACKTRACE 1
 
@@ -115,6 +116,43 @@ static unsigned long gator_protocol_version = PROTOCOL_VERSION;
 
 #define FRAME_HEADER_SIZE 3
 
+// Maximum number of records per timestamp that can be suppressed or delta encoded in a compact block counter frame
+// Must match Buffer::MAX_COMPACT_RECORDS in the daemon as decoders can not tell which side wrote a frame
+#define COMPACT_MAX_RECORDS 128
+#define COMPACT_KEY_RUN     -1
+
+// Binary session configuration written to /dev/gator/session_config, must be kept in sync with DriverSource.h in the daemon
+#define GATOR_CONFIG_MAGIC        0x47434647
+#define GATOR_CONFIG_VERSION      1
+#define GATOR_CONFIG_SESSION      (1 << 0)	// backtrace_depth, tick, response_type and live_rate are valid
+#define GATOR_CONFIG_COUNTERS     (1 << 1)	// all counters are reset before the counters that follow the header are applied
+#define GATOR_CONFIG_NAME_LEN     80
+#define GATOR_CONFIG_MAX_COUNTERS 4096
+
+struct gator_config_header {
+	u32 magic;
+	u32 version;
+	u32 flags;
+	u32 count;
+	s32 backtrace_depth;
+	s32 tick;
+	s32 response_type;
+	s32 compact_counters;
+	s64 live_rate;
+};
+
+struct gator_config_counter {
+	char name[GATOR_CONFIG_NAME_LEN];
+	s32 enabled;
+	s32 event;
+	// Read back as -1 if the counter does not support event based sampling
+	s32 count;
+	// Output only
+	s32 key;
+	// Output only, -1 if not applicable
+	s32 cores;
+};
+
 #if defined(__arm__)
 #define PC_REG regs->ARM_pc
 #elif defined(__aarch64__)
@@ -152,7 +190,12 @@ static u64 gator_hibernate_time;
 static unsigned long gator_buffer_opened;
 static unsigned long gator_timer_count;
 static unsigned long gator_response_type;
+// Send block counters as FRAME_BLOCK_COUNTER_COMPACT
+static unsigned long gator_compact_counters;
 static DEFINE_MUTEX(start_mutex);
+// The last session configuration written along with the values read back from the driver. Protected by start_mutex
+static char *gator_config;
+static size_t gator_config_size;
 static DEFINE_MUTEX(gator_buffer_mutex);
 
 bool event_based_sampling;
@@ -209,6 +252,21 @@ static DEFINE_PER_CPU(char *[NUM_GATOR_BUFS], gator_buffer);
 // The time after which the buffer should be committed for live display
 static DEFINE_PER_CPU(u64, gator_buffer_commit_time);
 
+// State used to encode the block counter buffer when gator_compact_counters is set, reset at the start of every frame
+struct compact_state {
+	u64 time;
+	int run;
+	int prev_count;
+	int curr_count;
+	int prev_keys[COMPACT_MAX_RECORDS];
+	long long prev_values[COMPACT_MAX_RECORDS];
+	int curr_keys[COMPACT_MAX_RECORDS];
+	long long curr_values[COMPACT_MAX_RECORDS];
+};
+
+// Allocated in gator_op_setup
+static DEFINE_PER_CPU(struct compact_state *, gator_compact_state);
+
 // List of all gator events - new events must be added to this list
 #define GATOR_EVENTS_LIST \
 	GATOR_EVENT(gator_events_armv6_init) \
@@ -880,6 +938,10 @@ static void gator_exit(void)
 	list_for_each_entry(gi, &gator_events, list)
 		if (gi->shutdown)
 			gi->shutdown();
+
+	vfree(gator_config);
+	gator_config = NULL;
+	gator_config_size = 0;
 }
 
 static int gator_start(void)
@@ -1060,6 +1122,12 @@ static int gator_op_setup(void)
 				goto setup_error;
 			}
 		}
+
+		per_cpu(gator_compact_state, cpu) = vmalloc(sizeof(struct compact_state));
+		if (!per_cpu(gator_compact_state, cpu)) {
+			err = -ENOMEM;
+			goto setup_error;
+		}
 	}
 
 setup_error:
@@ -1122,6 +1190,8 @@ static void gator_shutdown(void)
 			per_cpu(buffer_space_available, cpu)[i] = true;
 			per_cpu(gator_buffer_commit_time, cpu) = 0;
 		}
+		vfree(per_cpu(gator_compact_state, cpu));
+		per_cpu(gator_compact_state, cpu) = NULL;
 		mutex_unlock(&gator_buffer_mutex);
 	}
 
@@ -1322,6 +1392,135 @@ static const struct file_operations depth_fops = {
 	.write = depth_write
 };
 
+static bool gator_config_validate(const struct gator_config_header *header, size_t count)
+{
+	const struct gator_config_counter *counters = (const struct gator_config_counter *)(header + 1);
+	u32 i;
+
+	if (header->magic != GATOR_CONFIG_MAGIC || header->version != GATOR_CONFIG_VERSION)
+		return false;
+
+	if (header->count > GATOR_CONFIG_MAX_COUNTERS || count != sizeof(*header) + header->count * sizeof(*counters))
+		return false;
+
+	if (!(header->flags & GATOR_CONFIG_COUNTERS))
+		return header->count == 0;
+
+	// Check everything up front so that either all or none of the configuration is applied
+	for (i = 0; i < header->count; ++i) {
+		if (strnlen(counters[i].name, GATOR_CONFIG_NAME_LEN) == GATOR_CONFIG_NAME_LEN)
+			return false;
+		if (!gatorfs_find_ulong(counters[i].name, "enabled"))
+			return false;
+	}
+
+	return true;
+}
+
+static void gator_config_apply_counters(struct gator_config_header *header)
+{
+	struct gator_config_counter *counters = (struct gator_config_counter *)(header + 1);
+	struct gatorfs_ulong *ulong;
+	u32 i;
+
+	// Equivalent to writing zero to every events/<counter>/enabled and events/<counter>/count
+	list_for_each_entry(ulong, &gatorfs_ulongs, list) {
+		if (ulong->writable && (strcmp(ulong->dentry->d_name.name, "enabled") == 0 || strcmp(ulong->dentry->d_name.name, "count") == 0))
+			*ulong->val = 0;
+	}
+
+	for (i = 0; i < header->count; ++i) {
+		struct gator_config_counter *const counter = &counters[i];
+
+		*gatorfs_find_ulong(counter->name, "enabled")->val = counter->enabled;
+
+		ulong = gatorfs_find_ulong(counter->name, "event");
+		if (ulong && ulong->writable)
+			*ulong->val = counter->event;
+
+		ulong = gatorfs_find_ulong(counter->name, "count");
+		if (ulong && ulong->writable) {
+			*ulong->val = counter->count;
+		} else {
+			counter->count = -1;
+		}
+
+		ulong = gatorfs_find_ulong(counter->name, "key");
+		counter->key = ulong ? *ulong->val : 0;
+
+		ulong = gatorfs_find_ulong(counter->name, "cores");
+		counter->cores = ulong ? *ulong->val : -1;
+	}
+}
+
+static ssize_t config_read(struct file *file, char __user *buf, size_t count, loff_t *offset)
+{
+	ssize_t retval;
+
+	mutex_lock(&start_mutex);
+	retval = simple_read_from_buffer(buf, count, offset, gator_config, gator_config_size);
+	mutex_unlock(&start_mutex);
+
+	return retval;
+}
+
+static ssize_t config_write(struct file *file, char const __user *buf, size_t count, loff_t *offset)
+{
+	struct gator_config_header *header;
+	char *config;
+	int retval = 0;
+
+	if (*offset || count < sizeof(*header) || count > sizeof(*header) + GATOR_CONFIG_MAX_COUNTERS * sizeof(struct gator_config_counter))
+		return -EINVAL;
+
+	config = vmalloc(count);
+	if (!config)
+		return -ENOMEM;
+
+	if (copy_from_user(config, buf, count)) {
+		vfree(config);
+		return -EFAULT;
+	}
+	header = (struct gator_config_header *)config;
+
+	mutex_lock(&start_mutex);
+
+	if (gator_started) {
+		retval = -EBUSY;
+	} else if (!gator_config_validate(header, count)) {
+		retval = -EINVAL;
+	} else {
+		if (header->flags & GATOR_CONFIG_COUNTERS)
+			gator_config_apply_counters(header);
+
+		if (header->flags & GATOR_CONFIG_SESSION) {
+			gator_backtrace_depth = header->backtrace_depth;
+			gator_timer_count = header->tick;
+			gator_response_type = header->response_type;
+			gator_compact_counters = header->compact_counters;
+			gator_live_rate = header->live_rate;
+		}
+
+		vfree(gator_config);
+		gator_config = config;
+		gator_config_size = count;
+		config = NULL;
+	}
+
+	mutex_unlock(&start_mutex);
+
+	vfree(config);
+
+	if (retval)
+		return retval;
+	return count;
+}
+
+static const struct file_operations config_fops = {
+	.read = config_read,
+	.write = config_write
+};
+
 static void gator_op_create_files(struct super_block *sb, struct dentry *root)
 {
 	struct dentry *dir;
@@ -1335,15 +1534,18 @@ static void gator_op_create_files(struct super_block *sb, struct dentry *root)
 	}
 	userspace_buffer_size = BACKTRACE_BUFFER_SIZE;
 	gator_response_type = 1;
+	gator_compact_counters = 0;
 	gator_live_rate = 0;
 
 	gatorfs_create_file(sb, root, "enable", &enable_fops);
 	gatorfs_create_file(sb, root, "buffer", &gator_event_buffer_fops);
 	gatorfs_create_file(sb, root, "backtrace_depth", &depth_fops);
+	gatorfs_create_file_perm(sb, root, "session_config", &config_fops, 0600);
 	gatorfs_create_ro_ulong(sb, root, "cpu_cores", &gator_cpu_cores);
 	gatorfs_create_ro_ulong(sb, root, "buffer_size", &userspace_buffer_size);
 	gatorfs_create_ulong(sb, root, "tick", &gator_timer_count);
 	gatorfs_create_ulong(sb, root, "response_type", &gator_response_type);
+	gatorfs_create_ulong(sb, root, "compact_counters", &gator_compact_counters);
 	gatorfs_create_ro_ulong(sb, root, "version", &gator_protocol_version);
 	gatorfs_create_ro_u64(sb, root, "started", &gator_monotonic_started);
 	gatorfs_create_u64(sb, root, "live_rate", &gator_live_rate);
@@ -1388,9 +1590,6 @@ static void gator_op_create_files(struct super_block *sb, struct dentry *root)
 	GATOR_HANDLE_TRACEPOINT(mali_sw_counters); \
 	GATOR_HANDLE_TRACEPOINT(mali_timeline_event); \
 	GATOR_HANDLE_TRACEPOINT(mali_total_alloc_pages_change); \
-	GATOR_HANDLE_TRACEPOINT(mm_page_alloc); \
-	GATOR_HANDLE_TRACEPOINT(mm_page_free); \
-	GATOR_HANDLE_TRACEPOINT(mm_page_free_batched); \
 	GATOR_HANDLE_TRACEPOINT(sched_process_exec); \
 	GATOR_HANDLE_TRACEPOINT(sched_process_fork); \
 	GATOR_HANDLE_TRACEPOINT(sched_process_free); \
@@ -119,10 +119,14 @@ static bool marshal_backtrace_header(int exec_cookie, int tgid, int pid, u64 tim
 		return false;
 	}
 
-	gator_buffer_write_packed_int64(cpu, BACKTRACE_BUF, time);
-	gator_buffer_write_packed_int(cpu, BACKTRACE_BUF, exec_cookie);
-	gator_buffer_write_packed_int(cpu, BACKTRACE_BUF, tgid);
-	gator_buffer_write_packed_int(cpu, BACKTRACE_BUF, pid);
+	{
+		char record[MAXSIZE_PACK64 + 3 * MAXSIZE_PACK32];
+		int len = gator_pack_int64(record, time);
+		len += gator_pack_int(record + len, exec_cookie);
+		len += gator_pack_int(record + len, tgid);
+		len += gator_pack_int(record + len, pid);
+		gator_buffer_write_bytes(cpu, BACKTRACE_BUF, record, len);
+	}
 
 	return true;
 }
@@ -130,11 +134,14 @@ static bool marshal_backtrace_header(int exec_cookie, int tgid, int pid, u64 tim
 static void marshal_backtrace(unsigned long address, int cookie, int in_kernel)
 {
 	int cpu = get_physical_cpu();
+	char record[MAXSIZE_PACK32 + MAXSIZE_PACK64];
+	int len;
 	if (cookie == 0 && !in_kernel) {
 		cookie = UNRESOLVED_COOKIE;
 	}
-	gator_buffer_write_packed_int(cpu, BACKTRACE_BUF, cookie);
-	gator_buffer_write_packed_int64(cpu, BACKTRACE_BUF, address);
+	len = gator_pack_int(record, cookie);
+	len += gator_pack_int64(record + len, address);
+	gator_buffer_write_bytes(cpu, BACKTRACE_BUF, record, len);
 }
 
 static void marshal_backtrace_footer(u64 time)
@@ -150,11 +157,19 @@ static bool marshal_event_header(u64 time)
 {
 	unsigned long flags, cpu = get_physical_cpu();
 	bool retval = false;
+	char record[MAXSIZE_PACK32 + MAXSIZE_PACK64];
+	int len;
 
 	local_irq_save(flags);
-	if (buffer_check_space(cpu, BLOCK_COUNTER_BUF, MAXSIZE_PACK32 + MAXSIZE_PACK64)) {
-		gator_buffer_write_packed_int(cpu, BLOCK_COUNTER_BUF, 0);	// key of zero indicates a timestamp
-		gator_buffer_write_packed_int64(cpu, BLOCK_COUNTER_BUF, time);
+	if (gator_compact_counters) {
+		if (buffer_check_space(cpu, BLOCK_COUNTER_BUF, 3 * MAXSIZE_PACK32 + MAXSIZE_PACK64)) {
+			compact_timestamp(cpu, time);
+			retval = true;
+		}
+	} else if (buffer_check_space(cpu, BLOCK_COUNTER_BUF, MAXSIZE_PACK32 + MAXSIZE_PACK64)) {
+		len = gator_pack_int(record, 0);	// key of zero indicates a timestamp
+		len += gator_pack_int64(record + len, time);
+		gator_buffer_write_bytes(cpu, BLOCK_COUNTER_BUF, record, len);
 		retval = true;
 	}
 	local_irq_restore(flags);
@@ -165,6 +180,8 @@ static bool marshal_event_header(u64 time)
 static void marshal_event(int len, int *buffer)
 {
 	unsigned long i, flags, cpu = get_physical_cpu();
+	char record[2 * MAXSIZE_PACK32];
+	int pair;
 
 	if (len <= 0)
 		return;
@@ -178,11 +195,19 @@ static void marshal_event(int len, int *buffer)
 	// events must be written in key,value pairs
 	local_irq_save(flags);
 	for (i = 0; i < len; i += 2) {
+		if (gator_compact_counters) {
+			if (!buffer_check_space(cpu, BLOCK_COUNTER_BUF, 3 * MAXSIZE_PACK32 + MAXSIZE_PACK64)) {
+				break;
+			}
+			compact_event(cpu, buffer[i], buffer[i + 1]);
+			continue;
+		}
 		if (!buffer_check_space(cpu, BLOCK_COUNTER_BUF, 2 * MAXSIZE_PACK32)) {
 			break;
 		}
-		gator_buffer_write_packed_int(cpu, BLOCK_COUNTER_BUF, buffer[i]);
-		gator_buffer_write_packed_int(cpu, BLOCK_COUNTER_BUF, buffer[i + 1]);
+		pair = gator_pack_int(record, buffer[i]);
+		pair += gator_pack_int(record + pair, buffer[i + 1]);
+		gator_buffer_write_bytes(cpu, BLOCK_COUNTER_BUF, record, pair);
 	}
 	local_irq_restore(flags);
 }
@@ -190,6 +215,8 @@ static void marshal_event(int len, int *buffer)
 static void marshal_event64(int len, long long *buffer64)
 {
 	unsigned long i, flags, cpu = get_physical_cpu();
+	char record[2 * MAXSIZE_PACK64];
+	int pair;
 
 	if (len <= 0)
 		return;
@@ -203,11 +230,19 @@ static void marshal_event64(int len, long long *buffer64)
 	// events must be written in key,value pairs
 	local_irq_save(flags);
 	for (i = 0; i < len; i += 2) {
+		if (gator_compact_counters) {
+			if (!buffer_check_space(cpu, BLOCK_COUNTER_BUF, 3 * MAXSIZE_PACK32 + MAXSIZE_PACK64)) {
+				break;
+			}
+			compact_event(cpu, buffer64[i], buffer64[i + 1]);
+			continue;
+		}
 		if (!buffer_check_space(cpu, BLOCK_COUNTER_BUF, 2 * MAXSIZE_PACK64)) {
 			break;
 		}
-		gator_buffer_write_packed_int64(cpu, BLOCK_COUNTER_BUF, buffer64[i]);
-		gator_buffer_write_packed_int64(cpu, BLOCK_COUNTER_BUF, buffer64[i + 1]);
+		pair = gator_pack_int64(record, buffer64[i]);
+		pair += gator_pack_int64(record + pair, buffer64[i + 1]);
+		gator_buffer_write_bytes(cpu, BLOCK_COUNTER_BUF, record, pair);
 	}
 	local_irq_restore(flags);
 }
@@ -256,6 +291,8 @@ static void marshal_sched_trace_switch(int pid, int state)
 {
 	unsigned long cpu = get_physical_cpu(), flags;
 	u64 time;
+	char record[MAXSIZE_PACK64 + 3 * MAXSIZE_PACK32];
+	int len;
 
 	if (!per_cpu(gator_buffer, cpu)[SCHED_TRACE_BUF])
 		return;
@@ -263,10 +300,11 @@ static void marshal_sched_trace_switch(int pid, int state)
 	local_irq_save(flags);
 	time = gator_get_time();
 	if (buffer_check_space(cpu, SCHED_TRACE_BUF, MAXSIZE_PACK64 + 5 * MAXSIZE_PACK32)) {
-		gator_buffer_write_packed_int(cpu, SCHED_TRACE_BUF, MESSAGE_SCHED_SWITCH);
-		gator_buffer_write_packed_int64(cpu, SCHED_TRACE_BUF, time);
-		gator_buffer_write_packed_int(cpu, SCHED_TRACE_BUF, pid);
-		gator_buffer_write_packed_int(cpu, SCHED_TRACE_BUF, state);
+		len = gator_pack_int(record, MESSAGE_SCHED_SWITCH);
+		len += gator_pack_int64(record + len, time);
+		len += gator_pack_int(record + len, pid);
+		len += gator_pack_int(record + len, state);
+		gator_buffer_write_bytes(cpu, SCHED_TRACE_BUF, record, len);
 	}
 	local_irq_restore(flags);
 	// Check and commit; commit is set to occur once buffer is 3/4 full
@@ -335,20 +373,23 @@ static void marshal_activity_switch(int core, int key, int activity, int pid, in
 {
 	unsigned long cpu = get_physical_cpu(), flags;
 	u64 time;
+	char record[MAXSIZE_PACK64 + 6 * MAXSIZE_PACK32];
+	int len;
 
 	if (!per_cpu(gator_buffer, cpu)[ACTIVITY_BUF])
 		return;
 
 	local_irq_save(flags);
 	time = gator_get_time();
-	if (buffer_check_space(cpu, ACTIVITY_BUF, MAXSIZE_PACK64 + 5 * MAXSIZE_PACK32)) {
-		gator_buffer_write_packed_int(cpu, ACTIVITY_BUF, MESSAGE_SWITCH);
-		gator_buffer_write_packed_int64(cpu, ACTIVITY_BUF, time);
-		gator_buffer_write_packed_int(cpu, ACTIVITY_BUF, core);
-		gator_buffer_write_packed_int(cpu, ACTIVITY_BUF, key);
-		gator_buffer_write_packed_int(cpu, ACTIVITY_BUF, activity);
-		gator_buffer_write_packed_int(cpu, ACTIVITY_BUF, pid);
-		gator_buffer_write_packed_int(cpu, ACTIVITY_BUF, state);
+	if (buffer_check_space(cpu, ACTIVITY_BUF, MAXSIZE_PACK64 + 6 * MAXSIZE_PACK32)) {
+		len = gator_pack_int(record, MESSAGE_SWITCH);
+		len += gator_pack_int64(record + len, time);
+		len += gator_pack_int(record + len, core);
+		len += gator_pack_int(record + len, key);
+		len += gator_pack_int(record + len, activity);
+		len += gator_pack_int(record + len, pid);
+		len += gator_pack_int(record + len, state);
+		gator_buffer_write_bytes(cpu, ACTIVITY_BUF, record, len);
 	}
 	local_irq_restore(flags);
 	// Check and commit; commit is set to occur once buffer is 3/4 full
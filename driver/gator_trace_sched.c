@@ -12,6 +12,8 @@
 
 #define TASK_MAP_ENTRIES		1024	/* must be power of 2 */
 #define TASK_MAX_COLLISIONS		2
+// Minimum time between read_proc calls for a task when the sampling tick is disabled
+#define READ_PROC_DEFAULT_INTERVAL	(NSEC_PER_SEC / 100)
 
 enum {
 	STATE_WAIT_ON_OTHER = 0,
@@ -20,8 +22,26 @@ enum {
 	CPU_WAIT_TOTAL
 };
 
-static DEFINE_PER_CPU(uint64_t *, taskname_keys);
+// TASK_COMM_LEN is a multiple of 8 on every supported kernel, checked in gator_trace_sched_start
+#define TASK_COMM_WORDS			(TASK_COMM_LEN / sizeof(u64))
+
+// The comm is kept as words so that a hit is a few integer compares rather than a string copy and compare.
+// A new task at the same address, an exec or a prctl(PR_SET_NAME) changes the task, pid or words and misses
+struct task_name {
+	struct task_struct *task;
+	int pid;
+	u64 comm[TASK_COMM_WORDS];
+};
+
+struct task_proc {
+	int pid;
+	u64 time;
+};
+
+static DEFINE_PER_CPU(struct task_name *, task_names);
+static DEFINE_PER_CPU(struct task_proc *, task_procs);
 static DEFINE_PER_CPU(int, collecting);
+static u64 read_proc_interval;
 
 // this array is never read as the cpu wait charts are derived counters
 // the files are needed, nonetheless, to show that these counters are available
@@ -53,40 +73,52 @@ static int sched_trace_create_files(struct super_block *sb, struct dentry *root)
 
 static void emit_pid_name(struct task_struct *task)
 {
-	bool found = false;
 	char taskcomm[TASK_COMM_LEN + 3];
+	u64 comm[TASK_COMM_WORDS];
 	unsigned long x, cpu = get_physical_cpu();
-	uint64_t *keys = &(per_cpu(taskname_keys, cpu)[(task->pid & 0xFF) * TASK_MAX_COLLISIONS]);
-	uint64_t value;
+	struct task_name *names = &(per_cpu(task_names, cpu)[(task->pid & (TASK_MAP_ENTRIES - 1)) * TASK_MAX_COLLISIONS]);
+	size_t len;
 
-	value = gator_chksum_crc32(task->comm);
-	value = (value << 32) | (uint32_t)task->pid;
+	// Take a copy as task->comm may change underneath us, cannot use get_task_comm, as it's not exported on all kernel versions.
+	// A torn copy only costs an extra thread name message
+	memcpy(comm, task->comm, sizeof(comm));
 
 	// determine if the thread name was emitted already
 	for (x = 0; x < TASK_MAX_COLLISIONS; x++) {
-		if (keys[x] == value) {
-			found = true;
-			break;
+		if (names[x].task == task && names[x].pid == task->pid && names[x].comm[0] == comm[0] && names[x].comm[1] == comm[1]) {
+			return;
 		}
 	}
 
-	if (!found) {
-		// shift values, new value always in front
-		uint64_t oldv, newv = value;
-		for (x = 0; x < TASK_MAX_COLLISIONS; x++) {
-			oldv = keys[x];
-			keys[x] = newv;
-			newv = oldv;
-		}
+	// shift values, new value always in front
+	memmove(&names[1], &names[0], (TASK_MAX_COLLISIONS - 1) * sizeof(*names));
+	names[0].task = task;
+	names[0].pid = task->pid;
+	memcpy(names[0].comm, comm, sizeof(comm));
+
+	memcpy(taskcomm, comm, TASK_COMM_LEN);
+	taskcomm[TASK_COMM_LEN - 1] = '\0';
+	len = strlen(taskcomm);
+	if (len == TASK_COMM_LEN - 1) {
+		// append ellipses if task->comm has length of TASK_COMM_LEN - 1
+		strcat(taskcomm, "...");
+	}
 
-		// emit pid names, cannot use get_task_comm, as it's not exported on all kernel versions
-		if (strlcpy(taskcomm, task->comm, TASK_COMM_LEN) == TASK_COMM_LEN - 1) {
-			// append ellipses if task->comm has length of TASK_COMM_LEN - 1
-			strcat(taskcomm, "...");
-		}
+	marshal_thread_name(task->pid, taskcomm);
+}
+
+// Returns true if read_proc should be called for this task, limiting it to once per interval as it is called on every context switch
+static bool read_proc_due(int cpu, struct task_struct *task, u64 time)
+{
+	struct task_proc *proc = &(per_cpu(task_procs, cpu)[task->pid & (TASK_MAP_ENTRIES - 1)]);
 
-		marshal_thread_name(task->pid, taskcomm);
+	if (proc->pid == task->pid && time - proc->time < read_proc_interval) {
+		return false;
 	}
+
+	proc->pid = task->pid;
+	proc->time = time;
+	return true;
 }
 
 static void collect_counters(u64 time, struct task_struct *task)
@@ -94,8 +126,10 @@ static void collect_counters(u64 time, struct task_struct *task)
 	int *buffer, len, cpu = get_physical_cpu();
 	long long *buffer64;
 	struct gator_interface *gi;
+	bool read_proc;
 
 	if (marshal_event_header(time)) {
+		read_proc = task != NULL && read_proc_due(cpu, task, time);
 		list_for_each_entry(gi, &gator_events, list) {
 			if (gi->read) {
 				len = gi->read(&buffer);
@@ -104,7 +138,7 @@ static void collect_counters(u64 time, struct task_struct *task)
 				len = gi->read64(&buffer64);
 				marshal_event64(len, buffer64);
 			}
-			if (gi->read_proc && task != NULL) {
+			if (gi->read_proc && read_proc) {
 				len = gi->read_proc(&buffer64, task);
 				marshal_event64(len, buffer64);
 			}
@@ -260,7 +294,10 @@ static void gator_trace_sched_stop(void)
 	unregister_scheduler_tracepoints();
 
 	for_each_present_cpu(cpu) {
-		kfree(per_cpu(taskname_keys, cpu));
+		kfree(per_cpu(task_names, cpu));
+		per_cpu(task_names, cpu) = NULL;
+		kfree(per_cpu(task_procs, cpu));
+		per_cpu(task_procs, cpu) = NULL;
 	}
 }
 
@@ -269,14 +306,23 @@ static int gator_trace_sched_start(void)
 	int cpu, size;
 	int ret;
 
+	BUILD_BUG_ON(TASK_COMM_WORDS != 2 || TASK_COMM_LEN % sizeof(u64) != 0);
+
 	for_each_present_cpu(cpu) {
-		size = TASK_MAP_ENTRIES * TASK_MAX_COLLISIONS * sizeof(uint64_t);
-		per_cpu(taskname_keys, cpu) = (uint64_t *)kmalloc(size, GFP_KERNEL);
-		if (!per_cpu(taskname_keys, cpu))
+		size = TASK_MAP_ENTRIES * TASK_MAX_COLLISIONS * sizeof(struct task_name);
+		per_cpu(task_names, cpu) = (struct task_name *)kzalloc(size, GFP_KERNEL);
+		if (!per_cpu(task_names, cpu))
+			return -1;
+
+		size = TASK_MAP_ENTRIES * sizeof(struct task_proc);
+		per_cpu(task_procs, cpu) = (struct task_proc *)kzalloc(size, GFP_KERNEL);
+		if (!per_cpu(task_procs, cpu))
 			return -1;
-		memset(per_cpu(taskname_keys, cpu), 0, size);
 	}
 
+	// Sample per process counters no more often than the sampling tick
+	read_proc_interval = gator_timer_count > 0 ? NSEC_PER_SEC / gator_timer_count : READ_PROC_DEFAULT_INTERVAL;
+
 	ret = register_scheduler_tracepoints();
 
 	return ret;
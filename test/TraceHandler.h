@@ -0,0 +1,126 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef TRACEHANDLER_H
+#define TRACEHANDLER_H
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "GatorDecode.h"
+
+// Writes a line of text for each decoded message so that two decodes, or a decode and the calls an encoder was given, can be compared with strcmp.
+// The encoded bytes are not part of the trace, so frame is only the type and core and message is not traced
+class TraceHandler : public GatorDecodeHandler {
+public:
+	TraceHandler() : mBuf(NULL), mLength(0), mCapacity(0), mErrors(0) {
+		clear();
+	}
+
+	~TraceHandler() {
+		free(mBuf);
+	}
+
+	void clear() {
+		mLength = 0;
+		mErrors = 0;
+		append("%s", "");
+	}
+
+	const char *get() const { return mBuf; }
+	int getLength() const { return mLength; }
+	int getErrors() const { return mErrors; }
+
+	void append(const char *const format, ...) __attribute__((format(printf, 2, 3))) {
+		for (;;) {
+			va_list ap;
+			va_start(ap, format);
+			const int length = vsnprintf(mBuf + mLength, mCapacity - mLength, format, ap);
+			va_end(ap);
+			if (length < 0) {
+				abort();
+			}
+			if (mLength + length < mCapacity) {
+				mLength += length;
+				return;
+			}
+			mCapacity = 2 * (mLength + length + 1);
+			mBuf = (char *)realloc(mBuf, mCapacity);
+			if (mBuf == NULL) {
+				abort();
+			}
+		}
+	}
+
+	void frame(int type, int core, const uint8_t *, int) { append("frame %i %i\n", type, core); }
+	void error(const char *message, int64_t offset) { ++mErrors; append("error %s at %" PRId64 "\n", message, offset); }
+
+	void summary(int64_t timestamp, int64_t uptime, int64_t monotonicDelta) { append("summary %" PRId64 " %" PRId64 " %" PRId64 "\n", timestamp, uptime, monotonicDelta); }
+	void summaryAttr(const char *key, int keyLength, const char *value, int valueLength) { append("summaryAttr %.*s %.*s\n", keyLength, key, valueLength, value); }
+	void coreName(int core, int cpuid, const char *name, int length) { append("coreName %i %i %.*s\n", core, cpuid, length, name); }
+	void backtrace(int core, int64_t time, int execCookie, int tgid, int pid) { append("backtrace %i %" PRId64 " %i %i %i\n", core, time, execCookie, tgid, pid); }
+	void backtraceAddress(int core, int cookie, int64_t address) { append("backtraceAddress %i %i %" PRIx64 "\n", core, cookie, address); }
+	void cookie(int core, int cookie, const char *name, int length) { append("cookie %i %i %.*s\n", core, cookie, length, name); }
+	void threadName(int core, int64_t time, int pid, const char *name, int length) { append("threadName %i %" PRId64 " %i %.*s\n", core, time, pid, length, name); }
+	void link(int core, int64_t time, int cookie, int tgid, int pid) { append("link %i %" PRId64 " %i %i %i\n", core, time, cookie, tgid, pid); }
+	void counter(int core, int64_t time, int key, int64_t value) { append("counter %i %" PRId64 " %i %" PRId64 "\n", core, time, key, value); }
+	void annotate(int core, int pid, int64_t time, const uint8_t *data, int length) { append("annotate %i %i %" PRId64 " %.*s\n", core, pid, time, length, (const char *)data); }
+	void schedSwitch(int core, int64_t time, int pid, int state) { append("schedSwitch %i %" PRId64 " %i %i\n", core, time, pid, state); }
+	void schedExit(int core, int64_t time, int pid) { append("schedExit %i %" PRId64 " %i\n", core, time, pid); }
+	void idle(int core, int64_t time, int state) { append("idle %i %" PRId64 " %i\n", core, time, state); }
+	void activitySwitch(int core, int64_t time, int key, int activity, int pid, int state) { append("activitySwitch %i %" PRId64 " %i %i %i %i\n", core, time, key, activity, pid, state); }
+	void external(int fd, const uint8_t *, int length) { append("external %i %i\n", fd, length); }
+	void pea(int core, const uint8_t *, int size, int key) { append("pea %i %i %i\n", core, size, key); }
+	void key(int core, uint64_t id, int key) { append("key %i %" PRIu64 " %i\n", core, id, key); }
+	void keysOld(int core, const int *, int keyCount, const uint8_t *, int length) { append("keysOld %i %i %i\n", core, keyCount, length); }
+	void format(int core, const char *format, int length) { append("format %i %.*s\n", core, length, format); }
+	void maps(int core, int pid, int tid, const char *maps, int length) { append("maps %i %i %i %.*s\n", core, pid, tid, length, maps); }
+	void comm(int core, int pid, int tid, const char *image, int imageLength, const char *comm, int commLength) { append("comm %i %i %i %.*s %.*s\n", core, pid, tid, imageLength, image, commLength, comm); }
+	void internedString(int core, int id, const char *str, int length) { append("internedString %i %i %.*s\n", core, id, length, str); }
+	void commId(int core, int pid, int tid, int imageId, int commId) { append("commId %i %i %i %i %i\n", core, pid, tid, imageId, commId); }
+	void mapping(int core, int pid, int tid, uint64_t start, uint64_t end, uint64_t offset, int flags, int pathId) { append("mapping %i %i %i %" PRIx64 " %" PRIx64 " %" PRIx64 " %i %i\n", core, pid, tid, start, end, offset, flags, pathId); }
+	void perf(int cpu, const uint8_t *, int length) { append("perf %i %i\n", cpu, length); }
+
+private:
+	char *mBuf;
+	int mLength;
+	int mCapacity;
+	int mErrors;
+
+	// Intentionally unimplemented
+	TraceHandler(const TraceHandler &);
+	TraceHandler &operator=(const TraceHandler &);
+};
+
+// Prints the first line where the traces differ, returns true if they are the same
+static inline bool compareTraces(const char *const name, const char *const expected, const char *const actual) {
+	if (strcmp(expected, actual) == 0) {
+		return true;
+	}
+	int line = 1;
+	const char *e = expected;
+	const char *a = actual;
+	while (*e == *a) {
+		if (*e == '\n') {
+			++line;
+		}
+		++e;
+		++a;
+	}
+	while (e > expected && e[-1] != '\n') {
+		--e;
+		--a;
+	}
+	printf("%s: line %i differs\n  expected: %.*s\n  actual:   %.*s\n", name, line, (int)strcspn(e, "\n"), e, (int)strcspn(a, "\n"), a);
+	return false;
+}
+
+#endif // TRACEHANDLER_H
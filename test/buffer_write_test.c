@@ -0,0 +1,242 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ */
+
+// Userspace harness for the driver's gator_buffer_write.c. Every write is done with both the driver's encoder and the byte at a time
+// encoder it replaced, into rings small enough to wrap often, and the rings must stay byte identical. Then the ns per sched_switch
+// record of each is measured
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "driver_shim.h"
+
+// Use the sched trace buffer, the comparison uses a smaller ring so that writes wrap often
+#define BUF SCHED_TRACE_BUF
+#define RING_SIZE SCHED_TRACE_BUFFER_SIZE
+#define TEST_RING_SIZE 4096
+
+#include "../driver/gator_buffer_write.c"
+
+// The encoder before the contiguous fast path
+static void ref_buffer_write_packed_int(int cpu, int buftype, int x)
+{
+	uint32_t write = per_cpu(gator_buffer_write, cpu)[buftype];
+	uint32_t mask = gator_buffer_mask[buftype];
+	char *buffer = per_cpu(gator_buffer, cpu)[buftype];
+	int packedBytes = 0;
+	int more = true;
+	while (more) {
+		// low order 7 bits of x
+		char b = x & 0x7f;
+		x >>= 7;
+
+		if ((x == 0 && (b & 0x40) == 0) || (x == -1 && (b & 0x40) != 0)) {
+			more = false;
+		} else {
+			b |= 0x80;
+		}
+
+		buffer[(write + packedBytes) & mask] = b;
+		packedBytes++;
+	}
+
+	per_cpu(gator_buffer_write, cpu)[buftype] = (write + packedBytes) & mask;
+}
+
+static void ref_buffer_write_packed_int64(int cpu, int buftype, long long x)
+{
+	uint32_t write = per_cpu(gator_buffer_write, cpu)[buftype];
+	uint32_t mask = gator_buffer_mask[buftype];
+	char *buffer = per_cpu(gator_buffer, cpu)[buftype];
+	int packedBytes = 0;
+	int more = true;
+	while (more) {
+		// low order 7 bits of x
+		char b = x & 0x7f;
+		x >>= 7;
+
+		if ((x == 0 && (b & 0x40) == 0) || (x == -1 && (b & 0x40) != 0)) {
+			more = false;
+		} else {
+			b |= 0x80;
+		}
+
+		buffer[(write + packedBytes) & mask] = b;
+		packedBytes++;
+	}
+
+	per_cpu(gator_buffer_write, cpu)[buftype] = (write + packedBytes) & mask;
+}
+
+static void ref_buffer_write_bytes(int cpu, int buftype, const char *x, int len)
+{
+	int i;
+	u32 write = per_cpu(gator_buffer_write, cpu)[buftype];
+	u32 mask = gator_buffer_mask[buftype];
+	char *buffer = per_cpu(gator_buffer, cpu)[buftype];
+
+	for (i = 0; i < len; i++) {
+		buffer[write] = x[i];
+		write = (write + 1) & mask;
+	}
+
+	per_cpu(gator_buffer_write, cpu)[buftype] = write;
+}
+
+static void ref_buffer_write_string(int cpu, int buftype, const char *x)
+{
+	int len = strlen(x);
+	ref_buffer_write_packed_int(cpu, buftype, len);
+	ref_buffer_write_bytes(cpu, buftype, x, len);
+}
+
+// As marshal_sched_trace_switch writes it now, packed on the stack and written at once
+static void sched_switch(int cpu, u64 time, int pid, int state)
+{
+	char record[MAXSIZE_PACK64 + 3 * MAXSIZE_PACK32];
+	int len;
+
+	len = gator_pack_int(record, MESSAGE_SCHED_SWITCH);
+	len += gator_pack_int64(record + len, time);
+	len += gator_pack_int(record + len, pid);
+	len += gator_pack_int(record + len, state);
+	gator_buffer_write_bytes(cpu, BUF, record, len);
+}
+
+// As marshal_sched_trace_switch wrote it before
+static void ref_sched_switch(int cpu, u64 time, int pid, int state)
+{
+	ref_buffer_write_packed_int(cpu, BUF, MESSAGE_SCHED_SWITCH);
+	ref_buffer_write_packed_int64(cpu, BUF, time);
+	ref_buffer_write_packed_int(cpu, BUF, pid);
+	ref_buffer_write_packed_int(cpu, BUF, state);
+}
+
+static uint64_t seed = 88172645463325252ULL;
+
+static uint64_t next_random(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 7;
+	seed ^= seed << 17;
+	return seed;
+}
+
+static long long random_value(void)
+{
+	const uint64_t r = next_random();
+	const int bits = (int)((r >> 2) % 64);
+	long long value = (long long)(next_random() & (bits == 63 ? ~0ULL : (2ULL << bits) - 1));
+	return (r & 3) == 0 ? -value : value;
+}
+
+struct ring {
+	char buf[RING_SIZE];
+	int write;
+};
+
+static struct ring rings[2];
+
+static void use_ring(struct ring *ring)
+{
+	gator_buffer[0][BUF] = ring->buf;
+	gator_buffer_write[0][BUF] = ring->write;
+}
+
+static void save_ring(struct ring *ring)
+{
+	ring->write = gator_buffer_write[0][BUF];
+}
+
+static bool test_identical(void)
+{
+	static const char *const strings[] = { "", "a", "kworker/0:1", "/usr/lib/arm-linux-gnueabihf/libc-2.19.so" };
+	char bytes[300];
+	int op;
+
+	gator_buffer_size[BUF] = TEST_RING_SIZE;
+	gator_buffer_mask[BUF] = TEST_RING_SIZE - 1;
+	memset(rings, 0, sizeof(rings));
+
+	for (op = 0; op < 1000000; ++op) {
+		const int kind = (int)(next_random() % 5);
+		const long long value = random_value();
+		const int len = (int)(next_random() % sizeof(bytes));
+		int i;
+
+		for (i = 0; i < len; ++i) {
+			bytes[i] = (char)next_random();
+		}
+		for (i = 0; i < 2; ++i) {
+			use_ring(&rings[i]);
+			switch (kind) {
+			case 0:
+				(i == 0 ? ref_buffer_write_packed_int : gator_buffer_write_packed_int)(0, BUF, (int)value);
+				break;
+			case 1:
+				(i == 0 ? ref_buffer_write_packed_int64 : gator_buffer_write_packed_int64)(0, BUF, value);
+				break;
+			case 2:
+				(i == 0 ? ref_buffer_write_bytes : gator_buffer_write_bytes)(0, BUF, bytes, len);
+				break;
+			case 3:
+				(i == 0 ? ref_buffer_write_string : gator_buffer_write_string)(0, BUF, strings[len % 4]);
+				break;
+			default:
+				(i == 0 ? ref_sched_switch : sched_switch)(0, value, (int)(value >> 3), len % 3);
+				break;
+			}
+			save_ring(&rings[i]);
+		}
+
+		if (rings[0].write != rings[1].write || memcmp(rings[0].buf, rings[1].buf, TEST_RING_SIZE) != 0) {
+			printf("gator_buffer_write: output differs after operation %i of kind %i\n", op, kind);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static double bench(void (*write)(int, u64, int, int))
+{
+	const int count = 10000000;
+	struct timespec start, end;
+	int i;
+
+	use_ring(&rings[0]);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < count; ++i) {
+		// Times in ns and small pids and states as in a real capture
+		write(0, 1000000000LL + 997LL * i, 1000 + (i & 1023), i & 1);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / count;
+}
+
+int main(void)
+{
+	double ref_ns, ns;
+
+	if (!test_identical()) {
+		printf("buffer_write_test: FAILED\n");
+		return 1;
+	}
+
+	gator_buffer_size[BUF] = RING_SIZE;
+	gator_buffer_mask[BUF] = RING_SIZE - 1;
+	rings[0].write = 0;
+	ref_ns = bench(ref_sched_switch);
+	ns = bench(sched_switch);
+	printf("buffer_write_test: passed, sched_switch record %.1f ns before, %.1f ns now\n", ref_ns, ns);
+
+	return 0;
+}
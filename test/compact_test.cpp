@@ -0,0 +1,303 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+// Round trips compact block counter frames from both encoders, Buffer in the daemon and gator_buffer.c in the driver, through GatorDecoder and compares the records with those given to the encoders.
+// Also checks the times in the index CaptureFile writes beside the data
+
+#include <inttypes.h>
+#include <semaphore.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Buffer.h"
+#include "GatorDecode.h"
+#include "Logging.h"
+#include "Sender.h"
+#include "SessionData.h"
+#include "TraceHandler.h"
+#include "driver_compact.h"
+
+// Called by handleException
+void cleanUp() {
+}
+
+static const int TICK_COUNT = 20000;
+static const int MAX_KEYS = 200;
+static const int BUFFER_SIZE = 1 << 20;
+static const int MAX_FRAME_LENGTH = 128 << 10;
+
+static uint64_t gSeed = 88172645463325252ULL;
+
+static uint64_t nextRandom() {
+	gSeed ^= gSeed << 13;
+	gSeed ^= gSeed >> 7;
+	gSeed ^= gSeed << 17;
+	return gSeed;
+}
+
+// Counters mostly repeat or change by a little between ticks, which is what the compact frame is for, but sometimes take any value
+static int64_t nextValue(const int64_t value) {
+	const uint64_t r = nextRandom() % 16;
+	if (r < 9) {
+		return value;
+	}
+	if (r < 14) {
+		return value + (int64_t)(nextRandom() % 2001) - 1000;
+	}
+	// Half of the new values fit in 32 bits so that both marshal_event and marshal_event64 are used
+	return r == 14 ? (int32_t)nextRandom() : (int64_t)nextRandom();
+}
+
+// The records of one tick, key 1 is the tid and the rest are counters
+struct Tick {
+	uint64_t time;
+	int count;
+	int keys[MAX_KEYS];
+	int64_t values[MAX_KEYS];
+};
+
+// Usually the same keys in the same order as the previous tick, but sometimes counters are added, removed or reordered, and sometimes there are more than the encoders remember
+static void nextTick(Tick *const tick) {
+	tick->time += 1 + nextRandom() % 1000000;
+	const uint64_t r = nextRandom() % 64;
+	if (r == 0) {
+		tick->count = 1 + (int)(nextRandom() % MAX_KEYS);
+		for (int i = 1; i < MAX_KEYS; ++i) {
+			tick->keys[i] = 2 + (int)(nextRandom() % 1000);
+			tick->values[i] = (int64_t)nextRandom();
+		}
+	} else if (r == 1 && tick->count > 2) {
+		const int a = 1 + (int)(nextRandom() % (tick->count - 1));
+		const int b = 1 + (int)(nextRandom() % (tick->count - 1));
+		const int key = tick->keys[a];
+		tick->keys[a] = tick->keys[b];
+		tick->keys[b] = key;
+	} else if (r == 2) {
+		tick->count = 1 + (int)(nextRandom() % 40);
+	}
+	tick->values[0] = (nextRandom() % 8) == 0 ? (int)(nextRandom() % 32768) : tick->values[0];
+	for (int i = 1; i < tick->count; ++i) {
+		tick->values[i] = nextValue(tick->values[i]);
+	}
+}
+
+static void writeExpected(TraceHandler *const expected, const Tick &tick) {
+	for (int i = 0; i < tick.count; ++i) {
+		expected->counter(0, tick.time, tick.keys[i], tick.values[i]);
+	}
+}
+
+static bool writeDaemon(Buffer *const buffer, const Tick &tick) {
+	if (!buffer->eventHeader(tick.time) || !buffer->eventTid(tick.values[0])) {
+		return false;
+	}
+	for (int i = 1; i < tick.count; ++i) {
+		buffer->event64(tick.keys[i], tick.values[i]);
+		// Keys wider than 32 bits can't be compact encoded and are dropped
+		if (nextRandom() % 64 == 0) {
+			buffer->event64(((int64_t)1 << 32) + tick.keys[i], tick.values[i]);
+		}
+	}
+	return true;
+}
+
+// As collect_counters does, the records of each gator_interface are written with marshal_event if they fit in 32 bits and marshal_event64 otherwise
+static bool writeDriver(const Tick &tick) {
+	if (!driver_compact_header(tick.time)) {
+		return false;
+	}
+	int tid[2] = { 1, (int)tick.values[0] };
+	driver_compact_event(2, tid);
+
+	int i = 1;
+	while (i < tick.count) {
+		int count = 1 + (int)(nextRandom() % 8);
+		if (count > tick.count - i) {
+			count = tick.count - i;
+		}
+		bool fits = true;
+		int buffer[2 * 8];
+		long long buffer64[2 * 8];
+		for (int j = 0; j < count; ++j) {
+			fits = fits && tick.values[i + j] == (int32_t)tick.values[i + j];
+			buffer[2 * j] = tick.keys[i + j];
+			buffer[2 * j + 1] = (int32_t)tick.values[i + j];
+			buffer64[2 * j] = tick.keys[i + j];
+			buffer64[2 * j + 1] = tick.values[i + j];
+		}
+		if (fits) {
+			driver_compact_event(2 * count, buffer);
+		} else {
+			driver_compact_event64(2 * count, buffer64);
+		}
+		i += count;
+	}
+	return true;
+}
+
+static int64_t readLEInt64(const uint8_t *const buf) {
+	int64_t value = 0;
+	for (int i = 7; i >= 0; --i) {
+		value = (value << 8) | buf[i];
+	}
+	return value;
+}
+
+// Checks that CaptureIndex wrote an entry for each frame with the times of its first and last tick, see CaptureIndex.h for the layout
+static bool checkIndex(const char *const path, const int64_t *const frameTimes, const int frameCount, const int64_t dataLength) {
+	FILE *const file = fopen(path, "rb");
+	if (file == NULL) {
+		printf("compact_test: unable to open %s\n", path);
+		return false;
+	}
+	uint8_t header[8];
+	uint8_t entry[40];
+	bool ok = fread(header, sizeof(header), 1, file) == 1;
+	int64_t offset = 0;
+	int i = 0;
+	for (; ok && fread(entry, sizeof(entry), 1, file) == 1; ++i) {
+		const int64_t start = readLEInt64(entry);
+		const int64_t end = readLEInt64(entry + 8);
+		const int length = (int)readLEInt64(entry + 24) & 0x7fffffff;
+		if (i >= frameCount || start != frameTimes[2 * i] || end != frameTimes[2 * i + 1] || readLEInt64(entry + 16) != offset) {
+			printf("compact_test: index entry %i is wrong\n", i);
+			ok = false;
+		}
+		offset += length;
+	}
+	fclose(file);
+	if (ok && (i != frameCount || offset != dataLength)) {
+		printf("compact_test: the index has %i entries for %i frames\n", i, frameCount);
+		ok = false;
+	}
+	return ok;
+}
+
+static bool decode(const char *const name, const TraceHandler &expected, const uint8_t *const data, const int64_t length) {
+	TraceHandler actual;
+	if (GatorDecoder(&actual, false).decode(data, length) != length) {
+		printf("%s: not all the frames were decoded\n", name);
+		return false;
+	}
+	return compareTraces(name, expected.get(), actual.get());
+}
+
+int main() {
+	logg = new Logging(false);
+	gSessionData = new SessionData();
+	gSessionData->mLocalCapture = true;
+	gSessionData->mCompactCounters = true;
+
+	char dir[] = "/tmp/compact_test.XXXXXX";
+	if (mkdtemp(dir) == NULL) {
+		printf("compact_test: unable to create %s\n", dir);
+		return 1;
+	}
+
+	sem_t sem;
+	sem_init(&sem, 0, 0);
+	Buffer buffer(0, FRAME_BLOCK_COUNTER, BUFFER_SIZE, &sem);
+	Sender *const sender = new Sender(NULL);
+	sender->createDataFile(dir);
+	driver_compact_start();
+
+	TraceHandler expected;
+	uint8_t *const driverData = (uint8_t *)malloc((int64_t)TICK_COUNT * MAX_KEYS * 20);
+	char *const frame = (char *)malloc(MAX_FRAME_LENGTH);
+	// The first and last tick time of each frame
+	int64_t *const frameTimes = (int64_t *)malloc(2 * TICK_COUNT * sizeof(int64_t));
+	if (driverData == NULL || frame == NULL || frameTimes == NULL) {
+		printf("compact_test: malloc failed\n");
+		return 1;
+	}
+	int64_t driverLength = 0;
+	int64_t recordCount = 0;
+	int frameCount = 0;
+	bool ok = true;
+
+	Tick tick;
+	memset(&tick, 0, sizeof(tick));
+	tick.count = 40;
+	for (int i = 0; i < MAX_KEYS; ++i) {
+		tick.keys[i] = i + 1;
+	}
+	int ticksInFrame = 0;
+	for (int i = 0; i < TICK_COUNT && ok; ++i) {
+		nextTick(&tick);
+		if (ticksInFrame == 0) {
+			expected.frame(GATOR_FRAME_BLOCK_COUNTER_COMPACT, 0, NULL, 0);
+			frameTimes[2 * frameCount] = tick.time;
+			++frameCount;
+		}
+		frameTimes[2 * frameCount - 1] = tick.time;
+		writeExpected(&expected, tick);
+		recordCount += tick.count;
+		if (!writeDaemon(&buffer, tick) || !writeDriver(tick)) {
+			printf("compact_test: out of buffer space at tick %i\n", i);
+			ok = false;
+		}
+
+		// Commit after a random number of ticks, as the buffers do when they fill or the live rate expires
+		++ticksInFrame;
+		if (nextRandom() % 8 == 0 || i == TICK_COUNT - 1) {
+			buffer.commit(tick.time);
+			buffer.write(sender);
+			const int length = driver_compact_commit(frame, MAX_FRAME_LENGTH);
+			memcpy(driverData + driverLength, frame, length);
+			driverLength += length;
+			ticksInFrame = 0;
+		}
+	}
+
+	// Flushes the data file
+	delete sender;
+	driver_compact_stop();
+
+	char path[64];
+	snprintf(path, sizeof(path), "%s/0000000000", dir);
+	FILE *const file = fopen(path, "rb");
+	if (file == NULL) {
+		printf("compact_test: unable to open %s\n", path);
+		return 1;
+	}
+	fseek(file, 0, SEEK_END);
+	const int64_t daemonLength = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	uint8_t *const daemonData = (uint8_t *)malloc(daemonLength);
+	if (daemonData == NULL || fread(daemonData, 1, daemonLength, file) != (size_t)daemonLength) {
+		printf("compact_test: unable to read %s\n", path);
+		return 1;
+	}
+	fclose(file);
+	unlink(path);
+
+	snprintf(path, sizeof(path), "%s/0000000000.idx", dir);
+	ok = checkIndex(path, frameTimes, frameCount, daemonLength) && ok;
+	unlink(path);
+	rmdir(dir);
+
+	ok = decode("Buffer", expected, daemonData, daemonLength) && ok;
+	ok = decode("gator_buffer.c", expected, driverData, driverLength) && ok;
+	// Both encoders make the same frames from the same records
+	if (daemonLength != driverLength || memcmp(daemonData, driverData, daemonLength) != 0) {
+		printf("compact_test: Buffer and gator_buffer.c encoded different bytes\n");
+		ok = false;
+	}
+
+	printf("compact_test: %s, %" PRId64 " records in %" PRId64 " bytes\n", ok ? "passed" : "FAILED", recordCount, daemonLength);
+
+	free(daemonData);
+	free(frame);
+	free(driverData);
+	free(frameTimes);
+	sem_destroy(&sem);
+	return ok ? 0 : 1;
+}
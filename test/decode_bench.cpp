@@ -0,0 +1,193 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+// Single thread decode throughput of libgatordecode. Decodes the 0000000000 file of a local capture if one is given, otherwise a synthetic capture
+// shaped like the driver's: block counter frames of absolute timestamps, tids and counters of mixed widths, and sched trace frames. Perf frames are
+// left out of the synthetic capture as they are passed to the handler without decoding
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "GatorDecode.h"
+
+static const int RUNS = 5;
+static const int64_t SYNTHETIC_SIZE = 256 << 20;
+static const int FRAME_SIZE = 64 << 10;
+
+static uint64_t gSeed = 88172645463325252ULL;
+
+static uint64_t nextRandom() {
+	gSeed ^= gSeed << 13;
+	gSeed ^= gSeed >> 7;
+	gSeed ^= gSeed << 17;
+	return gSeed;
+}
+
+// Signed LEB128 as written by Buffer::packInt64
+static int pack(uint8_t *const buf, int64_t x) {
+	int length = 0;
+	for (;;) {
+		const uint8_t b = x & 0x7f;
+		x >>= 7;
+		if ((x == 0 && (b & 0x40) == 0) || (x == -1 && (b & 0x40) != 0)) {
+			buf[length++] = b;
+			return length;
+		}
+		buf[length++] = b | 0x80;
+	}
+}
+
+// Counters per tick, as collected by the driver for a cpu with a PMU, the scheduler, memory and network counters
+static const int COUNTERS = 24;
+
+// Returns the change of counter i since the last tick, the cycle and instruction counters change by millions each tick and the rest by less
+static int64_t counterDelta(const int i) {
+	const uint64_t r = nextRandom();
+	switch (i % 6) {
+	case 0:
+		return 1000000 + r % 9000000;
+	case 1:
+		return 100000 + r % 900000;
+	case 2:
+		return r % 20000;
+	case 3:
+		return r % 500;
+	case 4:
+		return r % 40;
+	default:
+		return (r % 4) == 0 ? (int64_t)(r >> 8) % 100000000 : 0;
+	}
+}
+
+static uint8_t *synthesize(int64_t *const length) {
+	uint8_t *const data = (uint8_t *)malloc(SYNTHETIC_SIZE + FRAME_SIZE);
+	if (data == NULL) {
+		return NULL;
+	}
+	int64_t pos = 0;
+	int64_t time = 1000000000000LL;
+	int tid = 1000;
+	for (int frame = 0; pos < SYNTHETIC_SIZE; ++frame) {
+		// Three in four frames are block counters, the rest sched trace
+		const bool counters = frame % 4 != 3;
+		uint8_t *const start = data + pos;
+		int n = 4;
+		n += pack(start + n, counters ? GATOR_FRAME_BLOCK_COUNTER : GATOR_FRAME_SCHED_TRACE);
+		n += pack(start + n, frame % 4);
+		while (n < FRAME_SIZE - 512) {
+			time += 100000 + nextRandom() % 1000000;
+			if (nextRandom() % 4 == 0) {
+				tid = 1000 + (int)(nextRandom() % 30000);
+			}
+			if (counters) {
+				n += pack(start + n, 0);
+				n += pack(start + n, time);
+				n += pack(start + n, GATOR_KEY_TID);
+				n += pack(start + n, tid);
+				for (int i = 0; i < COUNTERS; ++i) {
+					n += pack(start + n, 2 + i);
+					n += pack(start + n, counterDelta(i));
+				}
+			} else {
+				// MESSAGE_SCHED_SWITCH, time, pid, state
+				n += pack(start + n, 1);
+				n += pack(start + n, time);
+				n += pack(start + n, tid);
+				n += pack(start + n, nextRandom() % 2);
+			}
+		}
+		const int payload = n - 4;
+		start[0] = payload;
+		start[1] = payload >> 8;
+		start[2] = payload >> 16;
+		start[3] = payload >> 24;
+		pos += n;
+	}
+	*length = pos;
+	return data;
+}
+
+static uint8_t *readCapture(const char *const path, int64_t *const length) {
+	FILE *const file = fopen(path, "rb");
+	if (file == NULL) {
+		return NULL;
+	}
+	fseek(file, 0, SEEK_END);
+	*length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	uint8_t *const data = (uint8_t *)malloc(*length);
+	if (data != NULL && fread(data, 1, *length, file) != (size_t)*length) {
+		free(data);
+		fclose(file);
+		return NULL;
+	}
+	fclose(file);
+	return data;
+}
+
+// Consumes the decoded values so that the decoding is not optimized away
+class SumHandler : public GatorDecodeHandler {
+public:
+	SumHandler() : mSum(0), mErrors(0) {}
+
+	void error(const char *, int64_t) {
+		++mErrors;
+	}
+
+	void counters(int, const GatorCounter *const records, int count) {
+		for (int i = 0; i < count; ++i) {
+			mSum += records[i].time + records[i].key + records[i].value;
+		}
+	}
+
+	void schedSwitch(int, int64_t time, int pid, int state) {
+		mSum += time + pid + state;
+	}
+
+	void schedExit(int, int64_t time, int pid) {
+		mSum += time + pid;
+	}
+
+	int64_t mSum;
+	int mErrors;
+};
+
+int main(int argc, char *argv[]) {
+	int64_t length;
+	uint8_t *const data = argc > 1 ? readCapture(argv[1], &length) : synthesize(&length);
+	if (data == NULL) {
+		printf("decode_bench: unable to %s %s\n", argc > 1 ? "read" : "allocate", argc > 1 ? argv[1] : "the capture");
+		return 1;
+	}
+
+	double best = 0;
+	for (int i = 0; i < RUNS; ++i) {
+		SumHandler handler;
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		const int64_t decoded = GatorDecoder(&handler, false).decode(data, length);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		if (decoded != length || handler.mErrors != 0) {
+			printf("decode_bench: decoding failed after %lld bytes with %i errors\n", (long long)decoded, handler.mErrors);
+			return 1;
+		}
+		const double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+		if (i == 0 || seconds < best) {
+			best = seconds;
+		}
+	}
+
+	// The best of several runs is the least disturbed by other work on the cpu
+	printf("decode_bench: %.2f GB/s decoding %.0f MB of %s, best of %i runs\n", length / best / 1e9, length / 1e6, argc > 1 ? argv[1] : "synthetic capture", RUNS);
+
+	free(data);
+	return 0;
+}
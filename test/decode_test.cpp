@@ -0,0 +1,348 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+// Round trip oracle for libgatordecode. Frames are written by a byte at a time reference encoder, the same calls are made on a TraceHandler
+// and the trace must match what the decoder produces from the encoded bytes, whether the capture is decoded whole, fed in pieces or in parallel
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "GatorDecode.h"
+#include "TraceHandler.h"
+#include "Varint.h"
+
+static uint64_t gSeed = 88172645463325252ULL;
+
+static uint64_t nextRandom() {
+	gSeed ^= gSeed << 13;
+	gSeed ^= gSeed >> 7;
+	gSeed ^= gSeed << 17;
+	return gSeed;
+}
+
+// Mostly small values as in real captures, but every width up to 64 bits and negative values too
+static int64_t randomValue() {
+	const uint64_t r = nextRandom();
+	const int bits = (r & 3) != 0 ? (int)((r >> 2) % 14) : (int)((r >> 2) % 64);
+	int64_t value = (int64_t)(nextRandom() & (bits == 63 ? ~0ULL : (2ULL << bits) - 1));
+	return (r >> 8) % 8 == 0 ? -value : value;
+}
+
+// The capture being written, frames are [LE32 length][packed type][packed core][messages] as in the 0000000000 file of a local capture
+class Encoder {
+public:
+	Encoder() : mBuf(NULL), mLength(0), mCapacity(0), mFrameStart(-1) {}
+	~Encoder() { free(mBuf); }
+
+	const uint8_t *get() const { return mBuf; }
+	int64_t getLength() const { return mLength; }
+	int frameLength() const { return mLength - mFrameStart; }
+
+	void byte(const uint8_t b) {
+		if (mLength == mCapacity) {
+			mCapacity = 2 * mCapacity + 4096;
+			mBuf = (uint8_t *)realloc(mBuf, mCapacity);
+			if (mBuf == NULL) {
+				abort();
+			}
+		}
+		mBuf[mLength++] = b;
+	}
+
+	// Signed LEB128 written the obvious way, independent of Buffer::packInt64
+	void packed(int64_t x) {
+		for (;;) {
+			const uint8_t b = x & 0x7f;
+			x >>= 7;
+			if ((x == 0 && (b & 0x40) == 0) || (x == -1 && (b & 0x40) != 0)) {
+				byte(b);
+				return;
+			}
+			byte(b | 0x80);
+		}
+	}
+
+	void string(const char *const str) {
+		const int length = strlen(str);
+		packed(length);
+		for (int i = 0; i < length; ++i) {
+			byte(str[i]);
+		}
+	}
+
+	void beginFrame(TraceHandler *const expected, const int type, const int core) {
+		mFrameStart = mLength;
+		for (int i = 0; i < 4; ++i) {
+			byte(0);
+		}
+		packed(type);
+		packed(core);
+		expected->frame(type, core, NULL, 0);
+	}
+
+	void endFrame() {
+		const uint32_t length = mLength - mFrameStart - 4;
+		for (int i = 0; i < 4; ++i) {
+			mBuf[mFrameStart + i] = length >> (8 * i);
+		}
+	}
+
+private:
+	uint8_t *mBuf;
+	int64_t mLength;
+	int64_t mCapacity;
+	int64_t mFrameStart;
+
+	// Intentionally unimplemented
+	Encoder(const Encoder &);
+	Encoder &operator=(const Encoder &);
+};
+
+static bool testVarints() {
+	int64_t values[64 * 6 + 2];
+	int count = 0;
+	values[count++] = INT64_MIN;
+	values[count++] = INT64_MAX;
+	for (int bit = 0; bit < 64; ++bit) {
+		const int64_t power = (int64_t)(1ULL << bit);
+		values[count++] = power;
+		values[count++] = power - 1;
+		values[count++] = power + 1;
+		values[count++] = -power;
+		values[count++] = -power - 1;
+		values[count++] = -power + 1;
+	}
+
+	Encoder encoder;
+	for (int i = 0; i < count; ++i) {
+		encoder.packed(values[i]);
+	}
+
+	// One at a time
+	const uint8_t *pos = encoder.get();
+	const uint8_t *const end = pos + encoder.getLength();
+	for (int i = 0; i < count; ++i) {
+		int64_t value = 0;
+		const int bytes = varintDecode(pos, end, &value);
+		if (bytes == 0 || value != values[i]) {
+			printf("varintDecode: %lld decoded as %lld\n", (long long)values[i], (long long)value);
+			return false;
+		}
+		pos += bytes;
+	}
+
+	// In batches, which take the fast path for runs of single byte values
+	int64_t decoded[sizeof(values) / sizeof(values[0])];
+	const uint8_t *next;
+	const int decodedCount = varintDecodeBatch(encoder.get(), end, decoded, count, &next);
+	if (decodedCount != count || next != end) {
+		printf("varintDecodeBatch: decoded %i of %i values\n", decodedCount, count);
+		return false;
+	}
+	for (int i = 0; i < count; ++i) {
+		if (decoded[i] != values[i]) {
+			printf("varintDecodeBatch: %lld decoded as %lld\n", (long long)values[i], (long long)decoded[i]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Writes a capture with every frame layout that gatord writes on the host, recording the expected trace
+static void writeCapture(Encoder *const encoder, TraceHandler *const expected) {
+	encoder->beginFrame(expected, GATOR_FRAME_SUMMARY, 0);
+	encoder->packed(1);
+	encoder->string("1\n2\n3\n4\n5\n6\n7\n8\n");
+	encoder->packed(1413900000000000000LL);
+	encoder->packed(123456789);
+	encoder->packed(0);
+	encoder->string("uname");
+	encoder->string("Linux test");
+	encoder->packed(0);
+	expected->summary(1413900000000000000LL, 123456789, 0);
+	expected->summaryAttr("uname", 5, "Linux test", 10);
+	encoder->packed(3);
+	encoder->packed(1);
+	encoder->packed(0xc0f);
+	encoder->string("Cortex-A15");
+	expected->coreName(1, 0xc0f, "Cortex-A15", 10);
+	encoder->endFrame();
+
+	encoder->beginFrame(expected, GATOR_FRAME_NAME, 2);
+	encoder->packed(1);
+	encoder->packed(7);
+	encoder->string("/usr/bin/app");
+	expected->cookie(2, 7, "/usr/bin/app", 12);
+	encoder->packed(2);
+	encoder->packed(1000);
+	encoder->packed(42);
+	encoder->string("worker");
+	expected->threadName(2, 1000, 42, "worker", 6);
+	encoder->packed(4);
+	encoder->packed(1001);
+	encoder->packed(7);
+	encoder->packed(40);
+	encoder->packed(42);
+	expected->link(2, 1001, 7, 40, 42);
+	encoder->endFrame();
+
+	encoder->beginFrame(expected, GATOR_FRAME_BACKTRACE, 1);
+	encoder->packed(2000);
+	encoder->packed(7);
+	encoder->packed(40);
+	encoder->packed(42);
+	expected->backtrace(1, 2000, 7, 40, 42);
+	encoder->packed(7);
+	encoder->packed(0x8000);
+	expected->backtraceAddress(1, 7, 0x8000);
+	encoder->packed(0);
+	encoder->packed(-0x7ffffff0);
+	expected->backtraceAddress(1, 0, -0x7ffffff0);
+	encoder->packed(1);
+	encoder->endFrame();
+
+	// Block counter frames of random records, split as Buffer would when a frame fills up
+	int64_t time = 0;
+	for (int frame = 0; frame < 64; ++frame) {
+		const int core = frame % 4;
+		encoder->beginFrame(expected, GATOR_FRAME_BLOCK_COUNTER, core);
+		for (int record = 0; record < 500; ++record) {
+			if (record % 10 == 0) {
+				time += nextRandom() % 1000000;
+				encoder->packed(0);
+				encoder->packed(time);
+			}
+			const int key = 2 + (int)(nextRandom() % 200);
+			const int64_t value = randomValue();
+			encoder->packed(key);
+			encoder->packed(value);
+			expected->counter(core, time, key, value);
+		}
+		encoder->endFrame();
+
+		encoder->beginFrame(expected, GATOR_FRAME_SCHED_TRACE, core);
+		for (int message = 0; message < 50; ++message) {
+			time += nextRandom() % 10000;
+			const int pid = (int)(nextRandom() % 100000);
+			if (message % 7 == 6) {
+				encoder->packed(2);
+				encoder->packed(time);
+				encoder->packed(pid);
+				expected->schedExit(core, time, pid);
+			} else {
+				const int state = (int)(nextRandom() % 3);
+				encoder->packed(1);
+				encoder->packed(time);
+				encoder->packed(pid);
+				encoder->packed(state);
+				expected->schedSwitch(core, time, pid, state);
+			}
+		}
+		encoder->endFrame();
+
+		encoder->beginFrame(expected, GATOR_FRAME_COUNTER, 0);
+		for (int message = 0; message < 20; ++message) {
+			const int64_t value = randomValue();
+			encoder->packed(time);
+			encoder->packed(core);
+			encoder->packed(3 + message);
+			encoder->packed(value);
+			expected->counter(core, time, 3 + message, value);
+		}
+		encoder->endFrame();
+
+		encoder->beginFrame(expected, GATOR_FRAME_IDLE, 0);
+		encoder->packed(frame % 2);
+		encoder->packed(time);
+		encoder->packed(core);
+		expected->idle(core, time, frame % 2);
+		encoder->endFrame();
+	}
+
+	// A frame of an unknown type is skipped
+	encoder->beginFrame(expected, 99, 0);
+	encoder->packed(12345);
+	encoder->endFrame();
+}
+
+// Feeds the capture to the decoder in pieces of random size as a reader of the file or socket would
+static bool decodeInPieces(const Encoder &encoder, TraceHandler *const handler) {
+	GatorDecoder decoder(handler, false);
+	uint8_t *const buf = (uint8_t *)malloc(encoder.getLength());
+	if (buf == NULL) {
+		return false;
+	}
+	int64_t buffered = 0;
+	int64_t read = 0;
+	while (read < encoder.getLength()) {
+		int64_t size = 1 + nextRandom() % 5000;
+		if (size > encoder.getLength() - read) {
+			size = encoder.getLength() - read;
+		}
+		memcpy(buf + buffered, encoder.get() + read, size);
+		read += size;
+		buffered += size;
+		const int64_t used = decoder.decode(buf, buffered);
+		if (used < 0) {
+			free(buf);
+			return false;
+		}
+		memmove(buf, buf + used, buffered - used);
+		buffered -= used;
+	}
+	free(buf);
+	return buffered == 0;
+}
+
+int main() {
+	bool ok = testVarints();
+
+	Encoder encoder;
+	TraceHandler expected;
+	writeCapture(&encoder, &expected);
+
+	TraceHandler whole;
+	if (GatorDecoder(&whole, false).decode(encoder.get(), encoder.getLength()) != encoder.getLength()) {
+		printf("decode: not all the frames were decoded\n");
+		ok = false;
+	}
+	ok = compareTraces("decode", expected.get(), whole.get()) && ok;
+
+	TraceHandler pieces;
+	if (!decodeInPieces(encoder, &pieces)) {
+		printf("decode in pieces: framing failed\n");
+		ok = false;
+	}
+	ok = compareTraces("decode in pieces", expected.get(), pieces.get()) && ok;
+
+	for (int threadCount = 1; threadCount <= 8; ++threadCount) {
+		TraceHandler handlers[8];
+		GatorDecodeHandler *handlerPtrs[8];
+		for (int i = 0; i < threadCount; ++i) {
+			handlerPtrs[i] = &handlers[i];
+		}
+		if (!gatorDecodeParallel(encoder.get(), encoder.getLength(), false, handlerPtrs, threadCount)) {
+			printf("gatorDecodeParallel: failed with %i threads\n", threadCount);
+			ok = false;
+			continue;
+		}
+		TraceHandler joined;
+		for (int i = 0; i < threadCount; ++i) {
+			joined.append("%s", handlers[i].get());
+		}
+		char name[64];
+		snprintf(name, sizeof(name), "gatorDecodeParallel with %i threads", threadCount);
+		ok = compareTraces(name, expected.get(), joined.get()) && ok;
+	}
+
+	printf("decode_test: %s, %lld bytes\n", ok ? "passed" : "FAILED", (long long)encoder.getLength());
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ */
+
+#include "driver_compact.h"
+
+#include <stdlib.h>
+
+#include "driver_shim.h"
+
+#include "../driver/gator_buffer_write.c"
+#include "../driver/gator_buffer.c"
+#include "../driver/gator_marshaling.c"
+
+// In the driver these are called from the other files of the module. Listing the ones this harness does not call keeps -Wunused-function
+// able to report a marshaling function that the harness should call but doesn't
+static SHIM_UNUSED const void *const not_called[] = {
+	contiguous_space_available,
+	marshal_summary,
+	marshal_cookie_header,
+	marshal_cookie,
+	marshal_thread_name,
+	marshal_link,
+	marshal_backtrace_header,
+	marshal_backtrace,
+	marshal_backtrace_footer,
+	marshal_sched_trace_switch,
+	marshal_sched_trace_exit,
+};
+
+void driver_compact_start(void)
+{
+	gator_buffer_size[BLOCK_COUNTER_BUF] = BLOCK_COUNTER_BUFFER_SIZE;
+	gator_buffer_mask[BLOCK_COUNTER_BUF] = BLOCK_COUNTER_BUFFER_SIZE - 1;
+	gator_buffer[0][BLOCK_COUNTER_BUF] = malloc(BLOCK_COUNTER_BUFFER_SIZE);
+	gator_compact_state[0] = malloc(sizeof(struct compact_state));
+	if (gator_buffer[0][BLOCK_COUNTER_BUF] == NULL || gator_compact_state[0] == NULL) {
+		abort();
+	}
+	gator_buffer_read[0][BLOCK_COUNTER_BUF] = 0;
+	gator_buffer_write[0][BLOCK_COUNTER_BUF] = 0;
+	gator_buffer_commit[0][BLOCK_COUNTER_BUF] = 0;
+	buffer_space_available[0][BLOCK_COUNTER_BUF] = true;
+	// Local capture, no response type
+	gator_response_type = 0;
+	gator_compact_counters = 1;
+
+	marshal_frame(0, BLOCK_COUNTER_BUF);
+}
+
+void driver_compact_stop(void)
+{
+	free(gator_buffer[0][BLOCK_COUNTER_BUF]);
+	gator_buffer[0][BLOCK_COUNTER_BUF] = NULL;
+	free(gator_compact_state[0]);
+	gator_compact_state[0] = NULL;
+}
+
+int driver_compact_header(uint64_t time)
+{
+	return marshal_event_header(time);
+}
+
+void driver_compact_event(int len, int *buffer)
+{
+	marshal_event(len, buffer);
+}
+
+void driver_compact_event64(int len, long long *buffer64)
+{
+	marshal_event64(len, buffer64);
+}
+
+int driver_compact_commit(char *out, int size)
+{
+	const char *const buffer = gator_buffer[0][BLOCK_COUNTER_BUF];
+	int read = gator_buffer_read[0][BLOCK_COUNTER_BUF];
+	int length = 0;
+
+	gator_commit_buffer(0, BLOCK_COUNTER_BUF, 0);
+
+	// As userspace_buffer_read copies it out
+	while (read != gator_buffer_commit[0][BLOCK_COUNTER_BUF] && length < size) {
+		out[length++] = buffer[read];
+		read = (read + 1) & gator_buffer_mask[BLOCK_COUNTER_BUF];
+	}
+	gator_buffer_read[0][BLOCK_COUNTER_BUF] = read;
+
+	return length;
+}
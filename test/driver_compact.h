@@ -0,0 +1,36 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ */
+
+#ifndef DRIVER_COMPACT_H
+#define DRIVER_COMPACT_H
+
+#include <stdint.h>
+
+// The driver's block counter marshaling from gator_marshaling.c in compact mode, on the block counter buffer of cpu 0, for tests written in C++
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Allocates the buffer and starts the first frame
+void driver_compact_start(void);
+void driver_compact_stop(void);
+// marshal_event_header, returns zero if there is no space
+int driver_compact_header(uint64_t time);
+// marshal_event and marshal_event64, buffer holds len / 2 (key, value) pairs as the gator_interface read callbacks return them
+void driver_compact_event(int len, int *buffer);
+void driver_compact_event64(int len, long long *buffer64);
+// Commits the frame, copies the committed data to out in the local capture format and returns its length
+int driver_compact_commit(char *out, int size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DRIVER_COMPACT_H
@@ -0,0 +1,128 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ */
+
+#ifndef DRIVER_SHIM_H
+#define DRIVER_SHIM_H
+
+// A userspace stand in for the parts of the kernel and gator_main.c that the driver's buffer code uses, so that gator_buffer_write.c,
+// gator_buffer.c and gator_marshaling.c can be included by test harnesses. There is a single cpu and the constants must be kept in sync with gator_main.c
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef int32_t s32;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+#define likely(x) __builtin_expect(!!(x), 1)
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define per_cpu(var, cpu) (var[cpu])
+#define local_irq_save(flags) ((void)(flags))
+#define local_irq_restore(flags) ((void)(flags))
+#define mod_timer(timer, expires) ((void)(timer), (void)(expires))
+#define up(sem) ((void)(sem))
+#define pr_err(...) fprintf(stderr, __VA_ARGS__)
+#define get_physical_cpu() 0
+
+#define TASK_COMM_LEN 16
+#define GATOR_IKS_SUPPORT 0
+#define GATOR_CPU_FREQ_SUPPORT 0
+
+#define NR_CPUS 1
+
+// Not every harness uses every variable
+#define SHIM_UNUSED __attribute__((unused))
+
+enum {
+	SUMMARY_BUF,
+	BACKTRACE_BUF,
+	NAME_BUF,
+	COUNTER_BUF,
+	BLOCK_COUNTER_BUF,
+	ANNOTATE_BUF,
+	SCHED_TRACE_BUF,
+	IDLE_BUF,
+	ACTIVITY_BUF,
+	NUM_GATOR_BUFS
+};
+
+#define BLOCK_COUNTER_BUFFER_SIZE (128*1024)
+#define SCHED_TRACE_BUFFER_SIZE   (128*1024)
+
+#define FRAME_SUMMARY       1
+#define FRAME_BACKTRACE     2
+#define FRAME_NAME          3
+#define FRAME_COUNTER       4
+#define FRAME_BLOCK_COUNTER 5
+#define FRAME_ANNOTATE      6
+#define FRAME_SCHED_TRACE   7
+#define FRAME_IDLE          9
+#define FRAME_ACTIVITY     13
+#define FRAME_BLOCK_COUNTER_COMPACT 14
+
+#define UNRESOLVED_COOKIE ~0U
+
+#define MESSAGE_END_BACKTRACE 1
+#define MESSAGE_COOKIE      1
+#define MESSAGE_THREAD_NAME 2
+#define MESSAGE_LINK        4
+#define MESSAGE_SCHED_SWITCH 1
+#define MESSAGE_SCHED_EXIT   2
+#define MESSAGE_SUMMARY   1
+#define MESSAGE_SWITCH 2
+
+#define MAXSIZE_PACK32     5
+#define MAXSIZE_PACK64    10
+
+#define FRAME_HEADER_SIZE 3
+
+#define COMPACT_MAX_RECORDS 128
+#define COMPACT_KEY_RUN     -1
+
+static SHIM_UNUSED u32 gator_buffer_size[NUM_GATOR_BUFS];
+static SHIM_UNUSED u32 gator_buffer_mask[NUM_GATOR_BUFS];
+static SHIM_UNUSED int gator_buffer_read[NR_CPUS][NUM_GATOR_BUFS];
+static SHIM_UNUSED int gator_buffer_write[NR_CPUS][NUM_GATOR_BUFS];
+static SHIM_UNUSED int gator_buffer_commit[NR_CPUS][NUM_GATOR_BUFS];
+static SHIM_UNUSED int buffer_space_available[NR_CPUS][NUM_GATOR_BUFS];
+static SHIM_UNUSED char *gator_buffer[NR_CPUS][NUM_GATOR_BUFS];
+static SHIM_UNUSED u64 gator_buffer_commit_time[NR_CPUS];
+
+struct compact_state {
+	u64 time;
+	int run;
+	int prev_count;
+	int curr_count;
+	int prev_keys[COMPACT_MAX_RECORDS];
+	long long prev_values[COMPACT_MAX_RECORDS];
+	int curr_keys[COMPACT_MAX_RECORDS];
+	long long curr_values[COMPACT_MAX_RECORDS];
+};
+
+static SHIM_UNUSED struct compact_state *gator_compact_state[NR_CPUS];
+static SHIM_UNUSED unsigned long gator_compact_counters;
+static SHIM_UNUSED u64 gator_live_rate;
+static SHIM_UNUSED unsigned long gator_response_type;
+static SHIM_UNUSED bool in_scheduler_context[NR_CPUS];
+static SHIM_UNUSED int gator_buffer_wake_up_timer;
+static SHIM_UNUSED int gator_buffer_wake_sem;
+static SHIM_UNUSED unsigned long jiffies;
+static SHIM_UNUSED unsigned long gator_backtrace_depth;
+
+// The time gator_get_time returns, set by the harness
+static SHIM_UNUSED u64 shim_time;
+
+static inline u64 gator_get_time(void)
+{
+	return shim_time;
+}
+
+#endif // DRIVER_SHIM_H
@@ -0,0 +1,187 @@
+#!/usr/bin/env python3
+#
+# Tests gatord --hub against fake downstream gatords on localhost.
+#
+# Each fake target speaks enough of the Streamline protocol for the hub: the
+# handshake, the session, events and captured xml, clock pings from a clock
+# offset by a known amount, and a short capture starting with a summary frame.
+# The hub must estimate each offset and rewrite the summary timestamps so that
+# the captures line up.
+#
+# Usage: hub_test.py path/to/gatord
+#
+
+import json
+import os
+import shutil
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+# From Sender.h and StreamlineSetup.h
+COMMAND_REQUEST_XML = 0
+COMMAND_DELIVER_XML = 1
+COMMAND_APC_START = 2
+COMMAND_APC_STOP = 3
+COMMAND_PING = 5
+RESPONSE_XML = 1
+RESPONSE_APC_DATA = 3
+RESPONSE_ACK = 4
+
+FRAME_SUMMARY = 1
+FRAME_NAME = 3
+MESSAGE_SUMMARY = 1
+
+# Offsets of the fake target clocks from the hub's clock
+OFFSETS = (5000000000, -7000000)
+# The tolerated error in the estimated offsets, generous for loaded machines
+TOLERANCE_NS = 50000000
+TIMESTAMP = 123456789
+
+def pack(x):
+    """Packs x like Buffer::packInt64"""
+    out = bytearray()
+    while True:
+        b = x & 0x7f
+        x >>= 7
+        if (x == 0 and not b & 0x40) or (x == -1 and b & 0x40):
+            out.append(b)
+            return bytes(out)
+        out.append(b | 0x80)
+
+def unpack(data, pos):
+    result = 0
+    shift = 0
+    while True:
+        b = data[pos]
+        pos += 1
+        result |= (b & 0x7f) << shift
+        shift += 7
+        if not b & 0x80:
+            if shift < 64 and b & 0x40:
+                result -= 1 << shift
+            return result, pos
+
+def now(offset):
+    return time.clock_gettime_ns(time.CLOCK_MONOTONIC_RAW) + offset
+
+class FakeTarget(threading.Thread):
+    def __init__(self, offset):
+        threading.Thread.__init__(self)
+        self.offset = offset
+        self.error = None
+        self.listener = socket.socket()
+        self.listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.listener.bind(('127.0.0.1', 0))
+        self.listener.listen(1)
+        self.listener.settimeout(30)
+        self.port = self.listener.getsockname()[1]
+
+    def respond(self, conn, type, data):
+        conn.sendall(bytes([type]) + struct.pack('<I', len(data)) + data)
+
+    def run(self):
+        try:
+            self.serve()
+        except Exception as e:
+            self.error = e
+        finally:
+            self.listener.close()
+
+    def serve(self):
+        conn, _ = self.listener.accept()
+        conn.settimeout(30)
+        f = conn.makefile('rb')
+        while not f.readline().startswith(b'STREAMLINE'):
+            pass
+        conn.sendall(b'GATOR 19\n')
+        while True:
+            header = f.read(5)
+            if len(header) < 5:
+                raise Exception('hub disconnected')
+            data = f.read(struct.unpack('<I', header[1:])[0])
+            command = header[0]
+            if command == COMMAND_REQUEST_XML:
+                self.respond(conn, RESPONSE_XML, b'<?xml version="1.0" encoding="UTF-8"?>\n<fake/>')
+            elif command == COMMAND_DELIVER_XML:
+                self.respond(conn, RESPONSE_ACK, b'')
+            elif command == COMMAND_PING:
+                self.respond(conn, RESPONSE_ACK, struct.pack('<Q', now(self.offset)) if data == b'clock' else b'')
+            elif command == COMMAND_APC_START:
+                uptime = now(self.offset)
+                summary = pack(FRAME_SUMMARY) + pack(MESSAGE_SUMMARY) + pack(3) + b'\n\r\n' + pack(TIMESTAMP) + pack(uptime) + pack(0) + pack(5) + b'uname' + pack(1) + b'x' + pack(0)
+                self.respond(conn, RESPONSE_APC_DATA, summary)
+                for i in range(3):
+                    self.respond(conn, RESPONSE_APC_DATA, pack(FRAME_NAME) + pack(0))
+            elif command == COMMAND_APC_STOP:
+                self.respond(conn, RESPONSE_APC_DATA, b'')
+                conn.close()
+                return
+            else:
+                raise Exception('unexpected command %i' % command)
+
+def summaryTimestamp(path):
+    """Returns the timestamp of the summary frame at the start of a local capture"""
+    with open(path, 'rb') as f:
+        data = f.read()
+    length = struct.unpack('<I', data[:4])[0]
+    frame = data[4:4 + length]
+    frameType, pos = unpack(frame, 0)
+    messageType, pos = unpack(frame, pos)
+    if frameType != FRAME_SUMMARY or messageType != MESSAGE_SUMMARY:
+        raise Exception('%s does not start with a summary' % path)
+    canaryLength, pos = unpack(frame, pos)
+    timestamp, pos = unpack(frame, pos + canaryLength)
+    return timestamp
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit('usage: %s path/to/gatord' % sys.argv[0])
+
+    targets = [FakeTarget(offset) for offset in OFFSETS]
+    for target in targets:
+        target.start()
+
+    tmp = tempfile.mkdtemp()
+    try:
+        session = os.path.join(tmp, 'session.xml')
+        with open(session, 'w') as f:
+            f.write('<?xml version="1.0" encoding="UTF-8"?>\n<session version="1" call_stack_unwinding="no" parse_debug_info="no" high_resolution="no" buffer_mode="streaming" sample_rate="none" duration="1" target_address="localhost"/>\n')
+        out = os.path.join(tmp, 'out')
+        hubs = ','.join('127.0.0.1:%i' % target.port for target in targets)
+        subprocess.check_call([sys.argv[1], '--hub', hubs, '-s', session, '-o', out], timeout=60)
+        for target in targets:
+            target.join(30)
+            if target.is_alive() or target.error is not None:
+                raise Exception('fake target on port %i failed: %s' % (target.port, target.error))
+
+        with open(os.path.join(out, 'hub.json')) as f:
+            results = json.load(f)['targets']
+        if len(results) != len(targets):
+            raise Exception('expected %i targets in hub.json' % len(targets))
+        timestamps = []
+        for target, result in zip(targets, results):
+            error = result['clock_offset_ns'] - target.offset
+            print('port %i: clock offset %i ns, error %i ns, round trip %i ns' % (target.port, result['clock_offset_ns'], error, result['round_trip_ns']))
+            if abs(error) > TOLERANCE_NS:
+                raise Exception('clock offset of port %i is off by %i ns' % (target.port, error))
+            timestamps.append(summaryTimestamp(os.path.join(result['capture'], '0000000000')))
+
+        # The captures started at nearly the same time so once aligned so are their timestamps, even though the target clocks are seconds apart
+        if any(timestamp == TIMESTAMP for timestamp in timestamps):
+            raise Exception('summary timestamp was not rewritten')
+        spread = max(timestamps) - min(timestamps)
+        print('summary timestamps spread %i ns' % spread)
+        if spread > 1000000000:
+            raise Exception('captures are not aligned')
+    finally:
+        shutil.rmtree(tmp)
+
+    print('PASS')
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,109 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ */
+
+// Context switch cost in the style of 'perf bench sched pipe': two processes pinned to the same cpu pass a byte back and forth over
+// pipes so every message is a context switch and runs the sched_switch hook. Run it without a capture and then during a capture,
+// with each version of gator.ko, and the difference in ns per switch is the cost gator adds to the scheduler
+
+#define _GNU_SOURCE
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RUNS 5
+
+static void pin(int cpu)
+{
+	cpu_set_t cpus;
+
+	CPU_ZERO(&cpus);
+	CPU_SET(cpu, &cpus);
+	if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+		perror("sched_setaffinity");
+		exit(1);
+	}
+}
+
+// Returns ns per context switch
+static double run(int loops)
+{
+	int ping[2], pong[2];
+	struct timespec start, end;
+	char c = 0;
+	pid_t child;
+	int i;
+
+	if (pipe(ping) != 0 || pipe(pong) != 0) {
+		perror("pipe");
+		exit(1);
+	}
+
+	child = fork();
+	if (child < 0) {
+		perror("fork");
+		exit(1);
+	}
+	if (child == 0) {
+		for (i = 0; i < loops; ++i) {
+			if (read(ping[0], &c, 1) != 1 || write(pong[1], &c, 1) != 1) {
+				_exit(1);
+			}
+		}
+		_exit(0);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < loops; ++i) {
+		if (write(ping[1], &c, 1) != 1 || read(pong[0], &c, 1) != 1) {
+			perror("pipe");
+			exit(1);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	waitpid(child, NULL, 0);
+
+	close(ping[0]);
+	close(ping[1]);
+	close(pong[0]);
+	close(pong[1]);
+
+	// Each loop is two context switches
+	return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / (2.0 * loops);
+}
+
+int main(int argc, char *argv[])
+{
+	const int loops = argc > 1 ? atoi(argv[1]) : 200000;
+	const int cpu = argc > 2 ? atoi(argv[2]) : 0;
+	double best = 0;
+	int i;
+
+	if (loops <= 0) {
+		fprintf(stderr, "usage: %s [loops] [cpu]\n", argv[0]);
+		return 1;
+	}
+
+	// The child inherits the affinity
+	pin(cpu);
+	for (i = 0; i < RUNS; ++i) {
+		const double ns = run(loops);
+		if (i == 0 || ns < best) {
+			best = ns;
+		}
+	}
+
+	// The best of several runs is the least disturbed by other work on the cpu
+	printf("sched_bench: %.0f ns per context switch on cpu %i, best of %i runs of %i round trips\n", best, cpu, RUNS, loops);
+
+	return 0;
+}
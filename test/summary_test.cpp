@@ -0,0 +1,356 @@
+/**
+ * Copyright (C) ARM Limited 2014. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+// Feeds a synthetic capture through CaptureSummary, as Sender does during a local capture, and checks the totals and rates in the json.
+// The perf attrs, block counter and comm frames are written by the daemon's Buffer, the perf frame holds ring buffer records as PerfBuffer sends them.
+// Samples are taken in functions of this executable so that they are symbolized from its symbol table
+
+#include <inttypes.h>
+#include <link.h>
+#include <math.h>
+#include <semaphore.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Buffer.h"
+#include "CaptureSummary.h"
+#include "DynBuf.h"
+#include "Logging.h"
+#include "Sender.h"
+#include "SessionData.h"
+#include "k/perf_event.h"
+
+// Called by handleException
+void cleanUp() {
+}
+
+// The functions the samples are taken in
+extern "C" __attribute__((noinline)) int summaryTestHot(const int x) {
+	return 3 * x + 1;
+}
+
+extern "C" __attribute__((noinline)) int summaryTestCold(const int x) {
+	return 5 * x + 2;
+}
+
+static const int BUFFER_SIZE = 1 << 16;
+static const int PERF_CPU = 1;
+static const int PID = 1234;
+static const int TID = 1235;
+static const int HOT_SAMPLES = 300;
+static const int COLD_SAMPLES = 100;
+// Samples outside any mapping, which have no function
+static const int UNKNOWN_SAMPLES = 20;
+// Where the executable is mapped in the synthetic process
+static const uint64_t MAP_BASE = 0x7f0000000000ULL;
+static const uint64_t MAP_LENGTH = 0x10000000ULL;
+
+// Keys of the counters, the perf group is a cycle counter leading an event counter and the driver sends network and memory counters
+static const int KEY_CYCLES = 10;
+static const int KEY_EVENT = 11;
+static const int KEY_NET = 20;
+static const int KEY_MEM = 21;
+static const uint64_t ID_CYCLES = 100;
+static const uint64_t ID_EVENT = 101;
+
+struct FindText {
+	uint64_t address;
+	uint64_t offset;
+	bool found;
+};
+
+static int findText(struct dl_phdr_info *info, size_t, void *data) {
+	FindText *const find = (FindText *)data;
+	for (int i = 0; i < info->dlpi_phnum; ++i) {
+		const ElfW(Phdr) &phdr = info->dlpi_phdr[i];
+		const uint64_t vaddr = info->dlpi_addr + phdr.p_vaddr;
+		if (phdr.p_type == PT_LOAD && find->address >= vaddr && find->address < vaddr + phdr.p_filesz) {
+			find->offset = find->address - vaddr + phdr.p_offset;
+			find->found = true;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// Returns the offset in the executable of the code at address, which is what a perf sample in a file backed mapping resolves to
+static uint64_t fileOffset(const void *const address) {
+	FindText find;
+	find.address = (uint64_t)address;
+	find.offset = 0;
+	find.found = false;
+	dl_iterate_phdr(findText, &find);
+	if (!find.found) {
+		printf("summary_test: unable to find %p in the executable\n", address);
+		exit(1);
+	}
+	return find.offset;
+}
+
+static void append(DynBuf *const buf, const void *const data, const int length) {
+	if (!buf->append((const char *)data, length)) {
+		printf("summary_test: out of memory\n");
+		exit(1);
+	}
+}
+
+static void appendU64(DynBuf *const buf, const uint64_t value) {
+	append(buf, &value, sizeof(value));
+}
+
+// A PERF_RECORD_SAMPLE with the sample_type and read_format of the group leader in writeAttrs
+static void appendSample(DynBuf *const buf, const uint64_t ip, const uint64_t time, const uint64_t cycles, const uint64_t events) {
+	struct perf_event_header header;
+	header.type = PERF_RECORD_SAMPLE;
+	header.misc = PERF_RECORD_MISC_USER;
+	// identifier, ip, pid/tid, time, read of two values with ids and a callchain of two entries
+	header.size = sizeof(header) + 4 * sizeof(uint64_t) + 5 * sizeof(uint64_t) + 3 * sizeof(uint64_t);
+	append(buf, &header, sizeof(header));
+	appendU64(buf, ID_CYCLES);
+	appendU64(buf, ip);
+	const uint32_t tid[2] = { PID, TID };
+	append(buf, tid, sizeof(tid));
+	appendU64(buf, time);
+	appendU64(buf, 2);
+	appendU64(buf, cycles);
+	appendU64(buf, ID_CYCLES);
+	appendU64(buf, events);
+	appendU64(buf, ID_EVENT);
+	appendU64(buf, 2);
+	appendU64(buf, ip);
+	appendU64(buf, MAP_BASE + 0x10);
+}
+
+static void appendMmap(DynBuf *const buf, const char *const path) {
+	// The filename is NUL terminated and padded to 8 bytes
+	const int pathSize = (strlen(path) + 8) & ~7;
+	struct perf_event_header header;
+	header.type = PERF_RECORD_MMAP;
+	header.misc = PERF_RECORD_MISC_USER;
+	header.size = sizeof(header) + 2 * sizeof(uint32_t) + 3 * sizeof(uint64_t) + pathSize;
+	append(buf, &header, sizeof(header));
+	const uint32_t ids[2] = { PID, PID };
+	append(buf, ids, sizeof(ids));
+	appendU64(buf, MAP_BASE);
+	appendU64(buf, MAP_LENGTH);
+	appendU64(buf, 0);
+	char padded[PATH_MAX + 8];
+	memset(padded, 0, sizeof(padded));
+	strcpy(padded, path);
+	append(buf, padded, pathSize);
+}
+
+// Sends the perf records as PerfBuffer does, [LE32 length][FRAME_PERF][cpu as a raw byte][records]
+static void sendPerf(Sender *const sender, const DynBuf &records) {
+	unsigned char header[6];
+	Buffer::writeLEInt(header, records.getLength() + 2);
+	header[4] = FRAME_PERF;
+	header[5] = PERF_CPU;
+	sender->writeData((const char *)header, sizeof(header), RESPONSE_APC_DATA);
+	sender->writeData(records.getBuf(), records.getLength(), RESPONSE_APC_DATA);
+}
+
+static void writeAttrs(Buffer *const buffer) {
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.sample_type = PERF_SAMPLE_IDENTIFIER | PERF_SAMPLE_IP | PERF_SAMPLE_TID | PERF_SAMPLE_TIME | PERF_SAMPLE_READ | PERF_SAMPLE_CALLCHAIN;
+	attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID;
+	buffer->pea(&attr, KEY_CYCLES);
+	attr.sample_type = 0;
+	buffer->pea(&attr, KEY_EVENT);
+	const __u64 ids[2] = { ID_CYCLES, ID_EVENT };
+	const int keys[2] = { KEY_CYCLES, KEY_EVENT };
+	buffer->keys(2, ids, keys);
+	buffer->comm(PID, PID, "/usr/bin/summary_app", "summary_app");
+}
+
+static void enableCounter(const int index, const char *const type, const int key) {
+	Counter &counter = gSessionData->mCounters[index];
+	counter.setType(type);
+	counter.setKey(key);
+	counter.setEnabled(true);
+}
+
+// Returns the text following the first match of name in json, or exits
+static const char *find(const char *const json, const char *const name) {
+	const char *const pos = strstr(json, name);
+	if (pos == NULL) {
+		printf("summary_test: %s is missing from the summary\n", name);
+		exit(1);
+	}
+	return pos + strlen(name);
+}
+
+static bool checkValue(const char *const what, const int64_t actual, const int64_t expected) {
+	if (actual != expected) {
+		printf("summary_test: %s is %" PRId64 ", expected %" PRId64 "\n", what, actual, expected);
+		return false;
+	}
+	return true;
+}
+
+// The rate is printed with three decimals
+static bool checkRate(const char *const what, const double actual, const double expected) {
+	if (fabs(actual - expected) > 0.001 + 1e-9 * expected) {
+		printf("summary_test: %s rate is %.3f, expected %.3f\n", what, actual, expected);
+		return false;
+	}
+	return true;
+}
+
+int main() {
+	logg = new Logging(false);
+	gSessionData = new SessionData();
+	gSessionData->mLocalCapture = true;
+	gSessionData->mCores = 2;
+	enableCounter(0, "ARMv7_Cortex_A9_ccnt", KEY_CYCLES);
+	enableCounter(1, "ARMv7_Cortex_A9_cnt0", KEY_EVENT);
+	enableCounter(2, "Linux_net_rx", KEY_NET);
+	enableCounter(3, "Linux_meminfo_memused", KEY_MEM);
+
+	char exe[PATH_MAX];
+	const ssize_t exeLength = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+	if (exeLength <= 0) {
+		printf("summary_test: unable to find the executable\n");
+		return 1;
+	}
+	exe[exeLength] = '\0';
+
+	sem_t sem;
+	sem_init(&sem, 0, 0);
+	CaptureSummary summary;
+	Sender *const sender = new Sender(NULL);
+	sender->setSummary(&summary);
+
+	Buffer attrs(0, FRAME_PERF_ATTRS, BUFFER_SIZE, &sem);
+	writeAttrs(&attrs);
+	attrs.commit(1);
+	attrs.write(sender);
+
+	// The group counters are running totals, the summary reports the last one read
+	DynBuf records;
+	appendMmap(&records, exe);
+	const uint64_t hot = MAP_BASE + fileOffset((const void *)summaryTestHot);
+	const uint64_t cold = MAP_BASE + fileOffset((const void *)summaryTestCold);
+	uint64_t cycles = 0;
+	uint64_t events = 0;
+	const int sampleCount = HOT_SAMPLES + COLD_SAMPLES + UNKNOWN_SAMPLES;
+	for (int i = 0; i < sampleCount; ++i) {
+		cycles += 1000 + i;
+		events += 7 + i % 3;
+		const uint64_t ip = i < HOT_SAMPLES ? hot : i < HOT_SAMPLES + COLD_SAMPLES ? cold : MAP_BASE + MAP_LENGTH + i;
+		appendSample(&records, ip, 1000000 * (i + 1), cycles, events);
+		// Send in more than one frame
+		if (i % 128 == 127 || i == sampleCount - 1) {
+			sendPerf(sender, records);
+			records.clear();
+		}
+	}
+
+	// The network counter is a delta that is summed, memory is absolute so its range is reported
+	Buffer counters(0, FRAME_BLOCK_COUNTER, BUFFER_SIZE, &sem);
+	int64_t netTotal = 0;
+	int64_t memMin = 0, memMax = 0, memLast = 0, memSum = 0;
+	const int tickCount = 50;
+	for (int i = 0; i < tickCount; ++i) {
+		const int net = 1500 * (i % 4);
+		const int mem = 100000000 + 4096 * ((i * 37) % 11);
+		counters.eventHeader(1000000 * (i + 1));
+		counters.eventTid(TID);
+		counters.event(KEY_NET, net);
+		counters.event(KEY_MEM, mem);
+		netTotal += net;
+		memMin = i == 0 || mem < memMin ? mem : memMin;
+		memMax = i == 0 || mem > memMax ? mem : memMax;
+		memLast = mem;
+		memSum += mem;
+		if (i % 16 == 15 || i == tickCount - 1) {
+			counters.commit(1000000 * (i + 1));
+			counters.write(sender);
+		}
+	}
+	delete sender;
+
+	char path[] = "/tmp/summary_test.XXXXXX";
+	const int fd = mkstemp(path);
+	if (fd < 0 || !summary.writeJSON(path)) {
+		printf("summary_test: unable to write the summary\n");
+		return 1;
+	}
+	close(fd);
+	DynBuf json;
+	if (!json.read(path)) {
+		printf("summary_test: unable to read %s\n", path);
+		return 1;
+	}
+	unlink(path);
+
+	bool ok = true;
+	long long duration, samples, value;
+	double rate, mean;
+	int key;
+	sscanf(find(json.getBuf(), "\"duration_ns\":"), "%lld", &duration);
+	const double seconds = duration / 1e9;
+	sscanf(find(json.getBuf(), "\"samples\":"), "%lld", &samples);
+	ok = checkValue("samples", samples, sampleCount) && ok;
+
+	// The top functions are sorted by samples
+	char name[PATH_MAX + 64];
+	snprintf(name, sizeof(name), "{ \"function\": \"summaryTestHot\", \"image\": \"%s\", \"samples\":", exe);
+	sscanf(find(json.getBuf(), name), "%lld", &samples);
+	ok = checkValue("summaryTestHot samples", samples, HOT_SAMPLES) && ok;
+	snprintf(name, sizeof(name), "{ \"function\": \"summaryTestCold\", \"image\": \"%s\", \"samples\":", exe);
+	sscanf(find(json.getBuf(), name), "%lld", &samples);
+	ok = checkValue("summaryTestCold samples", samples, COLD_SAMPLES) && ok;
+	sscanf(find(json.getBuf(), "{ \"function\": null, \"image\": null, \"samples\":"), "%lld", &samples);
+	ok = checkValue("unknown function samples", samples, UNKNOWN_SAMPLES) && ok;
+	if (strstr(json.getBuf(), "summaryTestHot") > strstr(json.getBuf(), "summaryTestCold")) {
+		printf("summary_test: the top functions are not sorted by samples\n");
+		ok = false;
+	}
+
+	// The perf group counters are on the cpu of the perf frame, the driver counters on core 0
+	const char *const core0 = find(json.getBuf(), "{ \"core\": 0,");
+	const char *const core1 = find(json.getBuf(), "{ \"core\": 1,");
+	if (sscanf(find(core1, "\"name\": \"ARMv7_Cortex_A9_ccnt\","), " \"key\": %i, \"total\": %lld, \"values\": %lld, \"rate\": %lf", &key, &value, &samples, &rate) != 4) {
+		printf("summary_test: unable to parse the cycle counter\n");
+		return 1;
+	}
+	ok = checkValue("cycles key", key, KEY_CYCLES) && checkValue("cycles total", value, cycles) && checkValue("cycles values", samples, sampleCount) && checkRate("cycles", rate, cycles / seconds) && ok;
+	if (sscanf(find(core1, "\"name\": \"ARMv7_Cortex_A9_cnt0\","), " \"key\": %i, \"total\": %lld, \"values\": %lld, \"rate\": %lf", &key, &value, &samples, &rate) != 4) {
+		printf("summary_test: unable to parse the event counter\n");
+		return 1;
+	}
+	ok = checkValue("events key", key, KEY_EVENT) && checkValue("events total", value, events) && checkRate("events", rate, events / seconds) && ok;
+	if (sscanf(find(core0, "\"name\": \"Linux_net_rx\","), " \"key\": %i, \"total\": %lld, \"values\": %lld, \"rate\": %lf", &key, &value, &samples, &rate) != 4 || find(core0, "\"name\": \"Linux_net_rx\",") > core1) {
+		printf("summary_test: unable to parse the network counter\n");
+		return 1;
+	}
+	ok = checkValue("network total", value, netTotal) && checkValue("network values", samples, tickCount) && checkRate("network", rate, netTotal / seconds) && ok;
+	long long last, min, max;
+	if (sscanf(find(core0, "\"name\": \"Linux_meminfo_memused\","), " \"key\": %i, \"last\": %lld, \"min\": %lld, \"max\": %lld, \"mean\": %lf", &key, &last, &min, &max, &mean) != 5) {
+		printf("summary_test: unable to parse the memory counter\n");
+		return 1;
+	}
+	ok = checkValue("memory last", last, memLast) && checkValue("memory min", min, memMin) && checkValue("memory max", max, memMax) && checkRate("memory mean", mean, memSum / (double)tickCount) && ok;
+
+	// Every sample is in one thread of the process named by the comm
+	snprintf(name, sizeof(name), "{ \"pid\": %i, \"name\": \"summary_app\", \"cpu_time_ns\": 0, \"samples\":", PID);
+	sscanf(find(json.getBuf(), name), "%lld", &samples);
+	ok = checkValue("process samples", samples, sampleCount) && ok;
+
+	printf("summary_test: %s, %i samples over %.3f ms\n", ok ? "passed" : "FAILED", sampleCount, seconds * 1e3);
+
+	sem_destroy(&sem);
+	return ok ? 0 : 1;
+}